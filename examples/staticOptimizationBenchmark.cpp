@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "InternalForces/Muscles/StaticOptimization.h"
+#include "InternalForces/Muscles/StaticOptimizationQuadratic.h"
+#include "biorbd.h"
+
+///
+/// \brief main Compare the solve time per frame of the static optimization
+/// using Ipopt, Ipopt on several threads and the dedicated quadratic solver
+/// \return Nothing
+///
+/// This examples shows how to
+///     1. Load a model with muscles
+///     2. Generate a movement and the generalized forces (Tau) produced by
+///     known muscle activations
+///     3. Compute the muscle activations that reproduce this Tau with Ipopt
+///     (linearized, p = 2), with Ipopt on all the hardware threads and with
+///     the quadratic solver
+///     4. Print the time per frame and the residual torques to the console
+///
+/// Please note that this example will work only with the Eigen backend
+///
+
+using namespace BIORBD_NAMESPACE;
+
+int main() {
+  // Load a predefined model
+  Model model("arm26.bioMod");
+  size_t nbFrames(200);
+
+  // A smooth movement and the torques produced by smooth activations
+  std::vector<rigidbody::GeneralizedCoordinates> allQ;
+  std::vector<rigidbody::GeneralizedVelocity> allQdot;
+  std::vector<rigidbody::GeneralizedTorque> allTau;
+  std::vector<std::shared_ptr<internal_forces::muscles::State>> states =
+      model.stateSet();
+  for (size_t f = 0; f < nbFrames; ++f) {
+    double t(static_cast<double>(f) / static_cast<double>(nbFrames));
+    rigidbody::GeneralizedCoordinates Q(model);
+    rigidbody::GeneralizedVelocity Qdot(model);
+    for (unsigned int i = 0; i < model.nbQ(); ++i) {
+      Q[i] = 0.2 + 0.8 * std::sin(M_PI * t + i);
+      Qdot[i] = 0.8 * M_PI * std::cos(M_PI * t + i);
+    }
+    for (size_t i = 0; i < model.nbMuscles(); ++i) {
+      states[i]->setActivation(0.3 + 0.2 * std::sin(2 * M_PI * t + i));
+    }
+    allQ.push_back(Q);
+    allQdot.push_back(Qdot);
+    allTau.push_back(model.muscularJointTorque(states, Q, Qdot));
+  }
+
+  // Ipopt
+  auto ipoptStart(std::chrono::steady_clock::now());
+  internal_forces::muscles::StaticOptimization optim(
+      model, allQ, allQdot, allTau);
+  optim.run(true);
+  double ipoptTime(std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - ipoptStart)
+                       .count());
+
+  // Ipopt, the frames being split between the hardware threads
+  auto parallelStart(std::chrono::steady_clock::now());
+  internal_forces::muscles::StaticOptimization parallelOptim(
+      model, allQ, allQdot, allTau);
+  parallelOptim.runParallel(0, true);
+  double parallelTime(std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - parallelStart)
+                          .count());
+
+  // Quadratic solver, warm-started from the active set of the previous frame
+  internal_forces::muscles::StaticOptimizationQuadratic quadratic(model);
+  double maxResidual(0);
+  size_t nbIterations(0);
+  auto quadraticStart(std::chrono::steady_clock::now());
+  for (size_t f = 0; f < nbFrames; ++f) {
+    quadratic.solve(allQ[f], allQdot[f], allTau[f]);
+    maxResidual = std::max(
+        maxResidual, quadratic.residualTorques().lpNorm<Eigen::Infinity>());
+    nbIterations += quadratic.nbIterations();
+  }
+  double quadraticTime(std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - quadraticStart)
+                           .count());
+
+  // Print them to the console
+  std::cout << "Ipopt: " << 1e6 * ipoptTime / nbFrames << " us per frame"
+            << std::endl;
+  std::cout << "Parallel Ipopt: " << 1e6 * parallelTime / nbFrames
+            << " us per frame (up to " << parallelOptim.maxConcurrentSolves()
+            << " frames solved at the same time)" << std::endl;
+  std::cout << "Quadratic: " << 1e6 * quadraticTime / nbFrames
+            << " us per frame (" << static_cast<double>(nbIterations) / nbFrames
+            << " iterations per frame)" << std::endl;
+  std::cout << "Largest residual torque: " << maxResidual << std::endl;
+
+  return 0;
+}
@@ -69,9 +69,12 @@
 BIORBD_NAMESPACE::utils::String getVersion();
 
 namespace BIORBD_NAMESPACE {
+class InternalForceAccumulator;
+
 namespace rigidbody {
 class ExternalForceSet;
-}
+class GeneralizedAcceleration;
+}  // namespace rigidbody
 
 ///
 /// \brief The actual musculoskeletal model that holds everything in biorbd
@@ -111,6 +114,18 @@ class BIORBD_API Model : public rigidbody::Joints,
   ///
   Model(const utils::Path& path);
 
+  ///
+  /// \brief Deep copy of the model
+  /// \return A deep copy of the model
+  ///
+  Model DeepCopy() const;
+
+  ///
+  /// \brief Deep copy of the model
+  /// \param other The model to copy
+  ///
+  void DeepCopy(const Model& other);
+
   ///
   /// \brief Get an external forces set designed for the current model
   /// \param useLinearForces If this force set has external forces
@@ -120,8 +135,108 @@ class BIORBD_API Model : public rigidbody::Joints,
       bool useLinearForces = true,
       bool useSoftContacts = true);
 
+  ///
+  /// \brief Return the accumulator of the internal forces of the model, to
+  /// select the sources and keep their breakdown
+  /// \return The accumulator of the internal forces
+  ///
+  InternalForceAccumulator& internalForceAccumulator();
+
+  ///
+  /// \brief Compute the sum of the internal generalized forces (muscles,
+  /// ligaments, passive torques and actuators, and the joint dampings if they
+  /// were enabled)
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param muscleActivations The activations of all the muscles (ignored if
+  /// the model has no muscle)
+  /// \param actuatorActivations The activations of the actuators (ignored if
+  /// the model has no actuator)
+  /// \return The sum of the internal generalized forces
+  ///
+  /// The kinematics is updated once and shared by all the sources, the result
+  /// is kept in a buffer of the accumulator (see internalForceAccumulator).
+  /// The joint dampings are disabled by default since the forward dynamics
+  /// already subtract them from Tau.
+  ///
+  const rigidbody::GeneralizedTorque& internalForces(
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      const utils::Vector& muscleActivations,
+      const utils::Vector& actuatorActivations);
+
+#ifdef MODULE_MUSCLES
+  ///
+  /// \brief Compute the generalized accelerations of the model driven by its
+  /// muscles
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param activations The activations of all the muscles
+  /// \param forces The muscle forces (output, ignored if nullptr)
+  /// \return The generalized accelerations
+  ///
+  /// The kinematics is updated once and the geometry of the muscles is swept
+  /// once. The muscular, passive and ligament joint torques and the joint
+  /// dampings are summed by an accumulator kept by the model (independent
+  /// from internalForceAccumulator) before the forward dynamics. If the
+  /// muscles were compiled (see compileMuscles), their forces are computed by
+  /// the batched kernels.
+  ///
+  rigidbody::GeneralizedAcceleration muscleDrivenForwardDynamics(
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      const utils::Vector& activations,
+      utils::Vector* forces = nullptr);
+
+  ///
+  /// \brief Compute the generalized accelerations of the model driven by its
+  /// muscles
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param activations The activations of all the muscles
+  /// \param externalForces External force acting on the system
+  /// \param forces The muscle forces (output, ignored if nullptr)
+  /// \return The generalized accelerations
+  ///
+  rigidbody::GeneralizedAcceleration muscleDrivenForwardDynamics(
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      const utils::Vector& activations,
+      rigidbody::ExternalForceSet& externalForces,
+      utils::Vector* forces = nullptr);
+
+  ///
+  /// \brief Compute the generalized accelerations of the model driven by its
+  /// muscles and the time derivative of the activations
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param excitations The excitations of all the muscles
+  /// \param activations The activations of all the muscles
+  /// \param externalForces External force acting on the system
+  /// \param activationsDot The time derivative of the activations (output)
+  /// \param forces The muscle forces (output, ignored if nullptr)
+  /// \param areadyNormalized If the excitations are already normalized
+  /// \return The generalized accelerations
+  ///
+  rigidbody::GeneralizedAcceleration muscleDrivenForwardDynamics(
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      const utils::Vector& excitations,
+      const utils::Vector& activations,
+      rigidbody::ExternalForceSet& externalForces,
+      utils::Vector& activationsDot,
+      utils::Vector* forces = nullptr,
+      bool areadyNormalized = true);
+#endif
+
  private:
   std::shared_ptr<utils::Path> m_path;
+  std::shared_ptr<InternalForceAccumulator>
+      m_internalForceAccumulator;  ///< Accumulator of the internal forces
+#ifdef MODULE_MUSCLES
+  std::shared_ptr<InternalForceAccumulator>
+      m_muscleDrivenAccumulator;  ///< Accumulator of the muscle driven dynamics
+#endif
 
  public:
   ///
@@ -0,0 +1,209 @@
+#ifndef BIORBD_INTERNAL_FORCE_ACCUMULATOR_H
+#define BIORBD_INTERNAL_FORCE_ACCUMULATOR_H
+
+#include "biorbdConfig.h"
+
+#include <vector>
+
+#include "RigidBody/GeneralizedTorque.h"
+#include "Utils/Vector.h"
+
+namespace BIORBD_NAMESPACE {
+class Model;
+
+namespace rigidbody {
+class GeneralizedCoordinates;
+class GeneralizedVelocity;
+class Joints;
+}  // namespace rigidbody
+
+///
+/// \brief The sources of internal generalized forces
+///
+enum INTERNAL_FORCE_SOURCE {
+  MUSCLE_FORCES,
+  LIGAMENT_FORCES,
+  PASSIVE_TORQUES,
+  ACTUATOR_TORQUES,
+  JOINT_DAMPINGS,
+  NO_INTERNAL_FORCE_SOURCE
+};
+
+///
+/// \brief INTERNAL_FORCE_SOURCE_toStr returns the source name in a string
+/// format
+/// \param source The source to convert to string
+/// \return The name of the source
+///
+inline const char* INTERNAL_FORCE_SOURCE_toStr(INTERNAL_FORCE_SOURCE source) {
+  switch (source) {
+    case MUSCLE_FORCES:
+      return "Muscles";
+    case LIGAMENT_FORCES:
+      return "Ligaments";
+    case PASSIVE_TORQUES:
+      return "PassiveTorques";
+    case ACTUATOR_TORQUES:
+      return "Actuators";
+    case JOINT_DAMPINGS:
+      return "JointDampings";
+    default:
+      return "NoSource";
+  }
+}
+
+///
+/// \brief Sum of all the internal generalized forces of a model (muscles,
+/// ligaments, passive torques, actuators and joint dampings) computed in a
+/// single pass
+///
+/// The kinematics of the model is updated once and shared by all the sources.
+/// Each source writes in place in a buffer kept by the accumulator, so no
+/// generalized torque is allocated from one call to the next (the sources may
+/// still use temporaries of their own, e.g. the length jacobian of muscles
+/// that are not compiled). A source is only computed if it is enabled and if
+/// the model has elements of this type. If the breakdown is kept, the
+/// contribution of each source remains available after the computation (e.g.
+/// for logging).
+///
+/// The joint dampings are disabled by default: the forward dynamics of the
+/// model (ForwardDynamics, ForwardDynamicsConstraintsDirect, ...) already
+/// subtract them from the Tau they receive, so passing a sum that includes
+/// them as Tau would damp the joints twice. Enable them (see enable) only if
+/// the sum is used without these functions (e.g. for logging).
+///
+class BIORBD_API InternalForceAccumulator {
+ public:
+  ///
+  /// \brief Construct an accumulator with all the sources enabled, but the
+  /// joint dampings
+  ///
+  InternalForceAccumulator();
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~InternalForceAccumulator();
+
+  ///
+  /// \brief Enable or disable a source
+  /// \param source The source
+  /// \param enable If the source is added to the total
+  ///
+  void enable(INTERNAL_FORCE_SOURCE source, bool enable = true);
+
+  ///
+  /// \brief Return if a source is enabled
+  /// \param source The source
+  /// \return If the source is enabled
+  ///
+  bool isEnabled(INTERNAL_FORCE_SOURCE source) const;
+
+  ///
+  /// \brief Keep the contribution of each source after the computation
+  /// \param keep If the contributions are kept
+  ///
+  void keepBreakdown(bool keep = true);
+
+  ///
+  /// \brief Return if the contribution of each source is kept
+  /// \return If the contribution of each source is kept
+  ///
+  bool isBreakdownKept() const;
+
+  ///
+  /// \brief Compute the sum of the internal generalized forces
+  /// \param model The model
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param muscleActivations The activations of all the muscles (ignored if
+  /// the muscles are not computed)
+  /// \param actuatorActivations The activations of the actuators (ignored if
+  /// the actuators are not computed)
+  /// \return The sum of the internal generalized forces
+  ///
+  const rigidbody::GeneralizedTorque& compute(
+      Model& model,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      const utils::Vector& muscleActivations,
+      const utils::Vector& actuatorActivations);
+
+  ///
+  /// \brief Compute the sum of the internal generalized forces
+  /// \param model The model
+  /// \param updatedModel The joint model updated to Q and Qdot
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param muscleActivations The activations of all the muscles (ignored if
+  /// the muscles are not computed)
+  /// \param actuatorActivations The activations of the actuators (ignored if
+  /// the actuators are not computed)
+  /// \return The sum of the internal generalized forces
+  ///
+  const rigidbody::GeneralizedTorque& compute(
+      Model& model,
+      rigidbody::Joints& updatedModel,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      const utils::Vector& muscleActivations,
+      const utils::Vector& actuatorActivations);
+
+  ///
+  /// \brief Return the sum of the internal generalized forces of the last
+  /// computation
+  /// \return The sum of the internal generalized forces
+  ///
+  const rigidbody::GeneralizedTorque& torque() const;
+
+  ///
+  /// \brief Return the contribution of a source to the last computation
+  /// \param source The source
+  /// \return The contribution of the source (zero if it was not computed)
+  ///
+  /// The breakdown must be kept (see keepBreakdown)
+  ///
+  const utils::Vector& torque(INTERNAL_FORCE_SOURCE source) const;
+
+  ///
+  /// \brief Return the muscle forces of the last computation
+  /// \return The muscle forces (empty if the muscles were not computed)
+  ///
+  const utils::Vector& muscleForces() const;
+
+  ///
+  /// \brief Return the ligament forces of the last computation
+  /// \return The ligament forces (empty if the ligaments were not computed)
+  ///
+  const utils::Vector& ligamentForces() const;
+
+ protected:
+  ///
+  /// \brief Return if a source must be computed for a model
+  /// \param model The model
+  /// \param source The source
+  /// \return If the source is enabled and the model has elements of this type
+  ///
+  bool isComputed(const Model& model, INTERNAL_FORCE_SOURCE source) const;
+
+  ///
+  /// \brief Return the buffer a source writes in, sized to nbTau
+  /// \param source The source
+  /// \param nbTau The number of generalized torques
+  /// \return The buffer of the source
+  ///
+  utils::Vector& sourceBuffer(INTERNAL_FORCE_SOURCE source, size_t nbTau);
+
+  std::vector<bool> m_isEnabled;  ///< If each source is enabled
+  bool m_keepBreakdown;  ///< If the contribution of each source is kept
+  rigidbody::GeneralizedTorque m_torque;  ///< Sum of the internal forces
+  std::vector<utils::Vector>
+      m_breakdown;  ///< Contribution of each source (if kept)
+  utils::Vector m_sourceTorque;  ///< Contribution of the current source
+  utils::Vector m_muscleForces;  ///< Muscle forces of the last computation
+  utils::Vector m_ligamentForces;  ///< Ligament forces of the last computation
+};
+
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_INTERNAL_FORCE_ACCUMULATOR_H
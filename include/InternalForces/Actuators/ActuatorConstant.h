@@ -65,6 +65,12 @@ class BIORBD_API ActuatorConstant : public Actuator {
   ///
   virtual utils::Scalar torqueMax();
 
+  ///
+  /// \brief Return the maximal torque
+  /// \return The maximal torque
+  ///
+  const utils::Scalar& Tmax() const;
+
  protected:
   ///
   /// \brief Set the type of the constant actuator
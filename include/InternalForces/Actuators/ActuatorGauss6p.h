@@ -135,6 +135,90 @@ class BIORBD_API ActuatorGauss6p : public Actuator {
       const rigidbody::GeneralizedCoordinates& Q,
       const rigidbody::GeneralizedVelocity& Qdot);
 
+  ///
+  /// \brief Return the ratio of slope of the eccentric and concentric phases
+  /// \return The ratio of slope of the eccentric and concentric phases
+  ///
+  const utils::Scalar& k() const;
+
+  ///
+  /// \brief Return the maximum torque in the eccentric phase
+  /// \return The maximum torque in the eccentric phase
+  ///
+  const utils::Scalar& Tmax() const;
+
+  ///
+  /// \brief Return the maximum isometric torque
+  /// \return The maximum isometric torque
+  ///
+  const utils::Scalar& T0() const;
+
+  ///
+  /// \brief Return the maximum angular velocity
+  /// \return The maximum angular velocity
+  ///
+  const utils::Scalar& wmax() const;
+
+  ///
+  /// \brief Return the angular velocity of the concentric asymptote
+  /// \return The angular velocity of the concentric asymptote
+  ///
+  const utils::Scalar& wc() const;
+
+  ///
+  /// \brief Return the maximum activation level
+  /// \return The maximum activation level
+  ///
+  const utils::Scalar& amax() const;
+
+  ///
+  /// \brief Return the low plateau level
+  /// \return The low plateau level
+  ///
+  const utils::Scalar& amin() const;
+
+  ///
+  /// \brief Return the 1/10 of the distance amax/amin
+  /// \return The 1/10 of the distance amax/amin
+  ///
+  const utils::Scalar& wr() const;
+
+  ///
+  /// \brief Return the mid point plateau
+  /// \return The mid point plateau
+  ///
+  const utils::Scalar& w1() const;
+
+  ///
+  /// \brief Return the width of the 1st gaussian curve
+  /// \return The width of the 1st gaussian curve
+  ///
+  const utils::Scalar& r() const;
+
+  ///
+  /// \brief Return the 1st optimal position
+  /// \return The 1st optimal position
+  ///
+  const utils::Scalar& qopt() const;
+
+  ///
+  /// \brief Return the factor of the 2nd gaussian curve
+  /// \return The factor of the 2nd gaussian curve
+  ///
+  const utils::Scalar& facteur() const;
+
+  ///
+  /// \brief Return the width of the 2nd gaussian curve
+  /// \return The width of the 2nd gaussian curve
+  ///
+  const utils::Scalar& r2() const;
+
+  ///
+  /// \brief Return the 2nd optimal position
+  /// \return The 2nd optimal position
+  ///
+  const utils::Scalar& qopt2() const;
+
  protected:
   ///
   /// \brief Set the type of actuator
@@ -90,6 +90,18 @@ class BIORBD_API ActuatorLinear : public Actuator {
   virtual utils::Scalar torqueMax(
       const rigidbody::GeneralizedCoordinates& Q) const;
 
+  ///
+  /// \brief Return the slope of the maximal torque
+  /// \return The slope of the maximal torque
+  ///
+  const utils::Scalar& slope() const;
+
+  ///
+  /// \brief Return the maximal torque at zero
+  /// \return The maximal torque at zero
+  ///
+  const utils::Scalar& torqueAtZero() const;
+
  protected:
   ///
   /// \brief Set the type of actuator
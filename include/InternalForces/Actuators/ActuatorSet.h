@@ -0,0 +1,220 @@
+#ifndef BIORBD_ACTUATORS_ACTUATOR_SET_H
+#define BIORBD_ACTUATORS_ACTUATOR_SET_H
+
+#include "biorbdConfig.h"
+
+#include <memory>
+#include <vector>
+
+#include "InternalForces/Actuators/ActuatorEnums.h"
+#include "Utils/Vector.h"
+
+namespace BIORBD_NAMESPACE {
+namespace internal_forces {
+namespace actuator {
+class Actuator;
+
+///
+/// \brief Contiguous (structure-of-arrays) view of the parameters of a set of
+/// actuators, together with the kernels that evaluate all the actuators of a
+/// given type in a single loop
+///
+/// Each DoF holds two entries, the concentric (positive) actuator at 2 * dof
+/// and the eccentric (negative) actuator at 2 * dof + 1. The parameters are
+/// copied from the actuators when compile() is called. The ActuatorGauss3p
+/// share the kernel of the ActuatorGauss6p with a null second gaussian.
+///
+/// When an activation is provided, both directions are evaluated and the one
+/// matching the sign of the activation is selected afterward (a positive
+/// activation is concentric), so no branch depends on the activation inside
+/// the kernels.
+///
+class BIORBD_API ActuatorSet {
+ public:
+  ///
+  /// \brief Construct an empty actuator set
+  ///
+  ActuatorSet();
+
+  ///
+  /// \brief Construct an actuator set from the actuator pairs of each DoF
+  /// \param actuators The concentric and eccentric actuators of each DoF
+  ///
+  ActuatorSet(
+      const std::vector<
+          std::pair<std::shared_ptr<Actuator>, std::shared_ptr<Actuator>>>&
+          actuators);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~ActuatorSet();
+
+  ///
+  /// \brief Gather the parameters of all the actuators into contiguous arrays
+  /// \param actuators The concentric and eccentric actuators of each DoF
+  ///
+  void compile(
+      const std::vector<
+          std::pair<std::shared_ptr<Actuator>, std::shared_ptr<Actuator>>>&
+          actuators);
+
+  ///
+  /// \brief Return the number of DoF of the compiled actuators
+  /// \return The number of DoF
+  ///
+  size_t nbDof() const;
+
+  ///
+  /// \brief Return the entries (2 * dof + 1 if eccentric) of the actuators of
+  /// a type
+  /// \param type The type of actuator
+  /// \return The entries of the actuators
+  ///
+  /// The GAUSS3P and GAUSS6P actuators share the same list
+  ///
+  const std::vector<size_t>& indices(TYPE type) const;
+
+  ///
+  /// \brief Compute the maximal torques in both directions
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param concentric The concentric maximal torques (output, must be of size
+  /// nbDof)
+  /// \param eccentric The eccentric maximal torques (output, must be of size
+  /// nbDof)
+  ///
+  void computeTorqueMax(
+      const utils::Vector& Q,
+      const utils::Vector& Qdot,
+      utils::Vector& concentric,
+      utils::Vector& eccentric);
+
+  ///
+  /// \brief Compute the maximal torques in the direction of the activations
+  /// \param activation The activations. A positive value is interpreted as
+  /// concentric contraction and negative as eccentric contraction
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param torqueMax The maximal torques (output, must be of size nbDof)
+  ///
+  void computeTorqueMax(
+      const utils::Vector& activation,
+      const utils::Vector& Q,
+      const utils::Vector& Qdot,
+      utils::Vector& torqueMax);
+
+  ///
+  /// \brief Compute the generalized torques
+  /// \param activation The activations. A positive value is interpreted as
+  /// concentric contraction and negative as eccentric contraction
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param tau The generalized torques (output, must be of size nbDof)
+  ///
+  void computeTorques(
+      const utils::Vector& activation,
+      const utils::Vector& Q,
+      const utils::Vector& Qdot,
+      utils::Vector& tau);
+
+  ///
+  /// \brief Compute the generalized torques and their analytic partial
+  /// derivatives
+  /// \param activation The activations. A positive value is interpreted as
+  /// concentric contraction and negative as eccentric contraction
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param tau The generalized torques (output, must be of size nbDof)
+  /// \param dTaudActivation The derivative of each torque with respect to the
+  /// activation of its DoF (output, must be of size nbDof)
+  /// \param dTaudQ The derivative of each torque with respect to the
+  /// generalized coordinate of its DoF (output, must be of size nbDof)
+  /// \param dTaudQdot The derivative of each torque with respect to the
+  /// generalized velocity of its DoF (output, must be of size nbDof)
+  ///
+  /// Each torque only depends on its own DoF, the jacobians are therefore
+  /// diagonal and only their diagonal is returned. The derivatives are the
+  /// one-sided derivatives of the direction selected by the activation.
+  ///
+  void computeTorqueDerivatives(
+      const utils::Vector& activation,
+      const utils::Vector& Q,
+      const utils::Vector& Qdot,
+      utils::Vector& tau,
+      utils::Vector& dTaudActivation,
+      utils::Vector& dTaudQ,
+      utils::Vector& dTaudQdot);
+
+ protected:
+  ///
+  /// \brief Evaluate the maximal torque of every entry
+  /// \param Q The generalized coordinates
+  /// \param speed The generalized velocities seen by the actuators
+  /// \param withDerivatives If the derivatives with respect to the position
+  /// and the speed (in degrees) must be computed
+  ///
+  void computeEntries(
+      const utils::Vector& Q,
+      const utils::Vector& speed,
+      bool withDerivatives);
+
+  ///
+  /// \brief Fill m_speed with Qdot, negated where the activation is negative
+  /// \param activation The activations
+  /// \param Qdot The generalized velocities
+  ///
+  void resignSpeed(const utils::Vector& activation, const utils::Vector& Qdot);
+
+  ///
+  /// \brief Select, for each DoF, the entry matching the sign of the activation
+  /// \param activation The activations
+  /// \param entries The values of each entry
+  /// \param dof The index of the DoF
+  /// \return The value of the selected entry
+  ///
+  utils::Scalar select(
+      const utils::Vector& activation,
+      const utils::Vector& entries,
+      unsigned int dof) const;
+
+  size_t m_nbDof;  ///< Number of DoF
+
+  std::vector<size_t> m_constant;  ///< Entries of the constant actuators
+  std::vector<size_t> m_linear;    ///< Entries of the linear actuators
+  std::vector<size_t> m_gauss;  ///< Entries of the Gauss3p/Gauss6p actuators
+  std::vector<size_t>
+      m_sigmoid;  ///< Entries of the SigmoidGauss3p actuators
+
+  utils::Vector m_Tmax;   ///< Maximal (constant or eccentric) torque
+  utils::Vector m_slope;  ///< Slope of the linear actuators
+  utils::Vector m_torqueAtZero;  ///< Torque at zero of the linear actuators
+  utils::Vector m_Tc;  ///< Concentric asymptote (T0 * wc / wmax)
+  utils::Vector m_C;   ///< Concentric numerator (Tc * (wmax + wc))
+  utils::Vector m_we;  ///< Eccentric asymptote
+  utils::Vector m_E;   ///< Eccentric numerator (-(Tmax - T0) * we)
+  utils::Vector m_wc;  ///< Angular velocity of the concentric asymptote
+  utils::Vector m_amin;  ///< Low plateau level
+  utils::Vector m_amplitude;  ///< amax - amin
+  utils::Vector m_w1;  ///< Mid point plateau
+  utils::Vector m_wr;  ///< 1/10 of the distance amax/amin
+  utils::Vector m_qopt;  ///< (First) optimal position
+  utils::Vector m_r;     ///< Width of the (first) gaussian
+  utils::Vector m_facteur;  ///< Factor of the second gaussian (0 for Gauss3p)
+  utils::Vector m_qopt2;    ///< Second optimal position
+  utils::Vector m_r2;       ///< Width of the second gaussian
+  utils::Vector m_theta;    ///< Amplitude of the sigmoid
+  utils::Vector m_lambda;   ///< Tilt factor of the sigmoid
+  utils::Vector m_offset;   ///< Height of the sigmoid
+
+  utils::Vector m_speed;     ///< Velocity seen by each DoF
+  utils::Vector m_torqueMax;  ///< Maximal torque of each entry
+  utils::Vector m_dTdPos;  ///< Derivative of each entry wrt the position (deg)
+  utils::Vector m_dTdSpeed;  ///< Derivative of each entry wrt the speed (deg)
+};
+
+}  // namespace actuator
+}  // namespace internal_forces
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_ACTUATORS_ACTUATOR_SET_H
@@ -108,6 +108,36 @@ class BIORBD_API ActuatorSigmoidGauss3p : public Actuator {
       const rigidbody::GeneralizedCoordinates& Q,
       const rigidbody::GeneralizedVelocity& Qdot);
 
+  ///
+  /// \brief Return the width of the gaussian curve
+  /// \return The width of the gaussian curve
+  ///
+  const utils::Scalar& r() const;
+
+  ///
+  /// \brief Return the optimal position
+  /// \return The optimal position
+  ///
+  const utils::Scalar& qopt() const;
+
+  ///
+  /// \brief Return the amplitude of the sigmoid
+  /// \return The amplitude of the sigmoid
+  ///
+  const utils::Scalar& theta() const;
+
+  ///
+  /// \brief Return the tilt factor of the sigmoid
+  /// \return The tilt factor of the sigmoid
+  ///
+  const utils::Scalar& lambda() const;
+
+  ///
+  /// \brief Return the height of the sigmoid
+  /// \return The height of the sigmoid
+  ///
+  const utils::Scalar& offset() const;
+
  protected:
   ///
   /// \brief Set the type of actuator
@@ -10,8 +10,9 @@
 
 namespace BIORBD_NAMESPACE {
 namespace utils {
+class Matrix;
 class Vector;
-}
+}  // namespace utils
 
 namespace rigidbody {
 class GeneralizedCoordinates;
@@ -22,6 +23,8 @@ class GeneralizedTorque;
 namespace internal_forces {
 namespace actuator {
 class Actuator;
+class ActuatorSet;
+
 ///
 /// \brief Class holder for a set of actuators
 ///
@@ -101,6 +104,45 @@ class BIORBD_API Actuators {
       const rigidbody::GeneralizedCoordinates& Q,
       const rigidbody::GeneralizedVelocity& Qdot);
 
+  ///
+  /// \brief Compute the generalized torque into a preallocated vector
+  /// \param activation The level of activation of the torque. A positive value
+  /// is interpreted as concentric contraction and negative as eccentric
+  /// contraction
+  /// \param Q The generalized coordinates of the actuators
+  /// \param Qdot The generalized velocities of the actuators
+  /// \param tau The generalized torque (output, must be of size nbActuators)
+  ///
+  void torque(
+      const utils::Vector& activation,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      utils::Vector& tau);
+
+  ///
+  /// \brief Return the analytic jacobians of the generalized torque
+  /// \param activation The level of activation of the torque. A positive value
+  /// is interpreted as concentric contraction and negative as eccentric
+  /// contraction
+  /// \param Q The generalized coordinates of the actuators
+  /// \param Qdot The generalized velocities of the actuators
+  /// \param dTaudActivation The jacobian with respect to the activations
+  /// (output)
+  /// \param dTaudQ The jacobian with respect to the generalized coordinates
+  /// (output)
+  /// \param dTaudQdot The jacobian with respect to the generalized velocities
+  /// (output)
+  ///
+  /// Each actuator only depends on its own DoF, the jacobians are diagonal
+  ///
+  void torqueJacobians(
+      const utils::Vector& activation,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      utils::Matrix& dTaudActivation,
+      utils::Matrix& dTaudQ,
+      utils::Matrix& dTaudQdot);
+
   // Get and set
   ///
   /// \brief Return a specific concentric/eccentric actuator
@@ -131,6 +173,8 @@ class BIORBD_API Actuators {
       m_all;  ///< All the actuators reunited /pair (+ or -)
   std::shared_ptr<std::vector<bool>> m_isDofSet;  ///< If DoF all dof are set
   std::shared_ptr<bool> m_isClose;                ///< If the set is ready
+  std::shared_ptr<ActuatorSet>
+      m_actuatorSet;  ///< The actuators compiled when closing the set
 
   ///
   /// \brief getTorqueMaxDirection Get the max torque of a specific actuator
@@ -7,6 +7,7 @@
 #include "InternalForces/Actuators/ActuatorGauss3p.h"
 #include "InternalForces/Actuators/ActuatorGauss6p.h"
 #include "InternalForces/Actuators/ActuatorLinear.h"
+#include "InternalForces/Actuators/ActuatorSet.h"
 #include "InternalForces/Actuators/ActuatorSigmoidGauss3p.h"
 #include "InternalForces/Actuators/Actuators.h"
 
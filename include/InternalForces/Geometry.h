@@ -24,6 +24,7 @@ class GeneralizedVelocity;
 namespace internal_forces {
 class PathModifiers;
 class Characteristics;
+class WrappingObject;
 
 ///
 /// \brief Class Geometry of the muscle
@@ -109,6 +110,27 @@ class BIORBD_API Geometry {
       utils::Matrix& jacoPointsInGlobal,
       const rigidbody::GeneralizedVelocity* Qdot = nullptr);
 
+  ///
+  /// \brief Updates the position and dynamic elements from points, a length
+  /// and a length jacobian computed elsewhere (e.g. by a PathKinematics table)
+  /// \param pointsInGlobal Position of all the points in global
+  /// \param jacoPointsInGlobal Position of all the Jacobian points in global
+  /// \param lengths The length of all the paths of the table
+  /// \param lengthJacobian The length jacobian of all the paths of the table
+  /// \param idx The row of the path in the table
+  /// \param Qdot The generalized velocities of the joints
+  ///
+  /// The length and its jacobian are copied as they are, they are not
+  /// computed again from the points
+  ///
+  void updateKinematics(
+      std::vector<utils::Vector3d>& pointsInGlobal,
+      utils::Matrix& jacoPointsInGlobal,
+      const utils::Vector& lengths,
+      const utils::Matrix& lengthJacobian,
+      size_t idx,
+      const rigidbody::GeneralizedVelocity* Qdot = nullptr);
+
   ///
   /// \brief Set the origin position in the local reference frame of the muscle
   /// \param position The origin position to set
@@ -207,10 +229,15 @@ class BIORBD_API Geometry {
   /// \brief Actual function that implements the update of the kinematics
   /// \param Qdot The generalized velocities
   /// \param pathModifiers The set of path modifiers
+  /// \param updatedModel The joint model updated to Q (needed for the exact
+  /// jacobian length of wrapped paths)
+  /// \param Q The generalized coordinates
   ///
   void _updateKinematics(
       const rigidbody::GeneralizedVelocity* Qdot,
-      internal_forces::PathModifiers* pathModifiers = nullptr);
+      internal_forces::PathModifiers* pathModifiers = nullptr,
+      rigidbody::Joints* updatedModel = nullptr,
+      const rigidbody::GeneralizedCoordinates* Q = nullptr);
 
   ///
   /// \brief Updates the kinematics and return the position of the origin node
@@ -251,6 +278,29 @@ class BIORBD_API Geometry {
       internal_forces::PathModifiers* pathModifiers = nullptr);
 
   ///
+  /// \brief Return the position in global of the first via point after an
+  /// object (or of the insertion if there is none)
+  /// \param model The joint model
+  /// \param Q The generalized coordinates of the model
+  /// \param pathModifiers The set of path modifiers
+  /// \param idx The index of the object in the path modifiers
+  /// \return The position of the next fixed point in the global reference
+  ///
+  utils::Vector3d nextPointInGlobal(
+      rigidbody::Joints& model,
+      const rigidbody::GeneralizedCoordinates& Q,
+      internal_forces::PathModifiers& pathModifiers,
+      size_t idx);
+
+  ///
+  /// \brief Return the length of the path going through the points in global,
+  /// following the wrapping objects between their two points
+  /// \param pathModifiers The set of path modifiers
+  /// \return The length of the path
+  ///
+  utils::Scalar pathLength(internal_forces::PathModifiers* pathModifiers) const;
+
+
   /// \brief Update the kinematics, compute and return the muscle length
   /// \param characteristics The muscle characteristics
   /// \param pathModifiers The set of path modifiers
@@ -292,8 +342,67 @@ class BIORBD_API Geometry {
   ///
   /// \brief Compute the muscle length jacobian
   ///
+  /// If the path wraps, the jacobian approximates as if the wrapping points
+  /// were fixed on their segment
+  ///
   void computeJacobianLength();
 
+  ///
+  /// \brief Compute the exact muscle length jacobian of a wrapped path
+  /// \param updatedModel The joint model updated to Q
+  /// \param Q The generalized coordinates
+  /// \param pathModifiers The set of path modifiers
+  ///
+  void computeJacobianLength(
+      rigidbody::Joints& updatedModel,
+      const rigidbody::GeneralizedCoordinates& Q,
+      internal_forces::PathModifiers& pathModifiers);
+
+  ///
+  /// \brief Add the contribution of a straight segment to the muscle length
+  /// jacobian
+  /// \param idx The index of the first point of the segment
+  ///
+  void addJacobianLengthOfSegment(size_t idx);
+
+  ///
+  /// \brief Add the contribution of the path going around wrapping objects
+  /// that follow each other to the muscle length jacobian
+  /// \param updatedModel The joint model updated to Q
+  /// \param Q The generalized coordinates
+  /// \param pathModifiers The set of path modifiers
+  /// \param firstObject The index of the first wrapping object
+  /// \param lastObject The index of the last wrapping object
+  /// \param idxBefore The index of the point before the wrapping objects
+  /// \param idxAfter The index of the point after the wrapping objects
+  ///
+  /// With the CasADi backend, only one wrapping object is accepted
+  ///
+  void addJacobianLengthOfWraps(
+      rigidbody::Joints& updatedModel,
+      const rigidbody::GeneralizedCoordinates& Q,
+      internal_forces::PathModifiers& pathModifiers,
+      size_t firstObject,
+      size_t lastObject,
+      size_t idxBefore,
+      size_t idxAfter);
+
+#ifndef BIORBD_USE_CASADI_MATH
+  ///
+  /// \brief Return the jacobian of a point relative to a segment, as seen from
+  /// the reference frame of the segment (expressed in global)
+  /// \param jaco The jacobian of the point
+  /// \param jacoOrigin The 6D jacobian of the origin of the segment (angular
+  /// part first)
+  /// \param r The position of the point relative to the origin of the segment
+  /// \return The relative jacobian
+  ///
+  static utils::Matrix relativeJacobian(
+      const utils::Matrix& jaco,
+      const utils::Matrix& jacoOrigin,
+      const utils::Vector3d& r);
+#endif
+
   // Position des nodes dans le repere local
   std::shared_ptr<utils::Vector3d> m_origin;     ///< Origin node
   std::shared_ptr<utils::Vector3d> m_insertion;  ///< Insertion node
@@ -25,6 +25,7 @@ class Ligaments;
 ///
 class BIORBD_API Ligament : public Compound {
   friend Ligaments;
+  friend class LigamentSet;
 
  public:
   ///
@@ -153,6 +154,40 @@ class BIORBD_API Ligament : public Compound {
       utils::Matrix& jacoPointsInGlobal,
       const rigidbody::GeneralizedVelocity& Qdot);
 
+  ///
+  /// \brief Update by hand the points of the ligament, its length and its
+  /// jacobian from a row of a table (see PathKinematics)
+  /// \param ligamentPointsInGlobal The ligament points
+  /// \param jacoPointsInGlobal The Jacobian matrix of the points
+  /// \param lengths The length of all the paths of the table
+  /// \param lengthJacobian The length jacobian of all the paths of the table
+  /// \param idx The row of the ligament in the table
+  ///
+  void updateOrientations(
+      std::vector<utils::Vector3d>& ligamentPointsInGlobal,
+      utils::Matrix& jacoPointsInGlobal,
+      const utils::Vector& lengths,
+      const utils::Matrix& lengthJacobian,
+      size_t idx);
+
+  ///
+  /// \brief Update by hand the points of the ligament, its length and its
+  /// jacobian from a row of a table (see PathKinematics)
+  /// \param ligamentPointsInGlobal The ligament points
+  /// \param jacoPointsInGlobal The Jacobian matrix of the points
+  /// \param lengths The length of all the paths of the table
+  /// \param lengthJacobian The length jacobian of all the paths of the table
+  /// \param idx The row of the ligament in the table
+  /// \param Qdot The generalized velocities
+  ///
+  void updateOrientations(
+      std::vector<utils::Vector3d>& ligamentPointsInGlobal,
+      utils::Matrix& jacoPointsInGlobal,
+      const utils::Vector& lengths,
+      const utils::Matrix& lengthJacobian,
+      size_t idx,
+      const rigidbody::GeneralizedVelocity& Qdot);
+
   ///
   /// \brief Set the position of all the points attached to the ligament (0
   /// being the origin)
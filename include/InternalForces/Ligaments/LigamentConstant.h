@@ -75,6 +75,12 @@ class BIORBD_API LigamentConstant : public Ligament {
   ///
   void DeepCopy(const LigamentConstant& other);
 
+  ///
+  /// \brief Return the constant force of the ligament
+  /// \return The constant force of the ligament
+  ///
+  const utils::Scalar& constantForce() const;
+
   ///
   /// \brief Compute the Force-length
   ///
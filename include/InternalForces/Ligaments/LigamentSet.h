@@ -0,0 +1,138 @@
+#ifndef BIORBD_LIGAMENTS_LIGAMENT_SET_H
+#define BIORBD_LIGAMENTS_LIGAMENT_SET_H
+
+#include "biorbdConfig.h"
+
+#include <memory>
+#include <vector>
+
+#include "InternalForces/Ligaments/LigamentsEnums.h"
+#include "Utils/Vector.h"
+
+namespace BIORBD_NAMESPACE {
+namespace internal_forces {
+namespace ligaments {
+class Ligament;
+
+///
+/// \brief Contiguous (structure-of-arrays) view of the parameters of a set of
+/// ligaments, together with the kernels that evaluate all the ligaments of a
+/// given type in a single loop
+///
+/// The parameters are copied from the ligaments when compile() is called.
+/// This function must be called again if the characteristics of a ligament
+/// are changed.
+///
+class BIORBD_API LigamentSet {
+ public:
+  ///
+  /// \brief Construct an empty ligament set
+  ///
+  LigamentSet();
+
+  ///
+  /// \brief Construct a ligament set from a set of ligaments
+  /// \param ligaments The ligaments to compile
+  ///
+  LigamentSet(const std::vector<std::shared_ptr<Ligament>>& ligaments);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~LigamentSet();
+
+  ///
+  /// \brief Gather the parameters of all the ligaments into contiguous arrays
+  /// \param ligaments The ligaments to compile
+  ///
+  void compile(const std::vector<std::shared_ptr<Ligament>>& ligaments);
+
+  ///
+  /// \brief Return the number of compiled ligaments
+  /// \return The number of compiled ligaments
+  ///
+  size_t nbLigaments() const;
+
+  ///
+  /// \brief Return the indices of the ligaments of a type
+  /// \param type The type of ligament
+  /// \return The indices of the ligaments
+  ///
+  const std::vector<size_t>& indices(LIGAMENT_TYPE type) const;
+
+  ///
+  /// \brief Gather the lengths and velocities previously computed by the
+  /// geometry of each compiled ligament
+  ///
+  /// Warning: This function assumes that ligaments are already updated (via
+  /// `updateLigaments`)
+  ///
+  void updateKinematics();
+
+  ///
+  /// \brief Return the ligament lengths gathered by updateKinematics
+  /// \return The ligament lengths
+  ///
+  utils::Vector& ligamentLengths();
+
+  ///
+  /// \brief Return the ligament velocities gathered by updateKinematics
+  /// \return The ligament velocities
+  ///
+  utils::Vector& ligamentVelocities();
+
+  ///
+  /// \brief Compute the force of all the ligaments from the lengths and
+  /// velocities gathered by updateKinematics
+  /// \param forces The ligament forces (output, must be of size nbLigaments)
+  ///
+  /// The forces are written back to the ligaments, as their own computation
+  /// would do
+  ///
+  void computeForces(utils::Vector& forces) const;
+
+  ///
+  /// \brief Compute the force of all the ligaments
+  /// \param lengths The ligament lengths
+  /// \param velocities The ligament velocities
+  /// \param forces The ligament forces (output, must be of size nbLigaments)
+  ///
+  /// The force is the spring force of the type of the ligament plus a damping
+  /// force when the ligament lengthens
+  ///
+  void computeForces(
+      const utils::Vector& lengths,
+      const utils::Vector& velocities,
+      utils::Vector& forces) const;
+
+ protected:
+  ///
+  /// \brief Write the forces back to the ligaments
+  /// \param forces The ligament forces
+  ///
+  void scatterForces(const utils::Vector& forces) const;
+
+  std::vector<std::shared_ptr<Ligament>> m_ligaments;  ///< The ligaments
+  std::vector<size_t> m_constant;  ///< Indices of the constant ligaments
+  std::vector<size_t>
+      m_springLinear;  ///< Indices of the linear spring ligaments
+  std::vector<size_t>
+      m_springSecondOrder;  ///< Indices of the second order spring ligaments
+
+  utils::Vector m_force;        ///< Force of each constant ligament
+  utils::Vector m_stiffness;    ///< Stiffness of each spring ligament
+  utils::Vector m_epsilon;      ///< Epsilon of each second order spring
+  utils::Vector m_slackLength;  ///< Slack length of each ligament
+  utils::Vector m_dampingParam;  ///< Damping parameter of each ligament
+  utils::Vector
+      m_maxShorteningSpeed;  ///< Maximal shortening speed of each ligament
+
+  utils::Vector m_lengths;     ///< Lengths gathered by updateKinematics
+  utils::Vector m_velocities;  ///< Velocities gathered by updateKinematics
+};
+
+}  // namespace ligaments
+}  // namespace internal_forces
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_LIGAMENTS_LIGAMENT_SET_H
@@ -22,8 +22,11 @@ class Joints;
 }  // namespace rigidbody
 
 namespace internal_forces {
+class PathKinematics;
+
 namespace ligaments {
 class Ligament;
+class LigamentSet;
 
 ///
 /// \brief Ligament holder
@@ -93,6 +96,25 @@ class BIORBD_API Ligaments {
   ///
   std::vector<utils::String> ligamentNames() const;
 
+  ///
+  /// \brief Gather the parameters of all the ligaments into a contiguous
+  /// ligament set so the forces are computed by the batched kernels
+  ///
+  /// Once compiled, ligamentForces evaluates all the ligaments of a given type
+  /// in a single loop instead of calling each ligament, updateLigaments
+  /// computes all the attachment and via points of all the ligaments in a
+  /// single sweep (see PathKinematics) and ligamentsJointTorque only visits
+  /// the DoFs spanned by each ligament. This function must be called again if
+  /// the characteristics or the attachment points of a ligament are changed.
+  ///
+  void compileLigaments();
+
+  ///
+  /// \brief Return if the ligaments were compiled (see compileLigaments)
+  /// \return If the ligaments were compiled
+  ///
+  bool isLigamentsCompiled() const;
+
   ///
   /// \brief Compute the ligament joint torque
   /// \param F The force vector of all the ligaments
@@ -109,6 +131,16 @@ class BIORBD_API Ligaments {
   ///
   rigidbody::GeneralizedTorque ligamentsJointTorque(const utils::Vector& F);
 
+  ///
+  /// \brief Compute the ligament joint torque into a preallocated vector
+  /// \param F The force vector of all the ligaments
+  /// \param tau The ligament joint torque (output, resized if needed)
+  ///
+  /// Warning: This function assumes that ligaments are already updated (via
+  /// `updateligaments`)
+  ///
+  void ligamentsJointTorque(const utils::Vector& F, utils::Vector& tau);
+
   ///
   /// \brief Compute the ligament joint torque
   /// \param F The force vector of all the ligaments
@@ -278,6 +310,22 @@ class BIORBD_API Ligaments {
       const rigidbody::GeneralizedVelocity& Qdot,
       bool updateLigamentKinematics = true);
 
+  ///
+  /// \brief Compute the ligament forces into a preallocated vector
+  /// \param updatedModel The joint model updated to Q and Qdot
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param forces The ligament forces (output, resized if needed)
+  /// \param updateLigamentKinematics If the kinematics parameters of the
+  /// ligaments should be updated
+  ///
+  void ligamentForces(
+      rigidbody::Joints& updatedModel,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      utils::Vector& forces,
+      bool updateLigamentKinematics = true);
+
   ///
   /// \brief Compute and return the ligament forces
   /// \param Q The generalized coordinates
@@ -377,8 +425,37 @@ class BIORBD_API Ligaments {
       std::vector<utils::Matrix>& jacoPointsInGlobal);
 
  protected:
+  ///
+  /// \brief Return if the point table of the ligaments is filled
+  /// \return If the point table of the ligaments is filled
+  ///
+  bool isLigamentPathsFilled() const;
+
+  ///
+  /// \brief Update all the ligaments from the point table of the compiled
+  /// ligaments. The table is filled if needed.
+  /// \param updatedModel The joint model updated to Q
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities (nullptr to skip the velocities)
+  ///
+  void updateLigamentPaths(
+      rigidbody::Joints& updatedModel,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity* Qdot);
+
+  ///
+  /// \brief Compute the forces of the compiled ligaments from their current
+  /// lengths and velocities
+  /// \param forces The ligament forces (output, of size nbLigaments)
+  ///
+  void compiledLigamentForces(utils::Vector& forces);
+
   std::shared_ptr<std::vector<std::shared_ptr<Ligament>>>
       m_ligaments;  ///< Holder for ligament groups
+  std::shared_ptr<LigamentSet>
+      m_ligamentSet;  ///< Compiled ligament parameters (nullptr if not)
+  std::shared_ptr<PathKinematics>
+      m_ligamentPaths;  ///< Point table of the compiled ligaments
 };
 
 }  // namespace ligaments
@@ -6,6 +6,7 @@
 #include "InternalForces/Ligaments/Ligament.h"
 #include "InternalForces/Ligaments/LigamentCharacteristics.h"
 #include "InternalForces/Ligaments/LigamentConstant.h"
+#include "InternalForces/Ligaments/LigamentSet.h"
 #include "InternalForces/Ligaments/LigamentSpringLinear.h"
 #include "InternalForces/Ligaments/LigamentSpringSecondOrder.h"
 #include "InternalForces/Ligaments/Ligaments.h"
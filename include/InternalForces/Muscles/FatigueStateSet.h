@@ -0,0 +1,168 @@
+#ifndef BIORBD_MUSCLES_FATIGUE_STATE_SET_H
+#define BIORBD_MUSCLES_FATIGUE_STATE_SET_H
+
+#include "biorbdConfig.h"
+
+#include <memory>
+#include <vector>
+
+#include "Utils/Matrix.h"
+#include "Utils/Scalar.h"
+#include "Utils/Vector.h"
+
+namespace BIORBD_NAMESPACE {
+namespace internal_forces {
+namespace muscles {
+class Muscle;
+class FatigueModel;
+
+#ifndef BIORBD_USE_CASADI_MATH
+///
+/// \brief Contiguous (structure-of-arrays) view of the Xia fatigue states of a
+/// set of muscles (see FatigueDynamicStateXia)
+///
+/// The states of all the muscles are stored in a single 3 x nbMuscles matrix
+/// whose rows are the active, fatigued and resting fibers. The fatigue
+/// parameters and the states are copied from the muscles when compile() is
+/// called. Afterward, the states evolve in the matrix only: gatherStates() and
+/// scatterStates() read them from and write them back to the muscles. The
+/// columns of the muscles without a Xia fatigue state are left untouched.
+///
+class BIORBD_API FatigueStateSet {
+ public:
+  ///
+  /// \brief Construct an empty fatigue state set
+  ///
+  FatigueStateSet();
+
+  ///
+  /// \brief Construct a fatigue state set from a set of muscles
+  /// \param muscles The muscles to compile
+  ///
+  FatigueStateSet(const std::vector<std::shared_ptr<Muscle>>& muscles);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~FatigueStateSet();
+
+  ///
+  /// \brief Gather the fatigue parameters and states of all the muscles into
+  /// contiguous arrays
+  /// \param muscles The muscles to compile
+  ///
+  void compile(const std::vector<std::shared_ptr<Muscle>>& muscles);
+
+  ///
+  /// \brief Return the number of compiled muscles
+  /// \return The number of compiled muscles
+  ///
+  size_t nbMuscles() const;
+
+  ///
+  /// \brief Return the indices of the muscles with a Xia fatigue state
+  /// \return The indices of the muscles
+  ///
+  const std::vector<size_t>& indices() const;
+
+  ///
+  /// \brief Return the fatigue states
+  /// \return The active (row 0), fatigued (row 1) and resting (row 2) fibers
+  /// of each muscle
+  ///
+  utils::Matrix& states();
+
+  ///
+  /// \brief Return the fatigue states
+  /// \return The active (row 0), fatigued (row 1) and resting (row 2) fibers
+  /// of each muscle
+  ///
+  const utils::Matrix& states() const;
+
+  ///
+  /// \brief Copy the fatigue states of the muscles into the states matrix
+  ///
+  void gatherStates();
+
+  ///
+  /// \brief Copy the states matrix back into the fatigue states of the muscles
+  ///
+  void scatterStates() const;
+
+  ///
+  /// \brief Compute the time derivative of the fatigue states of all the
+  /// muscles
+  /// \param targetActivations The activations the muscles try to reach
+  /// \param statesDot The time derivative of the states (output)
+  ///
+  void timeDerivativeState(
+      const utils::Vector& targetActivations,
+      utils::Matrix& statesDot) const;
+
+  ///
+  /// \brief Compute the time derivative of some fatigue states
+  /// \param targetActivations The activations the muscles try to reach
+  /// \param states The fatigue states (3 x nbMuscles)
+  /// \param statesDot The time derivative of the states (output)
+  ///
+  void timeDerivativeState(
+      const utils::Vector& targetActivations,
+      const utils::Matrix& states,
+      utils::Matrix& statesDot) const;
+
+  ///
+  /// \brief Advance the states matrix with a constant target
+  /// \param targetActivations The activations the muscles try to reach
+  /// \param timeStep The time step
+  /// \param nbSteps The number of steps
+  ///
+  /// Each step is a backward (implicit) Euler step of the linear dynamics
+  /// selected by the branch of the command at the beginning of the step. It
+  /// is stable for any time step, keeps the fibers positive and the sum of
+  /// the fibers of each muscle is exactly conserved. The muscles are not
+  /// modified, see scatterStates().
+  ///
+  void integrate(
+      const utils::Vector& targetActivations,
+      double timeStep,
+      size_t nbSteps = 1);
+
+  ///
+  /// \brief Advance the states matrix along a sequence of targets
+  /// \param targetActivations The activations the muscles try to reach at
+  /// each step (nbMuscles x nbSteps)
+  /// \param timeStep The time step
+  /// \param activeFibers The active fibers at the end of each step (output,
+  /// nbMuscles x nbSteps, nullptr if not needed)
+  ///
+  void integrate(
+      const utils::Matrix& targetActivations,
+      double timeStep,
+      utils::Matrix* activeFibers = nullptr);
+
+ protected:
+  ///
+  /// \brief Advance the states matrix of one implicit Euler step
+  /// \param targetActivations The activations the muscles try to reach
+  /// \param timeStep The time step
+  ///
+  void integrateStep(const utils::Vector& targetActivations, double timeStep);
+
+  std::vector<std::shared_ptr<Muscle>> m_muscles;  ///< The compiled muscles
+  std::vector<size_t> m_xia;  ///< Indices of the Xia fatigable muscles
+  std::vector<std::shared_ptr<FatigueModel>>
+      m_fatigueModel;  ///< The fatigue model of each Xia fatigable muscle
+
+  utils::Vector m_fatigueRate;     ///< Fatigue rate of each muscle
+  utils::Vector m_recoveryRate;    ///< Recovery rate of each muscle
+  utils::Vector m_developFactor;   ///< Develop factor of each muscle
+  utils::Vector m_recoveryFactor;  ///< Recovery factor of each muscle
+  utils::Matrix m_states;  ///< Active, fatigued and resting fibers
+};
+#endif
+
+}  // namespace muscles
+}  // namespace internal_forces
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_MUSCLES_FATIGUE_STATE_SET_H
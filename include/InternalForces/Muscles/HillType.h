@@ -10,6 +10,8 @@ namespace BIORBD_NAMESPACE {
 namespace internal_forces {
 namespace muscles {
 class MuscleGeometry;
+class MuscleParameterSet;
+
 ///
 /// \brief Base class for all HillType muscles
 ///
@@ -24,6 +26,8 @@ class MuscleGeometry;
 /// - \f$damping = 0.1\f$
 ///
 class BIORBD_API HillType : public Muscle {
+  friend MuscleParameterSet;
+
  public:
   ///
   /// \brief Contruct a Hill-type muscle
@@ -20,12 +20,14 @@ namespace muscles {
 class Characteristics;
 class State;
 class Muscles;
+class MuscleParameterSet;
 
 ///
 /// \brief Base class of all muscle
 ///
 class BIORBD_API Muscle : public Compound {
   friend Muscles;
+  friend MuscleParameterSet;
 
  public:
   ///
@@ -194,6 +196,94 @@ class BIORBD_API Muscle : public Compound {
       utils::Matrix& jacoPointsInGlobal,
       const rigidbody::GeneralizedVelocity& Qdot);
 
+  ///
+  /// \brief Update by hand the length of the muscle and its jacobian
+  /// \param musculoTendonLength The musculotendon length
+  /// \param jacobianLength The musculotendon length jacobian
+  ///
+  /// The points of the muscle are not updated
+  ///
+  void updateOrientations(
+      const utils::Scalar& musculoTendonLength,
+      const utils::Matrix& jacobianLength);
+
+  ///
+  /// \brief Update by hand the length of the muscle and its jacobian
+  /// \param musculoTendonLength The musculotendon length
+  /// \param jacobianLength The musculotendon length jacobian
+  /// \param Qdot The generalized velocities
+  ///
+  /// The points of the muscle are not updated
+  ///
+  void updateOrientations(
+      const utils::Scalar& musculoTendonLength,
+      const utils::Matrix& jacobianLength,
+      const rigidbody::GeneralizedVelocity& Qdot);
+
+  ///
+  /// \brief Update by hand the length of the muscle and its jacobian from a
+  /// row of lengths and length jacobian (e.g. of a surrogate)
+  /// \param lengths The musculotendon length of all the muscles
+  /// \param lengthJacobian The length jacobian of all the muscles
+  /// \param idx The row of the muscle
+  ///
+  /// The points of the muscle are not updated
+  ///
+  void updateOrientations(
+      const utils::Vector& lengths,
+      const utils::Matrix& lengthJacobian,
+      size_t idx);
+
+  ///
+  /// \brief Update by hand the length of the muscle and its jacobian from a
+  /// row of lengths and length jacobian (e.g. of a surrogate)
+  /// \param lengths The musculotendon length of all the muscles
+  /// \param lengthJacobian The length jacobian of all the muscles
+  /// \param idx The row of the muscle
+  /// \param Qdot The generalized velocities
+  ///
+  /// The points of the muscle are not updated
+  ///
+  void updateOrientations(
+      const utils::Vector& lengths,
+      const utils::Matrix& lengthJacobian,
+      size_t idx,
+      const rigidbody::GeneralizedVelocity& Qdot);
+
+  ///
+  /// \brief Update by hand the points of the muscle, its length and its
+  /// jacobian from a row of a table (see PathKinematics)
+  /// \param musclePointsInGlobal The muscle points
+  /// \param jacoPointsInGlobal The Jacobian matrix of the points
+  /// \param lengths The musculotendon length of all the paths of the table
+  /// \param lengthJacobian The length jacobian of all the paths of the table
+  /// \param idx The row of the muscle in the table
+  ///
+  void updateOrientations(
+      std::vector<utils::Vector3d>& musclePointsInGlobal,
+      utils::Matrix& jacoPointsInGlobal,
+      const utils::Vector& lengths,
+      const utils::Matrix& lengthJacobian,
+      size_t idx);
+
+  ///
+  /// \brief Update by hand the points of the muscle, its length and its
+  /// jacobian from a row of a table (see PathKinematics)
+  /// \param musclePointsInGlobal The muscle points
+  /// \param jacoPointsInGlobal The Jacobian matrix of the points
+  /// \param lengths The musculotendon length of all the paths of the table
+  /// \param lengthJacobian The length jacobian of all the paths of the table
+  /// \param idx The row of the muscle in the table
+  /// \param Qdot The generalized velocities
+  ///
+  void updateOrientations(
+      std::vector<utils::Vector3d>& musclePointsInGlobal,
+      utils::Matrix& jacoPointsInGlobal,
+      const utils::Vector& lengths,
+      const utils::Matrix& lengthJacobian,
+      size_t idx,
+      const rigidbody::GeneralizedVelocity& Qdot);
+
   ///
   /// \brief Set the position of all the points attached to the muscle (0 being
   /// the origin)
@@ -0,0 +1,131 @@
+#ifndef BIORBD_MUSCLES_MUSCLE_CURVE_TABLE_H
+#define BIORBD_MUSCLES_MUSCLE_CURVE_TABLE_H
+
+#include "biorbdConfig.h"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace BIORBD_NAMESPACE {
+namespace internal_forces {
+namespace muscles {
+
+///
+/// \brief Lookup table of a normalized muscle curve (force-length or
+/// force-velocity) evaluated by cubic Hermite interpolation
+///
+/// The curve is sampled once on a uniform grid, storing its value and its
+/// derivatives at each node. Between two nodes, the interpolant is the cubic
+/// polynomial matching the values and the derivatives at both ends, so the
+/// interpolated curve and its first derivative are continuous. The left and
+/// right derivatives are stored separately so a kink of the curve located on
+/// a node (e.g. the start of the passive force-length curve) is reproduced
+/// exactly. Outside of the grid, the analytic curve is evaluated.
+///
+/// The accuracy of the table is measured against the analytic curve at
+/// construction (see maxError and maxDerivativeError).
+///
+class BIORBD_API MuscleCurveTable {
+ public:
+  ///
+  /// \brief The analytic curve: computes the value, the left derivative and
+  /// the right derivative at x
+  ///
+  typedef std::function<void(double, double&, double&, double&)> Curve;
+
+  ///
+  /// \brief Construct an empty table
+  ///
+  MuscleCurveTable();
+
+  ///
+  /// \brief Construct the table of a curve
+  /// \param curve The analytic curve
+  /// \param xMin The lower bound of the grid
+  /// \param xMax The upper bound of the grid
+  /// \param nbIntervals The number of intervals of the grid
+  ///
+  MuscleCurveTable(
+      const Curve& curve,
+      double xMin,
+      double xMax,
+      size_t nbIntervals);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~MuscleCurveTable();
+
+  ///
+  /// \brief Return the lower bound of the grid
+  /// \return The lower bound of the grid
+  ///
+  double xMin() const;
+
+  ///
+  /// \brief Return the upper bound of the grid
+  /// \return The upper bound of the grid
+  ///
+  double xMax() const;
+
+  ///
+  /// \brief Return the number of intervals of the grid
+  /// \return The number of intervals of the grid
+  ///
+  size_t nbIntervals() const;
+
+  ///
+  /// \brief Return the largest error of the interpolated values against the
+  /// analytic curve, observed inside the intervals
+  /// \return The largest error on the values
+  ///
+  double maxError() const;
+
+  ///
+  /// \brief Return the largest error of the interpolated derivatives against
+  /// the analytic curve, observed inside the intervals
+  /// \return The largest error on the derivatives
+  ///
+  double maxDerivativeError() const;
+
+  ///
+  /// \brief Evaluate the curve
+  /// \param x The point of evaluation
+  /// \return The value of the curve
+  ///
+  double value(double x) const;
+
+  ///
+  /// \brief Evaluate the curve and its derivative
+  /// \param x The point of evaluation
+  /// \param derivative The derivative of the curve (output)
+  /// \return The value of the curve
+  ///
+  double value(double x, double& derivative) const;
+
+ protected:
+  ///
+  /// \brief Find the interval of a point of the grid
+  /// \param x The point (inside the grid)
+  /// \param s The position of the point in the interval, from 0 to 1 (output)
+  /// \return The index of the interval
+  ///
+  size_t interval(double x, double& s) const;
+
+  Curve m_curve;  ///< The analytic curve
+  double m_xMin;  ///< Lower bound of the grid
+  double m_xMax;  ///< Upper bound of the grid
+  double m_step;  ///< Width of the intervals
+  size_t m_nbIntervals;  ///< Number of intervals
+  std::vector<double>
+      m_coefficients;  ///< Coefficients of the cubic of each interval
+  double m_maxError;  ///< Largest error on the values
+  double m_maxDerivativeError;  ///< Largest error on the derivatives
+};
+
+}  // namespace muscles
+}  // namespace internal_forces
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_MUSCLES_MUSCLE_CURVE_TABLE_H
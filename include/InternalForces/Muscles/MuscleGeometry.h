@@ -117,6 +117,64 @@ class BIORBD_API MuscleGeometry : public Geometry {
       const Characteristics& characteristics,
       const rigidbody::GeneralizedVelocity* Qdot = nullptr);
 
+  ///
+  /// \brief Updates the length and dynamic elements of the muscles from a
+  /// length and a length jacobian computed elsewhere (e.g. by a surrogate)
+  /// \param musculoTendonLength The musculotendon length
+  /// \param jacobianLength The musculotendon length jacobian
+  /// \param characteristics The muscle characteristics
+  /// \param Qdot The generalized velocities of the joints
+  ///
+  /// The points of the muscle are not updated
+  ///
+  void updateKinematics(
+      const utils::Scalar& musculoTendonLength,
+      const utils::Matrix& jacobianLength,
+      const Characteristics& characteristics,
+      const rigidbody::GeneralizedVelocity* Qdot = nullptr);
+
+  ///
+  /// \brief Updates the length and dynamic elements of the muscles from a row
+  /// of lengths and length jacobian computed elsewhere (e.g. by a surrogate)
+  /// \param lengths The musculotendon length of all the muscles
+  /// \param lengthJacobian The length jacobian of all the muscles
+  /// \param idx The row of the muscle
+  /// \param characteristics The muscle characteristics
+  /// \param Qdot The generalized velocities of the joints
+  ///
+  /// The points of the muscle are not updated
+  ///
+  void updateKinematics(
+      const utils::Vector& lengths,
+      const utils::Matrix& lengthJacobian,
+      size_t idx,
+      const Characteristics& characteristics,
+      const rigidbody::GeneralizedVelocity* Qdot = nullptr);
+
+  ///
+  /// \brief Updates the position and dynamic elements of the muscles from
+  /// points, a length and a length jacobian computed elsewhere (e.g. by a
+  /// PathKinematics table)
+  /// \param musclePointsInGlobal Position of all the points in global
+  /// \param jacoPointsInGlobal Position of all the Jacobian points in global
+  /// \param lengths The musculotendon length of all the paths of the table
+  /// \param lengthJacobian The length jacobian of all the paths of the table
+  /// \param idx The row of the muscle in the table
+  /// \param characteristics The muscle characteristics
+  /// \param Qdot The generalized velocities of the joints
+  ///
+  /// The length and its jacobian are copied as they are, they are not
+  /// computed again from the points
+  ///
+  void updateKinematics(
+      std::vector<utils::Vector3d>& musclePointsInGlobal,
+      utils::Matrix& jacoPointsInGlobal,
+      const utils::Vector& lengths,
+      const utils::Matrix& lengthJacobian,
+      size_t idx,
+      const Characteristics& characteristics,
+      const rigidbody::GeneralizedVelocity* Qdot = nullptr);
+
   ///
   /// \brief Return the previously computed muscle length
   /// \return The muscle lengh
@@ -134,11 +192,26 @@ class BIORBD_API MuscleGeometry : public Geometry {
   /// \brief Actual function that implements the update of the kinematics
   /// \param Qdot The generalized velocities
   /// \param pathModifiers The set of path modifiers
+  /// \param updatedModel The joint model updated to Q (needed for the exact
+  /// jacobian length of wrapped paths)
+  /// \param Q The generalized coordinates
   ///
   void _updateKinematics(
       const rigidbody::GeneralizedVelocity* Qdot,
       const Characteristics* characteristics,
-      internal_forces::PathModifiers* pathModifiers = nullptr);
+      internal_forces::PathModifiers* pathModifiers = nullptr,
+      rigidbody::Joints* updatedModel = nullptr,
+      const rigidbody::GeneralizedCoordinates* Q = nullptr);
+
+  ///
+  /// \brief Complete an update for which the musculotendon length and its
+  /// jacobian were given
+  /// \param characteristics The muscle characteristics
+  /// \param Qdot The generalized velocities
+  ///
+  void _updateKinematicsFromLength(
+      const Characteristics& characteristics,
+      const rigidbody::GeneralizedVelocity* Qdot);
 
   ///
   /// \brief Update the kinematics, compute and return the muscle length
@@ -0,0 +1,223 @@
+#ifndef BIORBD_MUSCLES_MUSCLE_LENGTH_SURROGATE_H
+#define BIORBD_MUSCLES_MUSCLE_LENGTH_SURROGATE_H
+
+#include "biorbdConfig.h"
+
+#include <vector>
+
+#include "Utils/Matrix.h"
+#include "Utils/Scalar.h"
+#include "Utils/String.h"
+#include "Utils/Vector.h"
+
+namespace BIORBD_NAMESPACE {
+namespace utils {
+class Path;
+}
+
+namespace rigidbody {
+class Joints;
+class GeneralizedCoordinates;
+}  // namespace rigidbody
+
+namespace internal_forces {
+namespace muscles {
+class Muscles;
+
+///
+/// \brief Polynomial approximation of the musculotendon lengths and of their
+/// jacobian as a function of the generalized coordinates
+///
+/// The length of each muscle is approximated by a polynomial of the
+/// generalized coordinates it spans (the ones its length depends on). The
+/// polynomials are sums of products of Chebyshev polynomials of total degree
+/// lower or equal to a given degree, the coordinates being normalized to
+/// [-1, 1] over the ranges of the segments. They are fitted offline by least
+/// squares on the lengths and on the length jacobian of the full geometry,
+/// sampled randomly within the ranges. The jacobian is the analytical
+/// derivative of the polynomials.
+///
+/// The number of terms grows quickly with the number of spanned coordinates,
+/// the degree should be lowered for muscles spanning many coordinates. The
+/// fitting requires the Eigen backend, the evaluation is available for both.
+/// This is not available for models with quaternions.
+///
+class BIORBD_API MuscleLengthSurrogate {
+ public:
+  ///
+  /// \brief Construct an empty surrogate
+  ///
+  MuscleLengthSurrogate();
+
+  ///
+  /// \brief Construct a surrogate from a file previously written (see write)
+  /// \param path The path of the file
+  ///
+  MuscleLengthSurrogate(const utils::Path& path);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~MuscleLengthSurrogate();
+
+#ifndef BIORBD_USE_CASADI_MATH
+  ///
+  /// \brief Fit the polynomials on the full geometry of the muscles
+  /// \param model The joint model (the ranges of its segments are used)
+  /// \param muscles The muscles to approximate (they must not use a
+  /// surrogate)
+  /// \param degree The maximal total degree of the polynomials
+  /// \param nbSamples The number of fitting samples (0 to choose it from the
+  /// number of terms of the polynomials)
+  /// \param seed The seed of the random sampling
+  ///
+  /// Another set of half as many samples is used to measure the errors of the
+  /// fit (see validationMaxLengthError and validationMaxJacobianError)
+  ///
+  void fit(
+      rigidbody::Joints& model,
+      Muscles& muscles,
+      size_t degree = 4,
+      size_t nbSamples = 0,
+      unsigned int seed = 0);
+#endif
+
+  ///
+  /// \brief Write the surrogate into a file
+  /// \param path The path of the file
+  ///
+  void write(const utils::Path& path) const;
+
+  ///
+  /// \brief Read the surrogate from a file previously written (see write)
+  /// \param path The path of the file
+  ///
+  void read(const utils::Path& path);
+
+  ///
+  /// \brief Return the number of approximated muscles
+  /// \return The number of approximated muscles
+  ///
+  size_t nbMuscles() const;
+
+  ///
+  /// \brief Return the number of degrees of freedom of the model
+  /// \return The number of degrees of freedom
+  ///
+  size_t nbDof() const;
+
+  ///
+  /// \brief Return the maximal total degree of the polynomials
+  /// \return The maximal total degree of the polynomials
+  ///
+  size_t degree() const;
+
+  ///
+  /// \brief Return the name of a muscle
+  /// \param idx The index of the muscle
+  /// \return The name of the muscle
+  ///
+  const utils::String& muscleName(size_t idx) const;
+
+  ///
+  /// \brief Return the generalized coordinates spanned by a muscle
+  /// \param idx The index of the muscle
+  /// \return The indices of the spanned generalized coordinates
+  ///
+  const std::vector<size_t>& spannedDofs(size_t idx) const;
+
+  ///
+  /// \brief Return the largest error on the length of a muscle observed on
+  /// the validation samples
+  /// \param idx The index of the muscle
+  /// \return The largest error on the length
+  ///
+  /// This is an estimate, not a bound: the error can be larger between the
+  /// samples
+  ///
+  double validationMaxLengthError(size_t idx) const;
+
+  ///
+  /// \brief Return the largest error on the length jacobian of a muscle
+  /// observed on the validation samples
+  /// \param idx The index of the muscle
+  /// \return The largest error on the elements of the jacobian
+  ///
+  /// This is an estimate, not a bound: the error can be larger between the
+  /// samples
+  ///
+  double validationMaxJacobianError(size_t idx) const;
+
+  ///
+  /// \brief Evaluate the lengths and the length jacobian of all the muscles
+  /// \param Q The generalized coordinates
+  ///
+  void update(const rigidbody::GeneralizedCoordinates& Q);
+
+  ///
+  /// \brief Return the musculotendon lengths of the last update
+  /// \return The musculotendon lengths
+  ///
+  const utils::Vector& lengths() const;
+
+  ///
+  /// \brief Return the musculotendon length jacobian of the last update
+  /// \return The length jacobian (nbMuscles x nbDof)
+  ///
+  const utils::Matrix& lengthJacobian() const;
+
+ protected:
+  ///
+  /// \brief Set the number of terms and allocate the buffers of a muscle from
+  /// its spanned generalized coordinates
+  /// \param idx The index of the muscle
+  ///
+  void setTerms(size_t idx);
+
+  ///
+  /// \brief Allocate the outputs once all the muscles are set
+  ///
+  void allocate();
+
+  ///
+  /// \brief Evaluate the terms of the polynomial of a muscle and their
+  /// derivatives with respect to the normalized coordinates
+  /// \param idx The index of the muscle
+  /// \param Q The generalized coordinates
+  ///
+  void evaluateTerms(size_t idx, const rigidbody::GeneralizedCoordinates& Q);
+
+  size_t m_nbDof;  ///< Number of degrees of freedom of the model
+  size_t m_degree;  ///< Maximal total degree of the polynomials
+  std::vector<utils::String> m_names;  ///< Names of the muscles
+  std::vector<std::vector<size_t>>
+      m_dofs;  ///< Spanned generalized coordinates of each muscle
+  std::vector<std::vector<double>>
+      m_center;  ///< Center of the range of the spanned coordinates
+  std::vector<std::vector<double>>
+      m_halfRange;  ///< Half of the range of the spanned coordinates
+  std::vector<std::vector<unsigned int>>
+      m_exponents;  ///< Degree of each coordinate in each term (term major)
+  std::vector<std::vector<double>>
+      m_coefficients;  ///< Coefficient of each term
+  std::vector<double>
+      m_lengthError;  ///< Largest validation error on the lengths
+  std::vector<double>
+      m_jacobianError;  ///< Largest validation error on the jacobian
+
+  std::vector<utils::Matrix>
+      m_chebyshev;  ///< Chebyshev polynomials of each coordinate (buffer)
+  std::vector<utils::Matrix>
+      m_chebyshevDerivative;  ///< Their derivatives (buffer)
+  std::vector<utils::Vector> m_terms;  ///< Terms of the polynomial (buffer)
+  std::vector<utils::Matrix>
+      m_termsDerivative;  ///< Derivative of the terms (buffer)
+  utils::Vector m_lengths;  ///< Musculotendon lengths of the last update
+  utils::Matrix m_lengthJacobian;  ///< Length jacobian of the last update
+};
+
+}  // namespace muscles
+}  // namespace internal_forces
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_MUSCLES_MUSCLE_LENGTH_SURROGATE_H
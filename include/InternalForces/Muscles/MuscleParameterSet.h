@@ -0,0 +1,506 @@
+#ifndef BIORBD_MUSCLES_MUSCLE_PARAMETER_SET_H
+#define BIORBD_MUSCLES_MUSCLE_PARAMETER_SET_H
+
+#include "biorbdConfig.h"
+
+#include <memory>
+#include <vector>
+
+#include "InternalForces/Muscles/MusclesEnums.h"
+#include "Utils/Scalar.h"
+#include "Utils/Vector.h"
+
+namespace BIORBD_NAMESPACE {
+namespace internal_forces {
+namespace muscles {
+class Muscle;
+class HillType;
+class FatigueModel;
+class MuscleCurveTable;
+
+///
+/// \brief Contiguous (structure-of-arrays) view of the parameters of a set of
+/// muscles, together with the force kernels that evaluate all the muscles of a
+/// given type in a single loop
+///
+/// The parameters are copied from the muscles when compile() is called. If the
+/// characteristics of a muscle are changed afterward, compile() must be called
+/// again for the changes to be taken into account. The fatigue states are not
+/// copied, they are read when the forces are computed.
+///
+/// The terms shared by all the muscles are combined in loops over contiguous
+/// arrays. The curves specific to a formulation loop over the index list of
+/// their type (see indices), so they are gathered rather than contiguous.
+/// The forces computed by computeForces are written back to the muscles, so
+/// Muscle::force() and the elements of the Hill-type muscles (e.g.
+/// HillType::FlCE) return the values of the last call.
+///
+class BIORBD_API MuscleParameterSet {
+ public:
+  ///
+  /// \brief Construct an empty muscle parameter set
+  ///
+  MuscleParameterSet();
+
+  ///
+  /// \brief Construct a muscle parameter set from a set of muscles
+  /// \param muscles The muscles to compile
+  ///
+  MuscleParameterSet(const std::vector<std::shared_ptr<Muscle>>& muscles);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~MuscleParameterSet();
+
+  ///
+  /// \brief Gather the parameters of all the muscles into contiguous arrays
+  /// \param muscles The muscles to compile
+  ///
+  void compile(const std::vector<std::shared_ptr<Muscle>>& muscles);
+
+  ///
+  /// \brief Return the number of compiled muscles
+  /// \return The number of compiled muscles
+  ///
+  size_t nbMuscles() const;
+
+  ///
+  /// \brief Return the type of a compiled muscle
+  /// \param idx The index of the muscle
+  /// \return The type of the muscle
+  ///
+  MUSCLE_TYPE type(size_t idx) const;
+
+  ///
+  /// \brief Return the indices of the muscles that share a force-length and
+  /// force-velocity formulation
+  /// \param type HILL, HILL_THELEN, HILL_DE_GROOTE or IDEALIZED_ACTUATOR
+  /// \return The indices of the muscles
+  ///
+  /// The ActiveOnly and Fatigable variants are listed with their parent type
+  ///
+  const std::vector<size_t>& indices(MUSCLE_TYPE type) const;
+
+  ///
+  /// \brief Return the indices of the muscles that share a state type
+  /// \param type SIMPLE_STATE, DYNAMIC, BUCHANAN or DE_GROOTE
+  /// \return The indices of the muscles
+  ///
+  const std::vector<size_t>& stateIndices(STATE_TYPE type) const;
+
+  ///
+  /// \brief Return the optimal lengths of the muscles
+  /// \return The optimal lengths of the muscles
+  ///
+  const utils::Vector& optimalLength() const;
+
+  ///
+  /// \brief Return the maximal isometric forces of the muscles
+  /// \return The maximal isometric forces of the muscles
+  ///
+  const utils::Vector& forceIsoMax() const;
+
+  ///
+  /// \brief Return the tendon slack lengths of the muscles
+  /// \return The tendon slack lengths of the muscles
+  ///
+  const utils::Vector& tendonSlackLength() const;
+
+  ///
+  /// \brief Return the cosines of the pennation angles of the muscles
+  /// \return The cosines of the pennation angles of the muscles
+  ///
+  const utils::Vector& cosPennationAngle() const;
+
+  ///
+  /// \brief Return the maximal shortening speeds of the muscles
+  /// \return The maximal shortening speeds of the muscles
+  ///
+  const utils::Vector& maxShorteningSpeed() const;
+
+  ///
+  /// \brief Evaluate the force-length and force-velocity curves of the
+  /// HillThelenType and HillDeGrooteType muscles from lookup tables instead of
+  /// the analytic formulas
+  /// \param use If the tables are used
+  /// \param nbIntervals The number of intervals of each table (must be even)
+  ///
+  /// The normalized curves are tabulated once, the lengths from 0 to 2 optimal
+  /// lengths and the velocities from -1 to 1 maximal shortening speed. They
+  /// are evaluated by cubic Hermite interpolation (see MuscleCurveTable),
+  /// including by computeForceDerivatives which then returns the derivatives
+  /// of the interpolated curves. Outside of these ranges the analytic curves
+  /// are used. The HillType curves depend on the activation and are always
+  /// analytic. This is not available with CasADi.
+  ///
+  void useCurveTables(bool use, size_t nbIntervals = 1000);
+
+  ///
+  /// \brief Return if the curves are evaluated from lookup tables
+  /// \return If the curves are evaluated from lookup tables
+  ///
+  bool isCurveTablesUsed() const;
+
+  ///
+  /// \brief Return the lookup table of a curve
+  /// \param type HILL_THELEN or HILL_DE_GROOTE
+  /// \param curve The curve
+  /// \return The lookup table of the curve
+  ///
+  const MuscleCurveTable& curveTable(MUSCLE_TYPE type, MUSCLE_CURVE curve)
+      const;
+
+  ///
+  /// \brief Return the largest error of the tabulated curves against the
+  /// analytic ones (see MuscleCurveTable::maxError)
+  /// \return The largest error on the normalized curves
+  ///
+  double curveTablesMaxError() const;
+
+  ///
+  /// \brief Compute the muscle lengths from the musculotendon lengths
+  /// \param musculoTendonLengths The musculotendon lengths
+  /// \param muscleLengths The muscle lengths (output)
+  ///
+  /// The tendon is rigid: \f$l_m = (l_{mt} - l_{ts}) / \cos(\alpha)\f$
+  ///
+  void computeMuscleLengths(
+      const utils::Vector& musculoTendonLengths,
+      utils::Vector& muscleLengths) const;
+
+  ///
+  /// \brief Gather the lengths and velocities previously computed by the
+  /// geometry of each compiled muscle
+  ///
+  /// Warning: This function assumes that muscles are already updated (via
+  /// `updateMuscles`) with the generalized velocities
+  ///
+  void updateKinematics();
+
+  ///
+  /// \brief Return the muscle lengths gathered by updateKinematics
+  /// \return The muscle lengths
+  ///
+  utils::Vector& muscleLengths();
+
+  ///
+  /// \brief Return the muscle velocities gathered by updateKinematics
+  /// \return The muscle velocities
+  ///
+  utils::Vector& muscleVelocities();
+
+  ///
+  /// \brief Compute the force of all the muscles from the lengths and
+  /// velocities gathered by updateKinematics
+  /// \param activations The activations of the muscles
+  /// \param forces The muscle forces (output)
+  ///
+  void computeForces(const utils::Vector& activations, utils::Vector& forces);
+
+  ///
+  /// \brief Compute the force of all the muscles
+  /// \param activations The activations of the muscles
+  /// \param muscleLengths The muscle lengths
+  /// \param muscleVelocities The muscle velocities
+  /// \param forces The muscle forces (output)
+  ///
+  /// The activations are bounded to [0, 1] as in State::setActivation (not
+  /// with CasADi, where they are used as they are).
+  ///
+  void computeForces(
+      const utils::Vector& activations,
+      const utils::Vector& muscleLengths,
+      const utils::Vector& muscleVelocities,
+      utils::Vector& forces);
+
+  ///
+  /// \brief Compute the partial derivatives of the force of all the muscles
+  /// from the lengths and velocities gathered by updateKinematics
+  /// \param activations The activations of the muscles
+  /// \param dFdActivations The derivative of the forces with respect to the
+  /// activations (output)
+  /// \param dFdLengths The derivative of the forces with respect to the
+  /// muscle lengths (output)
+  /// \param dFdVelocities The derivative of the forces with respect to the
+  /// muscle velocities (output)
+  ///
+  void computeForceDerivatives(
+      const utils::Vector& activations,
+      utils::Vector& dFdActivations,
+      utils::Vector& dFdLengths,
+      utils::Vector& dFdVelocities);
+
+  ///
+  /// \brief Compute the partial derivatives of the force of all the muscles
+  /// \param activations The activations of the muscles
+  /// \param muscleLengths The muscle lengths
+  /// \param muscleVelocities The muscle velocities
+  /// \param dFdActivations The derivative of the forces with respect to the
+  /// activations (output)
+  /// \param dFdLengths The derivative of the forces with respect to the
+  /// muscle lengths (output)
+  /// \param dFdVelocities The derivative of the forces with respect to the
+  /// muscle velocities (output)
+  ///
+  /// The derivatives are analytical. At the branching points of the
+  /// formulations (e.g. the sign of the velocity), the derivative of the
+  /// branch used by computeForces is returned.
+  ///
+  void computeForceDerivatives(
+      const utils::Vector& activations,
+      const utils::Vector& muscleLengths,
+      const utils::Vector& muscleVelocities,
+      utils::Vector& dFdActivations,
+      utils::Vector& dFdLengths,
+      utils::Vector& dFdVelocities);
+
+  ///
+  /// \brief Compute the second derivative of the force of all the muscles
+  /// with respect to their activation, from the lengths and velocities
+  /// gathered by updateKinematics
+  /// \param activations The activations of the muscles
+  /// \param d2FdActivations2 The second derivative of the forces with respect
+  /// to the activations (output)
+  ///
+  void computeForceActivationSecondDerivatives(
+      const utils::Vector& activations,
+      utils::Vector& d2FdActivations2);
+
+  ///
+  /// \brief Compute the second derivative of the force of all the muscles
+  /// with respect to their activation
+  /// \param activations The activations of the muscles
+  /// \param muscleLengths The muscle lengths
+  /// \param muscleVelocities The muscle velocities
+  /// \param d2FdActivations2 The second derivative of the forces with respect
+  /// to the activations (output)
+  ///
+  /// Only the force-length of the HillType muscles depends on the activation,
+  /// the forces of the other muscles are linear in the activation and their
+  /// second derivative is zero.
+  ///
+  void computeForceActivationSecondDerivatives(
+      const utils::Vector& activations,
+      const utils::Vector& muscleLengths,
+      const utils::Vector& muscleVelocities,
+      utils::Vector& d2FdActivations2);
+
+  ///
+  /// \brief Compute the time derivative of the activation of all the muscles
+  /// \param excitations The excitations of the muscles
+  /// \param activations The activations of the muscles
+  /// \param activationsDot The time derivative of the activations (output)
+  /// \param alreadyNormalized If the excitations are already normalized
+  ///
+  /// The time constants are copied from the characteristics by compile. The
+  /// muscles with a DYNAMIC state follow the first-order dynamics of
+  /// StateDynamics and the ones with a DE_GROOTE state its tanh-smoothed
+  /// version. The BUCHANAN states use the first-order dynamics as well, which
+  /// is their excitation dynamics (see
+  /// StateDynamicsBuchanan::timeDerivativeExcitation) when the neural commands
+  /// are sent as excitations and the excitations as activations. The states
+  /// of the muscles are not modified.
+  ///
+  void computeActivationsDot(
+      const utils::Vector& excitations,
+      const utils::Vector& activations,
+      utils::Vector& activationsDot,
+      bool alreadyNormalized = true) const;
+
+  ///
+  /// \brief Compute the time derivative of the activation of all the muscles
+  /// and its derivative with respect to the excitations
+  /// \param excitations The excitations of the muscles
+  /// \param activations The activations of the muscles
+  /// \param activationsDot The time derivative of the activations (output)
+  /// \param dActivationsDotdExcitations The derivative of the time derivative
+  /// of the activations with respect to the excitations (output)
+  /// \param alreadyNormalized If the excitations are already normalized
+  ///
+  /// Where the first-order dynamics switches from activation to deactivation,
+  /// the derivative of the deactivation branch is returned
+  ///
+  void computeActivationsDotDerivative(
+      const utils::Vector& excitations,
+      const utils::Vector& activations,
+      utils::Vector& activationsDot,
+      utils::Vector& dActivationsDotdExcitations,
+      bool alreadyNormalized = true) const;
+
+  ///
+  /// \brief Return the force-length contractile element of all the muscles
+  /// computed by the last call to computeForces
+  /// \return The force-length contractile element
+  ///
+  const utils::Vector& FlCE() const;
+
+  ///
+  /// \brief Return the force-length passive element of all the muscles
+  /// computed by the last call to computeForces
+  /// \return The force-length passive element
+  ///
+  const utils::Vector& FlPE() const;
+
+  ///
+  /// \brief Return the force-velocity contractile element of all the muscles
+  /// computed by the last call to computeForces
+  /// \return The force-velocity contractile element
+  ///
+  const utils::Vector& FvCE() const;
+
+  ///
+  /// \brief Return the damping of all the muscles computed by the last call to
+  /// computeForces
+  /// \return The damping
+  ///
+  const utils::Vector& damping() const;
+
+ protected:
+  ///
+  /// \brief Compute the force-length contractile element of the muscles
+  /// \param activations The activations of the muscles
+  /// \param muscleLengths The muscle lengths
+  ///
+  void computeFlCE(
+      const utils::Vector& activations,
+      const utils::Vector& muscleLengths);
+
+  ///
+  /// \brief Compute the force-length passive element of the muscles
+  /// \param muscleLengths The muscle lengths
+  ///
+  void computeFlPE(const utils::Vector& muscleLengths);
+
+  ///
+  /// \brief Compute the force-velocity contractile element of the muscles
+  /// \param muscleVelocities The muscle velocities
+  ///
+  void computeFvCE(const utils::Vector& muscleVelocities);
+
+  ///
+  /// \brief Compute the damping of the muscles
+  /// \param muscleVelocities The muscle velocities
+  ///
+  void computeDamping(const utils::Vector& muscleVelocities);
+
+  ///
+  /// \brief Compute the derivatives of the force-length contractile element
+  /// with respect to the activations and the muscle lengths
+  /// \param activations The activations of the muscles
+  /// \param muscleLengths The muscle lengths
+  ///
+  void computeFlCEDerivatives(
+      const utils::Vector& activations,
+      const utils::Vector& muscleLengths);
+
+  ///
+  /// \brief Compute the derivative of the force-length passive element with
+  /// respect to the muscle lengths
+  /// \param muscleLengths The muscle lengths
+  ///
+  void computeFlPEDerivative(const utils::Vector& muscleLengths);
+
+  ///
+  /// \brief Compute the derivatives of the force-velocity contractile element
+  /// and of the damping with respect to the muscle velocities
+  /// \param muscleVelocities The muscle velocities
+  ///
+  void computeFvCEDerivative(const utils::Vector& muscleVelocities);
+
+  ///
+  /// \brief Compute the activation dynamics of all the muscles
+  /// \param excitations The excitations of the muscles
+  /// \param activations The activations of the muscles
+  /// \param activationsDot The time derivative of the activations (output)
+  /// \param derivatives The derivative with respect to the excitations
+  /// (output, nullptr if not needed)
+  /// \param alreadyNormalized If the excitations are already normalized
+  ///
+  void computeActivationDynamics(
+      const utils::Vector& excitations,
+      const utils::Vector& activations,
+      utils::Vector& activationsDot,
+      utils::Vector* derivatives,
+      bool alreadyNormalized) const;
+
+  ///
+  /// \brief Write the forces and their elements back to the muscles
+  /// \param forces The muscle forces
+  ///
+  void scatterForces(const utils::Vector& forces);
+
+#ifndef BIORBD_USE_CASADI_MATH
+  ///
+  /// \brief Evaluate a lookup table for a set of muscles
+  /// \param table The lookup table
+  /// \param indices The indices of the muscles
+  /// \param x The lengths or the velocities of the muscles
+  /// \param normalization The value normalizing x
+  /// \param values The value of the curve (output, nullptr if not needed)
+  /// \param derivatives The derivative of the curve with respect to x (output,
+  /// nullptr if not needed)
+  ///
+  void evaluateCurveTable(
+      const MuscleCurveTable& table,
+      const std::vector<size_t>& indices,
+      const utils::Vector& x,
+      const utils::Vector& normalization,
+      utils::Vector* values,
+      utils::Vector* derivatives) const;
+#endif
+
+  std::vector<std::shared_ptr<Muscle>> m_muscles;  ///< The compiled muscles
+  std::vector<MUSCLE_TYPE> m_type;  ///< The type of each muscle
+  std::vector<std::shared_ptr<HillType>>
+      m_hillTypes;  ///< Each muscle as a HillType (nullptr if it is not one)
+  std::vector<size_t> m_hill;       ///< Indices of the HillType muscles
+  std::vector<size_t> m_thelen;  ///< Indices of the HillThelenType muscles
+  std::vector<size_t> m_deGroote;  ///< Indices of the HillDeGrooteType muscles
+  std::vector<size_t>
+      m_idealized;  ///< Indices of the IdealizedActuator muscles
+  std::vector<size_t> m_fatigable;  ///< Indices of the fatigable muscles
+  std::vector<std::shared_ptr<FatigueModel>>
+      m_fatigueModel;  ///< The fatigue model of each fatigable muscle
+  std::vector<size_t> m_simpleState;  ///< Indices of the SIMPLE_STATE muscles
+  std::vector<size_t> m_dynamicState;  ///< Indices of the DYNAMIC muscles
+  std::vector<size_t> m_buchananState;  ///< Indices of the BUCHANAN muscles
+  std::vector<size_t> m_deGrooteState;  ///< Indices of the DE_GROOTE muscles
+
+  utils::Vector m_optimalLength;       ///< Optimal length of each muscle
+  utils::Vector m_forceIsoMax;         ///< Maximal isometric force
+  utils::Vector m_tendonSlackLength;   ///< Tendon slack length
+  utils::Vector m_cosPennationAngle;   ///< Cosine of the pennation angle
+  utils::Vector m_maxShorteningSpeed;  ///< Maximal shortening speed
+  utils::Vector
+      m_passiveScale;  ///< 1 if the passive element is active, 0 otherwise
+  utils::Vector m_dampingScale;  ///< Damping constant (0 if not used)
+  utils::Vector
+      m_velocityScale;  ///< Velocity normalizing the force-velocity curve
+  std::vector<std::shared_ptr<MuscleCurveTable>>
+      m_curveTables;  ///< Tables of the Thelen then DeGroote curves (or empty)
+  utils::Vector m_minActivation;  ///< Minimal activation
+  utils::Vector m_torqueActivation;  ///< Time activation constant
+  utils::Vector m_torqueDeactivation;  ///< Time deactivation constant
+  utils::Vector m_maxExcitation;  ///< Excitation normalizing the excitations
+
+  utils::Vector m_activations;       ///< Bounded activations
+  utils::Vector m_muscleLengths;     ///< Muscle lengths
+  utils::Vector m_muscleVelocities;  ///< Muscle velocities
+  utils::Vector m_FlCE;     ///< Force-length contractile element
+  utils::Vector m_FlPE;     ///< Force-length passive element
+  utils::Vector m_FvCE;     ///< Force-velocity contractile element
+  utils::Vector m_damping;  ///< Damping
+
+  utils::Vector m_dFlCEdActivation;  ///< Derivative of FlCE wrt activation
+  utils::Vector m_dFlCEdLength;      ///< Derivative of FlCE wrt length
+  utils::Vector m_dFlPEdLength;      ///< Derivative of FlPE wrt length
+  utils::Vector m_dFvCEdVelocity;    ///< Derivative of FvCE wrt velocity
+  utils::Vector m_dDampingdVelocity;  ///< Derivative of damping wrt velocity
+};
+
+}  // namespace muscles
+}  // namespace internal_forces
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_MUSCLES_MUSCLE_PARAMETER_SET_H
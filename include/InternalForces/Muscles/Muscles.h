@@ -3,6 +3,7 @@
 
 #include "biorbdConfig.h"
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -12,6 +13,7 @@ namespace BIORBD_NAMESPACE {
 namespace utils {
 class String;
 class Matrix;
+class ThreadPool;
 class Vector;
 class Vector3d;
 }  // namespace utils
@@ -23,8 +25,12 @@ class GeneralizedTorque;
 }  // namespace rigidbody
 
 namespace internal_forces {
+class PathKinematics;
+
 namespace muscles {
 class MuscleGroup;
+class MuscleLengthSurrogate;
+class MuscleParameterSet;
 class State;
 class Muscle;
 
@@ -132,6 +138,101 @@ class BIORBD_API Muscles {
   ///
   const MuscleGroup& muscleGroup(const utils::String& name) const;
 
+  ///
+  /// \brief Gather the parameters of all the muscles into a contiguous
+  /// parameter set so the forces are computed by the batched kernels
+  ///
+  /// Once compiled, muscleForces evaluates all the muscles of a given type in
+  /// a single loop instead of calling each muscle, and updateMuscles computes
+  /// all the attachment and via points of all the muscles in a single sweep
+  /// (see PathKinematics). This function must be called again if the
+  /// characteristics or the attachment points of a muscle are changed.
+  ///
+  void compileMuscles();
+
+  ///
+  /// \brief Return if the muscles were compiled (see compileMuscles)
+  /// \return If the muscles were compiled
+  ///
+  bool isMusclesCompiled() const;
+
+  ///
+  /// \brief Return the compiled parameter set of the muscles. The muscles
+  /// must have been compiled (see compileMuscles)
+  /// \return The compiled parameter set
+  ///
+  MuscleParameterSet& muscleParameters();
+
+  ///
+  /// \brief Return a parameter set of the muscles for the batched kernels
+  /// (e.g. the force derivatives) without compiling the muscles
+  /// \return The compiled parameter set if the muscles were compiled,
+  /// otherwise a parameter set kept aside
+  ///
+  /// The set kept aside is not used by muscleForces nor updateMuscles, so the
+  /// muscles are still computed one by one until compileMuscles is called.
+  /// Like the compiled set, it is not refreshed when the characteristics of a
+  /// muscle are changed.
+  ///
+  MuscleParameterSet& batchedMuscleParameters();
+
+  ///
+  /// \brief Evaluate the force-length and force-velocity curves of the
+  /// compiled muscles from lookup tables (see
+  /// MuscleParameterSet::useCurveTables). The muscles must have been
+  /// compiled (see compileMuscles)
+  /// \param use If the tables are used
+  /// \param nbIntervals The number of intervals of each table (must be even)
+  ///
+  /// The setting is kept when the muscles are compiled again
+  ///
+  void useMuscleCurveTables(bool use, size_t nbIntervals = 1000);
+
+  ///
+  /// \brief Set the number of threads used to update the muscles, compute
+  /// their forces and the resulting joint torque
+  /// \param nbThreads The number of threads (0 or 1 to run serially)
+  ///
+  /// The muscles are distributed between the threads according to an
+  /// estimate of their cost (wrapping muscles being heavier than straight
+  /// ones). The partial joint torques of the threads are summed in a fixed
+  /// order, so the result does not depend on the scheduling. The wrapping
+  /// objects must not be shared between muscles. This is not available with
+  /// CasADi.
+  ///
+  void setMusclesNbThreads(size_t nbThreads);
+
+  ///
+  /// \brief Return the number of threads used to update the muscles
+  /// \return The number of threads (1 if serial)
+  ///
+  size_t musclesNbThreads() const;
+
+  ///
+  /// \brief Compute the musculotendon lengths and their jacobian from a
+  /// polynomial surrogate instead of the full path geometry
+  /// \param surrogate The fitted surrogate (nullptr to go back to the full
+  /// geometry)
+  ///
+  /// In that mode, updateMuscles only evaluates the surrogate: the points of
+  /// the muscles are not updated and, if Q is given alone, neither is the
+  /// kinematics of the model.
+  ///
+  void setMuscleLengthSurrogate(
+      const std::shared_ptr<MuscleLengthSurrogate>& surrogate);
+
+  ///
+  /// \brief Return if the muscle lengths are computed from a surrogate
+  /// \return If the muscle lengths are computed from a surrogate
+  ///
+  bool isMuscleLengthSurrogateUsed() const;
+
+  ///
+  /// \brief Return the surrogate of the muscle lengths
+  /// \return The surrogate of the muscle lengths
+  ///
+  MuscleLengthSurrogate& muscleLengthSurrogate();
+
   ///
   /// \brief Update all the muscles (positions, jacobian, etc.)
   /// \param updatedModel The model previously updated to proper kinematic level
@@ -203,6 +304,17 @@ class BIORBD_API Muscles {
   ///
   std::vector<std::shared_ptr<State>> stateSet();
 
+  ///
+  /// \brief Set the excitation and activation of the state of each muscle and
+  /// return the vector of state
+  /// \param excitations The excitations of all the muscles
+  /// \param activations The activations of all the muscles
+  /// \return The vector of state
+  ///
+  std::vector<std::shared_ptr<State>> stateSet(
+      const utils::Vector& excitations,
+      const utils::Vector& activations);
+
   ///
   /// \brief Compute the muscular joint torque
   /// \param F The force vector of all the muscles
@@ -219,6 +331,16 @@ class BIORBD_API Muscles {
   ///
   rigidbody::GeneralizedTorque muscularJointTorque(const utils::Vector& F);
 
+  ///
+  /// \brief Compute the muscular joint torque into a preallocated vector
+  /// \param F The force vector of all the muscles
+  /// \param tau The muscular joint torque (output, resized if needed)
+  ///
+  /// Warning: This function assumes that muscles are already updated (via
+  /// `updateMuscles`)
+  ///
+  void muscularJointTorque(const utils::Vector& F, utils::Vector& tau);
+
   ///
   /// \brief Compute the muscular joint torque
   /// \param F The force vector of all the muscles
@@ -327,6 +449,104 @@ class BIORBD_API Muscles {
       const rigidbody::GeneralizedVelocity& Qdot,
       int updateKin = 2);
 
+  ///
+  /// \brief Compute the muscular joint torque from the muscle activations
+  /// \param activations The activations of all the muscles
+  ///
+  /// This functions converts muscle activations into muscle forces (see
+  /// muscleForces) and then performs the computation for the muscular joint
+  /// torque from virtual power:
+  ///
+  /// i.e. \f$-J \times F\f$
+  ///
+  /// Warning: This function assumes that muscles are already updated (via
+  /// `updateMuscles`)
+  ///
+  rigidbody::GeneralizedTorque muscularJointTorqueFromActivations(
+      const utils::Vector& activations);
+
+  ///
+  /// \brief Compute the muscular joint torque from the muscle activations
+  /// \param updatedModel The model previously updated to proper kinematic level
+  /// \param activations The activations of all the muscles
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param updateMuscleParameters Update the kinematic related parameters of
+  /// the muscles
+  ///
+  rigidbody::GeneralizedTorque muscularJointTorqueFromActivations(
+      rigidbody::Joints& updatedModel,
+      const utils::Vector& activations,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      bool updateMuscleParameters = true);
+
+  ///
+  /// \brief Compute the muscular joint torque from the muscle activations
+  /// \param activations The activations of all the muscles
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param updateKin Update kinematics (0: don't update, 1:only muscles, [2:
+  /// both kinematics and muscles])
+  ///
+  rigidbody::GeneralizedTorque muscularJointTorqueFromActivations(
+      const utils::Vector& activations,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      int updateKin = 2);
+
+  ///
+  /// \brief Compute the analytical partial derivatives of the muscle forces
+  /// \param activations The activations of all the muscles
+  /// \param dFdActivations The derivative of the forces with respect to the
+  /// activations (output)
+  /// \param dFdLengths The derivative of the forces with respect to the
+  /// muscle lengths (output)
+  /// \param dFdVelocities The derivative of the forces with respect to the
+  /// muscle velocities (output)
+  ///
+  /// The derivatives are computed from the batched kernels (see
+  /// batchedMuscleParameters), without compiling the muscles.
+  ///
+  /// Warning: This function assumes that muscles are already updated (via
+  /// `updateMuscles`) with the generalized velocities
+  ///
+  void muscleForcesDerivatives(
+      const utils::Vector& activations,
+      utils::Vector& dFdActivations,
+      utils::Vector& dFdLengths,
+      utils::Vector& dFdVelocities);
+
+  ///
+  /// \brief Compute the derivative of the muscular joint torque with respect
+  /// to the muscle activations
+  /// \param activations The activations of all the muscles
+  /// \return The derivative (nbDof x nbMuscles)
+  ///
+  /// i.e. \f$-J^T \times diag(\partial F / \partial a)\f$
+  ///
+  /// Warning: This function assumes that muscles are already updated (via
+  /// `updateMuscles`) with the generalized velocities
+  ///
+  utils::Matrix muscularJointTorqueActivationsJacobian(
+      const utils::Vector& activations);
+
+  ///
+  /// \brief Compute the derivative of the muscular joint torque with respect
+  /// to the muscle activations
+  /// \param activations The activations of all the muscles
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param updateKin Update kinematics (0: don't update, 1:only muscles, [2:
+  /// both kinematics and muscles])
+  /// \return The derivative (nbDof x nbMuscles)
+  ///
+  utils::Matrix muscularJointTorqueActivationsJacobian(
+      const utils::Vector& activations,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      int updateKin = 2);
+
   ///
   /// \brief Interface that returns in a vector all the activations dot
   /// \param states The state of the muscle
@@ -337,6 +557,24 @@ class BIORBD_API Muscles {
       const std::vector<std::shared_ptr<State>>& states,
       bool areadyNormalized = true);
 
+  ///
+  /// \brief Interface that returns in a vector all the activations dot
+  /// \param excitations The excitations of all the muscles
+  /// \param activations The activations of all the muscles
+  /// \param areadyNormalized If the excitations are already normalized
+  /// \return All the activations dot
+  ///
+  /// The state of each muscle is updated with the excitations and activations.
+  /// If the muscles were compiled (see compileMuscles) and none has a BUCHANAN
+  /// state, all the derivatives are computed by the batched kernel instead
+  /// (see MuscleParameterSet::computeActivationsDot) and the states are left
+  /// untouched.
+  ///
+  utils::Vector activationDot(
+      const utils::Vector& excitations,
+      const utils::Vector& activations,
+      bool areadyNormalized = true);
+
   ///
   /// \brief Return the previously computed muscle length jacobian
   /// \return The muscle length jacobian
@@ -409,6 +647,53 @@ class BIORBD_API Muscles {
       const rigidbody::GeneralizedVelocity& Qdot,
       int updateKin = 2);
 
+  ///
+  /// \brief Compute and return the muscle forces
+  /// \param activations The activations of all the muscles
+  /// \return The muscle forces
+  ///
+  /// If the muscles were compiled (see compileMuscles), the forces are
+  /// computed by the batched kernels. Otherwise, each muscle is called with
+  /// its activation. In both cases the activations are bounded to [0, 1] as
+  /// in State::setActivation.
+  ///
+  /// Warning: This function assumes that muscles are already updated (via
+  /// `updateMuscles`)
+  ///
+  utils::Vector muscleForces(const utils::Vector& activations);
+
+  ///
+  /// \brief Compute and return the muscle forces
+  /// \param updatedModel The model previously updated to proper kinematic level
+  /// \param activations The activations of all the muscles
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param updateMuscleParameters Update the kinematic related parameters of
+  /// the muscles
+  /// \return The muscle forces
+  ///
+  utils::Vector muscleForces(
+      rigidbody::Joints& updatedModel,
+      const utils::Vector& activations,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      bool updateMuscleParameters = true);
+
+  ///
+  /// \brief Compute and return the muscle forces
+  /// \param activations The activations of all the muscles
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param updateKin Update kinematics (0: don't update, 1:only muscles, [2:
+  /// both kinematics and muscles])
+  /// \return The muscle forces
+  ///
+  utils::Vector muscleForces(
+      const utils::Vector& activations,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      int updateKin = 2);
+
   ///
   /// \brief Return the total number of muscle groups
   /// \return The total number of muscle groups
@@ -428,8 +713,62 @@ class BIORBD_API Muscles {
   size_t nbMuscles() const;
 
  protected:
+  ///
+  /// \brief Distribute the muscles between the threads according to an
+  /// estimate of their cost
+  ///
+  void partitionMuscles();
+
+  ///
+  /// \brief Execute a task for each group of muscles of the partition (see
+  /// partitionMuscles) on the worker threads
+  /// \param task The task, called with the index of the group of muscles
+  ///
+  void runMuscleTasks(const std::function<void(size_t)>& task);
+
+  ///
+  /// \brief Return if the point table of the muscles is filled
+  /// \return If the point table of the muscles is filled
+  ///
+  bool isMusclePathsFilled() const;
+
+  ///
+  /// \brief Update all the muscles from the point table of the compiled
+  /// muscles. The table is filled if needed.
+  /// \param updatedModel The joint model updated to Q
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities (nullptr to skip the velocities)
+  ///
+  void updateMusclePaths(
+      rigidbody::Joints& updatedModel,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity* Qdot);
+
+  ///
+  /// \brief Update all the muscles from the surrogate of the muscle lengths
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities (nullptr to skip the velocities)
+  ///
+  void updateMusclesFromSurrogate(
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity* Qdot);
+
   std::shared_ptr<std::vector<MuscleGroup>>
       m_mus;  ///< Holder for muscle groups
+  std::shared_ptr<MuscleParameterSet>
+      m_muscleParameters;  ///< Compiled muscle parameters (nullptr if not)
+  std::shared_ptr<MuscleParameterSet>
+      m_detachedMuscleParameters;  ///< Batched parameters if not compiled
+  std::shared_ptr<PathKinematics>
+      m_musclePaths;  ///< Point table of the compiled muscles (nullptr if not)
+  std::shared_ptr<utils::ThreadPool>
+      m_musclePool;  ///< Worker threads (nullptr if serial)
+  std::shared_ptr<std::vector<std::shared_ptr<Muscle>>>
+      m_muscleList;  ///< Flat list of the muscles used by the workers
+  std::shared_ptr<std::vector<std::vector<size_t>>>
+      m_muscleChunks;  ///< Indices of the muscles processed by each task
+  std::shared_ptr<MuscleLengthSurrogate>
+      m_lengthSurrogate;  ///< Surrogate of the muscle lengths (nullptr if not)
 };
 
 }  // namespace muscles
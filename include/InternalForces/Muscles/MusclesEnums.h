@@ -48,6 +48,16 @@ inline const char* MUSCLE_TYPE_toStr(MUSCLE_TYPE type) {
   }
 }
 
+///
+/// \brief The normalized curves of the Hill-type muscles
+///
+enum MUSCLE_CURVE {
+  FORCE_LENGTH_ACTIVE,
+  FORCE_LENGTH_PASSIVE,
+  FORCE_VELOCITY,
+  NO_MUSCLE_CURVE
+};
+
 ///
 /// \brief The available emg state type
 ///
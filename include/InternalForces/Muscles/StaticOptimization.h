@@ -3,16 +3,24 @@
 
 #include "biorbdConfig.h"
 
-#include <IpTNLP.hpp>
+#include <atomic>
 #include <memory>
 #include <vector>
 
+namespace Ipopt {
+class IpoptApplication;
+class TNLP;
+template <class T>
+class SmartPtr;
+}  // namespace Ipopt
+
 namespace BIORBD_NAMESPACE {
 class Model;
 
 namespace utils {
+class Matrix;
 class Vector;
-}
+}  // namespace utils
 
 namespace rigidbody {
 class GeneralizedCoordinates;
@@ -174,12 +182,59 @@ class BIORBD_API StaticOptimization {
   ///
   void run(bool useLinearizedState = true);
 
+  ///
+  /// \brief Run the static optimization of the frames on several threads
+  /// \param nbThreads The number of threads (0 to use the number of hardware
+  /// threads)
+  /// \param useLinearizedState If use the algorithm should be run with the
+  /// linearized approach (faster but less precise)
+  /// \param chunkSize The number of consecutive frames of a chunk (0 to split
+  /// the frames evenly between the threads)
+  ///
+  /// The frames are split into chunks of consecutive frames, distributed
+  /// between the threads. Inside a chunk, each frame is warm-started from the
+  /// solution of the previous one, the first frame of each chunk starts from
+  /// the initial activation guess. Each thread has its own IpoptApplication
+  /// and its own deep copy of the model (see Model::DeepCopy).
+  ///
+  /// The default linear solver of Ipopt (MUMPS) is not reentrant. Unless the
+  /// linear_solver option is set (e.g. in an ipopt.opt file), it is replaced
+  /// by the first reentrant solver available to Ipopt (ma57, ma27 or spral).
+  /// If there is none, or if MUMPS was explicitly asked for, a warning is
+  /// printed and the solves are serialized between the threads, which then
+  /// bring no speedup (see isSolverSerialized).
+  ///
+  void runParallel(
+      size_t nbThreads = 0,
+      bool useLinearizedState = true,
+      size_t chunkSize = 0);
+
+  ///
+  /// \brief Return if the solves of the last run waited for each other (non
+  /// reentrant linear solver, see runParallel)
+  /// \return If the solves were serialized
+  ///
+  bool isSolverSerialized() const;
+
+  ///
+  /// \brief Return the largest number of frames that were being solved at the
+  /// same time during the last run
+  /// \return The largest number of concurrent solves
+  ///
+  size_t maxConcurrentSolves() const;
+
   ///
   /// \brief Return the final solution
   /// \return The final solution
   ///
   std::vector<utils::Vector> finalSolution();
 
+  ///
+  /// \brief Return the final solution of all the frames
+  /// \return The activations (nbMuscles x nbFrames)
+  ///
+  const utils::Matrix& finalSolutionMatrix() const;
+
   ///
   /// \brief Return the final solution at a specific index
   /// \return The final solution at a specific index
@@ -199,9 +254,45 @@ class BIORBD_API StaticOptimization {
       m_initialActivationGuess;  ///< Initial activation guess
   unsigned int m_pNormFactor;    ///< The p-norm factor
   int m_verbose;                 ///< Verbose level
-  std::vector<Ipopt::SmartPtr<Ipopt::TNLP>>
-      m_staticOptimProblem;  ///< The static optimization problem
-  bool m_alreadyRun;         ///< If already ran the static optimization
+  std::shared_ptr<utils::Matrix>
+      m_solutions;   ///< The activations of each frame (one per column)
+  bool m_alreadyRun;  ///< If already ran the static optimization
+  bool m_isSolverSerialized;  ///< If the solves of the last run were serialized
+  std::shared_ptr<std::atomic<size_t>>
+      m_nbSolving;  ///< Number of frames being solved
+  std::shared_ptr<std::atomic<size_t>>
+      m_maxConcurrentSolves;  ///< Most frames solved at the same time
+
+  ///
+  /// \brief Solve consecutive frames, each one being warm-started from the
+  /// solution of the previous one
+  /// \param model The model used to evaluate the muscles
+  /// \param app The Ipopt application
+  /// \param first The first frame
+  /// \param last The frame after the last one
+  /// \param activationGuess The initial guess of the first frame, the
+  /// solution of the last frame when returning
+  /// \param useLinearizedState If the linearized approach is used
+  /// \param isSolverSerialized If the solves must wait for the other threads
+  /// (linear solver that is not reentrant)
+  ///
+  void solveFrames(
+      Model& model,
+      Ipopt::IpoptApplication& app,
+      size_t first,
+      size_t last,
+      utils::Vector& activationGuess,
+      bool useLinearizedState,
+      bool isSolverSerialized);
+
+  ///
+  /// \brief Solve a frame, counting the frames being solved at the same time
+  /// \param app The Ipopt application
+  /// \param problem The problem of the frame
+  ///
+  void optimize(
+      Ipopt::IpoptApplication& app,
+      const Ipopt::SmartPtr<Ipopt::TNLP>& problem);
 };
 
 }  // namespace muscles
@@ -11,6 +11,7 @@ namespace BIORBD_NAMESPACE {
 class Model;
 
 namespace utils {
+class Matrix;
 class Vector;
 }
 
@@ -39,7 +40,7 @@ class BIORBD_API StaticOptimizationIpopt : public Ipopt::TNLP {
   /// optimization will fail if the model is not strong enough
   /// \param pNormFactor The p-norm to perform
   /// \param verbose Level of IPOPT verbose you want
-  /// \param eps The precision to perform the finite diffentiation
+  /// \param eps Not used anymore, the derivatives are analytical
   ///
   StaticOptimizationIpopt(
       Model& model,
@@ -62,7 +63,7 @@ class BIORBD_API StaticOptimizationIpopt : public Ipopt::TNLP {
   /// \param n Number of variables
   /// \param m Number of constraints
   /// \param nnz_jac_g Dimension of the constraint jacobian
-  /// \param nnz_h_lag Dimension of the constraint hessian
+  /// \param nnz_h_lag Dimension of the hessian of the lagrangian
   /// \param index_style Formatting of the matrix (C-Style)
   /// \return Return the presence of that function
   ///
@@ -183,6 +184,37 @@ class BIORBD_API StaticOptimizationIpopt : public Ipopt::TNLP {
       Ipopt::Index* jCol,
       Ipopt::Number* values);
 
+  ///
+  /// \brief Return the hessian of the lagrangian
+  /// \param n The number of variables
+  /// \param x The values of the variables
+  /// \param new_x If the variables were modified by IPOPT
+  /// \param obj_factor The factor of the objective function
+  /// \param m The number of constraints
+  /// \param lambda The lagrange multipliers of the constraints
+  /// \param new_lambda If the multipliers were modified by IPOPT
+  /// \param nele_hess Number of elements in the hessian matrix
+  /// \param iRow iterator on the rows of the hessian
+  /// \param jCol iterator on the columns of the hessian
+  /// \param values The actual hessian (lower triangle)
+  /// \return Return the presence of that function
+  ///
+  /// Each muscle force only depends on its own activation, so the hessian is
+  /// diagonal
+  ///
+  virtual bool eval_h(
+      Ipopt::Index n,
+      const Ipopt::Number* x,
+      bool new_x,
+      Ipopt::Number obj_factor,
+      Ipopt::Index m,
+      const Ipopt::Number* lambda,
+      bool new_lambda,
+      Ipopt::Index nele_hess,
+      Ipopt::Index* iRow,
+      Ipopt::Index* jCol,
+      Ipopt::Number* values);
+
   ///
   /// \brief Finalize the optimization
   /// \param status The status of the optimization
@@ -234,6 +266,8 @@ class BIORBD_API StaticOptimizationIpopt : public Ipopt::TNLP {
   std::shared_ptr<unsigned int>
       m_nbTorqueResidual;         ///< The number of torque residual
   std::shared_ptr<double> m_eps;  ///< Precision of the finite differentiate
+  std::shared_ptr<utils::Matrix>
+      m_lengthJacobian;  ///< The muscle length jacobian at the frame
   std::shared_ptr<utils::Vector> m_activations;  ///< The activations
   std::shared_ptr<rigidbody::GeneralizedCoordinates>
       m_Q;  ///< The generalized coordinates
@@ -255,6 +289,16 @@ class BIORBD_API StaticOptimizationIpopt : public Ipopt::TNLP {
   /// \param x variables
   ///
   void dispatch(const Ipopt::Number* x);
+
+  ///
+  /// \brief Add the curvature of the constraints to the diagonal of the
+  /// hessian of the lagrangian
+  /// \param lambda The lagrange multipliers of the constraints
+  /// \param values The diagonal of the hessian
+  ///
+  virtual void addConstraintsHessian(
+      const Ipopt::Number* lambda,
+      Ipopt::Number* values);
 };
 
 }  // namespace muscles
@@ -35,7 +35,7 @@ class BIORBD_API StaticOptimizationIpoptLinearized
   /// optimization will fail if the model is not strong enough
   /// \param pNormFactor The p-norm to perform
   /// \param verbose Level of IPOPT verbose you want
-  /// \param eps The precision to perform the finite diffentiation
+  /// \param eps Not used anymore, the derivatives are analytical
   ///
   StaticOptimizationIpoptLinearized(
       Model& model,
@@ -92,6 +92,15 @@ class BIORBD_API StaticOptimizationIpoptLinearized
       Ipopt::Number* values);
 
  protected:
+  ///
+  /// \brief The linearized constraints have no curvature, nothing is added
+  /// \param lambda The lagrange multipliers of the constraints
+  /// \param values The diagonal of the hessian
+  ///
+  virtual void addConstraintsHessian(
+      const Ipopt::Number* lambda,
+      Ipopt::Number* values);
+
   std::shared_ptr<utils::Matrix> m_jacobian;  ///< The constraints jacobian
   void prepareJacobian();  ///< Setup the constant constraints jacobian
 };
@@ -0,0 +1,134 @@
+#ifndef BIORBD_MUSCLES_STATIC_OPTIMIZATION_QUADRATIC_H
+#define BIORBD_MUSCLES_STATIC_OPTIMIZATION_QUADRATIC_H
+
+#include "biorbdConfig.h"
+
+#include <memory>
+#include <vector>
+
+namespace BIORBD_NAMESPACE {
+class Model;
+
+namespace utils {
+class Matrix;
+class Vector;
+}  // namespace utils
+
+namespace rigidbody {
+class GeneralizedCoordinates;
+class GeneralizedVelocity;
+class GeneralizedTorque;
+}  // namespace rigidbody
+
+namespace internal_forces {
+namespace muscles {
+///
+/// \brief Static optimization of the squared activations on the linearized
+/// muscle forces, solved by a dedicated active-set method
+///
+/// For each frame, the muscle forces are linearized between a null and a full
+/// activation, so the muscular torque is tau0 + A * a. The residual torques
+/// r = torqueTarget - tau0 - A * a are eliminated, leaving the bound
+/// constrained and strictly convex quadratic program
+///
+///     min sum(a^2) + w * sum(r^2)     with aMin <= a <= aMax
+///
+/// which is solved by a primal active-set method. The set of the activations
+/// at their bounds is kept from one frame to the next, so consecutive frames
+/// usually converge in very few iterations. This does not need Ipopt and is
+/// only available with the Eigen backend.
+///
+class BIORBD_API StaticOptimizationQuadratic {
+ public:
+  ///
+  /// \brief Construct the solver
+  /// \param model The musculoskeletal Model
+  /// \param torquePonderation The weight of the residual torques
+  /// \param activationMin The lower bound of the activations
+  /// \param activationMax The upper bound of the activations
+  ///
+  StaticOptimizationQuadratic(
+      Model& model,
+      double torquePonderation = 1000,
+      double activationMin = 0.0001,
+      double activationMax = 0.9999);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~StaticOptimizationQuadratic();
+
+  ///
+  /// \brief Solve the static optimization of a frame, starting from the
+  /// active set of the previous frame
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param torqueTarget The generalized torque target
+  ///
+  void solve(
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      const rigidbody::GeneralizedTorque& torqueTarget);
+
+  ///
+  /// \brief Forget the active set, the next frame starts with all the
+  /// activations free
+  ///
+  void resetActiveSet();
+
+  ///
+  /// \brief Return the activations of the last solved frame
+  /// \return The activations
+  ///
+  const utils::Vector& activations() const;
+
+  ///
+  /// \brief Return the residual torques of the last solved frame
+  /// \return The residual torques
+  ///
+  const utils::Vector& residualTorques() const;
+
+  ///
+  /// \brief Return the number of active-set iterations of the last solved
+  /// frame
+  /// \return The number of iterations
+  ///
+  size_t nbIterations() const;
+
+  ///
+  /// \brief Return the number of activations at one of their bounds
+  /// \return The number of active bounds
+  ///
+  size_t nbActiveBounds() const;
+
+ protected:
+  ///
+  /// \brief Status of an activation in the active set
+  ///
+  enum BOUND_STATUS { FREE, AT_MIN, AT_MAX };
+
+  ///
+  /// \brief Minimize 0.5 * x^T H x + g^T x within the bounds, starting from the
+  /// current active set
+  /// \param H The hessian
+  /// \param g The gradient at zero
+  ///
+  void solveBoxQuadraticProgram(const utils::Matrix& H, const utils::Vector& g);
+
+  Model& m_model;  ///< The musculoskeletal model
+  double m_torquePonderation;  ///< Weight of the residual torques
+  double m_activationMin;  ///< Lower bound of the activations
+  double m_activationMax;  ///< Upper bound of the activations
+  std::shared_ptr<std::vector<BOUND_STATUS>>
+      m_status;  ///< Active set of the last frame
+  std::shared_ptr<utils::Vector> m_activations;  ///< Solution of the last frame
+  std::shared_ptr<utils::Vector>
+      m_residualTorques;  ///< Residual torques of the last frame
+  std::shared_ptr<size_t> m_nbIterations;  ///< Iterations of the last frame
+};
+
+}  // namespace muscles
+}  // namespace internal_forces
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_MUSCLES_STATIC_OPTIMIZATION_QUADRATIC_H
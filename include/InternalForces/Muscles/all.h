@@ -9,6 +9,7 @@
 #include "InternalForces/Muscles/FatigueModel.h"
 #include "InternalForces/Muscles/FatigueParameters.h"
 #include "InternalForces/Muscles/FatigueState.h"
+#include "InternalForces/Muscles/FatigueStateSet.h"
 #include "InternalForces/Muscles/HillDeGrooteActiveOnlyType.h"
 #include "InternalForces/Muscles/HillDeGrooteType.h"
 #include "InternalForces/Muscles/HillDeGrooteTypeFatigable.h"
@@ -20,11 +21,15 @@
 #include "InternalForces/Muscles/Muscle.h"
 #include "InternalForces/Muscles/MuscleGeometry.h"
 #include "InternalForces/Muscles/MuscleGroup.h"
+#include "InternalForces/Muscles/MuscleCurveTable.h"
+#include "InternalForces/Muscles/MuscleLengthSurrogate.h"
+#include "InternalForces/Muscles/MuscleParameterSet.h"
 #include "InternalForces/Muscles/Muscles.h"
 #include "InternalForces/Muscles/MusclesEnums.h"
 #include "InternalForces/Muscles/State.h"
 #include "InternalForces/Muscles/StateDynamics.h"
 #include "InternalForces/Muscles/StateDynamicsBuchanan.h"
+#include "InternalForces/Muscles/StaticOptimizationQuadratic.h"
 
 #ifdef MODULE_STATIC_OPTIM
 #include "InternalForces/Muscles/StaticOptimization.h"
@@ -63,6 +63,12 @@ class BIORBD_API PassiveTorqueConstant : public PassiveTorque {
   ///
   virtual utils::Scalar passiveTorque();
 
+  ///
+  /// \brief Return the constant torque
+  /// \return The constant torque
+  ///
+  const utils::Scalar& torque() const;
+
  protected:
   ///
   /// \brief Set the type of the constant passive torque
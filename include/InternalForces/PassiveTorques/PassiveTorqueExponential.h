@@ -106,6 +106,66 @@ class BIORBD_API PassiveTorqueExponential : public PassiveTorque {
       const rigidbody::GeneralizedCoordinates& Q,
       const rigidbody::GeneralizedCoordinates& QDot) const;
 
+  ///
+  /// \brief Return the first exponential rate
+  /// \return The first exponential rate
+  ///
+  const utils::Scalar& k1() const;
+
+  ///
+  /// \brief Return the second exponential rate
+  /// \return The second exponential rate
+  ///
+  const utils::Scalar& k2() const;
+
+  ///
+  /// \brief Return the first exponential gain
+  /// \return The first exponential gain
+  ///
+  const utils::Scalar& b1() const;
+
+  ///
+  /// \brief Return the second exponential gain
+  /// \return The second exponential gain
+  ///
+  const utils::Scalar& b2() const;
+
+  ///
+  /// \brief Return the generalized coordinate the exponentials are centered on
+  /// \return The generalized coordinate the exponentials are centered on
+  ///
+  const utils::Scalar& qMid() const;
+
+  ///
+  /// \brief Return the equilibrium torque
+  /// \return The equilibrium torque
+  ///
+  const utils::Scalar& tauEq() const;
+
+  ///
+  /// \brief Return the velocity dependency factor
+  /// \return The velocity dependency factor
+  ///
+  const utils::Scalar& pBeta() const;
+
+  ///
+  /// \brief Return the maximal velocity
+  /// \return The maximal velocity
+  ///
+  const utils::Scalar& wMax() const;
+
+  ///
+  /// \brief Return the velocity scaling
+  /// \return The velocity scaling
+  ///
+  const utils::Scalar& sV() const;
+
+  ///
+  /// \brief Return the generalized coordinate of the null elastic torque
+  /// \return The generalized coordinate of the null elastic torque
+  ///
+  const utils::Scalar& deltaP() const;
+
  protected:
   ///
   /// \brief Set the type of passive torque
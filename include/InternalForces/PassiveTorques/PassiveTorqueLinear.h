@@ -87,6 +87,18 @@ class BIORBD_API PassiveTorqueLinear : public PassiveTorque {
   virtual utils::Scalar passiveTorque(
       const rigidbody::GeneralizedCoordinates& Q) const;
 
+  ///
+  /// \brief Return the slope of the torque with respect to Q
+  /// \return The slope
+  ///
+  const utils::Scalar& slope() const;
+
+  ///
+  /// \brief Return the torque when Q is zero
+  /// \return The torque at zero
+  ///
+  const utils::Scalar& torqueAtZero() const;
+
  protected:
   ///
   /// \brief Set the type of passive torque
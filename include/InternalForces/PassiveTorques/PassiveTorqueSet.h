@@ -0,0 +1,120 @@
+#ifndef BIORBD_PASSIVE_TORQUES_PASSIVE_TORQUE_SET_H
+#define BIORBD_PASSIVE_TORQUES_PASSIVE_TORQUE_SET_H
+
+#include "biorbdConfig.h"
+
+#include <memory>
+#include <vector>
+
+#include "InternalForces/PassiveTorques/PassiveTorqueEnums.h"
+#include "Utils/Vector.h"
+
+namespace BIORBD_NAMESPACE {
+namespace internal_forces {
+namespace passive_torques {
+class PassiveTorque;
+
+///
+/// \brief Contiguous (structure-of-arrays) view of the parameters of a set of
+/// passive torques, together with the kernels that evaluate all the passive
+/// torques of a given type in a single loop
+///
+/// The parameters are copied from the passive torques when compile() is
+/// called. The passive torques are addressed by the index of their DoF, so
+/// the generalized coordinates, velocities and torques are read and written
+/// at these indices. The DoFs without passive torque get a null torque.
+///
+class BIORBD_API PassiveTorqueSet {
+ public:
+  ///
+  /// \brief Construct an empty passive torque set
+  ///
+  PassiveTorqueSet();
+
+  ///
+  /// \brief Construct a passive torque set from a set of passive torques
+  /// \param passiveTorques The passive torques to compile
+  ///
+  PassiveTorqueSet(
+      const std::vector<std::shared_ptr<PassiveTorque>>& passiveTorques);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~PassiveTorqueSet();
+
+  ///
+  /// \brief Gather the parameters of all the passive torques into contiguous
+  /// arrays
+  /// \param passiveTorques The passive torques to compile
+  ///
+  void compile(
+      const std::vector<std::shared_ptr<PassiveTorque>>& passiveTorques);
+
+  ///
+  /// \brief Return the number of compiled passive torques
+  /// \return The number of compiled passive torques
+  ///
+  size_t nbPassiveTorques() const;
+
+  ///
+  /// \brief Return the DoF indices of the passive torques of a type
+  /// \param type TORQUE_CONSTANT, TORQUE_LINEAR or TORQUE_EXPONENTIAL
+  /// \return The DoF indices of the passive torques
+  ///
+  const std::vector<size_t>& indices(TORQUE_TYPE type) const;
+
+  ///
+  /// \brief Compute the passive torques of all the DoFs
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param tau The passive torques (output, must be of size nbDof)
+  ///
+  void computeTorques(
+      const utils::Vector& Q,
+      const utils::Vector& Qdot,
+      utils::Vector& tau) const;
+
+  ///
+  /// \brief Compute the analytic partial derivatives of the passive torques
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param dTaudQ The derivative of each torque with respect to the
+  /// generalized coordinate of its DoF (output, must be of size nbDof)
+  /// \param dTaudQdot The derivative of each torque with respect to the
+  /// generalized velocity of its DoF (output, must be of size nbDof)
+  ///
+  /// Each passive torque only depends on its own DoF, the jacobians are
+  /// therefore diagonal and only their diagonal is returned
+  ///
+  void computeTorqueDerivatives(
+      const utils::Vector& Q,
+      const utils::Vector& Qdot,
+      utils::Vector& dTaudQ,
+      utils::Vector& dTaudQdot) const;
+
+ protected:
+  std::vector<size_t> m_constant;  ///< DoF indices of the constant torques
+  std::vector<size_t> m_linear;    ///< DoF indices of the linear torques
+  std::vector<size_t>
+      m_exponential;  ///< DoF indices of the exponential torques
+
+  utils::Vector m_torque;        ///< Torque of each constant torque
+  utils::Vector m_slope;         ///< Slope of each linear torque
+  utils::Vector m_torqueAtZero;  ///< Torque at zero of each linear torque
+  utils::Vector m_k1;            ///< First exponential rate
+  utils::Vector m_k2;            ///< Second exponential rate
+  utils::Vector m_b1;            ///< First exponential gain
+  utils::Vector m_b2;            ///< Second exponential gain
+  utils::Vector m_qMid;  ///< Coordinate the exponentials are centered on
+  utils::Vector m_tauEq;  ///< Equilibrium torque
+  utils::Vector m_deltaP;  ///< Coordinate of the null elastic torque
+  utils::Vector
+      m_velocityFactor;  ///< pBeta / (sV * wMax) of each exponential torque
+};
+
+}  // namespace passive_torques
+}  // namespace internal_forces
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_PASSIVE_TORQUES_PASSIVE_TORQUE_SET_H
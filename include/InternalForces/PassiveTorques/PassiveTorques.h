@@ -10,8 +10,9 @@
 
 namespace BIORBD_NAMESPACE {
 namespace utils {
+class Matrix;
 class Vector;
-}
+}  // namespace utils
 
 namespace rigidbody {
 class GeneralizedCoordinates;
@@ -22,6 +23,7 @@ class GeneralizedTorque;
 namespace internal_forces {
 namespace passive_torques {
 class PassiveTorque;
+class PassiveTorqueSet;
 ///
 /// \brief Class holder for a set of passive torques
 ///
@@ -66,6 +68,43 @@ class BIORBD_API PassiveTorques {
       const rigidbody::GeneralizedCoordinates& Q,
       const rigidbody::GeneralizedVelocity& Qdot);
 
+  ///
+  /// \brief Compute the passiveJointTorques into a preallocated vector
+  /// \param Q The generalized coordinates of the passive torques
+  /// \param Qdot The generalized velocities of the passive torques
+  /// \param tau The passive joint torques (output, must be of size nbDof)
+  ///
+  void passiveJointTorque(
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      utils::Vector& tau);
+
+  ///
+  /// \brief Return the analytic jacobians of the passiveJointTorques
+  /// \param Q The generalized coordinates of the passive torques
+  /// \param Qdot The generalized velocities of the passive torques
+  /// \param dTaudQ The jacobian with respect to Q (output)
+  /// \param dTaudQdot The jacobian with respect to Qdot (output)
+  ///
+  /// Each passive torque only depends on its own DoF, so both jacobians are
+  /// diagonal. They are meant for the implicit integrators.
+  ///
+  void passiveJointTorqueJacobians(
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      utils::Matrix& dTaudQ,
+      utils::Matrix& dTaudQdot);
+
+  ///
+  /// \brief Gather the passive torques into per-type contiguous arrays (see
+  /// PassiveTorqueSet)
+  ///
+  /// This is done automatically at the first evaluation after a passive torque
+  /// is added, it can be called when the model is closed to avoid doing it in
+  /// the first evaluation
+  ///
+  void compilePassiveTorques();
+
   // Get and set
   ///
   /// \brief Return the toal number of passive torques
@@ -85,6 +124,10 @@ class BIORBD_API PassiveTorques {
       std::shared_ptr<internal_forces::passive_torques::PassiveTorque>>>
       m_pas;                                      ///< Passive torque to add
   std::shared_ptr<std::vector<bool>> m_isDofSet;  ///< If DoF all dof are set
+  std::shared_ptr<PassiveTorqueSet>
+      m_passiveTorqueSet;  ///< The compiled passive torques
+  std::shared_ptr<bool>
+      m_isPassiveTorqueSetCompiled;  ///< If the passive torques are compiled
 };
 
 }  // namespace passive_torques
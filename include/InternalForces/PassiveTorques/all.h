@@ -6,6 +6,7 @@
 #include "InternalForces/PassiveTorques/PassiveTorqueEnums.h"
 #include "InternalForces/PassiveTorques/PassiveTorqueExponential.h"
 #include "InternalForces/PassiveTorques/PassiveTorqueLinear.h"
+#include "InternalForces/PassiveTorques/PassiveTorqueSet.h"
 #include "InternalForces/PassiveTorques/PassiveTorques.h"
 
 #endif  // BIORBD_PASSIVE_TORQUES_ALL_H
@@ -0,0 +1,201 @@
+#ifndef BIORBD_INTERNAL_FORCES_PATH_KINEMATICS_H
+#define BIORBD_INTERNAL_FORCES_PATH_KINEMATICS_H
+
+#include "biorbdConfig.h"
+
+#include <vector>
+
+#include "Utils/Matrix.h"
+#include "Utils/Matrix3d.h"
+#include "Utils/Scalar.h"
+#include "Utils/Vector.h"
+#include "Utils/Vector3d.h"
+
+namespace BIORBD_NAMESPACE {
+namespace rigidbody {
+class Joints;
+class GeneralizedCoordinates;
+}  // namespace rigidbody
+
+namespace internal_forces {
+class PathModifiers;
+
+///
+/// \brief Batched kinematics of the attachment and via points of a set of
+/// paths (muscles, ligaments, ...)
+///
+/// All the points of all the paths are gathered in a single point table. When
+/// updated, the frame and the 6D Jacobian of each body carrying at least one
+/// point are computed once, and the position and Jacobian of every point are
+/// deduced from them. The length of each path and the Jacobian of these lengths
+/// (the moment-arm matrix) are assembled directly from the point table.
+///
+/// Paths with a wrapping object cannot be expressed as a list of points fixed
+/// on the bodies. They are registered, but are not batched: their points and
+/// lengths are left untouched by update() and must be filled by the caller.
+///
+/// The local positions of the points are copied when the path is added. If an
+/// attachment or via point is moved afterward, the table must be rebuilt.
+///
+/// At the first update, the DoFs each body depends on are read from the
+/// structure of its Jacobian. The point and length Jacobians are only filled
+/// on the DoFs spanned by each path, and the joint torque of the path forces
+/// is a sparse product over these DoFs (with the CasADi backend, every path
+/// spans all the DoFs).
+///
+class BIORBD_API PathKinematics {
+ public:
+  ///
+  /// \brief Construct an empty point table
+  ///
+  PathKinematics();
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~PathKinematics();
+
+  ///
+  /// \brief Remove all the paths from the table
+  ///
+  void clear();
+
+  ///
+  /// \brief Add a path to the table
+  /// \param model The joint model
+  /// \param origin The origin of the path in the local reference frame
+  /// \param insertion The insertion of the path in the local reference frame
+  /// \param pathModifiers The via points or wrapping objects of the path
+  /// \return The index of the path in the table
+  ///
+  size_t addPath(
+      const rigidbody::Joints& model,
+      const utils::Vector3d& origin,
+      const utils::Vector3d& insertion,
+      const PathModifiers& pathModifiers);
+
+  ///
+  /// \brief Return the number of paths in the table
+  /// \return The number of paths
+  ///
+  size_t nbPaths() const;
+
+  ///
+  /// \brief Return if a path is computed by update()
+  /// \param idx The index of the path
+  /// \return If the path is computed by update() (false for wrapping paths)
+  ///
+  bool isBatched(size_t idx) const;
+
+  ///
+  /// \brief Compute the position and Jacobian of all the points, the length of
+  /// all the batched paths and their Jacobian
+  /// \param updatedModel The joint model updated to Q
+  /// \param Q The generalized coordinates
+  ///
+  /// Warning: This function assumes that the kinematics of updatedModel is
+  /// already computed at Q
+  ///
+  void update(
+      rigidbody::Joints& updatedModel,
+      const rigidbody::GeneralizedCoordinates& Q);
+
+  ///
+  /// \brief Return the points of a path in the global reference frame
+  /// \param idx The index of the path
+  /// \return The points of the path
+  ///
+  std::vector<utils::Vector3d>& pointsInGlobal(size_t idx);
+
+  ///
+  /// \brief Return the Jacobian of the points of a path
+  /// \param idx The index of the path
+  /// \return The Jacobian of the points (3*nbPoints x nbDof)
+  ///
+  utils::Matrix& pointsJacobian(size_t idx);
+
+  ///
+  /// \brief Return the length of the paths
+  /// \return The length of the paths
+  ///
+  utils::Vector& lengths();
+
+  ///
+  /// \brief Return the Jacobian of the length of the paths
+  /// \return The Jacobian of the length of the paths (nbPaths x nbDof)
+  ///
+  utils::Matrix& lengthJacobian();
+
+  ///
+  /// \brief Return the DoFs a path depends on
+  /// \param idx The index of the path
+  /// \return The sorted indices of the DoFs spanned by the path (all the DoFs
+  /// for a wrapping path)
+  ///
+  /// Warning: The DoFs are only known after the first update()
+  ///
+  const std::vector<size_t>& dofs(size_t idx) const;
+
+  ///
+  /// \brief Compute the joint torque produced by the forces of the paths
+  /// \param forces The force of each path
+  /// \param tau The joint torque \f$-J^T F\f$ (output, must be of size nbDof)
+  ///
+  /// Only the DoFs spanned by each path are visited
+  ///
+  /// Warning: This function assumes that the table is updated and that the
+  /// rows of the wrapping paths were filled in the length Jacobian
+  ///
+  void jointTorque(const utils::Vector& forces, utils::Vector& tau) const;
+
+ protected:
+  ///
+  /// \brief Read the DoFs of each body from its Jacobian and deduce the DoFs
+  /// of each path
+  ///
+  void computeDofs();
+
+  ///
+  /// \brief Return the index of a body in the table, adding it if needed
+  /// \param model The joint model
+  /// \param name The name of the body
+  /// \return The index of the body in the table
+  ///
+  size_t bodyIndex(const rigidbody::Joints& model, const utils::String& name);
+
+  ///
+  /// \brief Add a point to the table
+  /// \param model The joint model
+  /// \param point The point in the local reference frame
+  ///
+  void addPoint(const rigidbody::Joints& model, const utils::Vector3d& point);
+
+  size_t m_nbDof;  ///< Number of degrees of freedom of the model
+
+  std::vector<unsigned int> m_bodyId;  ///< The RBDL id of each body
+  std::vector<utils::Vector3d> m_bodyOrigin;  ///< Origin of each body
+  std::vector<utils::Matrix3d>
+      m_bodyRotation;  ///< Rotation from global to body of each body
+  std::vector<utils::Matrix> m_bodyJacobian;  ///< 6D Jacobian of each body
+  std::vector<std::vector<size_t>>
+      m_bodyDofs;  ///< DoFs each body depends on
+
+  std::vector<size_t> m_pointBody;  ///< Index of the body of each point
+  std::vector<utils::Vector3d> m_pointInLocal;  ///< Local position of each point
+
+  std::vector<size_t> m_firstPoint;  ///< Index of the first point of each path
+  std::vector<bool> m_isBatched;     ///< If the path is computed by update()
+  std::vector<std::vector<utils::Vector3d>>
+      m_pointsInGlobal;  ///< Points of each path in global reference frame
+  std::vector<utils::Matrix> m_pointsJacobian;  ///< Jacobian of each path
+  std::vector<std::vector<size_t>> m_pathDofs;  ///< DoFs spanned by each path
+  bool m_isDofsComputed;  ///< If the DoFs of the bodies and paths are known
+
+  utils::Vector m_lengths;         ///< Length of each path
+  utils::Matrix m_lengthJacobian;  ///< Jacobian of the length of each path
+};
+
+}  // namespace internal_forces
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_INTERNAL_FORCES_PATH_KINEMATICS_H
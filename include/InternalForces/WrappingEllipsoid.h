@@ -0,0 +1,292 @@
+#ifndef BIORBD_MUSCLES_WRAPPING_ELLIPSOID_H
+#define BIORBD_MUSCLES_WRAPPING_ELLIPSOID_H
+
+#include "biorbdConfig.h"
+
+#include "InternalForces/WrappingObject.h"
+
+namespace BIORBD_NAMESPACE {
+namespace internal_forces {
+///
+/// \brief Ellipsoid object that makes the muscle to wrap around
+///
+/// The path is the shortest one around the ellipsoid: the straight parts are
+/// tangent to the ellipsoid and the part on the ellipsoid is a geodesic. It is
+/// found by Newton iterations on the tangency conditions, the geodesic being
+/// integrated from the point where the path touches the ellipsoid. The
+/// iterations start from the section of the ellipsoid by the plane of the two
+/// nodes and its center (the image of the shortest path around the sphere the
+/// ellipsoid is scaled to), which is also kept if they fail.
+///
+/// Watch out, the CasADi backend always assumes contact between the muscle and
+/// the ellipsoid.
+///
+class BIORBD_API WrappingEllipsoid : public WrappingObject {
+ public:
+  ///
+  /// \brief Construct a wrapping ellipsoid
+  ///
+  WrappingEllipsoid();
+
+  ///
+  /// \brief Construct a wrapping ellipsoid
+  /// \param rt RotoTrans matrix of the center of the ellipsoid (its axes being
+  /// the axes of the ellipsoid)
+  /// \param semiAxes The length of the semi-axes of the ellipsoid
+  ///
+  WrappingEllipsoid(
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& semiAxes);
+
+  ///
+  /// \brief Construct a wrapping ellipsoid
+  /// \param rt RotoTrans matrix of the center of the ellipsoid (its axes being
+  /// the axes of the ellipsoid)
+  /// \param semiAxes The length of the semi-axes of the ellipsoid
+  /// \param name The name of the ellipsoid
+  /// \param parentName The parent name segment
+  ///
+  WrappingEllipsoid(
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& semiAxes,
+      const utils::String& name,
+      const utils::String& parentName);
+
+  ///
+  /// \brief Deep copy of the wrapping ellipsoid
+  /// \return A deep copy of the wrapping ellipsoid
+  ///
+  WrappingEllipsoid DeepCopy() const;
+
+  ///
+  /// \brief Deep copy of the wrapping ellipsoid in another wrapping ellipsoid
+  /// \param other The wrapping ellipsoid to copy
+  ///
+  void DeepCopy(const WrappingEllipsoid& other);
+
+  ///
+  /// \brief From the position of the ellipsoid, return the 2 locations where
+  /// the muscle leaves the wrapping object
+  /// \param rt RotoTrans matrix of the ellipsoid
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param p1 The 1st position on the ellipsoid the muscle leave
+  /// \param p2 The 2nd position on the ellipsoid the muscle leave
+  /// \param length Length of the muscle on the ellipsoid (ignored if no value
+  /// is provided)
+  ///
+  /// If the straight line does not pass through the ellipsoid, p1 and p2 are
+  /// put at one and two thirds of that line
+  ///
+  virtual void wrapPoints(
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Vector3d& p1,
+      utils::Vector3d& p2,
+      utils::Scalar* length = nullptr);
+
+  ///
+  /// \brief From the position of the ellipsoid, return the 2 locations where
+  /// the muscle leaves the wrapping object
+  /// \param model The joint model
+  /// \param Q The generalized coordinates
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param p1 The 1st position on the ellipsoid the muscle leave
+  /// \param p2 The 2nd position on the ellipsoid the muscle leave
+  /// \param length Length of the muscle on the ellipsoid (ignored if no value
+  /// is provided)
+  ///
+  virtual void wrapPoints(
+      rigidbody::Joints& model,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Vector3d& p1,
+      utils::Vector3d& p2,
+      utils::Scalar* length = nullptr);
+
+  ///
+  /// \brief Returns the previously computed 2 locations where the muscle leaves
+  /// the ellipsoid
+  /// \param p1 The 1st position on the ellipsoid the muscle leave
+  /// \param p2 The 2nd position on the ellipsoid the muscle leave
+  /// \param length Length of the muscle on the ellipsoid (ignored if no value
+  /// is provided)
+  ///
+  virtual void wrapPoints(
+      utils::Vector3d& p1,
+      utils::Vector3d& p2,
+      utils::Scalar* length = nullptr);
+
+  ///
+  /// \brief Return the derivative of the length of the path going from p1_bone
+  /// to p2_bone around the ellipsoid with respect to the position of these two
+  /// nodes, the ellipsoid being held fixed
+  /// \param rt RotoTrans matrix of the ellipsoid
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param dLdp1 The derivative of the length with respect to p1_bone
+  /// \param dLdp2 The derivative of the length with respect to p2_bone
+  ///
+  /// As the path is the shortest one, only the straight parts contribute to
+  /// the derivative. With the CasADi backend, the path is the section of the
+  /// ellipsoid and the derivative is computed by central finite differences
+  ///
+  virtual void lengthGradient(
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Vector3d& dLdp1,
+      utils::Vector3d& dLdp2) const;
+
+#ifndef BIORBD_USE_CASADI_MATH
+  ///
+  /// \brief Return the derivative of the 2 locations where the muscle leaves
+  /// the ellipsoid with respect to the position of the nodes, the ellipsoid
+  /// being held fixed
+  /// \param rt RotoTrans matrix of the ellipsoid
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param p1Wrap_p1 The derivative of the 1st location with respect to p1
+  /// \param p1Wrap_p2 The derivative of the 1st location with respect to p2
+  /// \param p2Wrap_p1 The derivative of the 2nd location with respect to p1
+  /// \param p2Wrap_p2 The derivative of the 2nd location with respect to p2
+  ///
+  virtual void wrapPointsJacobian(
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Matrix3d& p1Wrap_p1,
+      utils::Matrix3d& p1Wrap_p2,
+      utils::Matrix3d& p2Wrap_p1,
+      utils::Matrix3d& p2Wrap_p2) const;
+#endif
+
+  ///
+  /// \brief Return the RotoTrans matrix of the ellipsoid
+  /// \param model The joint model
+  /// \param Q The generalized coordinates
+  /// \param updateKin If the kinematics should be computed
+  /// \return The RotoTrans matrix of the ellipsoid
+  ///
+  virtual const utils::RotoTrans& RT(
+      rigidbody::Joints& model,
+      const rigidbody::GeneralizedCoordinates& Q,
+      bool updateKin = true);
+
+  ///
+  /// \brief Set the length of the semi-axes of the ellipsoid
+  /// \param val The length of the semi-axes
+  ///
+  void setSemiAxes(const utils::Vector3d& val);
+
+  ///
+  /// \brief Return the length of the semi-axes of the ellipsoid
+  /// \return The length of the semi-axes
+  ///
+  const utils::Vector3d& semiAxes() const;
+
+ protected:
+  ///
+  /// \brief Compute the path around the ellipsoid in its reference frame
+  /// \param p1 1st position of the muscle node in the reference of the
+  /// ellipsoid
+  /// \param p2 2nd position of the muscle node in the reference of the
+  /// ellipsoid
+  /// \param p1_wrap The 1st position on the ellipsoid the muscle leave
+  /// \param p2_wrap The 2nd position on the ellipsoid the muscle leave
+  /// \param length Length of the muscle on the ellipsoid
+  /// \return If the path wraps around the ellipsoid
+  ///
+  bool wrapInLocal(
+      const utils::Vector3d& p1,
+      const utils::Vector3d& p2,
+      utils::Vector3d& p1_wrap,
+      utils::Vector3d& p2_wrap,
+      utils::Scalar& length) const;
+
+  ///
+  /// \brief Compute the section of the ellipsoid by the plane of the two nodes
+  /// and its center, in its reference frame
+  /// \param p1 1st position of the muscle node in the reference of the
+  /// ellipsoid
+  /// \param p2 2nd position of the muscle node in the reference of the
+  /// ellipsoid
+  /// \param p1_wrap The 1st position on the ellipsoid the muscle leave
+  /// \param p2_wrap The 2nd position on the ellipsoid the muscle leave
+  /// \param length Length of the muscle on the ellipsoid
+  /// \return If the path wraps around the ellipsoid
+  ///
+  bool sectionInLocal(
+      const utils::Vector3d& p1,
+      const utils::Vector3d& p2,
+      utils::Vector3d& p1_wrap,
+      utils::Vector3d& p2_wrap,
+      utils::Scalar& length) const;
+
+#ifdef BIORBD_USE_CASADI_MATH
+  ///
+  /// \brief Return the total length of the path going from p1 to p2 around the
+  /// ellipsoid
+  /// \param p1 1st position of the muscle node in the reference of the
+  /// ellipsoid
+  /// \param p2 2nd position of the muscle node in the reference of the
+  /// ellipsoid
+  /// \return The length of the path
+  ///
+  utils::Scalar pathLengthInLocal(
+      const utils::Vector3d& p1,
+      const utils::Vector3d& p2) const;
+#else
+  ///
+  /// \brief Find the geodesic path around the ellipsoid in its reference frame
+  /// \param p1 1st position of the muscle node in the reference of the
+  /// ellipsoid
+  /// \param p2 2nd position of the muscle node in the reference of the
+  /// ellipsoid
+  /// \param t1 The 1st position on the ellipsoid the muscle leave (the
+  /// initial guess on input)
+  /// \param t2 The 2nd position on the ellipsoid the muscle leave
+  /// \param length Length of the muscle on the ellipsoid (the initial guess on
+  /// input)
+  /// \return If the iterations converged to a valid path
+  ///
+  bool geodesicInLocal(
+      const utils::Vector3d& p1,
+      const utils::Vector3d& p2,
+      utils::Vector3d& t1,
+      utils::Vector3d& t2,
+      utils::Scalar& length) const;
+
+  ///
+  /// \brief Return the diagonal of the Hessian of the implicit equation of the
+  /// ellipsoid
+  /// \return The diagonal of the Hessian (2 / a_i^2)
+  ///
+  utils::Vector3d geodesicHessian() const;
+
+  ///
+  /// \brief Return the largest normal curvature of the ellipsoid
+  /// \return The largest normal curvature
+  ///
+  double geodesicCurvature() const;
+#endif
+
+  std::shared_ptr<utils::Vector3d>
+      m_semiAxes;  ///< Length of the semi-axes of the ellipsoid
+  std::shared_ptr<utils::RotoTrans>
+      m_RTtoParent;  ///< RotoTrans matrix with the parent
+  std::shared_ptr<utils::Vector3d>
+      m_p1Wrap;  ///< First point of contact with the wrap
+  std::shared_ptr<utils::Vector3d>
+      m_p2Wrap;  ///< Second point of contact with the wrap
+  std::shared_ptr<utils::Scalar>
+      m_lengthAroundWrap;  ///< Length between p1 and p2
+};
+
+}  // namespace internal_forces
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_MUSCLES_WRAPPING_ELLIPSOID_H
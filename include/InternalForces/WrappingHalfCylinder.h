@@ -6,6 +6,10 @@
 #include "InternalForces/WrappingObject.h"
 
 namespace BIORBD_NAMESPACE {
+namespace utils {
+class Matrix3d;
+}
+
 namespace internal_forces {
 ///
 /// \brief Half cylinder of infinite length (the length only affect the
@@ -123,6 +127,50 @@ class BIORBD_API WrappingHalfCylinder : public WrappingObject {
       utils::Vector3d& p2,
       utils::Scalar* length = nullptr);
 
+  ///
+  /// \brief Return the derivative of the length of the path going from p1_bone
+  /// to p2_bone around the half cylinder with respect to the position of these
+  /// two nodes, the half cylinder being held fixed
+  /// \param rt RotoTrans matrix of the half cylinder
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param dLdp1 The derivative of the length with respect to p1_bone
+  /// \param dLdp2 The derivative of the length with respect to p2_bone
+  ///
+  /// The derivative is the exact derivative of the length computed by
+  /// wrapPoints (including the motion of the points where the muscle leaves the
+  /// half cylinder)
+  ///
+  virtual void lengthGradient(
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Vector3d& dLdp1,
+      utils::Vector3d& dLdp2) const;
+
+#ifndef BIORBD_USE_CASADI_MATH
+  ///
+  /// \brief Return the derivative of the points where the path leaves the
+  /// half cylinder with respect to the position of the two nodes, the half
+  /// cylinder being held fixed
+  /// \param rt RotoTrans matrix of the half cylinder
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param p1Wrap_p1 The derivative of the 1st point with respect to p1_bone
+  /// \param p1Wrap_p2 The derivative of the 1st point with respect to p2_bone
+  /// \param p2Wrap_p1 The derivative of the 2nd point with respect to p1_bone
+  /// \param p2Wrap_p2 The derivative of the 2nd point with respect to p2_bone
+  ///
+  virtual void wrapPointsJacobian(
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Matrix3d& p1Wrap_p1,
+      utils::Matrix3d& p1Wrap_p2,
+      utils::Matrix3d& p2Wrap_p1,
+      utils::Matrix3d& p2Wrap_p2) const;
+#endif
+
   ///
   /// \brief Return the RotoTrans matrix of the half cylinder
   /// \param model The joint model
@@ -193,6 +241,16 @@ class BIORBD_API WrappingHalfCylinder : public WrappingObject {
   void findTangentToCircle(const utils::Vector3d& p, utils::Vector3d& p_tan)
       const;
 
+  ///
+  /// \brief Compute the derivative of the selected tangent of a point with the
+  /// circle with respect to this point
+  /// \param p The point
+  /// \param jaco The derivative (only the X and Y components are filled, the
+  /// rest is set to zero)
+  ///
+  void tangentToCircleJacobian(const utils::Vector3d& p, utils::Matrix3d& jaco)
+      const;
+
   ///
   /// \brief Select between a set of nodes which ones to keep
   /// \param p The 2 muscles points
@@ -211,6 +269,45 @@ class BIORBD_API WrappingHalfCylinder : public WrappingObject {
       const NodeMusclePair& pointsInGlobal,
       NodeMusclePair& pointsToWrap) const;
 
+  ///
+  /// \brief Complete the derivative of a point to wrap with its height
+  /// \param pointsInGlobal The position of the muscle pair in the reference
+  /// frame of the half cylinder
+  /// \param pointToWrap The point to wrap (as computed by findVerticalNode)
+  /// \param jacoP1 The derivative of the point with respect to the 1st node.
+  /// The X and Y components must be filled, the Z component is computed
+  /// \param jacoP2 The derivative of the point with respect to the 2nd node.
+  /// The X and Y components must be filled, the Z component is computed
+  ///
+  void verticalNodeJacobian(
+      const NodeMusclePair& pointsInGlobal,
+      const utils::Vector3d& pointToWrap,
+      utils::Matrix3d& jacoP1,
+      utils::Matrix3d& jacoP2) const;
+
+  ///
+  /// \brief Find the points leaving the half cylinder and their derivative
+  /// with respect to the nodes, all expressed in the reference frame of the
+  /// half cylinder
+  /// \param p1 1st position of the muscle node
+  /// \param p2 2nd position of the muscle node
+  /// \param t1 The 1st position on the half cylinder the muscle leave
+  /// \param t2 The 2nd position on the half cylinder the muscle leave
+  /// \param t1_p1 The derivative of t1 with respect to p1
+  /// \param t1_p2 The derivative of t1 with respect to p2
+  /// \param t2_p1 The derivative of t2 with respect to p1
+  /// \param t2_p2 The derivative of t2 with respect to p2
+  ///
+  void wrapPointsInLocal(
+      const utils::Vector3d& p1,
+      const utils::Vector3d& p2,
+      utils::Vector3d& t1,
+      utils::Vector3d& t2,
+      utils::Matrix3d& t1_p1,
+      utils::Matrix3d& t1_p2,
+      utils::Matrix3d& t2_p1,
+      utils::Matrix3d& t2_p2) const;
+
 #ifndef BIORBD_USE_CASADI_MATH
   ///
   /// \brief Check if a wrapper has to be done
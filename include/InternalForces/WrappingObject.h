@@ -8,6 +8,7 @@
 
 namespace BIORBD_NAMESPACE {
 namespace utils {
+class Matrix3d;
 class String;
 }
 
@@ -127,6 +128,50 @@ class BIORBD_API WrappingObject : public utils::Vector3d {
       utils::Vector3d& p2,
       utils::Scalar* muscleLength = nullptr) = 0;  // Assume un appel déja faits
 
+  ///
+  /// \brief Return the derivative of the length of the path going from p1_bone
+  /// to p2_bone around the wrapping object with respect to the position of
+  /// these two nodes, the wrapping object being held fixed
+  /// \param rt RotoTrans matrix of the wrapping object
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param dLdp1 The derivative of the length with respect to p1_bone
+  /// \param dLdp2 The derivative of the length with respect to p2_bone
+  ///
+  virtual void lengthGradient(
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Vector3d& dLdp1,
+      utils::Vector3d& dLdp2) const;
+
+#ifndef BIORBD_USE_CASADI_MATH
+  ///
+  /// \brief Return the derivative of the points where the path leaves the
+  /// wrapping object with respect to the position of the two nodes, the
+  /// wrapping object being held fixed
+  /// \param rt RotoTrans matrix of the wrapping object
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param p1Wrap_p1 The derivative of the 1st point with respect to p1_bone
+  /// \param p1Wrap_p2 The derivative of the 1st point with respect to p2_bone
+  /// \param p2Wrap_p1 The derivative of the 2nd point with respect to p1_bone
+  /// \param p2Wrap_p2 The derivative of the 2nd point with respect to p2_bone
+  ///
+  /// This is needed to differentiate the paths going around several wrapping
+  /// objects in a row, the nodes of the next object being the points leaving
+  /// the previous one
+  ///
+  virtual void wrapPointsJacobian(
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Matrix3d& p1Wrap_p1,
+      utils::Matrix3d& p1Wrap_p2,
+      utils::Matrix3d& p2Wrap_p1,
+      utils::Matrix3d& p2Wrap_p2) const;
+#endif
+
   ///
   /// \brief Return the RotoTrans matrix of the wrapping object
   /// \param model The joint model
@@ -155,6 +200,33 @@ class BIORBD_API WrappingObject : public utils::Vector3d {
   }
 #endif
  protected:
+  ///
+  /// \brief Find the shortest path around a sphere centered on the origin
+  /// \param p1 1st position of the muscle node
+  /// \param p2 2nd position of the muscle node
+  /// \param radius The radius of the sphere
+  /// \param e1 First axis of the plane of the path (pointing toward p1)
+  /// \param e2 Second axis of the plane of the path (toward p2)
+  /// \param theta1 Angle (from e1) of the point where the path touches the
+  /// sphere coming from p1
+  /// \param theta2 Angle (from e1) of the point where the path leaves the
+  /// sphere going to p2
+  /// \return If the path wraps around the sphere
+  ///
+  /// The shortest path lies in the plane of the two nodes and the center of the
+  /// sphere. It is found in closed form from the tangents of the nodes with the
+  /// great circle of that plane. Watch out, the CasADi backend always assumes
+  /// that the path wraps.
+  ///
+  static bool greatCircleWrap(
+      const utils::Vector3d& p1,
+      const utils::Vector3d& p2,
+      const utils::Scalar& radius,
+      utils::Vector3d& e1,
+      utils::Vector3d& e2,
+      utils::Scalar& theta1,
+      utils::Scalar& theta2);
+
   std::shared_ptr<utils::RotoTrans>
       m_RT;  ///< RotoTrans matrix of the wrapping object
 };
@@ -67,33 +67,101 @@ class BIORBD_API WrappingSphere : public WrappingObject {
   void DeepCopy(const WrappingSphere& other);
 
   ///
-  /// \brief Not yet implemented
+  /// \brief From the position of the sphere, return the 2 locations where the
+  /// muscle leaves the wrapping object
+  /// \param rt RotoTrans matrix of the sphere
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param p1 The 1st position on the sphere the muscle leave
+  /// \param p2 The 2nd position on the sphere the muscle leave
+  /// \param length Length of the muscle on the sphere (ignored if no value is
+  /// provided)
+  ///
+  /// The muscle follows the shortest path (along a great circle). If the
+  /// straight line does not pass through the sphere, p1 and p2 are put at one
+  /// and two thirds of that line
   ///
   virtual void wrapPoints(
-      const utils::RotoTrans&,
-      const utils::Vector3d&,
-      const utils::Vector3d&,
-      utils::Vector3d&,
-      utils::Vector3d&,
-      utils::Scalar* = nullptr) {}
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Vector3d& p1,
+      utils::Vector3d& p2,
+      utils::Scalar* length = nullptr);
 
   ///
-  /// \brief Not yet implemented
+  /// \brief From the position of the sphere, return the 2 locations where the
+  /// muscle leaves the wrapping object
+  /// \param model The joint model
+  /// \param Q The generalized coordinates
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param p1 The 1st position on the sphere the muscle leave
+  /// \param p2 The 2nd position on the sphere the muscle leave
+  /// \param length Length of the muscle on the sphere (ignored if no value is
+  /// provided)
   ///
   virtual void wrapPoints(
-      rigidbody::Joints&,
-      const rigidbody::GeneralizedCoordinates&,
-      const utils::Vector3d&,
-      const utils::Vector3d&,
-      utils::Vector3d&,
-      utils::Vector3d&,
-      utils::Scalar* = nullptr) {}
+      rigidbody::Joints& model,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Vector3d& p1,
+      utils::Vector3d& p2,
+      utils::Scalar* length = nullptr);
 
   ///
-  /// \brief Not yet implemented
+  /// \brief Returns the previously computed 2 locations where the muscle leaves
+  /// the sphere
+  /// \param p1 The 1st position on the sphere the muscle leave
+  /// \param p2 The 2nd position on the sphere the muscle leave
+  /// \param length Length of the muscle on the sphere (ignored if no value is
+  /// provided)
   ///
-  virtual void
-  wrapPoints(utils::Vector3d&, utils::Vector3d&, utils::Scalar* = nullptr) {}
+  virtual void wrapPoints(
+      utils::Vector3d& p1,
+      utils::Vector3d& p2,
+      utils::Scalar* length = nullptr);
+
+  ///
+  /// \brief Return the derivative of the length of the path going from p1_bone
+  /// to p2_bone around the sphere with respect to the position of these two
+  /// nodes, the sphere being held fixed
+  /// \param rt RotoTrans matrix of the sphere
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param dLdp1 The derivative of the length with respect to p1_bone
+  /// \param dLdp2 The derivative of the length with respect to p2_bone
+  ///
+  virtual void lengthGradient(
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Vector3d& dLdp1,
+      utils::Vector3d& dLdp2) const;
+
+#ifndef BIORBD_USE_CASADI_MATH
+  ///
+  /// \brief Return the derivative of the points where the path leaves the
+  /// sphere with respect to the position of the two nodes, the sphere being
+  /// held fixed
+  /// \param rt RotoTrans matrix of the sphere
+  /// \param p1_bone 1st position of the muscle node
+  /// \param p2_bone 2nd position of the muscle node
+  /// \param p1Wrap_p1 The derivative of the 1st point with respect to p1_bone
+  /// \param p1Wrap_p2 The derivative of the 1st point with respect to p2_bone
+  /// \param p2Wrap_p1 The derivative of the 2nd point with respect to p1_bone
+  /// \param p2Wrap_p2 The derivative of the 2nd point with respect to p2_bone
+  ///
+  virtual void wrapPointsJacobian(
+      const utils::RotoTrans& rt,
+      const utils::Vector3d& p1_bone,
+      const utils::Vector3d& p2_bone,
+      utils::Matrix3d& p1Wrap_p1,
+      utils::Matrix3d& p1Wrap_p2,
+      utils::Matrix3d& p2Wrap_p1,
+      utils::Matrix3d& p2Wrap_p2) const;
+#endif
 
   ///
   /// \brief Return the RotoTrans matrix of the sphere
@@ -120,7 +188,29 @@ class BIORBD_API WrappingSphere : public WrappingObject {
   const utils::Scalar& diameter() const;
 
  protected:
+  ///
+  /// \brief Compute the path around the sphere in its reference frame
+  /// \param p1 1st position of the muscle node in the reference of the sphere
+  /// \param p2 2nd position of the muscle node in the reference of the sphere
+  /// \param p1_wrap The 1st position on the sphere the muscle leave
+  /// \param p2_wrap The 2nd position on the sphere the muscle leave
+  /// \param length Length of the muscle on the sphere
+  /// \return If the path wraps around the sphere
+  ///
+  bool wrapInLocal(
+      const utils::Vector3d& p1,
+      const utils::Vector3d& p2,
+      utils::Vector3d& p1_wrap,
+      utils::Vector3d& p2_wrap,
+      utils::Scalar& length) const;
+
   std::shared_ptr<utils::Scalar> m_dia;  ///< Diameter of the wrapping sphere
+  std::shared_ptr<utils::Vector3d>
+      m_p1Wrap;  ///< First point of contact with the wrap
+  std::shared_ptr<utils::Vector3d>
+      m_p2Wrap;  ///< Second point of contact with the wrap
+  std::shared_ptr<utils::Scalar>
+      m_lengthAroundWrap;  ///< Length between p1 and p2
 };
 
 }  // namespace internal_forces
@@ -5,8 +5,10 @@
 
 #include "InternalForces/Compound.h"
 #include "InternalForces/Geometry.h"
+#include "InternalForces/PathKinematics.h"
 #include "InternalForces/PathModifiers.h"
 #include "InternalForces/ViaPoint.h"
+#include "InternalForces/WrappingEllipsoid.h"
 #include "InternalForces/WrappingHalfCylinder.h"
 #include "InternalForces/WrappingObject.h"
 #include "InternalForces/WrappingSphere.h"
@@ -0,0 +1,234 @@
+#ifndef BIORBD_RIGIDBODY_CONTACT_SURFACE_H
+#define BIORBD_RIGIDBODY_CONTACT_SURFACE_H
+
+#include "biorbdConfig.h"
+
+#include <vector>
+
+#include "Utils/Vector3d.h"
+
+namespace BIORBD_NAMESPACE {
+namespace utils {
+class Matrix;
+class Matrix3d;
+}  // namespace utils
+
+namespace rigidbody {
+class Mesh;
+
+#ifndef BIORBD_USE_CASADI_MATH
+///
+/// \brief A triangulated surface of the environment the soft contacts can
+/// collide with (terrain, stairs, chair, ...)
+///
+/// The surface is made of triangles expressed in global reference frame,
+/// either from a mesh (e.g. read by Reader::readMeshFileStl) or from a regular
+/// grid of heights. A bounding volume hierarchy of axis aligned boxes is built
+/// once at construction, so the closest triangle of a point is found in
+/// O(log n). The normal of a triangle follows the right-hand rule on the order
+/// of its vertices and must point out of the surface.
+///
+/// As the closest triangle is a discrete choice, the surfaces are not
+/// available with the CasADi backend.
+///
+class BIORBD_API ContactSurface {
+ public:
+  ///
+  /// \brief Construct an empty surface
+  ///
+  ContactSurface();
+
+  ///
+  /// \brief Construct a surface from a mesh
+  /// \param mesh The mesh in global reference frame
+  ///
+  /// Faces with more than three vertices are split in triangle fans
+  ///
+  ContactSurface(const Mesh& mesh);
+
+  ///
+  /// \brief Construct a surface from a regular grid of heights
+  /// \param heights The heights (along z) of the nodes of the grid, the rows
+  /// being along x and the columns along y
+  /// \param origin The position of the first node of the grid
+  /// \param spacingX The distance between two nodes along x
+  /// \param spacingY The distance between two nodes along y
+  ///
+  ContactSurface(
+      const utils::Matrix& heights,
+      const utils::Vector3d& origin,
+      double spacingX,
+      double spacingY);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~ContactSurface();
+
+  ///
+  /// \brief Return the number of triangles of the surface
+  /// \return The number of triangles
+  ///
+  size_t nbTriangles() const;
+
+  ///
+  /// \brief Return the normal of a triangle
+  /// \param idx The index of the triangle
+  /// \return The unit normal of the triangle
+  ///
+  const utils::Vector3d& triangleNormal(size_t idx) const;
+
+  ///
+  /// \brief Find the closest point of the surface to a point
+  /// \param x The point in global reference frame
+  /// \param maxDistance The triangles further than this distance are ignored
+  /// \param point The closest point of the surface
+  /// \param triangle The index of the closest triangle. If it is a valid
+  /// index when called, this triangle is tested first (warm start) so most of
+  /// the hierarchy is pruned when the point did not move much
+  /// \return If a triangle was found closer than maxDistance
+  ///
+  bool closestPoint(
+      const utils::Vector3d& x,
+      double maxDistance,
+      utils::Vector3d& point,
+      size_t& triangle) const;
+
+  ///
+  /// \brief Return the axis aligned box containing the surface once moved
+  /// \param rotation The rotation applied to the surface
+  /// \param translation The translation applied to the surface
+  /// \param lower The lower corner of the box
+  /// \param upper The upper corner of the box
+  ///
+  void boundingBox(
+      const utils::Matrix3d& rotation,
+      const utils::Vector3d& translation,
+      utils::Vector3d& lower,
+      utils::Vector3d& upper) const;
+
+  ///
+  /// \brief Find the closest points between this surface and another one
+  /// \param other The other surface
+  /// \param rotation The rotation of the other surface in this one
+  /// \param translation The translation of the other surface in this one
+  /// \param maxDistance The pairs of triangles further than this distance are
+  /// ignored
+  /// \param distance The distance between the surfaces (0 if they intersect)
+  /// \param point The closest point of this surface
+  /// \param otherPoint The closest point of the other surface (expressed in
+  /// this surface)
+  /// \return If the surfaces are closer than maxDistance
+  ///
+  /// Both hierarchies are descended together, so only the pairs of boxes
+  /// closer than the best distance so far are visited.
+  ///
+  bool distance(
+      const ContactSurface& other,
+      const utils::Matrix3d& rotation,
+      const utils::Vector3d& translation,
+      double maxDistance,
+      double& distance,
+      utils::Vector3d& point,
+      utils::Vector3d& otherPoint) const;
+
+  ///
+  /// \brief Return how deep the vertices of another surface are inside this
+  /// one
+  /// \param other The other surface
+  /// \param rotation The rotation of the other surface in this one
+  /// \param translation The translation of the other surface in this one
+  /// \return The distance between the deepest vertex and its closest point
+  /// of this surface (0 if no vertex is inside)
+  ///
+  /// A vertex is inside if it is behind the closest point of this surface,
+  /// so this surface must be closed with its normals pointing outward. When
+  /// the closest point is on an edge or a vertex, the normals of all the
+  /// triangles touching it are summed, weighted by their angle at the point,
+  /// so the side is the same whichever of these triangles was found first.
+  /// Only the leaves of the other hierarchy overlapping the box of this
+  /// surface are visited.
+  ///
+  /// Only the vertices are tested: two surfaces crossing each other through
+  /// their edges or faces, without any vertex inside, have a penetration of 0
+  /// (see distance to know if they intersect).
+  ///
+  double penetration(
+      const ContactSurface& other,
+      const utils::Matrix3d& rotation,
+      const utils::Vector3d& translation) const;
+
+ protected:
+  ///
+  /// \brief Add a triangle to the surface
+  /// \param a The first vertex
+  /// \param b The second vertex
+  /// \param c The third vertex
+  ///
+  void addTriangle(
+      const utils::Vector3d& a,
+      const utils::Vector3d& b,
+      const utils::Vector3d& c);
+
+  ///
+  /// \brief Build the bounding volume hierarchy of the triangles
+  ///
+  void buildHierarchy();
+
+  ///
+  /// \brief Build a node of the hierarchy and its children
+  /// \param first The first triangle of the node in m_order
+  /// \param last One past the last triangle of the node in m_order
+  /// \return The index of the node
+  ///
+  size_t buildNode(size_t first, size_t last);
+
+  ///
+  /// \brief Return the closest point of a triangle to a point
+  /// \param x The point
+  /// \param idx The index of the triangle
+  /// \return The closest point of the triangle
+  ///
+  utils::Vector3d closestPointOnTriangle(const utils::Vector3d& x, size_t idx)
+      const;
+
+  ///
+  /// \brief Return the squared distance between a point and a node box
+  /// \param x The point
+  /// \param node The index of the node
+  /// \return The squared distance (0 if inside the box)
+  ///
+  double squaredDistanceToNode(const utils::Vector3d& x, size_t node) const;
+
+  ///
+  /// \brief Return the direction pointing out of the surface at one of its
+  /// points
+  /// \param point The point of the surface
+  /// \param triangle The index of a triangle touching the point
+  /// \return The normal of the triangle if the point is inside its face, the
+  /// sum of the normals of the triangles touching the point weighted by their
+  /// angle at the point otherwise (not normalized)
+  ///
+  utils::Vector3d pseudoNormal(const utils::Vector3d& point, size_t triangle)
+      const;
+
+  std::vector<utils::Vector3d> m_vertexA;  ///< First vertex of the triangles
+  std::vector<utils::Vector3d> m_vertexB;  ///< Second vertex of the triangles
+  std::vector<utils::Vector3d> m_vertexC;  ///< Third vertex of the triangles
+  std::vector<utils::Vector3d> m_normal;   ///< Normal of the triangles
+
+  std::vector<utils::Vector3d> m_nodeMin;  ///< Lower corner of the node boxes
+  std::vector<utils::Vector3d> m_nodeMax;  ///< Upper corner of the node boxes
+  std::vector<size_t>
+      m_nodeLeft;  ///< Left child of the nodes (first triangle for a leaf)
+  std::vector<size_t> m_nodeRight;  ///< Right child of the nodes
+  std::vector<size_t>
+      m_nodeCount;  ///< Number of triangles of the leaves (0 if not a leaf)
+  std::vector<size_t> m_order;      ///< Triangles sorted by leaf
+};
+#endif
+
+}  // namespace rigidbody
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_RIGIDBODY_CONTACT_SURFACE_H
@@ -13,6 +13,7 @@
 namespace BIORBD_NAMESPACE {
 class Model;
 namespace utils {
+class Matrix;
 class Vector3d;
 class String;
 }  // namespace utils
@@ -215,6 +216,32 @@ class BIORBD_API ExternalForceSet {
       const rigidbody::GeneralizedVelocity& Qdot);
 #endif  // !SWIG
 
+#ifndef BIORBD_USE_CASADI_MATH
+  ///
+  /// \brief The derivatives of the generalized forces of the soft contacts
+  /// with respect to the state, computed analytically
+  /// \param updatedModel The joint model that with its kinematics updated
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocity
+  /// \param dTauDq The derivatives with respect to Q (nbQdot x nbQdot)
+  /// \param dTauDqdot The derivatives with respect to Qdot (nbQdot x nbQdot)
+  ///
+  /// The matrices are the contribution of the soft contacts to the Jacobian
+  /// of the generalized forces (i.e. the generalized forces added by the
+  /// contacts to the equations of motion). If the soft contacts were not
+  /// compiled, they are batched in a temporary set and stay not compiled
+  /// (see SoftContacts::detachedSoftContactSet). If useSoftContacts is false,
+  /// the matrices are zero. An error is raised for models with quaternions
+  /// (nbQ != nbQdot).
+  ///
+  void computeSoftContactJacobians(
+      rigidbody::Joints& updatedModel,
+      const rigidbody::GeneralizedCoordinates& Q,
+      const rigidbody::GeneralizedVelocity& Qdot,
+      utils::Matrix& dTauDq,
+      utils::Matrix& dTauDqdot);
+#endif
+
   ///
   /// \brief Return if there is at least one external force expressed in the
   /// local reference frame. This is important since having this forces to send
@@ -320,6 +320,14 @@ class BIORBD_API Joints : public RigidBodyDynamics::Model
   ///
   GeneralizedTorque computeDampedTau(const GeneralizedVelocity& Qdot) const;
 
+  ///
+  /// \brief Compute the joint dampings into a preallocated vector
+  /// \param Qdot The generalized velocities
+  /// \param tau The joint dampings (output, resized if needed)
+  ///
+  void computeDampedTau(const GeneralizedVelocity& Qdot, utils::Vector& tau)
+      const;
+
  public:
   ///
   /// \brief Update the kinematic variables such as body velocities and
@@ -0,0 +1,246 @@
+#ifndef BIORBD_RIGIDBODY_LOOP_CONSTRAINT_SOLVER_H
+#define BIORBD_RIGIDBODY_LOOP_CONSTRAINT_SOLVER_H
+
+#include "biorbdConfig.h"
+
+#include <vector>
+
+#ifndef BIORBD_USE_CASADI_MATH
+#include <Eigen/Cholesky>
+#include <Eigen/LU>
+#endif
+
+#include "Utils/Matrix.h"
+#include "Utils/Vector.h"
+
+namespace BIORBD_NAMESPACE {
+class Model;
+
+namespace rigidbody {
+class Contacts;
+class ExternalForceSet;
+class GeneralizedAcceleration;
+class GeneralizedCoordinates;
+class GeneralizedTorque;
+class GeneralizedVelocity;
+
+#ifndef BIORBD_USE_CASADI_MATH
+///
+/// \brief Forward dynamics of closed chains (models with loop constraints)
+/// with a persistent workspace
+///
+/// The constraints of the model (loop constraints and rigid contacts) are
+/// used in place, without copying the constraint set, and the matrices and
+/// factorizations are kept from one call to the next. The independent rows
+/// of the constraint Jacobian, and the partition of the generalized
+/// coordinates into dependent and independent ones, are chosen once and kept
+/// as long as they stay well conditioned, so redundant constraints (e.g. a
+/// planar four-bar closed by a 6D loop) are handled without a rank revealing
+/// factorization at each step.
+///
+/// Two formulations are available:
+/// - range space (default): the accelerations are deduced from the Schur
+/// complement G H^-1 G^T of the KKT system, of the size of the constraints;
+/// - null space: the dynamics is projected on the independent coordinates
+/// (N^T H N, of the size of the degrees of freedom of the closed chain).
+///
+/// The drift of the constraints can be stabilized with Baumgarte terms (in
+/// addition to the stabilization of the loop constraints defined in the
+/// model) and the positions and velocities can be projected back on the
+/// constraints by moving the dependent coordinates only.
+///
+/// The model must not be modified (e.g. adding constraints) once the solver
+/// is constructed.
+///
+class BIORBD_API LoopConstraintSolver {
+ public:
+  ///
+  /// \brief Construct a solver for the constraints of a model
+  /// \param model The model
+  /// \param useNullSpace If the null space formulation is used
+  ///
+  LoopConstraintSolver(Model& model, bool useNullSpace = false);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~LoopConstraintSolver();
+
+  ///
+  /// \brief Set the formulation of the dynamics
+  /// \param useNullSpace If the null space formulation is used
+  ///
+  void setNullSpace(bool useNullSpace);
+
+  ///
+  /// \brief Return if the null space formulation is used
+  /// \return If the null space formulation is used
+  ///
+  bool isNullSpace() const;
+
+  ///
+  /// \brief Set the Baumgarte stabilization of the constraints, the
+  /// acceleration of the constraints being corrected by
+  /// -2 * alpha * velocityError - beta^2 * positionError
+  /// \param alpha The velocity stabilization parameter
+  /// \param beta The position stabilization parameter
+  ///
+  void setStabilization(double alpha, double beta);
+
+  ///
+  /// \brief Return the number of constraints
+  /// \return The number of constraints
+  ///
+  size_t nbConstraints() const;
+
+  ///
+  /// \brief Return the number of independent constraints
+  /// \return The number of independent constraints (0 before the first call)
+  ///
+  size_t nbIndependentConstraints() const;
+
+  ///
+  /// \brief Return the generalized coordinates moved to satisfy the
+  /// constraints
+  /// \return The index of the dependent coordinates
+  ///
+  const std::vector<unsigned int>& dependentCoordinates() const;
+
+  ///
+  /// \brief Return the generalized coordinates left free by the constraints
+  /// \return The index of the independent coordinates
+  ///
+  const std::vector<unsigned int>& independentCoordinates() const;
+
+  ///
+  /// \brief Compute the constrained forward dynamics
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param Tau The generalized torques
+  /// \return The generalized accelerations
+  ///
+  GeneralizedAcceleration forwardDynamics(
+      const GeneralizedCoordinates& Q,
+      const GeneralizedVelocity& Qdot,
+      const GeneralizedTorque& Tau);
+
+  ///
+  /// \brief Compute the constrained forward dynamics
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param Tau The generalized torques
+  /// \param externalForces The external forces acting on the system
+  /// \return The generalized accelerations
+  ///
+  GeneralizedAcceleration forwardDynamics(
+      const GeneralizedCoordinates& Q,
+      const GeneralizedVelocity& Qdot,
+      const GeneralizedTorque& Tau,
+      ExternalForceSet& externalForces);
+
+  ///
+  /// \brief Return the constraint forces of the last forward dynamics
+  /// \return The constraint forces (same order and sign as
+  /// ContactForcesFromForwardDynamicsConstraintsDirect, 0 for the redundant
+  /// constraints)
+  ///
+  const utils::Vector& forces() const;
+
+  ///
+  /// \brief Move the dependent coordinates so the positions satisfy the
+  /// constraints (Newton iterations)
+  /// \param Q The generalized coordinates to project
+  /// \param tolerance The maximal position error accepted
+  /// \param maxIterations The maximal number of iterations
+  /// \return If the tolerance was reached
+  ///
+  bool projectPositions(
+      GeneralizedCoordinates& Q,
+      double tolerance = 1e-12,
+      size_t maxIterations = 20);
+
+  ///
+  /// \brief Set the dependent velocities so the velocities satisfy the
+  /// constraints
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities to project
+  ///
+  void projectVelocities(
+      const GeneralizedCoordinates& Q,
+      GeneralizedVelocity& Qdot);
+
+ protected:
+  ///
+  /// \brief Choose the independent constraints and the dependent coordinates
+  /// \param G The Jacobian of all the constraints
+  ///
+  void partition(const Eigen::MatrixXd& G);
+
+  ///
+  /// \brief Factorize the Jacobian of the independent constraints with
+  /// respect to the dependent coordinates, partitioning again if it is ill
+  /// conditioned
+  /// \param G The Jacobian of all the constraints
+  ///
+  void factorizeDependent(const Eigen::MatrixXd& G);
+
+  ///
+  /// \brief Solve the dynamics from the mass matrix and the constraints
+  /// \param G The Jacobian of all the constraints
+  /// \param effects Tau minus the nonlinear effects
+  /// \param Qddot The generalized accelerations
+  ///
+  void solveRangeSpace(
+      const Eigen::MatrixXd& G,
+      const utils::Vector& effects,
+      GeneralizedAcceleration& Qddot);
+
+  ///
+  /// \brief Solve the dynamics projected on the independent coordinates
+  /// \param G The Jacobian of all the constraints
+  /// \param effects Tau minus the nonlinear effects
+  /// \param Qddot The generalized accelerations
+  ///
+  void solveNullSpace(
+      const Eigen::MatrixXd& G,
+      const utils::Vector& effects,
+      GeneralizedAcceleration& Qddot);
+
+  Model& m_model;            ///< The model
+  Contacts& m_constraints;   ///< The constraint set of the model
+  bool m_useNullSpace;       ///< If the null space formulation is used
+  double m_alpha;            ///< Baumgarte velocity parameter
+  double m_beta;             ///< Baumgarte position parameter
+  bool m_isPartitioned;      ///< If the partition was chosen
+  size_t m_nbPartitionedConstraints;  ///< Number of constraints partitioned
+
+  std::vector<unsigned int> m_rows;  ///< Independent constraints
+  std::vector<unsigned int>
+      m_dependent;  ///< Coordinates moved by the constraints
+  std::vector<unsigned int>
+      m_independent;  ///< Coordinates left free by the constraints
+
+  utils::Vector m_gamma;  ///< Acceleration of the constraints
+  utils::Vector m_error;  ///< Position error of the constraints
+  utils::Vector m_forces;  ///< Constraint forces
+  utils::Matrix m_jacobian;  ///< Jacobian of the independent constraints
+  utils::Matrix
+      m_dependentJacobian;  ///< Jacobian with respect to the dependent dofs
+  utils::Matrix m_scaledJacobian;  ///< L^-1 G^T, with H = L L^T
+  utils::Matrix m_schur;  ///< G H^-1 G^T
+  utils::Matrix m_nullSpace;  ///< Basis of the null space of G
+  utils::Matrix m_reducedMass;  ///< N^T H N
+
+  Eigen::LLT<Eigen::MatrixXd> m_massFactorization;  ///< Factorization of H
+  Eigen::LLT<Eigen::MatrixXd>
+      m_reducedFactorization;  ///< Factorization of the Schur complement or
+                               ///< of the reduced mass matrix
+  Eigen::PartialPivLU<Eigen::MatrixXd>
+      m_dependentFactorization;  ///< Factorization of m_dependentJacobian
+};
+#endif
+
+}  // namespace rigidbody
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_RIGIDBODY_LOOP_CONSTRAINT_SOLVER_H
@@ -0,0 +1,250 @@
+#ifndef BIORBD_RIGIDBODY_RIGID_CONTACT_SOLVER_H
+#define BIORBD_RIGIDBODY_RIGID_CONTACT_SOLVER_H
+
+#include "biorbdConfig.h"
+
+#include <vector>
+
+#ifndef BIORBD_USE_CASADI_MATH
+#include <Eigen/Cholesky>
+#endif
+
+#include "Utils/Matrix.h"
+#include "Utils/Vector.h"
+
+namespace BIORBD_NAMESPACE {
+class Model;
+
+namespace rigidbody {
+class Contacts;
+class ExternalForceSet;
+class GeneralizedCoordinates;
+class GeneralizedTorque;
+class GeneralizedVelocity;
+
+#ifndef BIORBD_USE_CASADI_MATH
+///
+/// \brief Unilateral and frictional rigid contacts, solved at the velocity
+/// level by projected Gauss-Seidel
+///
+/// The rigid contacts of the model are used as they are declared: for each
+/// contact, the axis along the normal (z by default) becomes unilateral (the
+/// contact can only push and is released when it does not need to) and the
+/// other declared axes carry the friction, bounded by the Coulomb disk
+/// ||p_t|| <= mu * p_n. The loop constraints and the contacts that are not
+/// declared along the normal stay bilateral.
+///
+/// A contact is only activated when it is within reach during the step: the
+/// gap of a contact is its position along the normal (the ground being the
+/// plane through the origin normal to that axis) and its normal velocity at
+/// the end of the step is bounded by v_n >= -gap / dt. A contact away from the
+/// ground therefore lands exactly on it, and the penetration of a contact
+/// that is already in the ground is pushed out by a fraction of the gap at
+/// each step (position-level stabilization).
+///
+/// Each call solves for the impulses p of the contacts from
+/// W p + b = v+, with the Delassus matrix W = G H^-1 G^T built from a single
+/// Cholesky factorization of the mass matrix. The iterations only sweep over
+/// this small matrix and are bounded by a maximal number, so the cost of a
+/// step does not depend on the contacts that are active. The impulses of
+/// the previous call are used as the starting point of the next one.
+///
+class BIORBD_API RigidContactSolver {
+ public:
+  ///
+  /// \brief Construct a solver for the rigid contacts of a model
+  /// \param model The model
+  /// \param friction The friction coefficient
+  /// \param normalAxis The axis of the normal of the contacts in the global
+  /// reference frame (0 for x, 1 for y, 2 for z)
+  ///
+  RigidContactSolver(
+      Model& model,
+      double friction = 0.8,
+      unsigned int normalAxis = 2);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~RigidContactSolver();
+
+  ///
+  /// \brief Set the friction coefficient
+  /// \param friction The friction coefficient
+  ///
+  void setFriction(double friction);
+
+  ///
+  /// \brief Return the friction coefficient
+  /// \return The friction coefficient
+  ///
+  double friction() const;
+
+  ///
+  /// \brief Set the restitution coefficient of the normal velocities
+  /// \param restitution The restitution coefficient (0 for a plastic impact)
+  ///
+  void setRestitution(double restitution);
+
+  ///
+  /// \brief Return the restitution coefficient
+  /// \return The restitution coefficient
+  ///
+  double restitution() const;
+
+  ///
+  /// \brief Set the fraction of the penetration pushed out at each step
+  /// \param stabilization The fraction of the penetration (0 to let the
+  /// penetration drift)
+  ///
+  void setStabilization(double stabilization);
+
+  ///
+  /// \brief Return the fraction of the penetration pushed out at each step
+  /// \return The fraction of the penetration
+  ///
+  double stabilization() const;
+
+  ///
+  /// \brief Set the stopping criteria of the iterations
+  /// \param maxIterations The maximal number of sweeps over the contacts
+  /// \param tolerance The largest change of impulse accepted at convergence
+  ///
+  void setIterations(size_t maxIterations, double tolerance);
+
+  ///
+  /// \brief Return the number of unilateral contacts
+  /// \return The number of unilateral contacts
+  ///
+  size_t nbUnilateralContacts() const;
+
+  ///
+  /// \brief Compute the velocities at the end of a time step
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities at the beginning of the step
+  /// \param Tau The generalized torques
+  /// \param dt The duration of the step
+  /// \return The generalized velocities at the end of the step
+  ///
+  GeneralizedVelocity timeStep(
+      const GeneralizedCoordinates& Q,
+      const GeneralizedVelocity& Qdot,
+      const GeneralizedTorque& Tau,
+      double dt);
+
+  ///
+  /// \brief Compute the velocities at the end of a time step
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities at the beginning of the step
+  /// \param Tau The generalized torques
+  /// \param dt The duration of the step
+  /// \param externalForces The external forces acting on the system
+  /// \return The generalized velocities at the end of the step
+  ///
+  GeneralizedVelocity timeStep(
+      const GeneralizedCoordinates& Q,
+      const GeneralizedVelocity& Qdot,
+      const GeneralizedTorque& Tau,
+      double dt,
+      ExternalForceSet& externalForces);
+
+  ///
+  /// \brief Compute the velocities after an impact
+  /// \param Q The generalized coordinates
+  /// \param QdotPre The generalized velocities before the impact
+  /// \return The generalized velocities after the impact
+  ///
+  /// Only the contacts that touch the ground (gap of zero or less) are
+  /// involved in the impact
+  ///
+  GeneralizedVelocity impact(
+      const GeneralizedCoordinates& Q,
+      const GeneralizedVelocity& QdotPre);
+
+  ///
+  /// \brief Return the impulses of the constraints of the last call
+  /// \return The impulses (same order as the constraints of the model)
+  ///
+  const utils::Vector& impulses() const;
+
+  ///
+  /// \brief Return the gaps of the unilateral contacts of the last call
+  /// \return The position of each contact along the normal (negative when
+  /// the contact is in the ground)
+  ///
+  const utils::Vector& gaps() const;
+
+  ///
+  /// \brief Return the number of sweeps of the last call
+  /// \return The number of sweeps
+  ///
+  size_t nbIterations() const;
+
+  ///
+  /// \brief Forget the impulses of the previous call (e.g. after moving the
+  /// model to an unrelated state)
+  ///
+  void resetWarmStart();
+
+ protected:
+  ///
+  /// \brief Sort the constraints of the model into contacts
+  ///
+  /// Called again by timeStep and impact if the number of constraints of the
+  /// model changed since the last call (the warm start is then reset).
+  ///
+  void classifyConstraints();
+
+  ///
+  /// \brief Compute the gaps of the unilateral contacts
+  /// \param Q The generalized coordinates (the kinematics being updated)
+  ///
+  void updateGaps(const GeneralizedCoordinates& Q);
+
+  ///
+  /// \brief Solve for the impulses and the final velocities
+  /// \param Qdot The generalized velocities before the impulses
+  /// \param effects The generalized forces of the step (dt * (Tau - C))
+  /// \param dt The duration of the step (0 for an impact)
+  /// \param QdotPost The generalized velocities after the impulses
+  ///
+  void solve(
+      const GeneralizedVelocity& Qdot,
+      const utils::Vector& effects,
+      double dt,
+      GeneralizedVelocity& QdotPost);
+
+  Model& m_model;            ///< The model
+  Contacts& m_constraints;   ///< The constraint set of the model
+  unsigned int m_normalAxis;  ///< The axis of the normal of the contacts
+  double m_friction;         ///< Friction coefficient
+  double m_restitution;      ///< Restitution coefficient
+  double m_stabilization;    ///< Fraction of the penetration pushed out
+  size_t m_maxIterations;    ///< Maximal number of sweeps
+  double m_tolerance;        ///< Largest change of impulse at convergence
+  size_t m_nbIterations;     ///< Number of sweeps of the last call
+  size_t m_nbClassifiedConstraints;  ///< Number of constraints classified
+
+  std::vector<unsigned int> m_bilateralRows;  ///< Rows without bounds
+  std::vector<std::vector<unsigned int>>
+      m_tangentRows;  ///< Friction rows of each unilateral contact
+  std::vector<unsigned int>
+      m_normalRows;  ///< Normal row of each unilateral contact
+  std::vector<size_t>
+      m_contactIndices;  ///< Rigid contact of each unilateral contact
+  std::vector<bool> m_isActive;  ///< If the contact is within reach
+
+  utils::Vector m_gaps;  ///< Position of the contacts along the normal
+
+  utils::Vector m_impulses;  ///< Impulses of the constraints
+  utils::Vector m_velocity;  ///< G Qdot before the impulses
+  utils::Matrix m_scaledJacobian;  ///< L^-1 G^T, with H = L L^T
+  utils::Matrix m_delassus;  ///< G H^-1 G^T
+  Eigen::LLT<Eigen::MatrixXd> m_massFactorization;  ///< Factorization of H
+};
+#endif
+
+}  // namespace rigidbody
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_RIGIDBODY_RIGID_CONTACT_SOLVER_H
@@ -0,0 +1,176 @@
+#ifndef BIORBD_RIGIDBODY_SEGMENT_COLLISIONS_H
+#define BIORBD_RIGIDBODY_SEGMENT_COLLISIONS_H
+
+#include "biorbdConfig.h"
+
+#include <memory>
+#include <vector>
+
+#include "Utils/Matrix3d.h"
+#include "Utils/Vector3d.h"
+
+namespace BIORBD_NAMESPACE {
+namespace utils {
+class RotoTrans;
+}
+
+namespace rigidbody {
+class ContactSurface;
+class GeneralizedCoordinates;
+class Joints;
+
+#ifndef BIORBD_USE_CASADI_MATH
+///
+/// \brief Distance and penetration between the meshes of the segments of a
+/// model
+///
+/// A bounding volume hierarchy is built once over the triangles of the mesh of
+/// each segment, in the local reference frame of the segment. At each update,
+/// the boxes of the meshes are moved with the segment frames (as given by
+/// allGlobalJCS) to discard the pairs that are far apart (broad phase). The
+/// hierarchies of the remaining pairs are then descended together to find
+/// their closest points (narrow phase) and, if they intersect, how deep one
+/// mesh is inside the other. The hierarchies are never rebuilt, only the
+/// relative transformation of the two segments is computed.
+///
+/// The segments without faces in their mesh are ignored. The penetration
+/// assumes closed meshes with their normals pointing outward and only
+/// measures the vertices of each mesh inside the other one: two meshes
+/// crossing each other through their edges or faces, without any vertex
+/// inside, are colliding with a penetration of 0. When the closest point of
+/// a vertex is on an edge or a vertex of the other mesh, the side is taken
+/// from the normals of all the faces around it, which is only reliable for
+/// meshes without holes or flipped faces.
+///
+class BIORBD_API SegmentCollisions {
+ public:
+  ///
+  /// \brief Construct an empty collision set
+  ///
+  SegmentCollisions();
+
+  ///
+  /// \brief Construct the collision set of the segments of a model
+  /// \param model The joint model
+  /// \param ignoreAdjacentSegments If the pairs made of a segment and its
+  /// parent are ignored (their meshes usually touch at the joint)
+  ///
+  SegmentCollisions(const Joints& model, bool ignoreAdjacentSegments = true);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~SegmentCollisions();
+
+  ///
+  /// \brief Build the hierarchies of the meshes and the pairs to test
+  /// \param model The joint model
+  /// \param ignoreAdjacentSegments If the pairs made of a segment and its
+  /// parent are ignored (their meshes usually touch at the joint)
+  ///
+  void build(const Joints& model, bool ignoreAdjacentSegments = true);
+
+  ///
+  /// \brief Return the number of pairs of segments tested
+  /// \return The number of pairs
+  ///
+  size_t nbPairs() const;
+
+  ///
+  /// \brief Return the first segment of a pair
+  /// \param idx The index of the pair
+  /// \return The index of the first segment in the model
+  ///
+  size_t firstSegment(size_t idx) const;
+
+  ///
+  /// \brief Return the second segment of a pair
+  /// \param idx The index of the pair
+  /// \return The index of the second segment in the model
+  ///
+  size_t secondSegment(size_t idx) const;
+
+  ///
+  /// \brief Compute the distance and penetration of all the pairs
+  /// \param jcs The frame of all the segments (see Joints::allGlobalJCS)
+  /// \param maxDistance The pairs further than this distance are not
+  /// computed
+  ///
+  void update(const std::vector<utils::RotoTrans>& jcs, double maxDistance);
+
+  ///
+  /// \brief Compute the distance and penetration of all the pairs
+  /// \param model The joint model
+  /// \param Q The generalized coordinates
+  /// \param maxDistance The pairs further than this distance are not
+  /// computed
+  /// \param updateKin If the kinematics of the model should be updated
+  ///
+  void update(
+      Joints& model,
+      const GeneralizedCoordinates& Q,
+      double maxDistance,
+      bool updateKin = true);
+
+  ///
+  /// \brief Return the distance between the meshes of a pair
+  /// \param idx The index of the pair
+  /// \return The distance (0 if the meshes intersect, infinity if they are
+  /// further than the maxDistance of the last update)
+  ///
+  double distance(size_t idx) const;
+
+  ///
+  /// \brief Return if the meshes of a pair intersect
+  /// \param idx The index of the pair
+  /// \return If the meshes intersect
+  ///
+  bool isColliding(size_t idx) const;
+
+  ///
+  /// \brief Return how deep the meshes of a pair are inside each other
+  /// \param idx The index of the pair
+  /// \return The depth of the deepest vertex inside the other mesh (0 if the
+  /// meshes do not intersect)
+  ///
+  double penetration(size_t idx) const;
+
+  ///
+  /// \brief Return the closest point of the first mesh of a pair
+  /// \param idx The index of the pair
+  /// \return The closest point in global reference frame
+  ///
+  const utils::Vector3d& firstPoint(size_t idx) const;
+
+  ///
+  /// \brief Return the closest point of the second mesh of a pair
+  /// \param idx The index of the pair
+  /// \return The closest point in global reference frame
+  ///
+  const utils::Vector3d& secondPoint(size_t idx) const;
+
+ protected:
+  std::vector<size_t> m_segment;  ///< Index of the segment of each mesh
+  std::vector<std::shared_ptr<ContactSurface>>
+      m_meshes;  ///< Mesh of the segments in their local reference frame
+  std::vector<utils::Matrix3d> m_rotation;    ///< Rotation of the meshes
+  std::vector<utils::Vector3d> m_translation;  ///< Translation of the meshes
+  std::vector<utils::Vector3d> m_lower;  ///< Lower corner of the mesh boxes
+  std::vector<utils::Vector3d> m_upper;  ///< Upper corner of the mesh boxes
+
+  std::vector<size_t> m_first;   ///< First mesh of the pairs
+  std::vector<size_t> m_second;  ///< Second mesh of the pairs
+  std::vector<double> m_distance;  ///< Distance of the pairs
+  std::vector<bool> m_isColliding;  ///< If the pairs intersect
+  std::vector<double> m_penetration;  ///< Penetration of the pairs
+  std::vector<utils::Vector3d>
+      m_firstPoint;  ///< Closest point of the first mesh of the pairs
+  std::vector<utils::Vector3d>
+      m_secondPoint;  ///< Closest point of the second mesh of the pairs
+};
+#endif
+
+}  // namespace rigidbody
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_RIGIDBODY_SEGMENT_COLLISIONS_H
@@ -114,6 +114,27 @@ class BIORBD_API SoftContactNode : public rigidbody::NodeSegment {
   ///
   virtual utils::Vector3d applicationPoint(const utils::Vector3d& x) const = 0;
 
+  ///
+  /// \brief Set the contact plane that interfaces with the node
+  /// \param origin A point of the plane in global reference frame
+  /// \param normal The unit normal of the plane in global reference frame
+  ///
+  void setContactPlane(
+      const utils::Vector3d& origin,
+      const utils::Vector3d& normal);
+
+  ///
+  /// \brief Return a point of the contact plane
+  /// \return A point of the contact plane in global reference frame
+  ///
+  const utils::Vector3d& contactPlaneOrigin() const;
+
+  ///
+  /// \brief Return the normal of the contact plane
+  /// \return The normal of the contact plane in global reference frame
+  ///
+  const utils::Vector3d& contactPlaneNormal() const;
+
  protected:
   ///
   /// \brief Set the type of the contact node
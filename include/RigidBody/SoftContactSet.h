@@ -0,0 +1,215 @@
+#ifndef BIORBD_RIGIDBODY_SOFT_CONTACT_SET_H
+#define BIORBD_RIGIDBODY_SOFT_CONTACT_SET_H
+
+#include "biorbdConfig.h"
+
+#include <memory>
+#include <vector>
+
+#include "Utils/Matrix.h"
+#include "Utils/Matrix3d.h"
+#include "Utils/SpatialVector.h"
+#include "Utils/Vector.h"
+#include "Utils/Vector3d.h"
+
+namespace BIORBD_NAMESPACE {
+namespace rigidbody {
+class GeneralizedCoordinates;
+class GeneralizedVelocity;
+class Joints;
+class SoftContactNode;
+
+///
+/// \brief Structure of arrays of the soft contacts of a model, used to compute
+/// all the contact forces in a single pass
+///
+/// The parameters of the contacts and their contact planes are copied in
+/// contiguous vectors when compiled. When updated, the frame and the velocity
+/// of each body carrying at least one contact are computed once, and the
+/// position and velocity of every contact are deduced from them. The forces
+/// are then computed by a single loop over the contacts (same as
+/// SoftContactSphere::computeForce) and transported at the origin of the
+/// world.
+///
+/// The set must be compiled again if a parameter, a position or a contact
+/// plane of a contact is changed afterward.
+///
+class BIORBD_API SoftContactSet {
+ public:
+  ///
+  /// \brief Construct an empty soft contact set
+  ///
+  SoftContactSet();
+
+  ///
+  /// \brief Construct and compile a soft contact set
+  /// \param model The joint model
+  /// \param contacts The soft contacts
+  ///
+  SoftContactSet(
+      const Joints& model,
+      const std::vector<std::shared_ptr<SoftContactNode>>& contacts);
+
+  ///
+  /// \brief Destroy class properly
+  ///
+  virtual ~SoftContactSet();
+
+  ///
+  /// \brief Copy the parameters of the contacts into contiguous vectors
+  /// \param model The joint model
+  /// \param contacts The soft contacts
+  ///
+  void compile(
+      const Joints& model,
+      const std::vector<std::shared_ptr<SoftContactNode>>& contacts);
+
+  ///
+  /// \brief Return the number of soft contacts
+  /// \return The number of soft contacts
+  ///
+  size_t nbSoftContacts() const;
+
+  ///
+  /// \brief Set the contact plane of a contact
+  /// \param idx The index of the contact
+  /// \param origin A point of the plane in global reference frame
+  /// \param normal The unit normal of the plane in global reference frame
+  ///
+  void setContactPlane(
+      size_t idx,
+      const utils::Vector3d& origin,
+      const utils::Vector3d& normal);
+
+  ///
+  /// \brief Compute the position and velocity of all the contacts
+  /// \param updatedModel The joint model updated to Q and Qdot
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  ///
+  void updateKinematics(
+      Joints& updatedModel,
+      const GeneralizedCoordinates& Q,
+      const GeneralizedVelocity& Qdot);
+
+  ///
+  /// \brief Compute the force of all the contacts from the last kinematics
+  ///
+  void computeForces();
+
+#ifndef BIORBD_USE_CASADI_MATH
+  ///
+  /// \brief Add the derivatives of the generalized forces of the contacts
+  /// with respect to the state, from the last kinematics and forces
+  /// \param updatedModel The joint model updated to Q and Qdot
+  /// \param Q The generalized coordinates
+  /// \param Qdot The generalized velocities
+  /// \param dTauDq The derivatives with respect to Q (nbQdot x nbQ)
+  /// \param dTauDqdot The derivatives with respect to Qdot (nbQdot x nbQdot)
+  ///
+  /// The derivatives go analytically through the Hunt-Crossley normal force,
+  /// the smoothed Stribeck friction and the kinematics of the contacts (point
+  /// Jacobians and their variation with Q, including the lever arm of the
+  /// forces). The contact planes are considered fixed and the models with
+  /// quaternions are not supported.
+  ///
+  void addGeneralizedForceJacobians(
+      Joints& updatedModel,
+      const GeneralizedCoordinates& Q,
+      const GeneralizedVelocity& Qdot,
+      utils::Matrix& dTauDq,
+      utils::Matrix& dTauDqdot);
+
+#endif
+  ///
+  /// \brief Add the contact forces, transported at the origin of the world, to
+  /// the spatial vectors of their segment
+  /// \param out The spatial vectors of the bodies
+  ///
+  void combineForces(std::vector<utils::SpatialVector>& out) const;
+
+  ///
+  /// \brief Return the position of the contacts of the last kinematics
+  /// \return The position of the contacts in global reference frame
+  ///
+  const std::vector<utils::Vector3d>& positions() const;
+
+  ///
+  /// \brief Return the velocity of the contacts of the last kinematics
+  /// \return The velocity of the contacts in global reference frame
+  ///
+  const std::vector<utils::Vector3d>& velocities() const;
+
+  ///
+  /// \brief Return the angular velocity of the segment of the contacts of the
+  /// last kinematics
+  /// \return The angular velocity of the contacts in global reference frame
+  ///
+  const std::vector<utils::Vector3d>& angularVelocities() const;
+
+  ///
+  /// \brief Return the forces of the last computation
+  /// \return The force of the contacts in global reference frame
+  ///
+  const std::vector<utils::Vector3d>& forces() const;
+
+  ///
+  /// \brief Return the forces of the last computation, transported at the
+  /// origin of the world
+  /// \return The spatial vector of the contacts
+  ///
+  const std::vector<utils::SpatialVector>& forcesAtOrigin() const;
+
+ protected:
+  ///
+  /// \brief Return the index of a body in the body table, adding it if needed
+  /// \param id The RBDL index of the body
+  /// \return The index of the body in the body table
+  ///
+  size_t bodyIndex(unsigned int id);
+
+  std::vector<unsigned int> m_bodyId;  ///< RBDL index of the bodies
+  std::vector<utils::Vector3d>
+      m_bodyOrigin;  ///< Origin of the bodies in global reference frame
+  std::vector<utils::Matrix3d>
+      m_bodyRotation;  ///< Orientation of the bodies (world to body)
+  std::vector<utils::Vector3d>
+      m_bodyAngularVelocity;  ///< Angular velocity of the bodies
+  std::vector<utils::Vector3d>
+      m_bodyVelocity;  ///< Linear velocity of the origin of the bodies
+
+  std::vector<size_t> m_contactBody;  ///< Body index of each contact
+  std::vector<size_t>
+      m_outIndex;  ///< Index of the spatial vector each contact is added to
+  std::vector<utils::Vector3d>
+      m_pointInLocal;  ///< Position of the contacts in their body
+  std::vector<utils::Vector3d> m_planeOrigin;  ///< A point of the planes
+  std::vector<utils::Vector3d> m_planeNormal;  ///< Normal of the planes
+
+  utils::Vector m_radius;  ///< Radius of the spheres
+  utils::Vector m_stiffness;  ///< Stiffness of the spheres
+  utils::Vector m_damping;  ///< Damping of the spheres
+  utils::Vector m_muStatic;  ///< Static coefficient of friction
+  utils::Vector m_muDynamic;  ///< Dynamic coefficient of friction
+  utils::Vector m_muViscous;  ///< Viscous coefficient of friction
+  utils::Vector m_transitionVelocity;  ///< Friction transition velocity
+
+  std::vector<utils::Vector3d> m_positions;  ///< Position of the contacts
+  std::vector<utils::Vector3d> m_velocities;  ///< Velocity of the contacts
+  std::vector<utils::Vector3d>
+      m_angularVelocities;  ///< Angular velocity of the contacts
+  std::vector<utils::Vector3d> m_forces;  ///< Force of the contacts
+  std::vector<utils::SpatialVector>
+      m_forcesAtOrigin;  ///< Force of the contacts at the origin of the world
+#ifndef BIORBD_USE_CASADI_MATH
+  std::vector<utils::Matrix>
+      m_bodyMotion;  ///< Motion of the dofs of the bodies at the world origin
+  std::vector<utils::Matrix>
+      m_bodyMotionAfter;  ///< Velocity of the bodies due to the next dofs
+#endif
+};
+
+}  // namespace rigidbody
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_RIGIDBODY_SOFT_CONTACT_SET_H
@@ -4,6 +4,7 @@
 #include "biorbdConfig.h"
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "rbdl/rbdl_math.h"
@@ -11,12 +12,15 @@
 namespace BIORBD_NAMESPACE {
 namespace utils {
 class String;
-}
+class Vector3d;
+}  // namespace utils
 
 namespace rigidbody {
+class ContactSurface;
 class GeneralizedCoordinates;
 class GeneralizedVelocity;
 class SoftContactNode;
+class SoftContactSet;
 class NodeSegment;
 
 ///
@@ -66,6 +70,80 @@ class BIORBD_API SoftContacts {
   ///
   void addSoftContact(const SoftContactNode &contact);
 
+  ///
+  /// \brief Gather the parameters of all the soft contacts into a contiguous
+  /// soft contact set so their forces are computed in a single pass
+  ///
+  /// Once compiled, the external forces evaluate the frame of each body
+  /// carrying a contact once and compute all the contact forces in a single
+  /// loop (see SoftContactSet). This function must be called again if the
+  /// parameters, the position or the contact plane of a contact are changed.
+  ///
+  void compileSoftContacts();
+
+  ///
+  /// \brief Return if the soft contacts were compiled (see compileSoftContacts)
+  /// \return If the soft contacts were compiled
+  ///
+  bool isSoftContactsCompiled() const;
+
+  ///
+  /// \brief Return the compiled soft contact set
+  /// \return The compiled soft contact set
+  ///
+  SoftContactSet &softContactSet();
+
+  ///
+  /// \brief Return a soft contact set of the current contacts without
+  /// compiling the soft contacts
+  /// \return A soft contact set built from the contacts as they are now
+  ///
+  /// The returned set is not kept, so the external forces are still computed
+  /// contact by contact until compileSoftContacts is called.
+  ///
+  SoftContactSet detachedSoftContactSet() const;
+
+#ifndef BIORBD_USE_CASADI_MATH
+  ///
+  /// \brief Add a surface of the environment the soft contacts collide with
+  /// \param surface The surface
+  ///
+  /// Once a surface is added, the contact plane of each soft contact is
+  /// replaced, before computing its force, by the plane tangent to the closest
+  /// surface or by its declared plane if it is closer (see
+  /// updateSoftContactPlanes)
+  ///
+  void addContactSurface(const ContactSurface &surface);
+
+  ///
+  /// \brief Return the number of contact surfaces
+  /// \return The number of contact surfaces
+  ///
+  size_t nbContactSurfaces() const;
+
+  ///
+  /// \brief Return a contact surface
+  /// \param idx The index of the surface
+  /// \return The contact surface
+  ///
+  const ContactSurface &contactSurface(size_t idx) const;
+
+  ///
+  /// \brief Move the contact plane of each soft contact on the closest point
+  /// of the contact surfaces
+  /// \param positions The position of the center of the contacts in global
+  /// reference frame
+  ///
+  /// The search starts from the closest triangle of the previous call. The
+  /// plane is the face of the closest triangle, or, on an edge or a vertex,
+  /// the plane tangent to the sphere. The plane declared with the contact
+  /// (e.g. in the bioMod) is one more candidate: it is kept if no surface is
+  /// closer than twice the radius of the sphere, or if the sphere is closer to
+  /// it (or deeper in it) than to the closest surface.
+  ///
+  void updateSoftContactPlanes(const std::vector<utils::Vector3d> &positions);
+
+#endif
   ///
   /// \brief Return a specified contact
   /// \param idx The index of the marker
@@ -163,6 +241,16 @@ class BIORBD_API SoftContacts {
  protected:
   std::shared_ptr<std::vector<std::shared_ptr<SoftContactNode>>>
       m_softContacts;  ///< The contacts
+  std::shared_ptr<SoftContactSet>
+      m_softContactSet;  ///< The compiled contacts (nullptr if not compiled)
+  std::shared_ptr<std::vector<std::shared_ptr<ContactSurface>>>
+      m_contactSurfaces;  ///< The surfaces the contacts collide with
+  std::shared_ptr<std::vector<size_t>>
+      m_contactSurfaceHint;  ///< Closest surface of each contact
+  std::shared_ptr<std::vector<size_t>>
+      m_contactTriangleHint;  ///< Closest triangle of each contact
+  std::shared_ptr<std::vector<std::pair<utils::Vector3d, utils::Vector3d>>>
+      m_declaredContactPlanes;  ///< Plane declared with each contact
 };
 
 }  // namespace rigidbody
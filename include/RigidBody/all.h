@@ -4,6 +4,7 @@
 #include "biorbdConfig.h"
 
 #include "RigidBody/Contacts.h"
+#include "RigidBody/ContactSurface.h"
 #include "RigidBody/ExternalForceSet.h"
 #include "RigidBody/GeneralizedAcceleration.h"
 #include "RigidBody/GeneralizedCoordinates.h"
@@ -12,14 +13,18 @@
 #include "RigidBody/IMU.h"
 #include "RigidBody/IMUs.h"
 #include "RigidBody/Joints.h"
+#include "RigidBody/LoopConstraintSolver.h"
 #include "RigidBody/Markers.h"
 #include "RigidBody/Mesh.h"
 #include "RigidBody/MeshFace.h"
 #include "RigidBody/NodeSegment.h"
 #include "RigidBody/RigidBodyEnums.h"
+#include "RigidBody/RigidContactSolver.h"
 #include "RigidBody/RotoTransNodes.h"
 #include "RigidBody/Segment.h"
 #include "RigidBody/SegmentCharacteristics.h"
+#include "RigidBody/SegmentCollisions.h"
+#include "RigidBody/SoftContactSet.h"
 #include "RigidBody/SoftContactSphere.h"
 #ifdef MODULE_KALMAN
 #include "RigidBody/KalmanRecons.h"
@@ -0,0 +1,88 @@
+#ifndef BIORBD_UTILS_THREAD_POOL_H
+#define BIORBD_UTILS_THREAD_POOL_H
+
+#include "biorbdConfig.h"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BIORBD_NAMESPACE {
+namespace utils {
+
+///
+/// \brief Persistent pool of worker threads executing indexed tasks
+///
+/// The threads are created once and sleep between two calls to run(). The
+/// calling thread takes part in the work, so a pool of n threads owns n - 1
+/// workers.
+///
+class BIORBD_API ThreadPool {
+ public:
+  ///
+  /// \brief Construct a thread pool
+  /// \param nbThreads The number of threads (including the calling thread). If
+  /// 0, the number of hardware threads is used
+  ///
+  ThreadPool(size_t nbThreads = 0);
+
+  ///
+  /// \brief Stop and join the workers
+  ///
+  virtual ~ThreadPool();
+
+  ///
+  /// \brief Return the number of threads (including the calling thread)
+  /// \return The number of threads
+  ///
+  size_t nbThreads() const;
+
+  ///
+  /// \brief Execute task(i) for each i in [0, nbTasks) and wait for all of them
+  /// to be done
+  /// \param nbTasks The number of tasks
+  /// \param task The task to execute
+  ///
+  /// The tasks are dispatched in increasing order to the first available
+  /// thread. If a task throws, the remaining tasks are still executed and the
+  /// first exception is rethrown once they are all done.
+  ///
+  void run(size_t nbTasks, const std::function<void(size_t)>& task);
+
+ protected:
+  ///
+  /// \brief Main loop of a worker thread
+  ///
+  void work();
+
+  ///
+  /// \brief Execute the tasks of the current run until there is none left
+  /// \param lock The lock on m_mutex (locked when entering and leaving)
+  ///
+  void processTasks(std::unique_lock<std::mutex>& lock);
+
+  std::vector<std::thread> m_workers;  ///< The worker threads
+  std::mutex m_runMutex;  ///< Serialize the calls to run()
+  std::mutex m_mutex;     ///< Protect the members below
+  std::condition_variable m_wakeUp;  ///< Signal a new run (or the stop)
+  std::condition_variable m_done;    ///< Signal that all the tasks are done
+  const std::function<void(size_t)>* m_task;  ///< The task of the current run
+  size_t m_nbTasks;     ///< Number of tasks of the current run
+  size_t m_nextTask;    ///< Next task to dispatch
+  size_t m_nbDone;      ///< Number of tasks done
+  size_t m_generation;  ///< Index of the current run
+  bool m_stop;          ///< If the workers must stop
+  std::exception_ptr m_error;  ///< First exception thrown by a task
+
+ private:
+  ThreadPool(const ThreadPool&);
+  ThreadPool& operator=(const ThreadPool&);
+};
+
+}  // namespace utils
+}  // namespace BIORBD_NAMESPACE
+
+#endif  // BIORBD_UTILS_THREAD_POOL_H
@@ -16,6 +16,7 @@ enum NODE_TYPE {
   WRAPPING_OBJECT,
   WRAPPING_HALF_CYLINDER,
   WRAPPING_SPHERE,
+  WRAPPING_ELLIPSOID,
   VIA_POINT,
   SOFT_CONTACT,
   SOFT_CONTACT_SPHERE,
@@ -43,6 +44,8 @@ inline const char* NODE_TYPE_toStr(NODE_TYPE type) {
       return "WrappingHalfCylinder";
     case WRAPPING_SPHERE:
       return "WrappinSphere";
+    case WRAPPING_ELLIPSOID:
+      return "WrappingEllipsoid";
     case VIA_POINT:
       return "ViaPoint";
     case SOFT_CONTACT:
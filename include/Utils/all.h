@@ -16,6 +16,7 @@
 #include "Utils/Scalar.h"
 #include "Utils/SpatialVector.h"
 #include "Utils/String.h"
+#include "Utils/ThreadPool.h"
 #include "Utils/Timer.h"
 #include "Utils/UtilsEnum.h"
 #include "Utils/Vector.h"
@@ -6,6 +6,7 @@
 #include <rbdl/rbdl.h>
 
 #include "BiorbdModel.h"
+#include "InternalForceAccumulator.h"
 #include "ModelReader.h"
 #include "ModelWriter.h"
 #include "RigidBody/all.h"
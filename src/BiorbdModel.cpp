@@ -3,29 +3,162 @@
 
 #include <rbdl/Model.h>
 
+#include <rbdl/Dynamics.h>
 #include <rbdl/Kinematics.h>
 
+#include "InternalForceAccumulator.h"
 #include "ModelReader.h"
 #include "RigidBody/ExternalForceSet.h"
+#include "RigidBody/GeneralizedAcceleration.h"
 #include "RigidBody/GeneralizedCoordinates.h"
+#include "RigidBody/GeneralizedTorque.h"
+#include "RigidBody/GeneralizedVelocity.h"
 #include "RigidBody/NodeSegment.h"
+#include "Utils/Error.h"
 #include "Utils/String.h"
 
 using namespace BIORBD_NAMESPACE;
 
 utils::String getVersion() { return BIORBD_VERSION; }
 
-Model::Model() : m_path(std::make_shared<utils::Path>()) {}
+Model::Model()
+    : m_path(std::make_shared<utils::Path>()),
+      m_internalForceAccumulator(std::make_shared<InternalForceAccumulator>())
+#ifdef MODULE_MUSCLES
+      ,
+      m_muscleDrivenAccumulator(std::make_shared<InternalForceAccumulator>())
+#endif
+{
+#ifdef MODULE_MUSCLES
+  // The actuators are not part of the muscle driven dynamics
+  m_muscleDrivenAccumulator->enable(ACTUATOR_TORQUES, false);
+  m_muscleDrivenAccumulator->enable(JOINT_DAMPINGS);
+#endif
+}
 
 Model::Model(const utils::Path &path)
-    : m_path(std::make_shared<utils::Path>(path)) {
+    : m_path(std::make_shared<utils::Path>(path)),
+      m_internalForceAccumulator(std::make_shared<InternalForceAccumulator>())
+#ifdef MODULE_MUSCLES
+      ,
+      m_muscleDrivenAccumulator(std::make_shared<InternalForceAccumulator>())
+#endif
+{
+#ifdef MODULE_MUSCLES
+  // The actuators are not part of the muscle driven dynamics
+  m_muscleDrivenAccumulator->enable(ACTUATOR_TORQUES, false);
+  m_muscleDrivenAccumulator->enable(JOINT_DAMPINGS);
+#endif
   Reader::readModelFile(*m_path, this);
 }
 
+Model Model::DeepCopy() const {
+  Model copy;
+  copy.DeepCopy(*this);
+  return copy;
+}
+
+void Model::DeepCopy(const Model &other) {
+  rigidbody::Joints::DeepCopy(other);
+  rigidbody::Markers::DeepCopy(other);
+  rigidbody::IMUs::DeepCopy(other);
+  rigidbody::RotoTransNodes::DeepCopy(other);
+  rigidbody::Contacts::DeepCopy(other);
+#ifdef MODULE_ACTUATORS
+  internal_forces::actuator::Actuators::DeepCopy(other);
+#endif
+#ifdef MODULE_MUSCLES
+  internal_forces::muscles::Muscles::DeepCopy(other);
+#endif
+#ifdef MODULE_PASSIVE_TORQUES
+  internal_forces::passive_torques::PassiveTorques::DeepCopy(other);
+#endif
+#ifdef MODULE_LIGAMENTS
+  internal_forces::ligaments::Ligaments::DeepCopy(other);
+#endif
+  rigidbody::SoftContacts::DeepCopy(other);
+  *m_path = other.m_path->DeepCopy();
+  *m_internalForceAccumulator = *other.m_internalForceAccumulator;
+#ifdef MODULE_MUSCLES
+  *m_muscleDrivenAccumulator = *other.m_muscleDrivenAccumulator;
+#endif
+}
+
 utils::Path Model::path() const { return *m_path; }
 
 rigidbody::ExternalForceSet Model::externalForceSet(
     bool useLinearForces,
     bool useSoftContacts) {
   return rigidbody::ExternalForceSet(*this, useLinearForces, useSoftContacts);
-}
\ No newline at end of file
+}
+
+InternalForceAccumulator &Model::internalForceAccumulator() {
+  return *m_internalForceAccumulator;
+}
+
+const rigidbody::GeneralizedTorque &Model::internalForces(
+    const rigidbody::GeneralizedCoordinates &Q,
+    const rigidbody::GeneralizedVelocity &Qdot,
+    const utils::Vector &muscleActivations,
+    const utils::Vector &actuatorActivations) {
+  return m_internalForceAccumulator->compute(
+      *this, Q, Qdot, muscleActivations, actuatorActivations);
+}
+
+#ifdef MODULE_MUSCLES
+rigidbody::GeneralizedAcceleration Model::muscleDrivenForwardDynamics(
+    const rigidbody::GeneralizedCoordinates &Q,
+    const rigidbody::GeneralizedVelocity &Qdot,
+    const utils::Vector &activations,
+    utils::Vector *forces) {
+  rigidbody::ExternalForceSet forceSet(*this);
+  return muscleDrivenForwardDynamics(Q, Qdot, activations, forceSet, forces);
+}
+
+rigidbody::GeneralizedAcceleration Model::muscleDrivenForwardDynamics(
+    const rigidbody::GeneralizedCoordinates &Q,
+    const rigidbody::GeneralizedVelocity &Qdot,
+    const utils::Vector &activations,
+    rigidbody::ExternalForceSet &externalForces,
+    utils::Vector *forces) {
+  utils::Error::check(
+      static_cast<size_t>(activations.size()) == nbMuscleTotal(),
+      "Activations must be of size nbMuscleTotal");
+
+  // One kinematics update for the muscles, the ligaments and the external
+  // forces
+#ifdef BIORBD_USE_CASADI_MATH
+  rigidbody::Joints
+#else
+  rigidbody::Joints &
+#endif
+      updatedModel = UpdateKinematicsCustom(&Q, &Qdot);
+
+  // One sweep of the muscle geometry, the muscular, passive and ligament
+  // joint torques and the joint dampings are summed by the accumulator
+  const rigidbody::GeneralizedTorque &tau(m_muscleDrivenAccumulator->compute(
+      *this, updatedModel, Q, Qdot, activations, utils::Vector()));
+  if (forces) {
+    *forces = m_muscleDrivenAccumulator->muscleForces();
+  }
+
+  rigidbody::GeneralizedAcceleration Qddot(updatedModel);
+  auto fExt = externalForces.computeRbdlSpatialVectors(updatedModel, Q, Qdot);
+  RigidBodyDynamics::ForwardDynamics(updatedModel, Q, Qdot, tau, Qddot, &fExt);
+  return Qddot;
+}
+
+rigidbody::GeneralizedAcceleration Model::muscleDrivenForwardDynamics(
+    const rigidbody::GeneralizedCoordinates &Q,
+    const rigidbody::GeneralizedVelocity &Qdot,
+    const utils::Vector &excitations,
+    const utils::Vector &activations,
+    rigidbody::ExternalForceSet &externalForces,
+    utils::Vector &activationsDot,
+    utils::Vector *forces,
+    bool areadyNormalized) {
+  activationsDot = activationDot(excitations, activations, areadyNormalized);
+  return muscleDrivenForwardDynamics(
+      Q, Qdot, activations, externalForces, forces);
+}
+#endif
@@ -0,0 +1,227 @@
+#define BIORBD_API_EXPORTS
+#include "InternalForceAccumulator.h"
+
+#include "BiorbdModel.h"
+#include "RigidBody/GeneralizedCoordinates.h"
+#include "RigidBody/GeneralizedVelocity.h"
+#include "Utils/Error.h"
+#ifdef MODULE_MUSCLES
+#include "InternalForces/Muscles/MuscleParameterSet.h"
+#endif
+
+using namespace BIORBD_NAMESPACE;
+
+InternalForceAccumulator::InternalForceAccumulator()
+    : m_isEnabled(NO_INTERNAL_FORCE_SOURCE, true),
+      m_keepBreakdown(false),
+      m_torque(),
+      m_breakdown(NO_INTERNAL_FORCE_SOURCE),
+      m_sourceTorque(),
+      m_muscleForces(),
+      m_ligamentForces() {
+  // The forward dynamics already subtract the joint dampings from Tau
+  m_isEnabled[JOINT_DAMPINGS] = false;
+}
+
+InternalForceAccumulator::~InternalForceAccumulator() {}
+
+void InternalForceAccumulator::enable(
+    INTERNAL_FORCE_SOURCE source,
+    bool enable) {
+  utils::Error::check(
+      source < NO_INTERNAL_FORCE_SOURCE, "Internal force source not found");
+  m_isEnabled[source] = enable;
+}
+
+bool InternalForceAccumulator::isEnabled(INTERNAL_FORCE_SOURCE source) const {
+  utils::Error::check(
+      source < NO_INTERNAL_FORCE_SOURCE, "Internal force source not found");
+  return m_isEnabled[source];
+}
+
+void InternalForceAccumulator::keepBreakdown(bool keep) {
+  m_keepBreakdown = keep;
+}
+
+bool InternalForceAccumulator::isBreakdownKept() const {
+  return m_keepBreakdown;
+}
+
+const rigidbody::GeneralizedTorque& InternalForceAccumulator::compute(
+    Model& model,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    const utils::Vector& muscleActivations,
+    const utils::Vector& actuatorActivations) {
+  // One kinematics update shared by all the sources
+#ifdef BIORBD_USE_CASADI_MATH
+  rigidbody::Joints
+#else
+  rigidbody::Joints&
+#endif
+      updatedModel = model.UpdateKinematicsCustom(&Q, &Qdot);
+  return compute(
+      model, updatedModel, Q, Qdot, muscleActivations, actuatorActivations);
+}
+
+const rigidbody::GeneralizedTorque& InternalForceAccumulator::compute(
+    Model& model,
+    rigidbody::Joints& updatedModel,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    const utils::Vector& muscleActivations,
+    const utils::Vector& actuatorActivations) {
+  size_t nbTau(model.nbGeneralizedTorque());
+  if (static_cast<size_t>(m_torque.rows()) != nbTau) {
+    m_torque = rigidbody::GeneralizedTorque(nbTau);
+  }
+  for (unsigned int i = 0; i < static_cast<unsigned int>(nbTau); ++i) {
+    m_torque(i) = 0;
+  }
+
+#ifdef MODULE_MUSCLES
+  if (isComputed(model, MUSCLE_FORCES)) {
+    utils::Error::check(
+        static_cast<size_t>(muscleActivations.size()) == model.nbMuscleTotal(),
+        "Muscle activations must be of size nbMuscleTotal");
+    model.updateMuscles(updatedModel, Q, Qdot);
+    if (model.isMusclesCompiled()) {
+      if (static_cast<size_t>(m_muscleForces.rows()) != model.nbMuscleTotal()) {
+        m_muscleForces = utils::Vector(model.nbMuscleTotal());
+      }
+      internal_forces::muscles::MuscleParameterSet& parameters(
+          model.muscleParameters());
+      parameters.updateKinematics();
+      parameters.computeForces(muscleActivations, m_muscleForces);
+    } else {
+      m_muscleForces = model.muscleForces(muscleActivations);
+    }
+    utils::Vector& tau(sourceBuffer(MUSCLE_FORCES, nbTau));
+    model.muscularJointTorque(m_muscleForces, tau);
+    m_torque += tau;
+  } else {
+    m_muscleForces = utils::Vector();
+  }
+#endif
+
+#ifdef MODULE_LIGAMENTS
+  if (isComputed(model, LIGAMENT_FORCES)) {
+    model.ligamentForces(updatedModel, Q, Qdot, m_ligamentForces);
+    utils::Vector& tau(sourceBuffer(LIGAMENT_FORCES, nbTau));
+    model.ligamentsJointTorque(m_ligamentForces, tau);
+    m_torque += tau;
+  } else {
+    m_ligamentForces = utils::Vector();
+  }
+#endif
+
+#ifdef MODULE_PASSIVE_TORQUES
+  if (isComputed(model, PASSIVE_TORQUES)) {
+    utils::Vector& tau(sourceBuffer(PASSIVE_TORQUES, nbTau));
+    model.passiveJointTorque(Q, Qdot, tau);
+    m_torque += tau;
+  }
+#endif
+
+#ifdef MODULE_ACTUATORS
+  if (isComputed(model, ACTUATOR_TORQUES)) {
+    utils::Error::check(
+        static_cast<size_t>(actuatorActivations.size()) == model.nbActuators(),
+        "Actuator activations must be of size nbActuators");
+    utils::Vector& tau(sourceBuffer(ACTUATOR_TORQUES, nbTau));
+    model.torque(actuatorActivations, Q, Qdot, tau);
+    m_torque += tau;
+  }
+#endif
+
+  if (isComputed(model, JOINT_DAMPINGS)) {
+    utils::Vector& tau(sourceBuffer(JOINT_DAMPINGS, nbTau));
+    model.computeDampedTau(Qdot, tau);
+    tau = -tau;
+    m_torque += tau;
+  }
+
+  // The sources that were skipped do not contribute
+  if (m_keepBreakdown) {
+    for (size_t s = 0; s < NO_INTERNAL_FORCE_SOURCE; ++s) {
+      if (!isComputed(model, static_cast<INTERNAL_FORCE_SOURCE>(s))) {
+        m_breakdown[s] = utils::Vector::Zero(static_cast<unsigned int>(nbTau));
+      }
+    }
+  }
+  return m_torque;
+}
+
+const rigidbody::GeneralizedTorque& InternalForceAccumulator::torque() const {
+  return m_torque;
+}
+
+const utils::Vector& InternalForceAccumulator::torque(
+    INTERNAL_FORCE_SOURCE source) const {
+  utils::Error::check(
+      m_keepBreakdown,
+      "The breakdown of the internal forces is not kept, call keepBreakdown "
+      "before the computation");
+  utils::Error::check(
+      source < NO_INTERNAL_FORCE_SOURCE, "Internal force source not found");
+  return m_breakdown[source];
+}
+
+const utils::Vector& InternalForceAccumulator::muscleForces() const {
+  return m_muscleForces;
+}
+
+const utils::Vector& InternalForceAccumulator::ligamentForces() const {
+  return m_ligamentForces;
+}
+
+bool InternalForceAccumulator::isComputed(
+    const Model& model,
+    INTERNAL_FORCE_SOURCE source) const {
+  if (!m_isEnabled[source]) {
+    return false;
+  }
+  switch (source) {
+    case MUSCLE_FORCES:
+#ifdef MODULE_MUSCLES
+      return model.nbMuscleTotal() != 0;
+#else
+      return false;
+#endif
+    case LIGAMENT_FORCES:
+#ifdef MODULE_LIGAMENTS
+      return model.nbLigaments() != 0;
+#else
+      return false;
+#endif
+    case PASSIVE_TORQUES:
+#ifdef MODULE_PASSIVE_TORQUES
+      return model.nbPassiveTorques() != 0;
+#else
+      return false;
+#endif
+    case ACTUATOR_TORQUES:
+#ifdef MODULE_ACTUATORS
+      return model.nbActuators() != 0;
+#else
+      return false;
+#endif
+    case JOINT_DAMPINGS:
+      return true;
+    default:
+      utils::Error::raise("Internal force source not found");
+  }
+#ifdef _WIN32
+  return false;  // Will never reach here
+#endif
+}
+
+utils::Vector& InternalForceAccumulator::sourceBuffer(
+    INTERNAL_FORCE_SOURCE source,
+    size_t nbTau) {
+  utils::Vector& buffer(m_keepBreakdown ? m_breakdown[source] : m_sourceTorque);
+  if (static_cast<size_t>(buffer.rows()) != nbTau) {
+    buffer = utils::Vector(static_cast<unsigned int>(nbTau));
+  }
+  return buffer;
+}
@@ -51,6 +51,11 @@ utils::Scalar internal_forces::actuator::ActuatorConstant::torqueMax() {
   return *m_Tmax;
 }
 
+const utils::Scalar &
+internal_forces::actuator::ActuatorConstant::Tmax() const {
+  return *m_Tmax;
+}
+
 void internal_forces::actuator::ActuatorConstant::setType() {
   *m_type = internal_forces::actuator::TYPE::CONSTANT;
 }
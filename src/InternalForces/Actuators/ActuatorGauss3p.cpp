@@ -167,6 +167,61 @@ utils::Scalar internal_forces::actuator::ActuatorGauss3p::torqueMax(
   return Tw * A * Ta;
 }
 
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss3p::k() const {
+  return *m_k;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss3p::Tmax() const {
+  return *m_Tmax;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss3p::T0() const {
+  return *m_T0;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss3p::wmax() const {
+  return *m_wmax;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss3p::wc() const {
+  return *m_wc;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss3p::amax() const {
+  return *m_amax;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss3p::amin() const {
+  return *m_amin;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss3p::wr() const {
+  return *m_wr;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss3p::w1() const {
+  return *m_w1;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss3p::r() const {
+  return *m_r;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss3p::qopt() const {
+  return *m_qopt;
+}
+
 void internal_forces::actuator::ActuatorGauss3p::setType() {
   *m_type = internal_forces::actuator::TYPE::GAUSS3P;
 }
@@ -191,6 +191,76 @@ utils::Scalar internal_forces::actuator::ActuatorGauss6p::torqueMax(
   return Tw * A * Ta;
 }
 
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::k() const {
+  return *m_k;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::Tmax() const {
+  return *m_Tmax;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::T0() const {
+  return *m_T0;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::wmax() const {
+  return *m_wmax;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::wc() const {
+  return *m_wc;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::amax() const {
+  return *m_amax;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::amin() const {
+  return *m_amin;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::wr() const {
+  return *m_wr;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::w1() const {
+  return *m_w1;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::r() const {
+  return *m_r;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::qopt() const {
+  return *m_qopt;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::facteur() const {
+  return *m_facteur;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::r2() const {
+  return *m_r2;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorGauss6p::qopt2() const {
+  return *m_qopt2;
+}
+
 void internal_forces::actuator::ActuatorGauss6p::setType() {
   *m_type = internal_forces::actuator::TYPE::GAUSS6P;
 }
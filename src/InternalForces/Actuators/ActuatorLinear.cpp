@@ -66,6 +66,16 @@ utils::Scalar internal_forces::actuator::ActuatorLinear::torqueMax(
   return (Q[static_cast<unsigned int>(*m_dofIdx)] * 180 / M_PI) * *m_m + *m_b;
 }
 
+const utils::Scalar&
+internal_forces::actuator::ActuatorLinear::slope() const {
+  return *m_m;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorLinear::torqueAtZero() const {
+  return *m_b;
+}
+
 void internal_forces::actuator::ActuatorLinear::setType() {
   *m_type = internal_forces::actuator::TYPE::LINEAR;
 }
@@ -0,0 +1,388 @@
+#define BIORBD_API_EXPORTS
+#include "InternalForces/Actuators/ActuatorSet.h"
+
+#include "InternalForces/Actuators/Actuator.h"
+#include "InternalForces/Actuators/ActuatorConstant.h"
+#include "InternalForces/Actuators/ActuatorGauss3p.h"
+#include "InternalForces/Actuators/ActuatorGauss6p.h"
+#include "InternalForces/Actuators/ActuatorLinear.h"
+#include "InternalForces/Actuators/ActuatorSigmoidGauss3p.h"
+#include "Utils/Error.h"
+#include "Utils/String.h"
+
+#ifdef USE_SMOOTH_IF_ELSE
+#include "Utils/CasadiExpand.h"
+#endif
+
+using namespace BIORBD_NAMESPACE;
+
+internal_forces::actuator::ActuatorSet::ActuatorSet() : m_nbDof(0) {}
+
+internal_forces::actuator::ActuatorSet::ActuatorSet(
+    const std::vector<std::pair<
+        std::shared_ptr<internal_forces::actuator::Actuator>,
+        std::shared_ptr<internal_forces::actuator::Actuator>>>& actuators)
+    : m_nbDof(0) {
+  compile(actuators);
+}
+
+internal_forces::actuator::ActuatorSet::~ActuatorSet() {}
+
+void internal_forces::actuator::ActuatorSet::compile(
+    const std::vector<std::pair<
+        std::shared_ptr<internal_forces::actuator::Actuator>,
+        std::shared_ptr<internal_forces::actuator::Actuator>>>& actuators) {
+  m_nbDof = actuators.size();
+  m_constant.clear();
+  m_linear.clear();
+  m_gauss.clear();
+  m_sigmoid.clear();
+
+  // The parameters are stored at the entry of the actuator, so every
+  // parameter vector has a slot for each entry, used or not
+  unsigned int nbEntries(static_cast<unsigned int>(2 * m_nbDof));
+  m_Tmax = utils::Vector::Zero(nbEntries);
+  m_slope = utils::Vector::Zero(nbEntries);
+  m_torqueAtZero = utils::Vector::Zero(nbEntries);
+  m_Tc = utils::Vector::Zero(nbEntries);
+  m_C = utils::Vector::Zero(nbEntries);
+  m_we = utils::Vector::Zero(nbEntries);
+  m_E = utils::Vector::Zero(nbEntries);
+  m_wc = utils::Vector::Zero(nbEntries);
+  m_amin = utils::Vector::Zero(nbEntries);
+  m_amplitude = utils::Vector::Zero(nbEntries);
+  m_w1 = utils::Vector::Zero(nbEntries);
+  m_wr = utils::Vector::Zero(nbEntries);
+  m_qopt = utils::Vector::Zero(nbEntries);
+  m_r = utils::Vector::Zero(nbEntries);
+  m_facteur = utils::Vector::Zero(nbEntries);
+  m_qopt2 = utils::Vector::Zero(nbEntries);
+  m_r2 = utils::Vector::Zero(nbEntries);
+  m_theta = utils::Vector::Zero(nbEntries);
+  m_lambda = utils::Vector::Zero(nbEntries);
+  m_offset = utils::Vector::Zero(nbEntries);
+
+  m_speed = utils::Vector::Zero(static_cast<unsigned int>(m_nbDof));
+  m_torqueMax = utils::Vector::Zero(nbEntries);
+  m_dTdPos = utils::Vector::Zero(nbEntries);
+  m_dTdSpeed = utils::Vector::Zero(nbEntries);
+
+  for (size_t e = 0; e < 2 * m_nbDof; ++e) {
+    const std::shared_ptr<internal_forces::actuator::Actuator>& actuator(
+        e % 2 == 0 ? actuators[e / 2].first : actuators[e / 2].second);
+    utils::Error::check(
+        actuator != nullptr,
+        "All DoF must have their actuators set before compiling them");
+    unsigned int i(static_cast<unsigned int>(e));
+
+    switch (actuator->type()) {
+      case internal_forces::actuator::TYPE::CONSTANT: {
+        const internal_forces::actuator::ActuatorConstant& act(
+            static_cast<const internal_forces::actuator::ActuatorConstant&>(
+                *actuator));
+        m_constant.push_back(e);
+        m_Tmax(i) = act.Tmax();
+        break;
+      }
+      case internal_forces::actuator::TYPE::LINEAR: {
+        const internal_forces::actuator::ActuatorLinear& act(
+            static_cast<const internal_forces::actuator::ActuatorLinear&>(
+                *actuator));
+        m_linear.push_back(e);
+        m_slope(i) = act.slope();
+        m_torqueAtZero(i) = act.torqueAtZero();
+        break;
+      }
+      case internal_forces::actuator::TYPE::GAUSS3P: {
+        const internal_forces::actuator::ActuatorGauss3p& act(
+            static_cast<const internal_forces::actuator::ActuatorGauss3p&>(
+                *actuator));
+        m_gauss.push_back(e);
+        utils::Scalar Tc(act.T0() * act.wc() / act.wmax());
+        utils::Scalar we(
+            ((act.Tmax() - act.T0()) * act.wmax() * act.wc()) /
+            (act.k() * act.T0() * (act.wmax() + act.wc())));
+        m_Tmax(i) = act.Tmax();
+        m_Tc(i) = Tc;
+        m_C(i) = Tc * (act.wmax() + act.wc());
+        m_we(i) = we;
+        m_E(i) = -(act.Tmax() - act.T0()) * we;
+        m_wc(i) = act.wc();
+        m_amin(i) = act.amin();
+        m_amplitude(i) = act.amax() - act.amin();
+        m_w1(i) = act.w1();
+        m_wr(i) = act.wr();
+        m_qopt(i) = act.qopt();
+        m_r(i) = act.r();
+        // The second gaussian is neutralized, any non-null width will do
+        m_qopt2(i) = 0;
+        m_r2(i) = 1;
+        break;
+      }
+      case internal_forces::actuator::TYPE::GAUSS6P: {
+        const internal_forces::actuator::ActuatorGauss6p& act(
+            static_cast<const internal_forces::actuator::ActuatorGauss6p&>(
+                *actuator));
+        m_gauss.push_back(e);
+        utils::Scalar Tc(act.T0() * act.wc() / act.wmax());
+        utils::Scalar we(
+            ((act.Tmax() - act.T0()) * act.wmax() * act.wc()) /
+            (act.k() * act.T0() * (act.wmax() + act.wc())));
+        m_Tmax(i) = act.Tmax();
+        m_Tc(i) = Tc;
+        m_C(i) = Tc * (act.wmax() + act.wc());
+        m_we(i) = we;
+        m_E(i) = -(act.Tmax() - act.T0()) * we;
+        m_wc(i) = act.wc();
+        m_amin(i) = act.amin();
+        m_amplitude(i) = act.amax() - act.amin();
+        m_w1(i) = act.w1();
+        m_wr(i) = act.wr();
+        m_qopt(i) = act.qopt();
+        m_r(i) = act.r();
+        m_facteur(i) = act.facteur();
+        m_qopt2(i) = act.qopt2();
+        m_r2(i) = act.r2();
+        break;
+      }
+      case internal_forces::actuator::TYPE::SIGMOIDGAUSS3P: {
+        const internal_forces::actuator::ActuatorSigmoidGauss3p& act(
+            static_cast<
+                const internal_forces::actuator::ActuatorSigmoidGauss3p&>(
+                *actuator));
+        m_sigmoid.push_back(e);
+        m_qopt(i) = act.qopt();
+        m_r(i) = act.r();
+        m_theta(i) = act.theta();
+        m_lambda(i) = act.lambda();
+        m_offset(i) = act.offset();
+        break;
+      }
+      default:
+        utils::Error::raise(
+            "Actuator " +
+            utils::String(
+                internal_forces::actuator::TYPE_toStr(actuator->type())) +
+            " cannot be compiled");
+    }
+  }
+}
+
+size_t internal_forces::actuator::ActuatorSet::nbDof() const {
+  return m_nbDof;
+}
+
+const std::vector<size_t>& internal_forces::actuator::ActuatorSet::indices(
+    internal_forces::actuator::TYPE type) const {
+  switch (type) {
+    case internal_forces::actuator::TYPE::CONSTANT:
+      return m_constant;
+    case internal_forces::actuator::TYPE::LINEAR:
+      return m_linear;
+    case internal_forces::actuator::TYPE::GAUSS3P:
+    case internal_forces::actuator::TYPE::GAUSS6P:
+      return m_gauss;
+    case internal_forces::actuator::TYPE::SIGMOIDGAUSS3P:
+      return m_sigmoid;
+    default:
+      utils::Error::raise("Actuator type not found");
+  }
+#ifdef _WIN32
+  return m_constant;  // Will never reach here
+#endif
+}
+
+void internal_forces::actuator::ActuatorSet::computeTorqueMax(
+    const utils::Vector& Q,
+    const utils::Vector& Qdot,
+    utils::Vector& concentric,
+    utils::Vector& eccentric) {
+  computeEntries(Q, Qdot, false);
+  for (unsigned int i = 0; i < static_cast<unsigned int>(m_nbDof); ++i) {
+    concentric(i) = m_torqueMax(2 * i);
+    eccentric(i) = m_torqueMax(2 * i + 1);
+  }
+}
+
+void internal_forces::actuator::ActuatorSet::computeTorqueMax(
+    const utils::Vector& activation,
+    const utils::Vector& Q,
+    const utils::Vector& Qdot,
+    utils::Vector& torqueMax) {
+  resignSpeed(activation, Qdot);
+  computeEntries(Q, m_speed, false);
+  for (unsigned int i = 0; i < static_cast<unsigned int>(m_nbDof); ++i) {
+    torqueMax(i) = select(activation, m_torqueMax, i);
+  }
+}
+
+void internal_forces::actuator::ActuatorSet::computeTorques(
+    const utils::Vector& activation,
+    const utils::Vector& Q,
+    const utils::Vector& Qdot,
+    utils::Vector& tau) {
+  resignSpeed(activation, Qdot);
+  computeEntries(Q, m_speed, false);
+  for (unsigned int i = 0; i < static_cast<unsigned int>(m_nbDof); ++i) {
+    tau(i) = activation(i) * select(activation, m_torqueMax, i);
+  }
+}
+
+void internal_forces::actuator::ActuatorSet::computeTorqueDerivatives(
+    const utils::Vector& activation,
+    const utils::Vector& Q,
+    const utils::Vector& Qdot,
+    utils::Vector& tau,
+    utils::Vector& dTaudActivation,
+    utils::Vector& dTaudQ,
+    utils::Vector& dTaudQdot) {
+  resignSpeed(activation, Qdot);
+  computeEntries(Q, m_speed, true);
+
+  // The kernels work in degrees and the speed is resigned by the activation:
+  //   tau = a * T(q * 180 / pi, sign(a) * qdot * 180 / pi)
+  double toDegrees(180 / M_PI);
+  for (unsigned int i = 0; i < static_cast<unsigned int>(m_nbDof); ++i) {
+    utils::Scalar torqueMax(select(activation, m_torqueMax, i));
+#ifdef BIORBD_USE_CASADI_MATH
+    utils::Scalar sign(IF_ELSE_NAMESPACE::if_else(
+        IF_ELSE_NAMESPACE::lt(activation(i), 0), -1, 1));
+#else
+    utils::Scalar sign(activation(i) < 0 ? -1 : 1);
+#endif
+    tau(i) = activation(i) * torqueMax;
+    dTaudActivation(i) = torqueMax;
+    dTaudQ(i) = activation(i) * select(activation, m_dTdPos, i) * toDegrees;
+    dTaudQdot(i) =
+        activation(i) * select(activation, m_dTdSpeed, i) * sign * toDegrees;
+  }
+}
+
+void internal_forces::actuator::ActuatorSet::computeEntries(
+    const utils::Vector& Q,
+    const utils::Vector& speed,
+    bool withDerivatives) {
+  if (withDerivatives) {
+    for (unsigned int e = 0; e < static_cast<unsigned int>(2 * m_nbDof);
+         ++e) {
+      m_dTdPos(e) = 0;
+      m_dTdSpeed(e) = 0;
+    }
+  }
+
+  for (size_t k = 0; k < m_constant.size(); ++k) {
+    unsigned int e(static_cast<unsigned int>(m_constant[k]));
+    m_torqueMax(e) = m_Tmax(e);
+  }
+
+  for (size_t k = 0; k < m_linear.size(); ++k) {
+    unsigned int e(static_cast<unsigned int>(m_linear[k]));
+    unsigned int dof(e / 2);
+    m_torqueMax(e) = (Q(dof) * 180 / M_PI) * m_slope(e) + m_torqueAtZero(e);
+    if (withDerivatives) {
+      m_dTdPos(e) = m_slope(e);
+    }
+  }
+
+  // Tw * A * Ta, see ActuatorGauss3p::torqueMax and ActuatorGauss6p::torqueMax
+  for (size_t k = 0; k < m_gauss.size(); ++k) {
+    unsigned int e(static_cast<unsigned int>(m_gauss[k]));
+    unsigned int dof(e / 2);
+    utils::Scalar pos(Q(dof) * 180 / M_PI);
+    utils::Scalar s(speed(dof) * 180 / M_PI);
+
+    // Tetanic torque max
+    utils::Scalar Tw;
+    utils::Scalar dTw;
+#ifdef BIORBD_USE_CASADI_MATH
+    Tw = IF_ELSE_NAMESPACE::if_else(
+        IF_ELSE_NAMESPACE::ge(s, 0),
+        m_C(e) / (m_wc(e) + s) - m_Tc(e),
+        m_E(e) / (m_we(e) - s) + m_Tmax(e));
+    dTw = IF_ELSE_NAMESPACE::if_else(
+        IF_ELSE_NAMESPACE::ge(s, 0),
+        -m_C(e) / ((m_wc(e) + s) * (m_wc(e) + s)),
+        m_E(e) / ((m_we(e) - s) * (m_we(e) - s)));
+#else
+    if (s >= 0) {
+      Tw = m_C(e) / (m_wc(e) + s) - m_Tc(e);  // For the concentric
+      dTw = -m_C(e) / ((m_wc(e) + s) * (m_wc(e) + s));
+    } else {
+      Tw = m_E(e) / (m_we(e) - s) + m_Tmax(e);  // For the eccentric
+      dTw = m_E(e) / ((m_we(e) - s) * (m_we(e) - s));
+    }
+#endif
+
+    // Differential activation
+    utils::Scalar expA(exp(-(s - m_w1(e)) / m_wr(e)));
+    utils::Scalar A(m_amin(e) + m_amplitude(e) / (1 + expA));
+
+    // Torque angle
+    utils::Scalar gauss1(
+        exp(-(m_qopt(e) - pos) * (m_qopt(e) - pos) / (2 * m_r(e) * m_r(e))));
+    utils::Scalar gauss2(
+        m_facteur(e) *
+        exp(-(m_qopt2(e) - pos) * (m_qopt2(e) - pos) /
+            (2 * m_r2(e) * m_r2(e))));
+    utils::Scalar Ta(gauss1 + gauss2);
+
+    m_torqueMax(e) = Tw * A * Ta;
+    if (withDerivatives) {
+      utils::Scalar dA(
+          m_amplitude(e) * expA / (m_wr(e) * (1 + expA) * (1 + expA)));
+      utils::Scalar dTa(
+          gauss1 * (m_qopt(e) - pos) / (m_r(e) * m_r(e)) +
+          gauss2 * (m_qopt2(e) - pos) / (m_r2(e) * m_r2(e)));
+      m_dTdPos(e) = Tw * A * dTa;
+      m_dTdSpeed(e) = (dTw * A + Tw * dA) * Ta;
+    }
+  }
+
+  // Tmax(speed) * Ta, see ActuatorSigmoidGauss3p::torqueMax
+  for (size_t k = 0; k < m_sigmoid.size(); ++k) {
+    unsigned int e(static_cast<unsigned int>(m_sigmoid[k]));
+    unsigned int dof(e / 2);
+    utils::Scalar pos(Q(dof) * 180 / M_PI);
+    utils::Scalar s(speed(dof) * 180 / M_PI);
+
+    utils::Scalar expT(exp(m_lambda(e) * s));
+    utils::Scalar Tmax(m_theta(e) / (1 + expT) + m_offset(e));
+    utils::Scalar Ta(
+        exp(-(m_qopt(e) - pos) * (m_qopt(e) - pos) / (2 * m_r(e) * m_r(e))));
+
+    m_torqueMax(e) = Tmax * Ta;
+    if (withDerivatives) {
+      m_dTdPos(e) = Tmax * Ta * (m_qopt(e) - pos) / (m_r(e) * m_r(e));
+      m_dTdSpeed(e) =
+          -m_theta(e) * m_lambda(e) * expT / ((1 + expT) * (1 + expT)) * Ta;
+    }
+  }
+}
+
+void internal_forces::actuator::ActuatorSet::resignSpeed(
+    const utils::Vector& activation,
+    const utils::Vector& Qdot) {
+  // Set qdot to be positive if concentric and negative if excentric
+  for (unsigned int i = 0; i < static_cast<unsigned int>(m_nbDof); ++i) {
+#ifdef BIORBD_USE_CASADI_MATH
+    m_speed(i) = IF_ELSE_NAMESPACE::if_else(
+        IF_ELSE_NAMESPACE::lt(activation(i), 0), -Qdot(i), Qdot(i));
+#else
+    m_speed(i) = activation(i) < 0 ? -Qdot(i) : Qdot(i);
+#endif
+  }
+}
+
+utils::Scalar internal_forces::actuator::ActuatorSet::select(
+    const utils::Vector& activation,
+    const utils::Vector& entries,
+    unsigned int dof) const {
+#ifdef BIORBD_USE_CASADI_MATH
+  return IF_ELSE_NAMESPACE::if_else(
+      IF_ELSE_NAMESPACE::ge(activation(dof), 0),
+      entries(2 * dof),
+      entries(2 * dof + 1));
+#else
+  return activation(dof) >= 0 ? entries(2 * dof) : entries(2 * dof + 1);
+#endif
+}
@@ -98,6 +98,31 @@ utils::Scalar internal_forces::actuator::ActuatorSigmoidGauss3p::torqueMax(
   return Tmax * exp(-(*m_qopt - pos) * (*m_qopt - pos) / (2 * *m_r * *m_r));
 }
 
+const utils::Scalar&
+internal_forces::actuator::ActuatorSigmoidGauss3p::r() const {
+  return *m_r;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorSigmoidGauss3p::qopt() const {
+  return *m_qopt;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorSigmoidGauss3p::theta() const {
+  return *m_theta;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorSigmoidGauss3p::lambda() const {
+  return *m_lambda;
+}
+
+const utils::Scalar&
+internal_forces::actuator::ActuatorSigmoidGauss3p::offset() const {
+  return *m_offset;
+}
+
 void internal_forces::actuator::ActuatorSigmoidGauss3p::setType() {
   *m_type = internal_forces::actuator::TYPE::SIGMOIDGAUSS3P;
 }
@@ -8,12 +8,14 @@
 #include "InternalForces/Actuators/ActuatorGauss3p.h"
 #include "InternalForces/Actuators/ActuatorGauss6p.h"
 #include "InternalForces/Actuators/ActuatorLinear.h"
+#include "InternalForces/Actuators/ActuatorSet.h"
 #include "InternalForces/Actuators/ActuatorSigmoidGauss3p.h"
 #include "RigidBody/GeneralizedCoordinates.h"
 #include "RigidBody/GeneralizedTorque.h"
 #include "RigidBody/GeneralizedVelocity.h"
 #include "RigidBody/Joints.h"
 #include "Utils/Error.h"
+#include "Utils/Matrix.h"
 
 #ifdef USE_SMOOTH_IF_ELSE
 #include "Utils/CasadiExpand.h"
@@ -27,7 +29,9 @@ internal_forces::actuator::Actuators::Actuators()
               std::shared_ptr<internal_forces::actuator::Actuator>,
               std::shared_ptr<internal_forces::actuator::Actuator>>>>()),
       m_isDofSet(std::make_shared<std::vector<bool>>(1)),
-      m_isClose(std::make_shared<bool>(false)) {
+      m_isClose(std::make_shared<bool>(false)),
+      m_actuatorSet(
+          std::make_shared<internal_forces::actuator::ActuatorSet>()) {
   (*m_isDofSet)[0] = false;
 }
 
@@ -35,7 +39,8 @@ internal_forces::actuator::Actuators::Actuators(
     const internal_forces::actuator::Actuators &other)
     : m_all(other.m_all),
       m_isDofSet(other.m_isDofSet),
-      m_isClose(other.m_isClose) {}
+      m_isClose(other.m_isClose),
+      m_actuatorSet(other.m_actuatorSet) {}
 
 internal_forces::actuator::Actuators::~Actuators() {}
 
@@ -133,6 +138,10 @@ void internal_forces::actuator::Actuators::DeepCopy(
     (*m_isDofSet)[i] = (*other.m_isDofSet)[i];
   }
   *m_isClose = *other.m_isClose;
+  m_actuatorSet = std::make_shared<internal_forces::actuator::ActuatorSet>();
+  if (*m_isClose) {
+    m_actuatorSet->compile(*m_all);
+  }
 }
 
 void internal_forces::actuator::Actuators::addActuator(
@@ -255,6 +264,7 @@ void internal_forces::actuator::Actuators::closeActuator() {
         "All DoF must have their actuators set "
         "before closing the model");
 
+  m_actuatorSet->compile(*m_all);
   *m_isClose = true;
 }
 
@@ -287,16 +297,52 @@ rigidbody::GeneralizedTorque internal_forces::actuator::Actuators::torque(
     const utils::Vector &activation,
     const rigidbody::GeneralizedCoordinates &Q,
     const rigidbody::GeneralizedVelocity &Qdot) {
-  // Calculate the maximal torques
-  rigidbody::GeneralizedTorque GeneralizedTorque(
-      torqueMax(activation, Q, Qdot));
+  rigidbody::GeneralizedTorque GeneralizedTorque(nbActuators());
+  torque(activation, Q, Qdot, GeneralizedTorque);
+  return GeneralizedTorque;
+}
 
-  // Put the signs
-  for (unsigned int i = 0; i < GeneralizedTorque.size(); ++i) {
-    GeneralizedTorque(i) = GeneralizedTorque(i) * activation(i);
-  }
+void internal_forces::actuator::Actuators::torque(
+    const utils::Vector &activation,
+    const rigidbody::GeneralizedCoordinates &Q,
+    const rigidbody::GeneralizedVelocity &Qdot,
+    utils::Vector &tau) {
+  utils::Error::check(
+      *m_isClose, "Close the actuator model before calling torque");
+  m_actuatorSet->computeTorques(activation, Q, Qdot, tau);
+}
 
-  return GeneralizedTorque;
+void internal_forces::actuator::Actuators::torqueJacobians(
+    const utils::Vector &activation,
+    const rigidbody::GeneralizedCoordinates &Q,
+    const rigidbody::GeneralizedVelocity &Qdot,
+    utils::Matrix &dTaudActivation,
+    utils::Matrix &dTaudQ,
+    utils::Matrix &dTaudQdot) {
+  utils::Error::check(
+      *m_isClose, "Close the actuator model before calling torqueJacobians");
+  unsigned int nbDof(static_cast<unsigned int>(nbActuators()));
+  utils::Vector tau(nbDof);
+  utils::Vector dTaudActivationDiagonal(nbDof);
+  utils::Vector dTaudQDiagonal(nbDof);
+  utils::Vector dTaudQdotDiagonal(nbDof);
+  m_actuatorSet->computeTorqueDerivatives(
+      activation,
+      Q,
+      Qdot,
+      tau,
+      dTaudActivationDiagonal,
+      dTaudQDiagonal,
+      dTaudQdotDiagonal);
+
+  dTaudActivation = utils::Matrix::Zero(nbDof, nbDof);
+  dTaudQ = utils::Matrix::Zero(nbDof, nbDof);
+  dTaudQdot = utils::Matrix::Zero(nbDof, nbDof);
+  for (unsigned int i = 0; i < nbDof; ++i) {
+    dTaudActivation(i, i) = dTaudActivationDiagonal(i);
+    dTaudQ(i, i) = dTaudQDiagonal(i);
+    dTaudQdot(i, i) = dTaudQdotDiagonal(i);
+  }
 }
 
 std::pair<rigidbody::GeneralizedTorque, rigidbody::GeneralizedTorque>
@@ -306,91 +352,12 @@ internal_forces::actuator::Actuators::torqueMax(
   utils::Error::check(
       *m_isClose, "Close the actuator model before calling torqueMax");
 
-  // Assuming that this is also a Joints type (via BiorbdModel)
-  const rigidbody::Joints &model = dynamic_cast<rigidbody::Joints &>(*this);
-
   std::pair<rigidbody::GeneralizedTorque, rigidbody::GeneralizedTorque>
       maxGeneralizedTorque_all = std::make_pair(
-          rigidbody::GeneralizedTorque(model),
-          rigidbody::GeneralizedTorque(model));
-
-  for (unsigned int i = 0; i < static_cast<unsigned int>(model.nbDof()); ++i) {
-    std::pair<std::shared_ptr<Actuator>, std::shared_ptr<Actuator>>
-        GeneralizedTorque_tp(actuator(i));
-    for (unsigned p = 0; p < 2; ++p) {
-      if (p == 0)  // First
-        if (std::dynamic_pointer_cast<ActuatorGauss3p>(
-                GeneralizedTorque_tp.first)) {
-          maxGeneralizedTorque_all.first[i] =
-              std::static_pointer_cast<ActuatorGauss3p>(
-                  GeneralizedTorque_tp.first)
-                  ->torqueMax(Q, Qdot);
-        } else if (std::dynamic_pointer_cast<ActuatorConstant>(
-                       GeneralizedTorque_tp.first)) {
-          maxGeneralizedTorque_all.first[i] =
-              std::static_pointer_cast<ActuatorConstant>(
-                  GeneralizedTorque_tp.first)
-                  ->torqueMax();
-        } else if (std::dynamic_pointer_cast<ActuatorLinear>(
-                       GeneralizedTorque_tp.first)) {
-          maxGeneralizedTorque_all.first[i] =
-              std::static_pointer_cast<ActuatorLinear>(
-                  GeneralizedTorque_tp.first)
-                  ->torqueMax(Q);
-        } else if (std::dynamic_pointer_cast<ActuatorGauss6p>(
-                       GeneralizedTorque_tp.first)) {
-          maxGeneralizedTorque_all.first[i] =
-              std::static_pointer_cast<ActuatorGauss6p>(
-                  GeneralizedTorque_tp.first)
-                  ->torqueMax(Q, Qdot);
-        } else if (std::dynamic_pointer_cast<ActuatorSigmoidGauss3p>(
-                       GeneralizedTorque_tp.first)) {
-          maxGeneralizedTorque_all.first[i] =
-              std::static_pointer_cast<ActuatorSigmoidGauss3p>(
-                  GeneralizedTorque_tp.first)
-                  ->torqueMax(Q, Qdot);
-        } else {
-          utils::Error::raise(
-              "Wrong type (should never get here because of previous safety)");
-        }
-      else  // Second
-        if (std::dynamic_pointer_cast<ActuatorGauss3p>(
-                GeneralizedTorque_tp.second)) {
-          maxGeneralizedTorque_all.second[i] =
-              std::static_pointer_cast<ActuatorGauss3p>(
-                  GeneralizedTorque_tp.second)
-                  ->torqueMax(Q, Qdot);
-        } else if (std::dynamic_pointer_cast<ActuatorConstant>(
-                       GeneralizedTorque_tp.second)) {
-          maxGeneralizedTorque_all.second[i] =
-              std::static_pointer_cast<ActuatorConstant>(
-                  GeneralizedTorque_tp.second)
-                  ->torqueMax();
-        } else if (std::dynamic_pointer_cast<ActuatorLinear>(
-                       GeneralizedTorque_tp.second)) {
-          maxGeneralizedTorque_all.second[i] =
-              std::static_pointer_cast<ActuatorLinear>(
-                  GeneralizedTorque_tp.second)
-                  ->torqueMax(Q);
-        } else if (std::dynamic_pointer_cast<ActuatorGauss6p>(
-                       GeneralizedTorque_tp.second)) {
-          maxGeneralizedTorque_all.second[i] =
-              std::static_pointer_cast<ActuatorGauss6p>(
-                  GeneralizedTorque_tp.second)
-                  ->torqueMax(Q, Qdot);
-        } else if (std::dynamic_pointer_cast<ActuatorSigmoidGauss3p>(
-                       GeneralizedTorque_tp.second)) {
-          maxGeneralizedTorque_all.second[i] =
-              std::static_pointer_cast<ActuatorSigmoidGauss3p>(
-                  GeneralizedTorque_tp.second)
-                  ->torqueMax(Q, Qdot);
-        } else {
-          utils::Error::raise(
-              "Wrong type (should never get here because of previous safety)");
-        }
-    }
-  }
-
+          rigidbody::GeneralizedTorque(nbActuators()),
+          rigidbody::GeneralizedTorque(nbActuators()));
+  m_actuatorSet->computeTorqueMax(
+      Q, Qdot, maxGeneralizedTorque_all.first, maxGeneralizedTorque_all.second);
   return maxGeneralizedTorque_all;
 }
 
@@ -401,41 +368,9 @@ rigidbody::GeneralizedTorque internal_forces::actuator::Actuators::torqueMax(
   utils::Error::check(
       *m_isClose, "Close the actuator model before calling torqueMax");
 
-  // Assuming that this is also a Joints type (via BiorbdModel)
-  const rigidbody::Joints &model = dynamic_cast<rigidbody::Joints &>(*this);
-
-  // Set qdot to be positive if concentric and negative if excentric
-  rigidbody::GeneralizedVelocity QdotResigned(Qdot);
-  for (unsigned int i = 0; i < static_cast<unsigned int>(Qdot.size()); ++i) {
-#ifdef BIORBD_USE_CASADI_MATH
-    QdotResigned(i) = IF_ELSE_NAMESPACE::if_else(
-        IF_ELSE_NAMESPACE::lt(activation(i), 0), -Qdot(i), Qdot(i));
-#else
-    if (activation(i) < 0) {
-      QdotResigned(i) = -Qdot(i);
-    }
-#endif
-  }
-
-  rigidbody::GeneralizedTorque maxGeneralizedTorque_all(model);
-
-  for (unsigned int i = 0; i < static_cast<unsigned int>(model.nbDof()); ++i) {
-#ifdef BIORBD_USE_CASADI_MATH
-    maxGeneralizedTorque_all[i] = IF_ELSE_NAMESPACE::if_else(
-        IF_ELSE_NAMESPACE::ge(activation(i, 0), 0),
-        getTorqueMaxDirection(actuator(i).first, Q, QdotResigned),
-        getTorqueMaxDirection(actuator(i).second, Q, QdotResigned));
-#else
-    if (activation[i] >= 0) {  // First
-      maxGeneralizedTorque_all[i] =
-          getTorqueMaxDirection(actuator(i).first, Q, QdotResigned);
-    } else {
-      maxGeneralizedTorque_all[i] =
-          getTorqueMaxDirection(actuator(i).second, Q, QdotResigned);
-    }
-#endif
-  }
-
+  rigidbody::GeneralizedTorque maxGeneralizedTorque_all(nbActuators());
+  m_actuatorSet->computeTorqueMax(
+      activation, Q, Qdot, maxGeneralizedTorque_all);
   return maxGeneralizedTorque_all;
 }
 
@@ -15,6 +15,7 @@
 #include "RigidBody/NodeSegment.h"
 #include "Utils/Error.h"
 #include "Utils/Matrix.h"
+#include "Utils/Matrix3d.h"
 #include "Utils/RotoTrans.h"
 
 using namespace BIORBD_NAMESPACE;
@@ -114,7 +115,7 @@ void internal_forces::Geometry::updateKinematics(
   jacobian(updatedModel, *Q);
 
   // Complete the update
-  _updateKinematics(Qdot, &pathModifiers);
+  _updateKinematics(Qdot, &pathModifiers, &updatedModel, Q);
 }
 
 void internal_forces::Geometry::updateKinematics(
@@ -133,6 +134,33 @@ void internal_forces::Geometry::updateKinematics(
   _updateKinematics(Qdot, nullptr);
 }
 
+void internal_forces::Geometry::updateKinematics(
+    std::vector<utils::Vector3d> &pointsInGlobal,
+    utils::Matrix &jacoPointsInGlobal,
+    const utils::Vector &lengths,
+    const utils::Matrix &lengthJacobian,
+    size_t idx,
+    const rigidbody::GeneralizedVelocity *Qdot) {
+  *m_posAndJacoWereForced = true;
+
+  // Position of the points in space and their Jacobian
+  setPointsInGlobal(pointsInGlobal);
+  jacobian(jacoPointsInGlobal);
+
+  // Length and its jacobian, read from the row of the table
+  unsigned int row(static_cast<unsigned int>(idx));
+  *m_length = lengths(row);
+  *m_jacobianLength = lengthJacobian.block(
+      row, 0, 1, static_cast<unsigned int>(lengthJacobian.cols()));
+  *m_isGeometryComputed = true;
+  if (Qdot != nullptr) {
+    velocity(*Qdot);
+    *m_isVelocityComputed = true;
+  } else {
+    *m_isVelocityComputed = false;
+  }
+}
+
 // Get and set the positions of the origins and insertions
 void internal_forces::Geometry::setOrigin(const utils::Vector3d &position) {
   if (dynamic_cast<const rigidbody::NodeSegment *>(&position)) {
@@ -235,13 +263,20 @@ const utils::Matrix &internal_forces::Geometry::jacobianLength() const {
 
 void internal_forces::Geometry::_updateKinematics(
     const rigidbody::GeneralizedVelocity *Qdot,
-    internal_forces::PathModifiers *pathModifiers) {
+    internal_forces::PathModifiers *pathModifiers,
+    rigidbody::Joints *updatedModel,
+    const rigidbody::GeneralizedCoordinates *Q) {
   // Compute the length and velocities
   length(pathModifiers);
   *m_isGeometryComputed = true;
 
   // Compute the jacobian of the lengths
-  computeJacobianLength();
+  if (updatedModel != nullptr && pathModifiers != nullptr &&
+      pathModifiers->nbWraps() != 0) {
+    computeJacobianLength(*updatedModel, *Q, *pathModifiers);
+  } else {
+    computeJacobianLength();
+  }
   if (Qdot != nullptr) {
     velocity(*Qdot);
     *m_isVelocityComputed = true;
@@ -287,122 +322,117 @@ void internal_forces::Geometry::setPointsInGlobal(
   m_pointsInLocal->clear();
   m_pointsInGlobal->clear();
 
-  // Do not apply on wrapping objects
-  if (pathModifiers->nbWraps() != 0) {
-    // CHECK TO MODIFY BEFOR GOING FORWARD WITH PROJECTS
-    utils::Error::check(
-        pathModifiers->nbVia() == 0, "Cannot mix wrapping and via points yet");
-    utils::Error::check(
-        pathModifiers->nbWraps() < 2,
-        "Cannot compute more than one wrapping yet");
-
-    // Get the matrix of Rt of the wrap
-    internal_forces::WrappingObject &w =
-        static_cast<internal_forces::WrappingObject &>(
-            pathModifiers->object(0));
-    const utils::RotoTrans &RT = w.RT(model, Q, false);
-
-    // Alias
-    const utils::Vector3d &po_mus = originInGlobal(model, Q);  // Origin on bone
-    const utils::Vector3d &pi_mus =
-        insertionInGlobal(model, Q);  // Insertion on bone
-
-    utils::Vector3d pi_wrap(
-        0,
-        0,
-        0);  // point on the wrapping related to insertion
-    utils::Vector3d po_wrap(
-        0,
-        0,
-        0);  // point on the wrapping related to origin
-
-    utils::Scalar a;  // Force the computation of the length
-    w.wrapPoints(RT, po_mus, pi_mus, po_wrap, pi_wrap, &a);
-
-    // Store the points in local
-    m_pointsInLocal->push_back(originInLocal());
-    m_pointsInLocal->push_back(
-        utils::Vector3d(
-            model.CalcBodyToBaseCoordinates(Q, w.parent(), po_wrap, false),
-            "wrap_o",
-            w.parent()));
-    m_pointsInLocal->push_back(
-        utils::Vector3d(
-            model.CalcBodyToBaseCoordinates(Q, w.parent(), pi_wrap, false),
-            "wrap_i",
-            w.parent()));
-    m_pointsInLocal->push_back(insertionInLocal());
-
-    // Store the points in global
-    m_pointsInGlobal->push_back(po_mus);
-    m_pointsInGlobal->push_back(po_wrap);
-    m_pointsInGlobal->push_back(pi_wrap);
-    m_pointsInGlobal->push_back(pi_mus);
-
-  }
-
-  else if (
-      pathModifiers->nbObjects() != 0 &&
-      pathModifiers->object(0).typeOfNode() == utils::NODE_TYPE::VIA_POINT) {
-    m_pointsInLocal->push_back(originInLocal());
-    m_pointsInGlobal->push_back(originInGlobal(model, Q));
-    for (size_t i = 0; i < pathModifiers->nbObjects(); ++i) {
-      const internal_forces::ViaPoint &node(
-          static_cast<internal_forces::ViaPoint &>(pathModifiers->object(i)));
-      m_pointsInLocal->push_back(node);
+  m_pointsInLocal->push_back(originInLocal());
+  m_pointsInGlobal->push_back(originInGlobal(model, Q));
+
+  // Apply the via points and wrapping objects in order. A wrapping object wraps
+  // the path going from the previous point to the next via point (or
+  // insertion).
+  size_t nbObjects(pathModifiers != nullptr ? pathModifiers->nbObjects() : 0);
+  for (size_t i = 0; i < nbObjects; ++i) {
+    utils::Vector3d &object(pathModifiers->object(i));
+    if (object.typeOfNode() == utils::NODE_TYPE::VIA_POINT) {
+      m_pointsInLocal->push_back(object);
       m_pointsInGlobal->push_back(
-          model.CalcBodyToBaseCoordinates(Q, node.parent(), node, false));
+          model.CalcBodyToBaseCoordinates(Q, object.parent(), object, false));
+
+    } else if (
+        object.typeOfNode() == utils::NODE_TYPE::WRAPPING_HALF_CYLINDER ||
+        object.typeOfNode() == utils::NODE_TYPE::WRAPPING_SPHERE ||
+        object.typeOfNode() == utils::NODE_TYPE::WRAPPING_ELLIPSOID) {
+      // Get the matrix of Rt of the wrap
+      internal_forces::WrappingObject &w =
+          static_cast<internal_forces::WrappingObject &>(object);
+      const utils::RotoTrans &RT = w.RT(model, Q, false);
+
+      // Points before and after the wrap
+      utils::Vector3d p1_mus(m_pointsInGlobal->back());
+      utils::Vector3d p2_mus(nextPointInGlobal(model, Q, *pathModifiers, i));
+
+      utils::Vector3d p1_wrap(0, 0, 0);  // point on the wrapping related to p1
+      utils::Vector3d p2_wrap(0, 0, 0);  // point on the wrapping related to p2
+      utils::Scalar a;  // Force the computation of the length
+      w.wrapPoints(RT, p1_mus, p2_mus, p1_wrap, p2_wrap, &a);
+
+      // Store the points in local (as if they were fixed on the wrap)
+      unsigned int id(model.GetBodyId(w.parent().c_str()));
+      m_pointsInLocal->push_back(
+          utils::Vector3d(
+              RigidBodyDynamics::CalcBaseToBodyCoordinates(
+                  model, Q, id, p1_wrap, false),
+              "wrap_o",
+              w.parent()));
+      m_pointsInLocal->push_back(
+          utils::Vector3d(
+              RigidBodyDynamics::CalcBaseToBodyCoordinates(
+                  model, Q, id, p2_wrap, false),
+              "wrap_i",
+              w.parent()));
+
+      // Store the points in global
+      m_pointsInGlobal->push_back(p1_wrap);
+      m_pointsInGlobal->push_back(p2_wrap);
+
+    } else {
+      utils::Error::raise("Length for this type of object was not implemented");
     }
-    m_pointsInLocal->push_back(insertionInLocal());
-    m_pointsInGlobal->push_back(insertionInGlobal(model, Q));
-
-  } else if (pathModifiers->nbObjects() == 0) {
-    m_pointsInLocal->push_back(originInLocal());
-    m_pointsInLocal->push_back(insertionInLocal());
-    m_pointsInGlobal->push_back(originInGlobal(model, Q));
-    m_pointsInGlobal->push_back(insertionInGlobal(model, Q));
-  } else {
-    utils::Error::raise("Length for this type of object was not implemented");
   }
 
+  m_pointsInLocal->push_back(insertionInLocal());
+  m_pointsInGlobal->push_back(insertionInGlobal(model, Q));
+
   // Set the dimension of jacobian
   setJacobianDimension(model);
 }
 
-const utils::Scalar &internal_forces::Geometry::length(
-    internal_forces::PathModifiers *pathModifiers) {
-  *m_length = 0;
+utils::Vector3d internal_forces::Geometry::nextPointInGlobal(
+    rigidbody::Joints &model,
+    const rigidbody::GeneralizedCoordinates &Q,
+    internal_forces::PathModifiers &pathModifiers,
+    size_t idx) {
+  for (size_t i = idx + 1; i < pathModifiers.nbObjects(); ++i) {
+    const utils::Vector3d &object(pathModifiers.object(i));
+    if (object.typeOfNode() == utils::NODE_TYPE::VIA_POINT) {
+      return model.CalcBodyToBaseCoordinates(
+          Q, object.parent(), object, false);
+    }
+  }
+  return insertionInGlobal(model, Q);
+}
 
-  // because we can't combine, test the first (0) will let us know all the types
-  // if more than one
-  if (pathModifiers != nullptr && pathModifiers->nbWraps() != 0) {
-    utils::Error::check(
-        pathModifiers->nbVia() == 0, "Cannot mix wrapping and via points yet");
-    utils::Error::check(
-        pathModifiers->nbWraps() < 2,
-        "Cannot compute more than one wrapping yet");
-
-    utils::Vector3d pi_wrap(
-        0,
-        0,
-        0);  // point on the wrapping related to insertion
-    utils::Vector3d po_wrap(
-        0,
-        0,
-        0);  // point on the wrapping related to origin
-    utils::Scalar lengthWrap(0);
-    static_cast<internal_forces::WrappingObject &>(pathModifiers->object(0))
-        .wrapPoints(po_wrap, pi_wrap, &lengthWrap);
-    *m_length =
-        ((*m_pointsInGlobal)[0] - po_wrap).norm() +  // length before the wrap
-        lengthWrap +                                 // length on the wrap
-        ((*m_pointsInGlobal)[3] - pi_wrap).norm();   // length after the wrap
+utils::Scalar internal_forces::Geometry::pathLength(
+    internal_forces::PathModifiers *pathModifiers) const {
+  const std::vector<utils::Vector3d> &p = *m_pointsInGlobal;
+  utils::Scalar length(0);
 
-  } else {
-    for (size_t i = 0; i < m_pointsInGlobal->size() - 1; ++i) {
-      *m_length += ((*m_pointsInGlobal)[i + 1] - (*m_pointsInGlobal)[i]).norm();
+  // On a wrapping object, the path follows the object between its two points
+  size_t point(0);
+  if (pathModifiers != nullptr && pathModifiers->nbWraps() != 0) {
+    for (size_t i = 0; i < pathModifiers->nbObjects(); ++i) {
+      utils::Vector3d &object(pathModifiers->object(i));
+      length = length + (p[point + 1] - p[point]).norm();
+      if (object.typeOfNode() == utils::NODE_TYPE::VIA_POINT) {
+        point += 1;
+      } else {
+        utils::Vector3d p1_wrap(0, 0, 0);
+        utils::Vector3d p2_wrap(0, 0, 0);
+        utils::Scalar lengthWrap(0);
+        static_cast<internal_forces::WrappingObject &>(object).wrapPoints(
+            p1_wrap, p2_wrap, &lengthWrap);
+        length = length + lengthWrap;
+        point += 2;
+      }
     }
   }
+  for (; point < p.size() - 1; ++point) {
+    length = length + (p[point + 1] - p[point]).norm();
+  }
+  return length;
+}
+
+const utils::Scalar &internal_forces::Geometry::length(
+    internal_forces::PathModifiers *pathModifiers) {
+  *m_length = pathLength(pathModifiers);
   return *m_length;
 }
 
@@ -414,8 +444,13 @@ const utils::Scalar &internal_forces::Geometry::velocity(
 }
 
 void internal_forces::Geometry::setJacobianDimension(rigidbody::Joints &model) {
-  *m_jacobian = utils::Matrix::Zero(
-      static_cast<unsigned int>(m_pointsInLocal->size() * 3), model.dof_count);
+  // Only reallocate if the number of points changed (e.g. forced update)
+  int nbRows(static_cast<int>(m_pointsInLocal->size() * 3));
+  if (m_jacobian->rows() != nbRows ||
+      m_jacobian->cols() != static_cast<int>(model.dof_count)) {
+    *m_jacobian = utils::Matrix::Zero(
+        static_cast<unsigned int>(nbRows), model.dof_count);
+  }
 }
 
 void internal_forces::Geometry::jacobian(const utils::Matrix &jaco) {
@@ -444,11 +479,173 @@ void internal_forces::Geometry::jacobian(
 void internal_forces::Geometry::computeJacobianLength() {
   *m_jacobianLength = utils::Matrix::Zero(1, m_jacobian->cols());
 
-  // jacobian approximates as if there were no wrapping object
-  const std::vector<utils::Vector3d> &p = *m_pointsInGlobal;
-  for (size_t i = 0; i < p.size() - 1; ++i) {
-    *m_jacobianLength +=
-        ((p[i + 1] - p[i]).transpose() * (jacobian(i + 1) - jacobian(i))) /
-        (p[i + 1] - p[i]).norm();
+  // if there is a wrapping object, the jacobian approximates as if the
+  // wrapping points were fixed on their segment
+  for (size_t i = 0; i < m_pointsInGlobal->size() - 1; ++i) {
+    addJacobianLengthOfSegment(i);
+  }
+}
+
+void internal_forces::Geometry::computeJacobianLength(
+    rigidbody::Joints &updatedModel,
+    const rigidbody::GeneralizedCoordinates &Q,
+    internal_forces::PathModifiers &pathModifiers) {
+  *m_jacobianLength = utils::Matrix::Zero(1, m_jacobian->cols());
+
+  // The wrapping objects in between two fixed points (origin, via points or
+  // insertion) are differentiated exactly
+  size_t point(0);
+  bool isCounted(false);  // If the segment starting at point is already done
+  size_t nbObjects(pathModifiers.nbObjects());
+  for (size_t i = 0; i < nbObjects; ++i) {
+    const utils::Vector3d &object(pathModifiers.object(i));
+    if (object.typeOfNode() == utils::NODE_TYPE::VIA_POINT) {
+      if (!isCounted) {
+        addJacobianLengthOfSegment(point);
+      }
+      isCounted = false;
+      point += 1;
+      continue;
+    }
+
+    // Wrapping objects that follow each other
+    size_t last(i);
+    while (last + 1 < nbObjects &&
+           pathModifiers.object(last + 1).typeOfNode() !=
+               utils::NODE_TYPE::VIA_POINT) {
+      ++last;
+    }
+    size_t nbWraps(last - i + 1);
+#ifdef BIORBD_USE_CASADI_MATH
+    if (nbWraps > 1) {
+      // They are approximated as if their points were fixed on their segment
+      // (the part on the objects then does not contribute)
+      for (size_t j = 0; j < nbWraps; ++j) {
+        addJacobianLengthOfSegment(point);
+        point += 2;
+      }
+      isCounted = false;
+      i = last;
+      continue;
+    }
+#endif
+
+    // From the previous point to the next one, around the objects
+    addJacobianLengthOfWraps(
+        updatedModel,
+        Q,
+        pathModifiers,
+        i,
+        last,
+        point,
+        point + 2 * nbWraps + 1);
+    isCounted = true;
+    point += 2 * nbWraps;
+    i = last;
+  }
+  if (!isCounted) {
+    addJacobianLengthOfSegment(point);
+  }
+}
+
+void internal_forces::Geometry::addJacobianLengthOfSegment(size_t idx) {
+  const utils::Vector3d &p1((*m_pointsInGlobal)[idx]);
+  const utils::Vector3d &p2((*m_pointsInGlobal)[idx + 1]);
+  unsigned int nbDof(static_cast<unsigned int>(m_jacobian->cols()));
+  unsigned int row(static_cast<unsigned int>(3 * idx));
+  *m_jacobianLength += ((p2 - p1).transpose() *
+                        (m_jacobian->block(row + 3, 0, 3, nbDof) -
+                         m_jacobian->block(row, 0, 3, nbDof))) /
+                       (p2 - p1).norm();
+}
+
+void internal_forces::Geometry::addJacobianLengthOfWraps(
+    rigidbody::Joints &updatedModel,
+    const rigidbody::GeneralizedCoordinates &Q,
+    internal_forces::PathModifiers &pathModifiers,
+    size_t firstObject,
+    size_t lastObject,
+    size_t idxBefore,
+    size_t idxAfter) {
+  unsigned int nbDof(static_cast<unsigned int>(m_jacobian->cols()));
+  unsigned int row1(static_cast<unsigned int>(3 * idxBefore));
+  unsigned int row2(static_cast<unsigned int>(3 * idxAfter));
+  const utils::Vector3d zero(0, 0, 0);
+
+  // Each wrapping object wraps the path going from the point where the path
+  // leaves the previous object (or from the point before) to the point after
+  utils::Vector3d p1((*m_pointsInGlobal)[idxBefore]);
+  const utils::Vector3d &p2((*m_pointsInGlobal)[idxAfter]);
+  utils::Matrix J1(m_jacobian->block(row1, 0, 3, nbDof));
+  utils::Matrix J2(m_jacobian->block(row2, 0, 3, nbDof));
+  for (size_t i = firstObject; i <= lastObject; ++i) {
+    const internal_forces::WrappingObject &w(
+        static_cast<const internal_forces::WrappingObject &>(
+            pathModifiers.object(i)));
+
+    // Derivative of the length with respect to the points before and after
+    // the wrap, the wrapping object being held fixed
+    utils::Vector3d dLdp1(0, 0, 0);
+    utils::Vector3d dLdp2(0, 0, 0);
+    w.lengthGradient(w.RT(), p1, p2, dLdp1, dLdp2);
+
+    // The length only depends on the position of these points relative to the
+    // wrapping object. The relative velocity of a point p is
+    // v_p - (v_o + omega x (p - o)) where o is the origin of the segment of the
+    // wrapping object
+    unsigned int id(updatedModel.GetBodyId(w.parent().c_str()));
+    utils::Matrix G(utils::Matrix::Zero(6, nbDof));
+    RigidBodyDynamics::CalcPointJacobian6D(updatedModel, Q, id, zero, G, false);
+    utils::Vector3d o(
+        RigidBodyDynamics::CalcBodyToBaseCoordinates(
+            updatedModel, Q, id, zero, false));
+
+    utils::Vector3d dLdLinear(dLdp1 + dLdp2);
+    utils::Vector3d dLdAngular((p1 - o).cross(dLdp1) + (p2 - o).cross(dLdp2));
+    *m_jacobianLength += dLdp1.transpose() * J1 + dLdp2.transpose() * J2 -
+                         dLdLinear.transpose() * G.block(3, 0, 3, nbDof) -
+                         dLdAngular.transpose() * G.block(0, 0, 3, nbDof);
+
+#ifndef BIORBD_USE_CASADI_MATH
+    if (i == lastObject) {
+      break;
+    }
+
+    // The path does not go straight from where it leaves the object to the
+    // point after, but around the next object instead. That point moves with
+    // the object and with the points relative to it
+    utils::Matrix3d p1Wrap_p1;
+    utils::Matrix3d p1Wrap_p2;
+    utils::Matrix3d p2Wrap_p1;
+    utils::Matrix3d p2Wrap_p2;
+    w.wrapPointsJacobian(
+        w.RT(), p1, p2, p1Wrap_p1, p1Wrap_p2, p2Wrap_p1, p2Wrap_p2);
+    const utils::Vector3d &p2Wrap(
+        (*m_pointsInGlobal)[idxBefore + 2 * (i - firstObject) + 2]);
+    utils::Matrix J2Wrap(
+        p2Wrap_p1 * relativeJacobian(J1, G, p1 - o) +
+        p2Wrap_p2 * relativeJacobian(J2, G, p2 - o) -
+        relativeJacobian(utils::Matrix::Zero(3, nbDof), G, p2Wrap - o));
+
+    utils::Vector3d u((p2Wrap - p2) / (p2Wrap - p2).norm());
+    *m_jacobianLength -= u.transpose() * (J2Wrap - J2);
+    p1 = p2Wrap;
+    J1 = J2Wrap;
+#endif
+  }
+}
+
+#ifndef BIORBD_USE_CASADI_MATH
+utils::Matrix internal_forces::Geometry::relativeJacobian(
+    const utils::Matrix &jaco,
+    const utils::Matrix &jacoOrigin,
+    const utils::Vector3d &r) {
+  unsigned int nbDof(static_cast<unsigned int>(jaco.cols()));
+  utils::Matrix relative(jaco - jacoOrigin.block(3, 0, 3, nbDof));
+  for (unsigned int i = 0; i < nbDof; ++i) {
+    utils::Vector3d omega(jacoOrigin.block(0, i, 3, 1));
+    relative.block(0, i, 3, 1) += r.cross(omega);
   }
+  return relative;
 }
+#endif
@@ -139,6 +139,35 @@ void internal_forces::ligaments::Ligament::updateOrientations(
   m_position->updateKinematics(
       ligamentPointsInGlobal, jacoPointsInGlobal, &Qdot);
 }
+void internal_forces::ligaments::Ligament::updateOrientations(
+    std::vector<utils::Vector3d> &ligamentPointsInGlobal,
+    utils::Matrix &jacoPointsInGlobal,
+    const utils::Vector &lengths,
+    const utils::Matrix &lengthJacobian,
+    size_t idx) {
+  m_position->updateKinematics(
+      ligamentPointsInGlobal,
+      jacoPointsInGlobal,
+      lengths,
+      lengthJacobian,
+      idx,
+      nullptr);
+}
+void internal_forces::ligaments::Ligament::updateOrientations(
+    std::vector<utils::Vector3d> &ligamentPointsInGlobal,
+    utils::Matrix &jacoPointsInGlobal,
+    const utils::Vector &lengths,
+    const utils::Matrix &lengthJacobian,
+    size_t idx,
+    const rigidbody::GeneralizedVelocity &Qdot) {
+  m_position->updateKinematics(
+      ligamentPointsInGlobal,
+      jacoPointsInGlobal,
+      lengths,
+      lengthJacobian,
+      idx,
+      &Qdot);
+}
 
 void internal_forces::ligaments::Ligament::setPosition(
     const internal_forces::Geometry &positions) {
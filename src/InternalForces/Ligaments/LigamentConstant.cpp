@@ -78,6 +78,11 @@ void internal_forces::ligaments::LigamentConstant::DeepCopy(
   *m_force = *other.m_force;
 }
 
+const utils::Scalar &
+internal_forces::ligaments::LigamentConstant::constantForce() const {
+  return *m_force;
+}
+
 internal_forces::ligaments::LigamentConstant::~LigamentConstant() {}
 
 void internal_forces::ligaments::LigamentConstant::setType() {
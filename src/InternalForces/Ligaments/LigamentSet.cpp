@@ -0,0 +1,187 @@
+#define BIORBD_API_EXPORTS
+#include "InternalForces/Ligaments/LigamentSet.h"
+
+#include <cmath>
+
+#include "InternalForces/Geometry.h"
+#include "InternalForces/Ligaments/Ligament.h"
+#include "InternalForces/Ligaments/LigamentCharacteristics.h"
+#include "InternalForces/Ligaments/LigamentConstant.h"
+#include "InternalForces/Ligaments/LigamentSpringLinear.h"
+#include "InternalForces/Ligaments/LigamentSpringSecondOrder.h"
+#include "Utils/Error.h"
+
+#ifdef USE_SMOOTH_IF_ELSE
+#include "Utils/CasadiExpand.h"
+#endif
+
+using namespace BIORBD_NAMESPACE;
+
+internal_forces::ligaments::LigamentSet::LigamentSet() {}
+
+internal_forces::ligaments::LigamentSet::LigamentSet(
+    const std::vector<std::shared_ptr<internal_forces::ligaments::Ligament>>&
+        ligaments) {
+  compile(ligaments);
+}
+
+internal_forces::ligaments::LigamentSet::~LigamentSet() {}
+
+void internal_forces::ligaments::LigamentSet::compile(
+    const std::vector<std::shared_ptr<internal_forces::ligaments::Ligament>>&
+        ligaments) {
+  unsigned int nbLig(static_cast<unsigned int>(ligaments.size()));
+  m_ligaments = ligaments;
+  m_constant.clear();
+  m_springLinear.clear();
+  m_springSecondOrder.clear();
+
+  m_force = utils::Vector::Zero(nbLig);
+  m_stiffness = utils::Vector::Zero(nbLig);
+  m_epsilon = utils::Vector::Zero(nbLig);
+  m_slackLength = utils::Vector::Zero(nbLig);
+  m_dampingParam = utils::Vector::Zero(nbLig);
+  m_maxShorteningSpeed = utils::Vector::Zero(nbLig);
+  m_lengths = utils::Vector::Zero(nbLig);
+  m_velocities = utils::Vector::Zero(nbLig);
+
+  for (size_t i = 0; i < ligaments.size(); ++i) {
+    const internal_forces::ligaments::Ligament& ligament(*ligaments[i]);
+    const internal_forces::ligaments::LigamentCharacteristics& characteristics(
+        ligament.characteristics());
+    unsigned int idx(static_cast<unsigned int>(i));
+    m_slackLength(idx) = characteristics.ligamentSlackLength();
+    m_dampingParam(idx) = characteristics.dampingParam();
+    m_maxShorteningSpeed(idx) = characteristics.maxShorteningSpeed();
+
+    switch (ligament.type()) {
+      case internal_forces::ligaments::LIGAMENT_TYPE::LIGAMENT_CONSTANT:
+        m_constant.push_back(i);
+        m_force(idx) =
+            static_cast<const internal_forces::ligaments::LigamentConstant&>(
+                ligament)
+                .constantForce();
+        break;
+      case internal_forces::ligaments::LIGAMENT_TYPE::LIGAMENT_SPRING_LINEAR:
+        m_springLinear.push_back(i);
+        m_stiffness(idx) = static_cast<
+                               const internal_forces::ligaments::
+                                   LigamentSpringLinear&>(ligament)
+                               .stiffness();
+        break;
+      case internal_forces::ligaments::LIGAMENT_TYPE::
+          LIGAMENT_SPRING_SECOND_ORDER: {
+        const internal_forces::ligaments::LigamentSpringSecondOrder& spring(
+            static_cast<
+                const internal_forces::ligaments::LigamentSpringSecondOrder&>(
+                ligament));
+        m_springSecondOrder.push_back(i);
+        m_stiffness(idx) = spring.stiffness();
+        m_epsilon(idx) = spring.epsilon();
+        break;
+      }
+      default:
+        utils::Error::raise("Ligament type not found");
+    }
+  }
+}
+
+size_t internal_forces::ligaments::LigamentSet::nbLigaments() const {
+  return m_ligaments.size();
+}
+
+const std::vector<size_t>& internal_forces::ligaments::LigamentSet::indices(
+    internal_forces::ligaments::LIGAMENT_TYPE type) const {
+  switch (type) {
+    case internal_forces::ligaments::LIGAMENT_TYPE::LIGAMENT_CONSTANT:
+      return m_constant;
+    case internal_forces::ligaments::LIGAMENT_TYPE::LIGAMENT_SPRING_LINEAR:
+      return m_springLinear;
+    case internal_forces::ligaments::LIGAMENT_TYPE::
+        LIGAMENT_SPRING_SECOND_ORDER:
+      return m_springSecondOrder;
+    default:
+      utils::Error::raise("Ligament type not found");
+  }
+#ifdef _WIN32
+  return m_constant;  // Will never reach here
+#endif
+}
+
+void internal_forces::ligaments::LigamentSet::updateKinematics() {
+  for (size_t i = 0; i < m_ligaments.size(); ++i) {
+    const internal_forces::Geometry& geometry(m_ligaments[i]->position());
+    m_lengths(static_cast<unsigned int>(i)) = geometry.length();
+    m_velocities(static_cast<unsigned int>(i)) = geometry.velocity();
+  }
+}
+
+utils::Vector& internal_forces::ligaments::LigamentSet::ligamentLengths() {
+  return m_lengths;
+}
+
+utils::Vector& internal_forces::ligaments::LigamentSet::ligamentVelocities() {
+  return m_velocities;
+}
+
+void internal_forces::ligaments::LigamentSet::computeForces(
+    utils::Vector& forces) const {
+  computeForces(m_lengths, m_velocities, forces);
+  scatterForces(forces);
+}
+
+void internal_forces::ligaments::LigamentSet::scatterForces(
+    const utils::Vector& forces) const {
+  for (size_t k = 0; k < m_ligaments.size(); ++k) {
+    *m_ligaments[k]->m_force = forces(static_cast<unsigned int>(k));
+  }
+}
+
+void internal_forces::ligaments::LigamentSet::computeForces(
+    const utils::Vector& lengths,
+    const utils::Vector& velocities,
+    utils::Vector& forces) const {
+  for (size_t k = 0; k < m_constant.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_constant[k]));
+    forces(i) = m_force(i);
+  }
+
+  // Same as LigamentSpringLinear::computeFl
+  for (size_t k = 0; k < m_springLinear.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_springLinear[k]));
+#ifdef BIORBD_USE_CASADI_MATH
+    forces(i) = IF_ELSE_NAMESPACE::if_else_zero(
+        IF_ELSE_NAMESPACE::gt(lengths(i), m_slackLength(i)),
+        m_stiffness(i) * (lengths(i) - m_slackLength(i)));
+#else
+    forces(i) = lengths(i) > m_slackLength(i)
+                    ? m_stiffness(i) * (lengths(i) - m_slackLength(i))
+                    : 0;
+#endif
+  }
+
+  // Same as LigamentSpringSecondOrder::computeFl
+  for (size_t k = 0; k < m_springSecondOrder.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_springSecondOrder[k]));
+    utils::Scalar d(lengths(i) - m_slackLength(i));
+    forces(i) = (m_stiffness(i) / 2) *
+                (d + std::sqrt(d * d + m_epsilon(i) * m_epsilon(i)));
+  }
+
+  // Damping of the lengthening ligaments, same as Ligament::computeDamping
+  for (unsigned int i = 0; i < static_cast<unsigned int>(nbLigaments());
+       ++i) {
+#ifdef BIORBD_USE_CASADI_MATH
+    forces(i) =
+        forces(i) +
+        IF_ELSE_NAMESPACE::if_else_zero(
+            IF_ELSE_NAMESPACE::gt(velocities(i), 0),
+            (velocities(i) / m_maxShorteningSpeed(i)) * m_dampingParam(i));
+#else
+    if (velocities(i) > 0) {
+      forces(i) +=
+          (velocities(i) / m_maxShorteningSpeed(i)) * m_dampingParam(i);
+    }
+#endif
+  }
+}
@@ -4,8 +4,10 @@
 
 #include "InternalForces/Ligaments/Ligament.h"
 #include "InternalForces/Ligaments/LigamentConstant.h"
+#include "InternalForces/Ligaments/LigamentSet.h"
 #include "InternalForces/Ligaments/LigamentSpringLinear.h"
 #include "InternalForces/Ligaments/LigamentSpringSecondOrder.h"
+#include "InternalForces/PathKinematics.h"
 #include "RigidBody/GeneralizedCoordinates.h"
 #include "RigidBody/GeneralizedTorque.h"
 #include "RigidBody/GeneralizedVelocity.h"
@@ -18,11 +20,15 @@ using namespace BIORBD_NAMESPACE;
 internal_forces::ligaments::Ligaments::Ligaments()
     : m_ligaments(
           std::make_shared<std::vector<
-              std::shared_ptr<internal_forces::ligaments::Ligament>>>()) {}
+              std::shared_ptr<internal_forces::ligaments::Ligament>>>()),
+      m_ligamentSet(nullptr),
+      m_ligamentPaths(nullptr) {}
 
 internal_forces::ligaments::Ligaments::Ligaments(
     const internal_forces::ligaments::Ligaments& other)
-    : m_ligaments(other.m_ligaments) {}
+    : m_ligaments(other.m_ligaments),
+      m_ligamentSet(other.m_ligamentSet),
+      m_ligamentPaths(other.m_ligamentPaths) {}
 
 internal_forces::ligaments::Ligaments::~Ligaments() {}
 
@@ -37,30 +43,43 @@ void internal_forces::ligaments::Ligaments::DeepCopy(
     const internal_forces::ligaments::Ligaments& other) {
   m_ligaments->resize(other.m_ligaments->size());
   for (size_t i = 0; i < other.m_ligaments->size(); ++i) {
-    if ((*other.m_ligaments)[i]->type() ==
+    const internal_forces::ligaments::Ligament& ligament(
+        *(*other.m_ligaments)[i]);
+    if (ligament.type() ==
         internal_forces::ligaments::LIGAMENT_TYPE::LIGAMENT_CONSTANT) {
       (*m_ligaments)[i] =
           std::make_shared<internal_forces::ligaments::LigamentConstant>(
-              (*other.m_ligaments)[i]);
-      return;
+              static_cast<
+                  const internal_forces::ligaments::LigamentConstant&>(
+                  ligament)
+                  .DeepCopy());
     } else if (
-        (*other.m_ligaments)[i]->type() ==
+        ligament.type() ==
         internal_forces::ligaments::LIGAMENT_TYPE::LIGAMENT_SPRING_LINEAR) {
       (*m_ligaments)[i] =
           std::make_shared<internal_forces::ligaments::LigamentSpringLinear>(
-              (*other.m_ligaments)[i]);
-      return;
+              static_cast<
+                  const internal_forces::ligaments::LigamentSpringLinear&>(
+                  ligament)
+                  .DeepCopy());
     } else if (
-        (*other.m_ligaments)[i]->type() ==
+        ligament.type() ==
         internal_forces::ligaments::LIGAMENT_TYPE::
             LIGAMENT_SPRING_SECOND_ORDER) {
       (*m_ligaments)[i] = std::make_shared<
           internal_forces::ligaments::LigamentSpringSecondOrder>(
-          (*other.m_ligaments)[i]);
-      return;
+          static_cast<
+              const internal_forces::ligaments::LigamentSpringSecondOrder&>(
+              ligament)
+              .DeepCopy());
     }
   }
-  *m_ligaments = *other.m_ligaments;
+  if (other.m_ligamentSet) {
+    compileLigaments();
+  } else {
+    m_ligamentSet = nullptr;
+    m_ligamentPaths = nullptr;
+  }
 }
 
 internal_forces::ligaments::Ligament&
@@ -100,6 +119,11 @@ void internal_forces::ligaments::Ligaments::addLigament(
   } else {
     utils::Error::raise("Ligament type not found");
   }
+
+  // The compiled set must include the new ligament
+  if (m_ligamentSet) {
+    compileLigaments();
+  }
   return;
 }
 
@@ -112,15 +136,50 @@ internal_forces::ligaments::Ligaments::ligamentNames() const {
   return names;
 }
 
+void internal_forces::ligaments::Ligaments::compileLigaments() {
+  m_ligamentSet =
+      std::make_shared<internal_forces::ligaments::LigamentSet>(*m_ligaments);
+
+  // The point table needs the model, it is filled at the next update
+  m_ligamentPaths = std::make_shared<internal_forces::PathKinematics>();
+}
+
+bool internal_forces::ligaments::Ligaments::isLigamentsCompiled() const {
+  return m_ligamentSet != nullptr;
+}
+
 // From ligament Force
 rigidbody::GeneralizedTorque
 internal_forces::ligaments::Ligaments::ligamentsJointTorque(
     const utils::Vector& F) {
+  utils::Vector tau;
+  ligamentsJointTorque(F, tau);
+  return rigidbody::GeneralizedTorque(tau);
+}
+
+void internal_forces::ligaments::Ligaments::ligamentsJointTorque(
+    const utils::Vector& F,
+    utils::Vector& tau) {
+  // The point table only visits the DoFs spanned by each ligament
+  if (isLigamentPathsFilled()) {
+    size_t nbDof(
+        static_cast<size_t>(m_ligamentPaths->lengthJacobian().cols()));
+    if (static_cast<size_t>(tau.rows()) != nbDof) {
+      tau = utils::Vector(nbDof);
+    }
+    m_ligamentPaths->jointTorque(F, tau);
+    return;
+  }
+
   // Get the Jacobian matrix and get the forces of each muscle
   const utils::Matrix& jaco(ligamentsLengthJacobian());
 
   // Compute the reaction of the forces on the bodies
-  return rigidbody::GeneralizedTorque(-jaco.transpose() * F);
+#ifdef BIORBD_USE_CASADI_MATH
+  tau = -jaco.transpose() * F;
+#else
+  tau.noalias() = -(jaco.transpose() * F);
+#endif
 }
 
 // From ligament Force and kinematics
@@ -202,6 +261,13 @@ utils::Vector internal_forces::ligaments::Ligaments::ligamentForces(
     rigidbody::Joints& updatedModel,
     const rigidbody::GeneralizedCoordinates& Q,
     bool updateLigamentKinematics) {
+  if (m_ligamentSet) {
+    if (updateLigamentKinematics) updateLigaments(updatedModel, Q);
+    utils::Vector forces(nbLigaments());
+    compiledLigamentForces(forces);
+    return forces;
+  }
+
   // Output variable
   utils::Vector forces(nbLigaments());
   for (size_t j = 0; j < nbLigaments(); ++j) {
@@ -243,13 +309,31 @@ utils::Vector internal_forces::ligaments::Ligaments::ligamentForces(
     bool updateLigamentKinematics) {
   // Output variable
   utils::Vector forces(nbLigaments());
+  ligamentForces(updatedModel, Q, Qdot, forces, updateLigamentKinematics);
+
+  // The forces
+  return forces;
+}
+
+void internal_forces::ligaments::Ligaments::ligamentForces(
+    rigidbody::Joints& updatedModel,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    utils::Vector& forces,
+    bool updateLigamentKinematics) {
+  if (static_cast<size_t>(forces.rows()) != nbLigaments()) {
+    forces = utils::Vector(nbLigaments());
+  }
+  if (m_ligamentSet) {
+    if (updateLigamentKinematics) updateLigaments(updatedModel, Q, Qdot);
+    compiledLigamentForces(forces);
+    return;
+  }
+
   for (size_t j = 0; j < nbLigaments(); ++j) {
     forces(static_cast<unsigned int>(j)) = ((*m_ligaments)[j]->force(
         updatedModel, Q, Qdot, updateLigamentKinematics));
   }
-
-  // The forces
-  return forces;
 }
 
 utils::Vector internal_forces::ligaments::Ligaments::ligamentForces(
@@ -277,6 +361,11 @@ utils::Vector internal_forces::ligaments::Ligaments::ligamentForces(
 
 utils::Matrix internal_forces::ligaments::Ligaments::ligamentsLengthJacobian()
     const {
+  // The point table already assembled the matrix
+  if (isLigamentPathsFilled()) {
+    return m_ligamentPaths->lengthJacobian();
+  }
+
   const rigidbody::Joints& model =
       dynamic_cast<const rigidbody::Joints&>(*this);
 
@@ -299,7 +388,7 @@ utils::Matrix internal_forces::ligaments::Ligaments::ligamentsLengthJacobian(
     bool updateLigamentKinematics) {
   // Update the ligament position
   if (updateLigamentKinematics) updateLigaments(updatedModel, Q);
-  return ligamentsLengthJacobian(updatedModel);
+  return ligamentsLengthJacobian();
 }
 
 utils::Matrix internal_forces::ligaments::Ligaments::ligamentsLengthJacobian(
@@ -352,6 +441,11 @@ void internal_forces::ligaments::Ligaments::updateLigaments(
     rigidbody::Joints& updatedModel,
     const rigidbody::GeneralizedCoordinates& Q,
     const rigidbody::GeneralizedVelocity& Qdot) {
+  if (m_ligamentPaths) {
+    updateLigamentPaths(updatedModel, Q, &Qdot);
+    return;
+  }
+
   for (size_t j = 0; j < nbLigaments(); ++j) {
     ligament(j).updateOrientations(updatedModel, Q, Qdot);
   }
@@ -375,6 +469,11 @@ void internal_forces::ligaments::Ligaments::updateLigaments(
 void internal_forces::ligaments::Ligaments::updateLigaments(
     rigidbody::Joints& updatedModel,
     const rigidbody::GeneralizedCoordinates& Q) {
+  if (m_ligamentPaths) {
+    updateLigamentPaths(updatedModel, Q, nullptr);
+    return;
+  }
+
   for (size_t j = 0; j < nbLigaments(); ++j) {
     ligament(j).updateOrientations(updatedModel, Q);
   }
@@ -403,6 +502,11 @@ void internal_forces::ligaments::Ligaments::updateLigaments(
     ligament(j).updateOrientations(
         ligamentPointsInGlobal[j], jacoPointsInGlobal[j], Qdot);
   }
+
+  // The point table is now outdated
+  if (m_ligamentPaths) {
+    m_ligamentPaths->clear();
+  }
 }
 
 void internal_forces::ligaments::Ligaments::updateLigaments(
@@ -412,4 +516,83 @@ void internal_forces::ligaments::Ligaments::updateLigaments(
     ligament(j).updateOrientations(
         ligamentPointsInGlobal[j], jacoPointsInGlobal[j]);
   }
+
+  // The point table is now outdated
+  if (m_ligamentPaths) {
+    m_ligamentPaths->clear();
+  }
+}
+
+bool internal_forces::ligaments::Ligaments::isLigamentPathsFilled() const {
+  return m_ligamentPaths && m_ligamentPaths->nbPaths() != 0 &&
+         m_ligamentPaths->nbPaths() == nbLigaments();
+}
+
+void internal_forces::ligaments::Ligaments::updateLigamentPaths(
+    rigidbody::Joints& updatedModel,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity* Qdot) {
+  internal_forces::PathKinematics& paths(*m_ligamentPaths);
+
+  // Build the point table at the first update
+  if (!isLigamentPathsFilled()) {
+    paths.clear();
+    for (size_t j = 0; j < nbLigaments(); ++j) {
+      internal_forces::ligaments::Ligament& lig(ligament(j));
+      paths.addPath(
+          updatedModel,
+          lig.position().originInLocal(),
+          lig.position().insertionInLocal(),
+          lig.pathModifier());
+    }
+  }
+
+  // Positions and Jacobians of all the points in one sweep
+  paths.update(updatedModel, Q);
+
+  for (size_t j = 0; j < nbLigaments(); ++j) {
+    internal_forces::ligaments::Ligament& lig(ligament(j));
+    if (paths.isBatched(j)) {
+      // The length and its jacobian are read from the table
+      if (Qdot) {
+        lig.updateOrientations(
+            paths.pointsInGlobal(j),
+            paths.pointsJacobian(j),
+            paths.lengths(),
+            paths.lengthJacobian(),
+            j,
+            *Qdot);
+      } else {
+        lig.updateOrientations(
+            paths.pointsInGlobal(j),
+            paths.pointsJacobian(j),
+            paths.lengths(),
+            paths.lengthJacobian(),
+            j);
+      }
+    } else {
+      // Wrapping ligaments are computed on their own
+      if (Qdot) {
+        lig.updateOrientations(updatedModel, Q, *Qdot);
+      } else {
+        lig.updateOrientations(updatedModel, Q);
+      }
+      paths.lengthJacobian().block(
+          static_cast<unsigned int>(j),
+          0,
+          1,
+          static_cast<unsigned int>(updatedModel.dof_count)) =
+          lig.position().jacobianLength();
+    }
+  }
+}
+
+void internal_forces::ligaments::Ligaments::compiledLigamentForces(
+    utils::Vector& forces) {
+  // Ligaments may have been added since the last compilation
+  if (m_ligamentSet->nbLigaments() != nbLigaments()) {
+    compileLigaments();
+  }
+  m_ligamentSet->updateKinematics();
+  m_ligamentSet->computeForces(forces);
 }
\ No newline at end of file
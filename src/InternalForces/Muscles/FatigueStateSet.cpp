@@ -0,0 +1,217 @@
+#define BIORBD_API_EXPORTS
+#include "InternalForces/Muscles/FatigueStateSet.h"
+
+#ifndef BIORBD_USE_CASADI_MATH
+#include "InternalForces/Muscles/Characteristics.h"
+#include "InternalForces/Muscles/FatigueModel.h"
+#include "InternalForces/Muscles/FatigueParameters.h"
+#include "InternalForces/Muscles/FatigueState.h"
+#include "InternalForces/Muscles/Muscle.h"
+#include "Utils/Error.h"
+
+using namespace BIORBD_NAMESPACE;
+
+internal_forces::muscles::FatigueStateSet::FatigueStateSet() {}
+
+internal_forces::muscles::FatigueStateSet::FatigueStateSet(
+    const std::vector<std::shared_ptr<internal_forces::muscles::Muscle>>&
+        muscles) {
+  compile(muscles);
+}
+
+internal_forces::muscles::FatigueStateSet::~FatigueStateSet() {}
+
+void internal_forces::muscles::FatigueStateSet::compile(
+    const std::vector<std::shared_ptr<internal_forces::muscles::Muscle>>&
+        muscles) {
+  size_t nbMus(muscles.size());
+  m_muscles = muscles;
+  m_xia.clear();
+  m_fatigueModel.clear();
+
+  // The muscles without a Xia fatigue state have null rates and never move
+  m_fatigueRate = utils::Vector::Zero(nbMus);
+  m_recoveryRate = utils::Vector::Zero(nbMus);
+  m_developFactor = utils::Vector::Zero(nbMus);
+  m_recoveryFactor = utils::Vector::Zero(nbMus);
+  m_states = utils::Matrix::Zero(3, static_cast<unsigned int>(nbMus));
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    m_states(0, i) = 1;
+  }
+
+  for (size_t i = 0; i < nbMus; ++i) {
+    std::shared_ptr<internal_forces::muscles::FatigueModel> fatigueModel(
+        std::dynamic_pointer_cast<internal_forces::muscles::FatigueModel>(
+            muscles[i]));
+    if (!fatigueModel ||
+        fatigueModel->fatigueState().getType() !=
+            internal_forces::muscles::STATE_FATIGUE_TYPE::DYNAMIC_XIA) {
+      continue;
+    }
+    const internal_forces::muscles::FatigueParameters& parameters(
+        muscles[i]->characteristics().fatigueParameters());
+    unsigned int idx(static_cast<unsigned int>(i));
+
+    m_xia.push_back(i);
+    m_fatigueModel.push_back(fatigueModel);
+    m_fatigueRate(idx) = parameters.fatigueRate();
+    m_recoveryRate(idx) = parameters.recoveryRate();
+    m_developFactor(idx) = parameters.developFactor();
+    m_recoveryFactor(idx) = parameters.recoveryFactor();
+  }
+  gatherStates();
+}
+
+size_t internal_forces::muscles::FatigueStateSet::nbMuscles() const {
+  return m_muscles.size();
+}
+
+const std::vector<size_t>& internal_forces::muscles::FatigueStateSet::indices()
+    const {
+  return m_xia;
+}
+
+utils::Matrix& internal_forces::muscles::FatigueStateSet::states() {
+  return m_states;
+}
+
+const utils::Matrix& internal_forces::muscles::FatigueStateSet::states()
+    const {
+  return m_states;
+}
+
+void internal_forces::muscles::FatigueStateSet::gatherStates() {
+  for (size_t k = 0; k < m_xia.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_xia[k]));
+    const internal_forces::muscles::FatigueState& state(
+        m_fatigueModel[k]->fatigueState());
+    m_states(0, i) = state.activeFibers();
+    m_states(1, i) = state.fatiguedFibers();
+    m_states(2, i) = state.restingFibers();
+  }
+}
+
+void internal_forces::muscles::FatigueStateSet::scatterStates() const {
+  for (size_t k = 0; k < m_xia.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_xia[k]));
+    m_fatigueModel[k]->setFatigueState(
+        m_states(0, i), m_states(1, i), m_states(2, i));
+  }
+}
+
+void internal_forces::muscles::FatigueStateSet::timeDerivativeState(
+    const utils::Vector& targetActivations,
+    utils::Matrix& statesDot) const {
+  timeDerivativeState(targetActivations, m_states, statesDot);
+}
+
+void internal_forces::muscles::FatigueStateSet::timeDerivativeState(
+    const utils::Vector& targetActivations,
+    const utils::Matrix& states,
+    utils::Matrix& statesDot) const {
+  utils::Error::check(
+      static_cast<size_t>(targetActivations.size()) == nbMuscles() &&
+          states.rows() == 3 &&
+          static_cast<size_t>(states.cols()) == nbMuscles(),
+      "The target activations must be of size nbMuscles and the states of "
+      "size 3 x nbMuscles");
+  statesDot = utils::Matrix::Zero(3, states.cols());
+
+  // Same command as FatigueDynamicStateXia::timeDerivativeState
+  for (size_t k = 0; k < m_xia.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_xia[k]));
+    double target(targetActivations(i));
+    double active(states(0, i));
+    double fatigued(states(1, i));
+    double resting(states(2, i));
+
+    double command;
+    if (active < target) {
+      command = resting > target - active
+                    ? m_developFactor(i) * (target - active)
+                    : m_developFactor(i) * resting;
+    } else {
+      command = m_recoveryFactor(i) * (target - active);
+    }
+    double fatiguing(m_fatigueRate(i) * active);
+    double recovering(m_recoveryRate(i) * fatigued);
+    statesDot(0, i) = command - fatiguing;
+    statesDot(1, i) = fatiguing - recovering;
+    statesDot(2, i) = -command + recovering;
+  }
+}
+
+void internal_forces::muscles::FatigueStateSet::integrate(
+    const utils::Vector& targetActivations,
+    double timeStep,
+    size_t nbSteps) {
+  utils::Error::check(
+      static_cast<size_t>(targetActivations.size()) == nbMuscles(),
+      "The target activations must be of size nbMuscles");
+  utils::Error::check(timeStep > 0, "The time step must be positive");
+  for (size_t s = 0; s < nbSteps; ++s) {
+    integrateStep(targetActivations, timeStep);
+  }
+}
+
+void internal_forces::muscles::FatigueStateSet::integrate(
+    const utils::Matrix& targetActivations,
+    double timeStep,
+    utils::Matrix* activeFibers) {
+  utils::Error::check(
+      static_cast<size_t>(targetActivations.rows()) == nbMuscles(),
+      "The target activations must have nbMuscles rows");
+  utils::Error::check(timeStep > 0, "The time step must be positive");
+  if (activeFibers) {
+    *activeFibers =
+        utils::Matrix(targetActivations.rows(), targetActivations.cols());
+  }
+  for (unsigned int s = 0; s < targetActivations.cols(); ++s) {
+    integrateStep(utils::Vector(targetActivations.col(s)), timeStep);
+    if (activeFibers) {
+      activeFibers->col(s) = m_states.row(0).transpose();
+    }
+  }
+}
+
+void internal_forces::muscles::FatigueStateSet::integrateStep(
+    const utils::Vector& targetActivations,
+    double timeStep) {
+  // On each branch of the command the dynamics is linear. The resting fibers
+  // are replaced by the total minus the others, so the backward Euler step
+  // reduces to a 2 x 2 system in the active (a) and fatigued (f) fibers:
+  //   f = (f0 + h * F * a) / (1 + h * R)
+  // with F the fatigue rate and R the recovery rate
+  double h(timeStep);
+  for (size_t k = 0; k < m_xia.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_xia[k]));
+    double target(targetActivations(i));
+    double active(m_states(0, i));
+    double fatigued(m_states(1, i));
+    double resting(m_states(2, i));
+    double total(active + fatigued + resting);
+    double fatigueRate(m_fatigueRate(i));
+    double recovery(1 + h * m_recoveryRate(i));
+
+    if (active < target && resting <= target - active) {
+      // Recruitment limited by the resting fibers: command = LD * r
+      double develop(m_developFactor(i));
+      active = ((active + h * develop * total) * recovery -
+                h * develop * fatigued) /
+               ((1 + h * (develop + fatigueRate)) * recovery +
+                h * h * develop * fatigueRate);
+    } else {
+      // Command toward the target: command = L * (target - a)
+      double factor(
+          active < target ? m_developFactor(i) : m_recoveryFactor(i));
+      active = (active + h * factor * target) /
+               (1 + h * (factor + fatigueRate));
+    }
+    fatigued = (fatigued + h * fatigueRate * active) / recovery;
+
+    m_states(0, i) = active;
+    m_states(1, i) = fatigued;
+    m_states(2, i) = total - active - fatigued;
+  }
+}
+#endif
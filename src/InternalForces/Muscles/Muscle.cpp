@@ -108,10 +108,6 @@ internal_forces::muscles::Muscle::Muscle(
           std::make_shared<internal_forces::muscles::Characteristics>(c)),
       m_state(std::make_shared<internal_forces::muscles::State>()) {
   setState(emg);
-
-  utils::Error::check(
-      pathModifiers.nbWraps() <= 1,
-      "Multiple wrapping objects is not implemented yet");
 }
 
 internal_forces::muscles::Muscle::~Muscle() {
@@ -166,6 +162,65 @@ void internal_forces::muscles::Muscle::updateOrientations(
   m_position->updateKinematics(
       musclePointsInGlobal, jacoPointsInGlobal, *m_characteristics, &Qdot);
 }
+void internal_forces::muscles::Muscle::updateOrientations(
+    const utils::Scalar &musculoTendonLength,
+    const utils::Matrix &jacobianLength) {
+  m_position->updateKinematics(
+      musculoTendonLength, jacobianLength, *m_characteristics, nullptr);
+}
+void internal_forces::muscles::Muscle::updateOrientations(
+    const utils::Scalar &musculoTendonLength,
+    const utils::Matrix &jacobianLength,
+    const rigidbody::GeneralizedVelocity &Qdot) {
+  m_position->updateKinematics(
+      musculoTendonLength, jacobianLength, *m_characteristics, &Qdot);
+}
+void internal_forces::muscles::Muscle::updateOrientations(
+    const utils::Vector &lengths,
+    const utils::Matrix &lengthJacobian,
+    size_t idx) {
+  m_position->updateKinematics(
+      lengths, lengthJacobian, idx, *m_characteristics, nullptr);
+}
+void internal_forces::muscles::Muscle::updateOrientations(
+    const utils::Vector &lengths,
+    const utils::Matrix &lengthJacobian,
+    size_t idx,
+    const rigidbody::GeneralizedVelocity &Qdot) {
+  m_position->updateKinematics(
+      lengths, lengthJacobian, idx, *m_characteristics, &Qdot);
+}
+void internal_forces::muscles::Muscle::updateOrientations(
+    std::vector<utils::Vector3d> &musclePointsInGlobal,
+    utils::Matrix &jacoPointsInGlobal,
+    const utils::Vector &lengths,
+    const utils::Matrix &lengthJacobian,
+    size_t idx) {
+  m_position->updateKinematics(
+      musclePointsInGlobal,
+      jacoPointsInGlobal,
+      lengths,
+      lengthJacobian,
+      idx,
+      *m_characteristics,
+      nullptr);
+}
+void internal_forces::muscles::Muscle::updateOrientations(
+    std::vector<utils::Vector3d> &musclePointsInGlobal,
+    utils::Matrix &jacoPointsInGlobal,
+    const utils::Vector &lengths,
+    const utils::Matrix &lengthJacobian,
+    size_t idx,
+    const rigidbody::GeneralizedVelocity &Qdot) {
+  m_position->updateKinematics(
+      musclePointsInGlobal,
+      jacoPointsInGlobal,
+      lengths,
+      lengthJacobian,
+      idx,
+      *m_characteristics,
+      &Qdot);
+}
 
 void internal_forces::muscles::Muscle::setPosition(
     const internal_forces::muscles::MuscleGeometry &positions) {
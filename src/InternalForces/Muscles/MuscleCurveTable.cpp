@@ -0,0 +1,136 @@
+#define BIORBD_API_EXPORTS
+#include "InternalForces/Muscles/MuscleCurveTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Utils/Error.h"
+
+using namespace BIORBD_NAMESPACE;
+
+// Number of points checked against the analytic curve inside each interval
+static const size_t nbValidationPoints(7);
+
+internal_forces::muscles::MuscleCurveTable::MuscleCurveTable()
+    : m_xMin(0),
+      m_xMax(0),
+      m_step(0),
+      m_nbIntervals(0),
+      m_maxError(0),
+      m_maxDerivativeError(0) {}
+
+internal_forces::muscles::MuscleCurveTable::MuscleCurveTable(
+    const Curve& curve,
+    double xMin,
+    double xMax,
+    size_t nbIntervals)
+    : m_curve(curve),
+      m_xMin(xMin),
+      m_xMax(xMax),
+      m_step((xMax - xMin) / static_cast<double>(nbIntervals)),
+      m_nbIntervals(nbIntervals),
+      m_coefficients(4 * nbIntervals),
+      m_maxError(0),
+      m_maxDerivativeError(0) {
+  utils::Error::check(
+      nbIntervals > 0, "The table must have at least one interval");
+  utils::Error::check(xMax > xMin, "The bounds of the table are inverted");
+
+  // Values and one-sided derivatives at the nodes
+  std::vector<double> values(nbIntervals + 1);
+  std::vector<double> left(nbIntervals + 1);
+  std::vector<double> right(nbIntervals + 1);
+  for (size_t i = 0; i <= nbIntervals; ++i) {
+    m_curve(
+        m_xMin + static_cast<double>(i) * m_step, values[i], left[i], right[i]);
+  }
+
+  // Hermite cubic of each interval: c0 + c1 s + c2 s^2 + c3 s^3
+  for (size_t i = 0; i < nbIntervals; ++i) {
+    double m0(m_step * right[i]);
+    double m1(m_step * left[i + 1]);
+    double dy(values[i + 1] - values[i]);
+    m_coefficients[4 * i] = values[i];
+    m_coefficients[4 * i + 1] = m0;
+    m_coefficients[4 * i + 2] = 3 * dy - 2 * m0 - m1;
+    m_coefficients[4 * i + 3] = -2 * dy + m0 + m1;
+  }
+
+  // Measure the accuracy inside the intervals, where the curve is smooth
+  for (size_t i = 0; i < nbIntervals; ++i) {
+    for (size_t k = 1; k <= nbValidationPoints; ++k) {
+      double x(
+          m_xMin +
+          (static_cast<double>(i) +
+           static_cast<double>(k) / (nbValidationPoints + 1)) *
+              m_step);
+      double exact, exactDerivative, unused;
+      m_curve(x, exact, exactDerivative, unused);
+      double derivative;
+      double interpolated(value(x, derivative));
+      m_maxError = std::max(m_maxError, std::fabs(interpolated - exact));
+      m_maxDerivativeError = std::max(
+          m_maxDerivativeError, std::fabs(derivative - exactDerivative));
+    }
+  }
+}
+
+internal_forces::muscles::MuscleCurveTable::~MuscleCurveTable() {}
+
+double internal_forces::muscles::MuscleCurveTable::xMin() const {
+  return m_xMin;
+}
+
+double internal_forces::muscles::MuscleCurveTable::xMax() const {
+  return m_xMax;
+}
+
+size_t internal_forces::muscles::MuscleCurveTable::nbIntervals() const {
+  return m_nbIntervals;
+}
+
+double internal_forces::muscles::MuscleCurveTable::maxError() const {
+  return m_maxError;
+}
+
+double internal_forces::muscles::MuscleCurveTable::maxDerivativeError()
+    const {
+  return m_maxDerivativeError;
+}
+
+double internal_forces::muscles::MuscleCurveTable::value(double x) const {
+  if (x < m_xMin || x > m_xMax) {
+    double value, left, right;
+    m_curve(x, value, left, right);
+    return value;
+  }
+  double s;
+  const double* c(&m_coefficients[4 * interval(x, s)]);
+  return c[0] + s * (c[1] + s * (c[2] + s * c[3]));
+}
+
+double internal_forces::muscles::MuscleCurveTable::value(
+    double x,
+    double& derivative) const {
+  if (x < m_xMin || x > m_xMax) {
+    double value, right;
+    m_curve(x, value, derivative, right);
+    return value;
+  }
+  double s;
+  const double* c(&m_coefficients[4 * interval(x, s)]);
+  derivative = (c[1] + s * (2 * c[2] + 3 * s * c[3])) / m_step;
+  return c[0] + s * (c[1] + s * (c[2] + s * c[3]));
+}
+
+size_t internal_forces::muscles::MuscleCurveTable::interval(
+    double x,
+    double& s) const {
+  double t((x - m_xMin) / m_step);
+  size_t idx(static_cast<size_t>(t));
+  if (idx >= m_nbIntervals) {
+    idx = m_nbIntervals - 1;
+  }
+  s = t - static_cast<double>(idx);
+  return idx;
+}
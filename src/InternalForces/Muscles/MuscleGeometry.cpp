@@ -82,7 +82,7 @@ void internal_forces::muscles::MuscleGeometry::updateKinematics(
   jacobian(updatedModel, *Q);
 
   // Complete the update
-  _updateKinematics(Qdot, &characteristics, &pathModifiers);
+  _updateKinematics(Qdot, &characteristics, &pathModifiers, &updatedModel, Q);
 }
 
 void internal_forces::muscles::MuscleGeometry::updateKinematics(
@@ -102,6 +102,57 @@ void internal_forces::muscles::MuscleGeometry::updateKinematics(
   _updateKinematics(Qdot, &characteristics);
 }
 
+void internal_forces::muscles::MuscleGeometry::updateKinematics(
+    const utils::Scalar& musculoTendonLength,
+    const utils::Matrix& jacobianLength,
+    const internal_forces::muscles::Characteristics& characteristics,
+    const rigidbody::GeneralizedVelocity* Qdot) {
+  *m_posAndJacoWereForced = true;
+
+  // Length and its jacobian
+  *m_muscleTendonLength = musculoTendonLength;
+  *m_jacobianLength = jacobianLength;
+  _updateKinematicsFromLength(characteristics, Qdot);
+}
+
+void internal_forces::muscles::MuscleGeometry::updateKinematics(
+    const utils::Vector& lengths,
+    const utils::Matrix& lengthJacobian,
+    size_t idx,
+    const internal_forces::muscles::Characteristics& characteristics,
+    const rigidbody::GeneralizedVelocity* Qdot) {
+  *m_posAndJacoWereForced = true;
+
+  // Length and its jacobian, read from the row
+  unsigned int row(static_cast<unsigned int>(idx));
+  *m_muscleTendonLength = lengths(row);
+  *m_jacobianLength = lengthJacobian.block(
+      row, 0, 1, static_cast<unsigned int>(lengthJacobian.cols()));
+  _updateKinematicsFromLength(characteristics, Qdot);
+}
+
+void internal_forces::muscles::MuscleGeometry::updateKinematics(
+    std::vector<utils::Vector3d>& pointsInGlobal,
+    utils::Matrix& jacoPointsInGlobal,
+    const utils::Vector& lengths,
+    const utils::Matrix& lengthJacobian,
+    size_t idx,
+    const internal_forces::muscles::Characteristics& characteristics,
+    const rigidbody::GeneralizedVelocity* Qdot) {
+  *m_posAndJacoWereForced = true;
+
+  // Position of the points in space and their Jacobian
+  setPointsInGlobal(pointsInGlobal);
+  jacobian(jacoPointsInGlobal);
+
+  // Length and its jacobian, read from the row of the table
+  unsigned int row(static_cast<unsigned int>(idx));
+  *m_muscleTendonLength = lengths(row);
+  *m_jacobianLength = lengthJacobian.block(
+      row, 0, 1, static_cast<unsigned int>(lengthJacobian.cols()));
+  _updateKinematicsFromLength(characteristics, Qdot);
+}
+
 const utils::Scalar& internal_forces::muscles::MuscleGeometry::length() const {
   utils::Error::check(
       *m_isGeometryComputed,
@@ -122,13 +173,20 @@ internal_forces::muscles::MuscleGeometry::musculoTendonLength() const {
 void internal_forces::muscles::MuscleGeometry::_updateKinematics(
     const rigidbody::GeneralizedVelocity* Qdot,
     const internal_forces::muscles::Characteristics* characteristics,
-    internal_forces::PathModifiers* pathModifiers) {
+    internal_forces::PathModifiers* pathModifiers,
+    rigidbody::Joints* updatedModel,
+    const rigidbody::GeneralizedCoordinates* Q) {
   // Compute the length and velocities
   length(characteristics, pathModifiers);
   *m_isGeometryComputed = true;
 
   // Compute the jacobian of the lengths
-  computeJacobianLength();
+  if (updatedModel != nullptr && pathModifiers != nullptr &&
+      pathModifiers->nbWraps() != 0) {
+    computeJacobianLength(*updatedModel, *Q, *pathModifiers);
+  } else {
+    computeJacobianLength();
+  }
   if (Qdot != nullptr) {
     velocity(*Qdot);
     *m_isVelocityComputed = true;
@@ -137,39 +195,26 @@ void internal_forces::muscles::MuscleGeometry::_updateKinematics(
   }
 }
 
-const utils::Scalar& internal_forces::muscles::MuscleGeometry::length(
-    const internal_forces::muscles::Characteristics* characteristics,
-    internal_forces::PathModifiers* pathModifiers) {
-  *m_muscleTendonLength = 0;
-
-  // because we can't combine, test the first (0) will let us know all the types
-  // if more than one
-  if (pathModifiers != nullptr && pathModifiers->nbWraps() != 0) {
-    utils::Error::check(
-        pathModifiers->nbVia() == 0, "Cannot mix wrapping and via points yet");
-    utils::Error::check(
-        pathModifiers->nbWraps() < 2,
-        "Cannot compute more than one wrapping yet");
-
-    utils::Vector3d pi_wrap(
-        0, 0, 0);  // point on the wrapping related to insertion
-    utils::Vector3d po_wrap(
-        0, 0, 0);  // point on the wrapping related to origin
-    utils::Scalar lengthWrap(0);
-    static_cast<internal_forces::WrappingObject&>(pathModifiers->object(0))
-        .wrapPoints(po_wrap, pi_wrap, &lengthWrap);
-
-    *m_muscleTendonLength =
-        ((*m_pointsInGlobal)[0] - po_wrap).norm() +  // length before the wrap
-        lengthWrap +                                 // length on the wrap
-        ((*m_pointsInGlobal)[3] - pi_wrap).norm();   // length after the wrap
+void internal_forces::muscles::MuscleGeometry::_updateKinematicsFromLength(
+    const internal_forces::muscles::Characteristics& characteristics,
+    const rigidbody::GeneralizedVelocity* Qdot) {
+  *m_muscleLength =
+      (*m_muscleTendonLength - characteristics.tendonSlackLength()) /
+      std::cos(characteristics.pennationAngle());
+  *m_isGeometryComputed = true;
 
+  if (Qdot != nullptr) {
+    velocity(*Qdot);
+    *m_isVelocityComputed = true;
   } else {
-    for (size_t i = 0; i < m_pointsInGlobal->size() - 1; ++i) {
-      *m_muscleTendonLength +=
-          ((*m_pointsInGlobal)[i + 1] - (*m_pointsInGlobal)[i]).norm();
-    }
+    *m_isVelocityComputed = false;
   }
+}
+
+const utils::Scalar& internal_forces::muscles::MuscleGeometry::length(
+    const internal_forces::muscles::Characteristics* characteristics,
+    internal_forces::PathModifiers* pathModifiers) {
+  *m_muscleTendonLength = pathLength(pathModifiers);
   *m_muscleLength =
       (*m_muscleTendonLength - characteristics->tendonSlackLength()) /
       std::cos(characteristics->pennationAngle());
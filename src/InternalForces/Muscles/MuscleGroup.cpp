@@ -14,6 +14,13 @@
 #include "Utils/Error.h"
 
 using namespace BIORBD_NAMESPACE;
+
+// Deep copy of a muscle of a given type
+template <typename T>
+static std::shared_ptr<internal_forces::muscles::Muscle> deepCopyOf(
+    const internal_forces::muscles::Muscle &muscle) {
+  return std::make_shared<T>(static_cast<const T &>(muscle).DeepCopy());
+}
 internal_forces::muscles::MuscleGroup::MuscleGroup()
     : m_mus(
           std::make_shared<std::vector<
@@ -53,61 +60,47 @@ void internal_forces::muscles::MuscleGroup::DeepCopy(
     const internal_forces::muscles::MuscleGroup &other) {
   m_mus->resize(other.m_mus->size());
   for (size_t i = 0; i < other.m_mus->size(); ++i) {
-    if ((*other.m_mus)[i]->type() ==
-        internal_forces::muscles::MUSCLE_TYPE::IDEALIZED_ACTUATOR) {
-      (*m_mus)[i] =
-          std::make_shared<internal_forces::muscles::IdealizedActuator>(
-              (*other.m_mus)[i]);
-    } else if (
-        (*other.m_mus)[i]->type() ==
-        internal_forces::muscles::MUSCLE_TYPE::HILL) {
-      (*m_mus)[i] = std::make_shared<internal_forces::muscles::HillType>(
-          (*other.m_mus)[i]);
-    } else if (
-        (*other.m_mus)[i]->type() ==
-        internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN) {
-      (*m_mus)[i] = std::make_shared<internal_forces::muscles::HillThelenType>(
-          (*other.m_mus)[i]);
-    } else if (
-        (*other.m_mus)[i]->type() ==
-        internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE) {
-      (*m_mus)[i] =
-          std::make_shared<internal_forces::muscles::HillDeGrooteType>(
-              (*other.m_mus)[i]);
-    } else if (
-        (*other.m_mus)[i]->type() ==
-        internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN_ACTIVE) {
-      (*m_mus)[i] =
-          std::make_shared<internal_forces::muscles::HillThelenActiveOnlyType>(
-              (*other.m_mus)[i]);
-    } else if (
-        (*other.m_mus)[i]->type() ==
-        internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN_FATIGABLE) {
-      (*m_mus)[i] =
-          std::make_shared<internal_forces::muscles::HillThelenTypeFatigable>(
-              (*other.m_mus)[i]);
-    } else if (
-        (*other.m_mus)[i]->type() ==
-        internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE_ACTIVE) {
-      (*m_mus)[i] = std::make_shared<
-          internal_forces::muscles::HillDeGrooteActiveOnlyType>(
-          (*other.m_mus)[i]);
-    } else if (
-        (*other.m_mus)[i]->type() ==
-        internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE_FATIGABLE) {
-      (*m_mus)[i] =
-          std::make_shared<internal_forces::muscles::HillDeGrooteTypeFatigable>(
-              (*other.m_mus)[i]);
-    } else {
-      utils::Error::raise(
-          "DeepCopy was not prepared to copy " +
-          utils::String(
-              internal_forces::muscles::MUSCLE_TYPE_toStr(
-                  (*other.m_mus)[i]->type())) +
-          " type");
+    const internal_forces::muscles::Muscle &muscle(*(*other.m_mus)[i]);
+    switch (muscle.type()) {
+      case internal_forces::muscles::MUSCLE_TYPE::IDEALIZED_ACTUATOR:
+        (*m_mus)[i] =
+            deepCopyOf<internal_forces::muscles::IdealizedActuator>(muscle);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL:
+        (*m_mus)[i] = deepCopyOf<internal_forces::muscles::HillType>(muscle);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN:
+        (*m_mus)[i] =
+            deepCopyOf<internal_forces::muscles::HillThelenType>(muscle);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE:
+        (*m_mus)[i] =
+            deepCopyOf<internal_forces::muscles::HillDeGrooteType>(muscle);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN_ACTIVE:
+        (*m_mus)[i] = deepCopyOf<
+            internal_forces::muscles::HillThelenActiveOnlyType>(muscle);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN_FATIGABLE:
+        (*m_mus)[i] = deepCopyOf<
+            internal_forces::muscles::HillThelenTypeFatigable>(muscle);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE_ACTIVE:
+        (*m_mus)[i] = deepCopyOf<
+            internal_forces::muscles::HillDeGrooteActiveOnlyType>(muscle);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE_FATIGABLE:
+        (*m_mus)[i] = deepCopyOf<
+            internal_forces::muscles::HillDeGrooteTypeFatigable>(muscle);
+        break;
+      default:
+        utils::Error::raise(
+            "DeepCopy was not prepared to copy " +
+            utils::String(
+                internal_forces::muscles::MUSCLE_TYPE_toStr(muscle.type())) +
+            " type");
     }
   }
-  *m_mus = *other.m_mus;
   *m_name = *other.m_name;
   *m_originName = *other.m_originName;
   *m_insertName = *other.m_insertName;
@@ -0,0 +1,488 @@
+#define BIORBD_API_EXPORTS
+#include "InternalForces/Muscles/MuscleLengthSurrogate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#include "InternalForces/Muscles/Muscle.h"
+#include "InternalForces/Muscles/MuscleGeometry.h"
+#include "InternalForces/Muscles/Muscles.h"
+#include "RigidBody/GeneralizedCoordinates.h"
+#include "RigidBody/Joints.h"
+#include "RigidBody/Segment.h"
+#include "Utils/Error.h"
+#include "Utils/IfStream.h"
+#include "Utils/Path.h"
+#include "Utils/Range.h"
+
+using namespace BIORBD_NAMESPACE;
+
+// List the degrees of each coordinate of all the terms of total degree lower
+// or equal to remaining (coordinates from k to n)
+static void listExponents(
+    size_t n,
+    size_t k,
+    unsigned int remaining,
+    std::vector<unsigned int>& current,
+    std::vector<unsigned int>& exponents) {
+  if (k == n) {
+    exponents.insert(exponents.end(), current.begin(), current.end());
+    return;
+  }
+  for (unsigned int e = 0; e <= remaining; ++e) {
+    current[k] = e;
+    listExponents(n, k + 1, remaining - e, current, exponents);
+  }
+}
+
+internal_forces::muscles::MuscleLengthSurrogate::MuscleLengthSurrogate()
+    : m_nbDof(0), m_degree(0) {}
+
+internal_forces::muscles::MuscleLengthSurrogate::MuscleLengthSurrogate(
+    const utils::Path& path)
+    : m_nbDof(0), m_degree(0) {
+  read(path);
+}
+
+internal_forces::muscles::MuscleLengthSurrogate::~MuscleLengthSurrogate() {}
+
+#ifndef BIORBD_USE_CASADI_MATH
+void internal_forces::muscles::MuscleLengthSurrogate::fit(
+    rigidbody::Joints& model,
+    internal_forces::muscles::Muscles& muscles,
+    size_t degree,
+    size_t nbSamples,
+    unsigned int seed) {
+  utils::Error::check(
+      model.nbQ() == model.nbDof(),
+      "The muscle length surrogate is not available for models with "
+      "quaternions");
+  utils::Error::check(
+      !muscles.isMuscleLengthSurrogateUsed(),
+      "The muscles must not use a surrogate while it is fitted");
+
+  size_t nbMus(muscles.nbMuscles());
+  m_nbDof = model.nbDof();
+  m_degree = degree;
+  m_names.resize(nbMus);
+  m_dofs.assign(nbMus, std::vector<size_t>());
+  m_center.assign(nbMus, std::vector<double>());
+  m_halfRange.assign(nbMus, std::vector<double>());
+  m_exponents.resize(nbMus);
+  m_coefficients.resize(nbMus);
+  m_lengthError.assign(nbMus, 0);
+  m_jacobianError.assign(nbMus, 0);
+  m_chebyshev.resize(nbMus);
+  m_chebyshevDerivative.resize(nbMus);
+  m_terms.resize(nbMus);
+  m_termsDerivative.resize(nbMus);
+  for (size_t m = 0; m < nbMus; ++m) {
+    m_names[m] = muscles.muscle(m).name();
+  }
+
+  // Ranges of the generalized coordinates
+  std::vector<double> minQ(m_nbDof, -M_PI);
+  std::vector<double> maxQ(m_nbDof, M_PI);
+  for (size_t s = 0; s < model.nbSegment(); ++s) {
+    const rigidbody::Segment& segment(model.segment(s));
+    if (segment.nbDof() == 0) {
+      continue;
+    }
+    size_t first(segment.getFirstDofIndexInGeneralizedCoordinates(model));
+    const std::vector<utils::Range>& ranges(segment.QRanges());
+    for (size_t i = 0; i < ranges.size(); ++i) {
+      minQ[first + i] = ranges[i].min();
+      maxQ[first + i] = ranges[i].max();
+    }
+  }
+
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> distribution(0, 1);
+  rigidbody::GeneralizedCoordinates Q(model);
+  auto drawQ = [&]() {
+    for (unsigned int i = 0; i < m_nbDof; ++i) {
+      Q(i) = minQ[i] + (maxQ[i] - minQ[i]) * distribution(generator);
+    }
+  };
+  utils::Vector lengths(static_cast<unsigned int>(nbMus));
+  auto computeGeometry = [&]() {
+    muscles.updateMuscles(Q, true);
+    for (size_t m = 0; m < nbMus; ++m) {
+      lengths(static_cast<unsigned int>(m)) =
+          muscles.muscle(m).position().musculoTendonLength();
+    }
+  };
+
+  // The spanned coordinates are the ones the length depends on
+  utils::Matrix maxJacobian(
+      utils::Matrix::Zero(
+          static_cast<unsigned int>(nbMus),
+          static_cast<unsigned int>(m_nbDof)));
+  for (size_t s = 0; s < 2 * m_nbDof + 10; ++s) {
+    drawQ();
+    computeGeometry();
+    maxJacobian =
+        maxJacobian.cwiseMax(muscles.musclesLengthJacobian().cwiseAbs());
+  }
+  size_t maxTerms(0);
+  for (size_t m = 0; m < nbMus; ++m) {
+    for (size_t i = 0; i < m_nbDof; ++i) {
+      if (maxJacobian(
+              static_cast<unsigned int>(m), static_cast<unsigned int>(i)) >
+          1e-10) {
+        m_dofs[m].push_back(i);
+        m_center[m].push_back((maxQ[i] + minQ[i]) / 2);
+        double halfRange((maxQ[i] - minQ[i]) / 2);
+        m_halfRange[m].push_back(halfRange > 0 ? halfRange : 1);
+      }
+    }
+    setTerms(m);
+    maxTerms = std::max(maxTerms, static_cast<size_t>(m_terms[m].size()));
+  }
+  if (nbSamples == 0) {
+    nbSamples = std::max(static_cast<size_t>(100), 3 * maxTerms);
+  }
+
+  // Sample the full geometry
+  std::vector<rigidbody::GeneralizedCoordinates> samplesQ;
+  std::vector<utils::Vector> samplesLength;
+  std::vector<utils::Matrix> samplesJacobian;
+  for (size_t s = 0; s < nbSamples; ++s) {
+    drawQ();
+    computeGeometry();
+    samplesQ.push_back(Q);
+    samplesLength.push_back(lengths);
+    samplesJacobian.push_back(muscles.musclesLengthJacobian());
+  }
+
+  // Least squares on the lengths and on their derivatives with respect to the
+  // normalized coordinates
+  for (size_t m = 0; m < nbMus; ++m) {
+    const std::vector<size_t>& dofs(m_dofs[m]);
+    size_t n(dofs.size());
+    unsigned int nbTerms(static_cast<unsigned int>(m_terms[m].size()));
+    unsigned int row(0);
+    utils::Matrix A(static_cast<unsigned int>(nbSamples * (1 + n)), nbTerms);
+    utils::Vector b(static_cast<unsigned int>(nbSamples * (1 + n)));
+    for (size_t s = 0; s < nbSamples; ++s) {
+      evaluateTerms(m, samplesQ[s]);
+      A.row(row) = m_terms[m].transpose();
+      b(row++) = samplesLength[s](static_cast<unsigned int>(m));
+      for (size_t j = 0; j < n; ++j) {
+        A.row(row) =
+            m_termsDerivative[m].col(static_cast<unsigned int>(j)).transpose();
+        b(row++) = samplesJacobian[s](
+                       static_cast<unsigned int>(m),
+                       static_cast<unsigned int>(dofs[j])) *
+                   m_halfRange[m][j];
+      }
+    }
+    utils::Vector coefficients(A.colPivHouseholderQr().solve(b));
+    m_coefficients[m].assign(
+        coefficients.data(), coefficients.data() + nbTerms);
+  }
+  allocate();
+
+  // Estimate the error on other samples
+  for (size_t s = 0; s < nbSamples / 2; ++s) {
+    drawQ();
+    computeGeometry();
+    const utils::Matrix& jacobian(muscles.musclesLengthJacobian());
+    update(Q);
+    for (size_t m = 0; m < nbMus; ++m) {
+      unsigned int idx(static_cast<unsigned int>(m));
+      m_lengthError[m] = std::max(
+          m_lengthError[m], std::fabs(m_lengths(idx) - lengths(idx)));
+      m_jacobianError[m] = std::max(
+          m_jacobianError[m],
+          (m_lengthJacobian.row(idx) - jacobian.row(idx))
+              .cwiseAbs()
+              .maxCoeff());
+    }
+  }
+}
+#endif
+
+void internal_forces::muscles::MuscleLengthSurrogate::write(
+    const utils::Path& path) const {
+  std::ofstream file;
+  file.open(path.relativePath().c_str());
+  utils::Error::check(
+      file.is_open(), "File " + path.absolutePath() + " could not be open");
+  file.precision(17);
+
+  file << "version 1" << std::endl;
+  file << "nbdof " << m_nbDof << std::endl;
+  file << "degree " << m_degree << std::endl;
+  for (size_t m = 0; m < nbMuscles(); ++m) {
+    file << std::endl;
+    file << "muscle " << m_names[m] << std::endl;
+    file << "\tdofs " << m_dofs[m].size();
+    for (size_t i = 0; i < m_dofs[m].size(); ++i) {
+      file << " " << m_dofs[m][i];
+    }
+    file << std::endl;
+    file << "\tcenter";
+    for (size_t i = 0; i < m_center[m].size(); ++i) {
+      file << " " << m_center[m][i];
+    }
+    file << std::endl;
+    file << "\thalfrange";
+    for (size_t i = 0; i < m_halfRange[m].size(); ++i) {
+      file << " " << m_halfRange[m][i];
+    }
+    file << std::endl;
+    file << "\tlengtherror " << m_lengthError[m] << std::endl;
+    file << "\tjacobianerror " << m_jacobianError[m] << std::endl;
+    file << "\tcoefficients " << m_coefficients[m].size();
+    for (size_t i = 0; i < m_coefficients[m].size(); ++i) {
+      file << " " << m_coefficients[m][i];
+    }
+    file << std::endl;
+    file << "endmuscle" << std::endl;
+  }
+  utils::Error::check(
+      file.good(), "File " + path.absolutePath() + " could not be written");
+  file.close();
+}
+
+void internal_forces::muscles::MuscleLengthSurrogate::read(
+    const utils::Path& path) {
+  if (!path.isFileReadable())
+    utils::Error::raise("File " + path.absolutePath() + " could not be open");
+  utils::IfStream file(path.absolutePath().c_str(), std::ios::in);
+
+  utils::String tag;
+  file.readSpecificTag("version", tag);
+  utils::Error::check(
+      atoi(tag.c_str()) == 1, "Version " + tag + " is not implemented yet");
+
+  m_names.clear();
+  m_dofs.clear();
+  m_center.clear();
+  m_halfRange.clear();
+  m_exponents.clear();
+  m_coefficients.clear();
+  m_lengthError.clear();
+  m_jacobianError.clear();
+  m_chebyshev.clear();
+  m_chebyshevDerivative.clear();
+  m_terms.clear();
+  m_termsDerivative.clear();
+  while (file.read(tag)) {
+    if (!tag.tolower().compare("nbdof")) {
+      file.read(m_nbDof);
+    } else if (!tag.tolower().compare("degree")) {
+      file.read(m_degree);
+    } else if (!tag.tolower().compare("muscle")) {
+      utils::String name;
+      file.read(name);
+      m_names.push_back(name);
+      m_dofs.push_back(std::vector<size_t>());
+      m_center.push_back(std::vector<double>());
+      m_halfRange.push_back(std::vector<double>());
+      m_exponents.push_back(std::vector<unsigned int>());
+      m_coefficients.push_back(std::vector<double>());
+      m_lengthError.push_back(0);
+      m_jacobianError.push_back(0);
+      m_chebyshev.push_back(utils::Matrix());
+      m_chebyshevDerivative.push_back(utils::Matrix());
+      m_terms.push_back(utils::Vector());
+      m_termsDerivative.push_back(utils::Matrix());
+      size_t m(m_names.size() - 1);
+
+      utils::String property;
+      while (file.read(property) && property.tolower().compare("endmuscle")) {
+        if (!property.tolower().compare("dofs")) {
+          size_t n(0);
+          file.read(n);
+          m_dofs[m].resize(n);
+          m_center[m].resize(n);
+          m_halfRange[m].resize(n);
+          for (size_t i = 0; i < n; ++i) {
+            file.read(m_dofs[m][i]);
+          }
+        } else if (!property.tolower().compare("center")) {
+          for (size_t i = 0; i < m_center[m].size(); ++i) {
+            file.read(m_center[m][i]);
+          }
+        } else if (!property.tolower().compare("halfrange")) {
+          for (size_t i = 0; i < m_halfRange[m].size(); ++i) {
+            file.read(m_halfRange[m][i]);
+          }
+        } else if (!property.tolower().compare("lengtherror")) {
+          file.read(m_lengthError[m]);
+        } else if (!property.tolower().compare("jacobianerror")) {
+          file.read(m_jacobianError[m]);
+        } else if (!property.tolower().compare("coefficients")) {
+          size_t nbTerms(0);
+          file.read(nbTerms);
+          m_coefficients[m].resize(nbTerms);
+          for (size_t i = 0; i < nbTerms; ++i) {
+            file.read(m_coefficients[m][i]);
+          }
+        }
+      }
+      setTerms(m);
+      utils::Error::check(
+          m_coefficients[m].size() == static_cast<size_t>(m_terms[m].size()),
+          "Wrong number of coefficients for the muscle " + name);
+    }
+  }
+  file.close();
+  allocate();
+}
+
+size_t internal_forces::muscles::MuscleLengthSurrogate::nbMuscles() const {
+  return m_names.size();
+}
+
+size_t internal_forces::muscles::MuscleLengthSurrogate::nbDof() const {
+  return m_nbDof;
+}
+
+size_t internal_forces::muscles::MuscleLengthSurrogate::degree() const {
+  return m_degree;
+}
+
+const utils::String&
+internal_forces::muscles::MuscleLengthSurrogate::muscleName(size_t idx) const {
+  utils::Error::check(
+      idx < nbMuscles(), "Idx is higher than the number of muscles");
+  return m_names[idx];
+}
+
+const std::vector<size_t>&
+internal_forces::muscles::MuscleLengthSurrogate::spannedDofs(size_t idx) const {
+  utils::Error::check(
+      idx < nbMuscles(), "Idx is higher than the number of muscles");
+  return m_dofs[idx];
+}
+
+double internal_forces::muscles::MuscleLengthSurrogate::
+    validationMaxLengthError(size_t idx) const {
+  utils::Error::check(
+      idx < nbMuscles(), "Idx is higher than the number of muscles");
+  return m_lengthError[idx];
+}
+
+double internal_forces::muscles::MuscleLengthSurrogate::
+    validationMaxJacobianError(size_t idx) const {
+  utils::Error::check(
+      idx < nbMuscles(), "Idx is higher than the number of muscles");
+  return m_jacobianError[idx];
+}
+
+void internal_forces::muscles::MuscleLengthSurrogate::update(
+    const rigidbody::GeneralizedCoordinates& Q) {
+  for (size_t m = 0; m < nbMuscles(); ++m) {
+    evaluateTerms(m, Q);
+    const std::vector<double>& coefficients(m_coefficients[m]);
+    const utils::Vector& terms(m_terms[m]);
+    const utils::Matrix& termsDerivative(m_termsDerivative[m]);
+    unsigned int idx(static_cast<unsigned int>(m));
+
+    utils::Scalar length(0);
+    for (unsigned int t = 0; t < coefficients.size(); ++t) {
+      length = length + coefficients[t] * terms(t);
+    }
+    m_lengths(idx) = length;
+
+    for (size_t j = 0; j < m_dofs[m].size(); ++j) {
+      unsigned int col(static_cast<unsigned int>(j));
+      utils::Scalar derivative(0);
+      for (unsigned int t = 0; t < coefficients.size(); ++t) {
+        derivative = derivative + coefficients[t] * termsDerivative(t, col);
+      }
+      m_lengthJacobian(idx, static_cast<unsigned int>(m_dofs[m][j])) =
+          derivative / m_halfRange[m][j];
+    }
+  }
+}
+
+const utils::Vector& internal_forces::muscles::MuscleLengthSurrogate::lengths()
+    const {
+  return m_lengths;
+}
+
+const utils::Matrix&
+internal_forces::muscles::MuscleLengthSurrogate::lengthJacobian() const {
+  return m_lengthJacobian;
+}
+
+void internal_forces::muscles::MuscleLengthSurrogate::setTerms(size_t idx) {
+  size_t n(m_dofs[idx].size());
+  std::vector<unsigned int> current(n, 0);
+  m_exponents[idx].clear();
+  listExponents(
+      n, 0, static_cast<unsigned int>(m_degree), current, m_exponents[idx]);
+  unsigned int nbTerms(
+      n == 0 ? 1 : static_cast<unsigned int>(m_exponents[idx].size() / n));
+
+  unsigned int nbRows(static_cast<unsigned int>(n));
+  unsigned int nbCols(static_cast<unsigned int>(m_degree + 1));
+  m_chebyshev[idx] = utils::Matrix::Zero(nbRows, nbCols);
+  m_chebyshevDerivative[idx] = utils::Matrix::Zero(nbRows, nbCols);
+  m_terms[idx] = utils::Vector::Zero(nbTerms);
+  m_termsDerivative[idx] = utils::Matrix::Zero(nbTerms, nbRows);
+}
+
+void internal_forces::muscles::MuscleLengthSurrogate::allocate() {
+  m_lengths = utils::Vector::Zero(static_cast<unsigned int>(nbMuscles()));
+  m_lengthJacobian = utils::Matrix::Zero(
+      static_cast<unsigned int>(nbMuscles()),
+      static_cast<unsigned int>(m_nbDof));
+}
+
+void internal_forces::muscles::MuscleLengthSurrogate::evaluateTerms(
+    size_t idx,
+    const rigidbody::GeneralizedCoordinates& Q) {
+  const std::vector<size_t>& dofs(m_dofs[idx]);
+  unsigned int n(static_cast<unsigned int>(dofs.size()));
+  unsigned int degree(static_cast<unsigned int>(m_degree));
+  utils::Matrix& T(m_chebyshev[idx]);
+  utils::Matrix& dT(m_chebyshevDerivative[idx]);
+
+  // Chebyshev polynomials of each normalized coordinate and their derivatives
+  for (unsigned int k = 0; k < n; ++k) {
+    utils::Scalar x(
+        (Q(static_cast<unsigned int>(dofs[k])) - m_center[idx][k]) /
+        m_halfRange[idx][k]);
+    T(k, 0) = 1;
+    dT(k, 0) = 0;
+    if (degree >= 1) {
+      T(k, 1) = x;
+      dT(k, 1) = 1;
+    }
+    for (unsigned int p = 2; p <= degree; ++p) {
+      T(k, p) = 2 * x * T(k, p - 1) - T(k, p - 2);
+      dT(k, p) = 2 * T(k, p - 1) + 2 * x * dT(k, p - 1) - dT(k, p - 2);
+    }
+  }
+
+  // Products of the polynomials of each coordinate
+  utils::Vector& terms(m_terms[idx]);
+  utils::Matrix& termsDerivative(m_termsDerivative[idx]);
+  const std::vector<unsigned int>& exponents(m_exponents[idx]);
+  unsigned int nbTerms(static_cast<unsigned int>(terms.size()));
+  for (unsigned int t = 0; t < nbTerms; ++t) {
+    const unsigned int* e(n == 0 ? nullptr : &exponents[t * n]);
+    utils::Scalar value(1);
+    for (unsigned int k = 0; k < n; ++k) {
+      value = value * T(k, e[k]);
+    }
+    terms(t) = value;
+
+    for (unsigned int j = 0; j < n; ++j) {
+      utils::Scalar derivative(dT(j, e[j]));
+      for (unsigned int k = 0; k < n; ++k) {
+        if (k != j) {
+          derivative = derivative * T(k, e[k]);
+        }
+      }
+      termsDerivative(t, j) = derivative;
+    }
+  }
+}
@@ -0,0 +1,1156 @@
+#define BIORBD_API_EXPORTS
+#include "InternalForces/Muscles/MuscleParameterSet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "InternalForces/Muscles/Characteristics.h"
+#include "InternalForces/Muscles/FatigueModel.h"
+#include "InternalForces/Muscles/FatigueState.h"
+#include "InternalForces/Muscles/HillType.h"
+#include "InternalForces/Muscles/Muscle.h"
+#include "InternalForces/Muscles/MuscleCurveTable.h"
+#include "InternalForces/Muscles/MuscleGeometry.h"
+#include "InternalForces/Muscles/State.h"
+#include "Utils/Error.h"
+
+#ifdef USE_SMOOTH_IF_ELSE
+#include "Utils/CasadiExpand.h"
+#endif
+
+using namespace BIORBD_NAMESPACE;
+
+// Constants of the HillType formulation (see HillType.cpp)
+static const double hillFlCE_1(0.15);
+static const double hillFlCE_2(0.45);
+static const double hillFvCE_1(1.0);
+static const double hillFvCE_2(-.33 / 2 * hillFvCE_1 / (1 + hillFvCE_1));
+static const double hillFlPE_1(10.0);
+static const double hillFlPE_2(5.0);
+static const double hillDamping(0.1);
+
+#ifndef BIORBD_USE_CASADI_MATH
+// Normalized curves of the HillThelenType and HillDeGrooteType muscles, with
+// their left and right derivatives (see MuscleCurveTable)
+static void thelenFlCE(double l, double& value, double& left, double& right) {
+  value = exp(-((l - 1) * (l - 1)) / 0.45);
+  left = right = -2 * (l - 1) / 0.45 * value;
+}
+
+static void deGrooteFlCE(
+    double l,
+    double& value,
+    double& left,
+    double& right) {
+  const double b[3] = {0.815, 0.433, 0.100};
+  const double m[3] = {1.055, 0.717, 1.000};
+  const double c[3] = {0.162, -0.030, 0.354};
+  const double d[3] = {0.063, 0.200, 0.0};
+  value = 0;
+  left = 0;
+  for (size_t j = 0; j < 3; ++j) {
+    double s(c[j] + d[j] * l);
+    double diff(l - m[j]);
+    double g(b[j] * exp(-0.5 * diff * diff / (s * s)));
+    // The width of a gaussian vanishes at one length, where it is null
+    if (g > 0) {
+      value += g;
+      left += g * (-diff / (s * s) + diff * diff * d[j] / (s * s * s));
+    }
+  }
+  right = left;
+}
+
+static void passiveFlPE(
+    double kpe,
+    double l,
+    double& value,
+    double& left,
+    double& right) {
+  double e(exp(kpe * (l - 1) / 0.6));
+  double derivative(kpe / 0.6 * e / (exp(kpe) - 1));
+  value = l > 1 ? (e - 1) / (exp(kpe) - 1) : 0;
+  left = l > 1 ? derivative : 0;
+  right = l >= 1 ? derivative : 0;
+}
+
+// WARNING CONCENTRIC IS NOT FROM THELEN (see HillThelenType.h)
+static double thelenFvCEBranch(double v, bool fromBelow, double& derivative) {
+  const double kvce(0.06);
+  const double flen(1.6);
+  const double a(3.0 / 11.0);
+  const double b(3.0 / 11.0);
+  if (fromBelow ? v > 0 : v >= 0) {
+    double den(1 + v / kvce);
+    derivative = (flen - 1) / kvce / (den * den);
+    return (1 + v * flen / kvce) / den;
+  } else if (fromBelow ? v > -1 : v >= -1) {
+    derivative = (1 + a) * b / ((b - v) * (b - v));
+    return (1 + a) * b / (b - v) - a;
+  } else {
+    derivative = 0;
+    return 0;
+  }
+}
+
+static void thelenFvCE(double v, double& value, double& left, double& right) {
+  value = thelenFvCEBranch(v, false, right);
+  thelenFvCEBranch(v, true, left);
+}
+
+static void deGrooteFvCE(double v, double& value, double& left, double& right) {
+  double x(-8.149 * v + -0.374);
+  value = -0.318 * std::log(x + std::sqrt(x * x + 1)) + 0.886;
+  left = right = -0.318 / std::sqrt(x * x + 1) * -8.149;
+}
+#endif
+
+internal_forces::muscles::MuscleParameterSet::MuscleParameterSet() {}
+
+internal_forces::muscles::MuscleParameterSet::MuscleParameterSet(
+    const std::vector<std::shared_ptr<internal_forces::muscles::Muscle>>&
+        muscles) {
+  compile(muscles);
+}
+
+internal_forces::muscles::MuscleParameterSet::~MuscleParameterSet() {}
+
+void internal_forces::muscles::MuscleParameterSet::compile(
+    const std::vector<std::shared_ptr<internal_forces::muscles::Muscle>>&
+        muscles) {
+  size_t nbMus(muscles.size());
+  m_muscles = muscles;
+  m_type.resize(nbMus);
+  m_hillTypes.resize(nbMus);
+  m_hill.clear();
+  m_thelen.clear();
+  m_deGroote.clear();
+  m_idealized.clear();
+  m_fatigable.clear();
+  m_fatigueModel.clear();
+  m_simpleState.clear();
+  m_dynamicState.clear();
+  m_buchananState.clear();
+  m_deGrooteState.clear();
+
+  m_optimalLength = utils::Vector(nbMus);
+  m_forceIsoMax = utils::Vector(nbMus);
+  m_tendonSlackLength = utils::Vector(nbMus);
+  m_cosPennationAngle = utils::Vector(nbMus);
+  m_maxShorteningSpeed = utils::Vector(nbMus);
+  m_passiveScale = utils::Vector(nbMus);
+  m_dampingScale = utils::Vector(nbMus);
+  m_velocityScale = utils::Vector(nbMus);
+  m_minActivation = utils::Vector(nbMus);
+  m_torqueActivation = utils::Vector(nbMus);
+  m_torqueDeactivation = utils::Vector(nbMus);
+  m_maxExcitation = utils::Vector(nbMus);
+  m_activations = utils::Vector(nbMus);
+  m_muscleLengths = utils::Vector(nbMus);
+  m_muscleVelocities = utils::Vector(nbMus);
+  m_FlCE = utils::Vector(nbMus);
+  m_FlPE = utils::Vector(nbMus);
+  m_FvCE = utils::Vector(nbMus);
+  m_damping = utils::Vector(nbMus);
+  m_dFlCEdActivation = utils::Vector(nbMus);
+  m_dFlCEdLength = utils::Vector(nbMus);
+  m_dFlPEdLength = utils::Vector(nbMus);
+  m_dFvCEdVelocity = utils::Vector(nbMus);
+  m_dDampingdVelocity = utils::Vector(nbMus);
+
+  for (size_t i = 0; i < nbMus; ++i) {
+    const internal_forces::muscles::Muscle& muscle(*muscles[i]);
+    const internal_forces::muscles::Characteristics& c(
+        muscle.characteristics());
+    unsigned int idx(static_cast<unsigned int>(i));
+
+    m_type[i] = muscle.type();
+    m_hillTypes[i] =
+        std::dynamic_pointer_cast<internal_forces::muscles::HillType>(
+            muscles[i]);
+    m_optimalLength(idx) = c.optimalLength();
+    m_forceIsoMax(idx) = c.forceIsoMax();
+    m_tendonSlackLength(idx) = c.tendonSlackLength();
+    m_cosPennationAngle(idx) = cos(c.pennationAngle());
+    m_maxShorteningSpeed(idx) = c.maxShorteningSpeed();
+    m_passiveScale(idx) = 1.0;
+    m_dampingScale(idx) = c.useDamping() ? hillDamping : 0.0;
+    m_velocityScale(idx) = c.maxShorteningSpeed();
+    m_minActivation(idx) = c.minActivation();
+    m_torqueActivation(idx) = c.torqueActivation();
+    m_torqueDeactivation(idx) = c.torqueDeactivation();
+    m_maxExcitation(idx) = c.stateMax().excitation();
+
+    switch (muscle.state().type()) {
+      case internal_forces::muscles::STATE_TYPE::DYNAMIC:
+        m_dynamicState.push_back(i);
+        break;
+      case internal_forces::muscles::STATE_TYPE::BUCHANAN:
+        m_buchananState.push_back(i);
+        break;
+      case internal_forces::muscles::STATE_TYPE::DE_GROOTE:
+        m_deGrooteState.push_back(i);
+        break;
+      default:
+        m_simpleState.push_back(i);
+    }
+
+    switch (m_type[i]) {
+      case internal_forces::muscles::MUSCLE_TYPE::HILL:
+        m_hill.push_back(i);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN_ACTIVE:
+        m_passiveScale(idx) = 0.0;
+        m_dampingScale(idx) = 0.0;
+        m_velocityScale(idx) = c.optimalLength() * c.maxShorteningSpeed();
+        m_thelen.push_back(i);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN_FATIGABLE:
+        m_velocityScale(idx) = c.optimalLength() * c.maxShorteningSpeed();
+        m_fatigable.push_back(i);
+        m_fatigueModel.push_back(
+            std::dynamic_pointer_cast<internal_forces::muscles::FatigueModel>(
+                muscles[i]));
+        m_thelen.push_back(i);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN:
+        m_velocityScale(idx) = c.optimalLength() * c.maxShorteningSpeed();
+        m_thelen.push_back(i);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE_ACTIVE:
+        m_passiveScale(idx) = 0.0;
+        m_dampingScale(idx) = 0.0;
+        m_deGroote.push_back(i);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE_FATIGABLE:
+        m_fatigable.push_back(i);
+        m_fatigueModel.push_back(
+            std::dynamic_pointer_cast<internal_forces::muscles::FatigueModel>(
+                muscles[i]));
+        m_deGroote.push_back(i);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE:
+        m_deGroote.push_back(i);
+        break;
+      case internal_forces::muscles::MUSCLE_TYPE::IDEALIZED_ACTUATOR:
+        m_passiveScale(idx) = 0.0;
+        m_dampingScale(idx) = 0.0;
+        m_idealized.push_back(i);
+        break;
+      default:
+        utils::Error::raise("Muscle type not implemented");
+    }
+  }
+}
+
+size_t internal_forces::muscles::MuscleParameterSet::nbMuscles() const {
+  return m_type.size();
+}
+
+internal_forces::muscles::MUSCLE_TYPE
+internal_forces::muscles::MuscleParameterSet::type(size_t idx) const {
+  utils::Error::check(idx < nbMuscles(), "Idx is higher than nbMuscles");
+  return m_type[idx];
+}
+
+const std::vector<size_t>&
+internal_forces::muscles::MuscleParameterSet::indices(
+    internal_forces::muscles::MUSCLE_TYPE type) const {
+  switch (type) {
+    case internal_forces::muscles::MUSCLE_TYPE::HILL:
+      return m_hill;
+    case internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN:
+      return m_thelen;
+    case internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE:
+      return m_deGroote;
+    case internal_forces::muscles::MUSCLE_TYPE::IDEALIZED_ACTUATOR:
+      return m_idealized;
+    default:
+      utils::Error::raise(
+          "Only HILL, HILL_THELEN, HILL_DE_GROOTE and IDEALIZED_ACTUATOR "
+          "have an index list");
+  }
+#ifdef _WIN32
+  return m_hill;  // Will never reach here
+#endif
+}
+
+const std::vector<size_t>&
+internal_forces::muscles::MuscleParameterSet::stateIndices(
+    internal_forces::muscles::STATE_TYPE type) const {
+  switch (type) {
+    case internal_forces::muscles::STATE_TYPE::SIMPLE_STATE:
+      return m_simpleState;
+    case internal_forces::muscles::STATE_TYPE::DYNAMIC:
+      return m_dynamicState;
+    case internal_forces::muscles::STATE_TYPE::BUCHANAN:
+      return m_buchananState;
+    case internal_forces::muscles::STATE_TYPE::DE_GROOTE:
+      return m_deGrooteState;
+    default:
+      utils::Error::raise(
+          "Only SIMPLE_STATE, DYNAMIC, BUCHANAN and DE_GROOTE have an index "
+          "list");
+  }
+#ifdef _WIN32
+  return m_simpleState;  // Will never reach here
+#endif
+}
+
+const utils::Vector&
+internal_forces::muscles::MuscleParameterSet::optimalLength() const {
+  return m_optimalLength;
+}
+
+const utils::Vector& internal_forces::muscles::MuscleParameterSet::forceIsoMax()
+    const {
+  return m_forceIsoMax;
+}
+
+const utils::Vector&
+internal_forces::muscles::MuscleParameterSet::tendonSlackLength() const {
+  return m_tendonSlackLength;
+}
+
+const utils::Vector&
+internal_forces::muscles::MuscleParameterSet::cosPennationAngle() const {
+  return m_cosPennationAngle;
+}
+
+const utils::Vector&
+internal_forces::muscles::MuscleParameterSet::maxShorteningSpeed() const {
+  return m_maxShorteningSpeed;
+}
+
+void internal_forces::muscles::MuscleParameterSet::useCurveTables(
+    bool use,
+    size_t nbIntervals) {
+  if (!use) {
+    m_curveTables.clear();
+    return;
+  }
+#ifdef BIORBD_USE_CASADI_MATH
+  utils::Error::raise("The curve tables are not available with CasADi");
+#else
+  // The kinks of the curves (l = 1, v = 0 and v = -1) must fall on nodes
+  utils::Error::check(
+      nbIntervals > 0 && nbIntervals % 2 == 0,
+      "The number of intervals of the curve tables must be even");
+  m_curveTables.clear();
+  using namespace std::placeholders;
+  const MuscleCurveTable::Curve curves[6] = {
+      thelenFlCE,
+      std::bind(passiveFlPE, 5.0, _1, _2, _3, _4),
+      thelenFvCE,
+      deGrooteFlCE,
+      std::bind(passiveFlPE, 4.0, _1, _2, _3, _4),
+      deGrooteFvCE};
+  for (size_t i = 0; i < 6; ++i) {
+    bool isVelocity(i % NO_MUSCLE_CURVE == FORCE_VELOCITY);
+    m_curveTables.push_back(std::make_shared<MuscleCurveTable>(
+        curves[i],
+        isVelocity ? -1.0 : 0.0,
+        isVelocity ? 1.0 : 2.0,
+        nbIntervals));
+  }
+#endif
+}
+
+bool internal_forces::muscles::MuscleParameterSet::isCurveTablesUsed() const {
+  return !m_curveTables.empty();
+}
+
+const internal_forces::muscles::MuscleCurveTable&
+internal_forces::muscles::MuscleParameterSet::curveTable(
+    internal_forces::muscles::MUSCLE_TYPE type,
+    internal_forces::muscles::MUSCLE_CURVE curve) const {
+  utils::Error::check(isCurveTablesUsed(), "The curve tables are not used");
+  utils::Error::check(
+      type == internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN ||
+          type == internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE,
+      "Only HILL_THELEN and HILL_DE_GROOTE have curve tables");
+  utils::Error::check(curve < NO_MUSCLE_CURVE, "Wrong muscle curve");
+  size_t offset(
+      type == internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN
+          ? 0
+          : NO_MUSCLE_CURVE);
+  return *m_curveTables[offset + curve];
+}
+
+double internal_forces::muscles::MuscleParameterSet::curveTablesMaxError()
+    const {
+  double error(0);
+  for (size_t i = 0; i < m_curveTables.size(); ++i) {
+    error = std::max(error, m_curveTables[i]->maxError());
+  }
+  return error;
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeMuscleLengths(
+    const utils::Vector& musculoTendonLengths,
+    utils::Vector& muscleLengths) const {
+  for (unsigned int i = 0; i < static_cast<unsigned int>(nbMuscles()); ++i) {
+    muscleLengths(i) = (musculoTendonLengths(i) - m_tendonSlackLength(i)) /
+                       m_cosPennationAngle(i);
+  }
+}
+
+void internal_forces::muscles::MuscleParameterSet::updateKinematics() {
+  for (size_t i = 0; i < m_muscles.size(); ++i) {
+    const internal_forces::muscles::MuscleGeometry& geometry(
+        m_muscles[i]->position());
+    m_muscleLengths(static_cast<unsigned int>(i)) = geometry.length();
+    m_muscleVelocities(static_cast<unsigned int>(i)) = geometry.velocity();
+  }
+}
+
+utils::Vector& internal_forces::muscles::MuscleParameterSet::muscleLengths() {
+  return m_muscleLengths;
+}
+
+utils::Vector&
+internal_forces::muscles::MuscleParameterSet::muscleVelocities() {
+  return m_muscleVelocities;
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeForces(
+    const utils::Vector& activations,
+    utils::Vector& forces) {
+  computeForces(activations, m_muscleLengths, m_muscleVelocities, forces);
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeForces(
+    const utils::Vector& activations,
+    const utils::Vector& muscleLengths,
+    const utils::Vector& muscleVelocities,
+    utils::Vector& forces) {
+  // Bound the activations as State::setActivation does
+  for (unsigned int i = 0; i < static_cast<unsigned int>(nbMuscles()); ++i) {
+#ifdef BIORBD_USE_CASADI_MATH
+    m_activations(i) = activations(i);
+#else
+    m_activations(i) = std::min(std::max(activations(i), 0.0), 1.0);
+#endif
+  }
+
+  // Compute the forces of each element
+  computeFvCE(muscleVelocities);
+  computeFlCE(m_activations, muscleLengths);
+  computeFlPE(muscleLengths);
+  computeDamping(muscleVelocities);
+
+  // Combine the forces
+  for (unsigned int i = 0; i < static_cast<unsigned int>(nbMuscles()); ++i) {
+    forces(i) = m_forceIsoMax(i) *
+                (m_activations(i) * m_FlCE(i) * m_FvCE(i) + m_FlPE(i) +
+                 m_damping(i)) *
+                m_cosPennationAngle(i);
+  }
+  for (size_t k = 0; k < m_idealized.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_idealized[k]));
+    forces(i) = m_forceIsoMax(i) * m_activations(i);
+  }
+  scatterForces(forces);
+}
+
+void internal_forces::muscles::MuscleParameterSet::scatterForces(
+    const utils::Vector& forces) {
+  for (size_t k = 0; k < m_muscles.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(k));
+    *m_muscles[k]->m_force = forces(i);
+    const std::shared_ptr<internal_forces::muscles::HillType>& hill(
+        m_hillTypes[k]);
+    if (hill) {
+      *hill->m_FlCE = m_FlCE(i);
+      *hill->m_FlPE = m_FlPE(i);
+      *hill->m_FvCE = m_FvCE(i);
+      *hill->m_damping = m_damping(i);
+    }
+  }
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeForceDerivatives(
+    const utils::Vector& activations,
+    utils::Vector& dFdActivations,
+    utils::Vector& dFdLengths,
+    utils::Vector& dFdVelocities) {
+  computeForceDerivatives(
+      activations,
+      m_muscleLengths,
+      m_muscleVelocities,
+      dFdActivations,
+      dFdLengths,
+      dFdVelocities);
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeForceDerivatives(
+    const utils::Vector& activations,
+    const utils::Vector& muscleLengths,
+    const utils::Vector& muscleVelocities,
+    utils::Vector& dFdActivations,
+    utils::Vector& dFdLengths,
+    utils::Vector& dFdVelocities) {
+  // The elements themselves are needed by the product rule
+  computeFvCE(muscleVelocities);
+  computeFlCE(activations, muscleLengths);
+  computeFlCEDerivatives(activations, muscleLengths);
+  computeFlPEDerivative(muscleLengths);
+  computeFvCEDerivative(muscleVelocities);
+
+  // F = Fmax * (a * FlCE(a, l) * FvCE(v) + FlPE(l) + damping(v)) * cos(alpha)
+  for (unsigned int i = 0; i < static_cast<unsigned int>(nbMuscles()); ++i) {
+    utils::Scalar scale(m_forceIsoMax(i) * m_cosPennationAngle(i));
+    dFdActivations(i) = scale * m_FvCE(i) *
+                        (m_FlCE(i) + activations(i) * m_dFlCEdActivation(i));
+    dFdLengths(i) = scale * (activations(i) * m_dFlCEdLength(i) * m_FvCE(i) +
+                             m_dFlPEdLength(i));
+    dFdVelocities(i) =
+        scale * (activations(i) * m_FlCE(i) * m_dFvCEdVelocity(i) +
+                 m_dDampingdVelocity(i));
+  }
+
+  // F = Fmax * a
+  for (size_t k = 0; k < m_idealized.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_idealized[k]));
+    dFdActivations(i) = m_forceIsoMax(i);
+    dFdLengths(i) = 0.0;
+    dFdVelocities(i) = 0.0;
+  }
+}
+
+void internal_forces::muscles::MuscleParameterSet::
+    computeForceActivationSecondDerivatives(
+        const utils::Vector& activations,
+        utils::Vector& d2FdActivations2) {
+  computeForceActivationSecondDerivatives(
+      activations, m_muscleLengths, m_muscleVelocities, d2FdActivations2);
+}
+
+void internal_forces::muscles::MuscleParameterSet::
+    computeForceActivationSecondDerivatives(
+        const utils::Vector& activations,
+        const utils::Vector& muscleLengths,
+        const utils::Vector& muscleVelocities,
+        utils::Vector& d2FdActivations2) {
+  computeFvCE(muscleVelocities);
+  computeFlCE(activations, muscleLengths);
+  computeFlCEDerivatives(activations, muscleLengths);
+
+  for (unsigned int i = 0; i < static_cast<unsigned int>(nbMuscles()); ++i) {
+    d2FdActivations2(i) = 0.0;
+  }
+
+  // FlCE = exp(-x^2 / c2) with x = l / (c1 * (1 - a) + 1) - 1
+  for (size_t k = 0; k < m_hill.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_hill[k]));
+    utils::Scalar normLength(muscleLengths(i) / m_optimalLength(i));
+    utils::Scalar d(hillFlCE_1 * (1 - activations(i)) + 1);
+    utils::Scalar x(normLength / d - 1);
+    utils::Scalar dx(normLength * hillFlCE_1 / (d * d));
+    utils::Scalar d2x(2 * normLength * hillFlCE_1 * hillFlCE_1 / (d * d * d));
+    utils::Scalar d2FlCE(
+        -2 / hillFlCE_2 * m_FlCE(i) *
+        (dx * dx + x * d2x - 2 * x * x * dx * dx / hillFlCE_2));
+    d2FdActivations2(i) =
+        m_forceIsoMax(i) * m_cosPennationAngle(i) * m_FvCE(i) *
+        (2 * m_dFlCEdActivation(i) + activations(i) * d2FlCE);
+  }
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeActivationsDot(
+    const utils::Vector& excitations,
+    const utils::Vector& activations,
+    utils::Vector& activationsDot,
+    bool alreadyNormalized) const {
+  computeActivationDynamics(
+      excitations, activations, activationsDot, nullptr, alreadyNormalized);
+}
+
+void internal_forces::muscles::MuscleParameterSet::
+    computeActivationsDotDerivative(
+        const utils::Vector& excitations,
+        const utils::Vector& activations,
+        utils::Vector& activationsDot,
+        utils::Vector& dActivationsDotdExcitations,
+        bool alreadyNormalized) const {
+  computeActivationDynamics(
+      excitations,
+      activations,
+      activationsDot,
+      &dActivationsDotdExcitations,
+      alreadyNormalized);
+}
+
+const utils::Vector& internal_forces::muscles::MuscleParameterSet::FlCE()
+    const {
+  return m_FlCE;
+}
+
+const utils::Vector& internal_forces::muscles::MuscleParameterSet::FlPE()
+    const {
+  return m_FlPE;
+}
+
+const utils::Vector& internal_forces::muscles::MuscleParameterSet::FvCE()
+    const {
+  return m_FvCE;
+}
+
+const utils::Vector& internal_forces::muscles::MuscleParameterSet::damping()
+    const {
+  return m_damping;
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeFlCE(
+    const utils::Vector& activations,
+    const utils::Vector& muscleLengths) {
+  for (size_t k = 0; k < m_hill.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_hill[k]));
+    utils::Scalar normLength(muscleLengths(i) / m_optimalLength(i));
+    utils::Scalar x(
+        normLength / (hillFlCE_1 * (1 - activations(i)) + 1) - 1);
+    m_FlCE(i) = exp(-(x * x) / hillFlCE_2);
+  }
+
+  if (isCurveTablesUsed()) {
+#ifndef BIORBD_USE_CASADI_MATH
+    evaluateCurveTable(
+        curveTable(HILL_THELEN, FORCE_LENGTH_ACTIVE),
+        m_thelen,
+        muscleLengths,
+        m_optimalLength,
+        &m_FlCE,
+        nullptr);
+    evaluateCurveTable(
+        curveTable(HILL_DE_GROOTE, FORCE_LENGTH_ACTIVE),
+        m_deGroote,
+        muscleLengths,
+        m_optimalLength,
+        &m_FlCE,
+        nullptr);
+#endif
+  } else {
+    for (size_t k = 0; k < m_thelen.size(); ++k) {
+      unsigned int i(static_cast<unsigned int>(m_thelen[k]));
+      utils::Scalar normLength(muscleLengths(i) / m_optimalLength(i));
+      m_FlCE(i) = exp(-((normLength - 1) * (normLength - 1)) / 0.45);
+    }
+
+    for (size_t k = 0; k < m_deGroote.size(); ++k) {
+      unsigned int i(static_cast<unsigned int>(m_deGroote[k]));
+      utils::Scalar normLength(muscleLengths(i) / m_optimalLength(i));
+      utils::Scalar s1(0.162 + 0.063 * normLength);
+      utils::Scalar s2(-0.030 + 0.200 * normLength);
+      utils::Scalar s3(0.354 + 0.0 * normLength);
+      m_FlCE(i) =
+          0.815 * exp((-0.5 * ((normLength - 1.055) * (normLength - 1.055))) /
+                      (s1 * s1)) +
+          0.433 * exp((-0.5 * ((normLength - 0.717) * (normLength - 0.717))) /
+                      (s2 * s2)) +
+          0.100 * exp((-0.5 * ((normLength - 1.000) * (normLength - 1.000))) /
+                      (s3 * s3));
+    }
+  }
+
+  for (size_t k = 0; k < m_idealized.size(); ++k) {
+    m_FlCE(static_cast<unsigned int>(m_idealized[k])) = 1.0;
+  }
+
+  // The fatigue states evolve with time, they are therefore read at each call
+  for (size_t k = 0; k < m_fatigable.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_fatigable[k]));
+    m_FlCE(i) = m_FlCE(i) * m_fatigueModel[k]->fatigueState().activeFibers();
+  }
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeFlPE(
+    const utils::Vector& muscleLengths) {
+  for (size_t k = 0; k < m_hill.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_hill[k]));
+    utils::Scalar l(muscleLengths(i));
+#ifdef BIORBD_USE_CASADI_MATH
+    m_FlPE(i) = IF_ELSE_NAMESPACE::if_else_zero(
+        IF_ELSE_NAMESPACE::gt(l, 0),
+        exp(hillFlPE_1 * (l / m_optimalLength(i) - 1) - hillFlPE_2));
+#else
+    m_FlPE(i) =
+        l > 0 ? exp(hillFlPE_1 * (l / m_optimalLength(i) - 1) - hillFlPE_2)
+              : 0;
+#endif
+  }
+
+  if (isCurveTablesUsed()) {
+#ifndef BIORBD_USE_CASADI_MATH
+    evaluateCurveTable(
+        curveTable(HILL_THELEN, FORCE_LENGTH_PASSIVE),
+        m_thelen,
+        muscleLengths,
+        m_optimalLength,
+        &m_FlPE,
+        nullptr);
+    evaluateCurveTable(
+        curveTable(HILL_DE_GROOTE, FORCE_LENGTH_PASSIVE),
+        m_deGroote,
+        muscleLengths,
+        m_optimalLength,
+        &m_FlPE,
+        nullptr);
+    for (size_t k = 0; k < m_thelen.size() + m_deGroote.size(); ++k) {
+      unsigned int i(static_cast<unsigned int>(
+          k < m_thelen.size() ? m_thelen[k] : m_deGroote[k - m_thelen.size()]));
+      m_FlPE(i) = m_FlPE(i) * m_passiveScale(i);
+    }
+#endif
+  } else {
+    // Thelen (kpe = 5) and DeGroote (kpe = 4) share the same formulation
+    for (size_t k = 0; k < m_thelen.size() + m_deGroote.size(); ++k) {
+      bool isThelen(k < m_thelen.size());
+      unsigned int i(static_cast<unsigned int>(
+          isThelen ? m_thelen[k] : m_deGroote[k - m_thelen.size()]));
+      utils::Scalar kpe(isThelen ? 5.0 : 4.0);
+      utils::Scalar normLength(muscleLengths(i) / m_optimalLength(i));
+      utils::Scalar t5 = exp(kpe * (normLength - 1) / 0.6);
+      utils::Scalar t7 = exp(kpe);
+#ifdef BIORBD_USE_CASADI_MATH
+      m_FlPE(i) =
+          m_passiveScale(i) *
+          IF_ELSE_NAMESPACE::if_else_zero(
+              IF_ELSE_NAMESPACE::gt(normLength, 1), (t5 - 1) / (t7 - 1));
+#else
+      m_FlPE(i) = m_passiveScale(i) > 0 && normLength > 1 ? (t5 - 1) / (t7 - 1)
+                                                          : 0;
+#endif
+    }
+  }
+
+  for (size_t k = 0; k < m_idealized.size(); ++k) {
+    m_FlPE(static_cast<unsigned int>(m_idealized[k])) = 0.0;
+  }
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeFvCE(
+    const utils::Vector& muscleVelocities) {
+  for (size_t k = 0; k < m_hill.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_hill[k]));
+    utils::Scalar v(muscleVelocities(i));
+    utils::Scalar vMax(m_maxShorteningSpeed(i));
+#ifdef BIORBD_USE_CASADI_MATH
+    m_FvCE(i) = IF_ELSE_NAMESPACE::if_else(
+        IF_ELSE_NAMESPACE::le(v, 0),
+        (1.0 - std::fabs(v) / vMax) / (1.0 + std::fabs(v) / vMax / hillFvCE_1),
+        (1.0 - 1.33 * v / vMax / hillFvCE_2) / (1 - v / vMax / hillFvCE_2));
+#else
+    m_FvCE(i) =
+        v <= 0
+            ? (1 - fabs(v) / vMax) / (1 + fabs(v) / vMax / hillFvCE_1)
+            : (1 - 1.33 * v / vMax / hillFvCE_2) / (1 - v / vMax / hillFvCE_2);
+#endif
+  }
+
+  if (isCurveTablesUsed()) {
+#ifndef BIORBD_USE_CASADI_MATH
+    evaluateCurveTable(
+        curveTable(HILL_THELEN, FORCE_VELOCITY),
+        m_thelen,
+        muscleVelocities,
+        m_velocityScale,
+        &m_FvCE,
+        nullptr);
+    evaluateCurveTable(
+        curveTable(HILL_DE_GROOTE, FORCE_VELOCITY),
+        m_deGroote,
+        muscleVelocities,
+        m_velocityScale,
+        &m_FvCE,
+        nullptr);
+#endif
+  } else {
+    // WARNING CONCENTRIC IS NOT FROM THELEN (see HillThelenType.h)
+    for (size_t k = 0; k < m_thelen.size(); ++k) {
+      unsigned int i(static_cast<unsigned int>(m_thelen[k]));
+      utils::Scalar normV(
+          muscleVelocities(i) / (m_optimalLength(i) * m_maxShorteningSpeed(i)));
+      const double kvce(0.06);
+      const double flen(1.6);
+      const double a(3.0 / 11.0);
+      const double b(3.0 / 11.0);
+#ifdef BIORBD_USE_CASADI_MATH
+      m_FvCE(i) = IF_ELSE_NAMESPACE::if_else(
+          IF_ELSE_NAMESPACE::ge(normV, 0),
+          ((1 + normV * flen / kvce) / (1 + normV / kvce)),
+          IF_ELSE_NAMESPACE::if_else(
+              IF_ELSE_NAMESPACE::ge(normV, -1),
+              (1 + a) * b / (-normV + b) - a,
+              0));
+#else
+      m_FvCE(i) = normV >= 0 ? (1 + normV * flen / kvce) / (1 + normV / kvce)
+                  : normV >= -1 ? (1 + a) * b / (-normV + b) - a
+                                : 0;
+#endif
+    }
+
+    for (size_t k = 0; k < m_deGroote.size(); ++k) {
+      unsigned int i(static_cast<unsigned int>(m_deGroote[k]));
+      utils::Scalar normV(muscleVelocities(i) / m_maxShorteningSpeed(i));
+      utils::Scalar x(-8.149 * normV + -0.374);
+      m_FvCE(i) = -0.318 * std::log(x + std::sqrt(x * x + 1)) + 0.886;
+    }
+  }
+
+  for (size_t k = 0; k < m_idealized.size(); ++k) {
+    m_FvCE(static_cast<unsigned int>(m_idealized[k])) = 1.0;
+  }
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeDamping(
+    const utils::Vector& muscleVelocities) {
+  for (unsigned int i = 0; i < static_cast<unsigned int>(nbMuscles()); ++i) {
+    utils::Scalar v(muscleVelocities(i));
+#ifdef BIORBD_USE_CASADI_MATH
+    m_damping(i) = IF_ELSE_NAMESPACE::if_else_zero(
+        IF_ELSE_NAMESPACE::gt(v, 0),
+        v / (m_optimalLength(i) * m_maxShorteningSpeed(i)) * m_dampingScale(i));
+#else
+    m_damping(i) =
+        v > 0 ? v / (m_optimalLength(i) * m_maxShorteningSpeed(i)) *
+                    m_dampingScale(i)
+              : 0;
+#endif
+  }
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeFlCEDerivatives(
+    const utils::Vector& activations,
+    const utils::Vector& muscleLengths) {
+  // Only the HillType force-length depends on the activation
+  for (unsigned int i = 0; i < static_cast<unsigned int>(nbMuscles()); ++i) {
+    m_dFlCEdActivation(i) = 0.0;
+  }
+
+  for (size_t k = 0; k < m_hill.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_hill[k]));
+    utils::Scalar normLength(muscleLengths(i) / m_optimalLength(i));
+    utils::Scalar d(hillFlCE_1 * (1 - activations(i)) + 1);
+    utils::Scalar x(normLength / d - 1);
+    utils::Scalar dFdx(-2 * x / hillFlCE_2 * m_FlCE(i));
+    m_dFlCEdActivation(i) = dFdx * normLength * hillFlCE_1 / (d * d);
+    m_dFlCEdLength(i) = dFdx / (d * m_optimalLength(i));
+  }
+
+  if (isCurveTablesUsed()) {
+#ifndef BIORBD_USE_CASADI_MATH
+    evaluateCurveTable(
+        curveTable(HILL_THELEN, FORCE_LENGTH_ACTIVE),
+        m_thelen,
+        muscleLengths,
+        m_optimalLength,
+        nullptr,
+        &m_dFlCEdLength);
+    evaluateCurveTable(
+        curveTable(HILL_DE_GROOTE, FORCE_LENGTH_ACTIVE),
+        m_deGroote,
+        muscleLengths,
+        m_optimalLength,
+        nullptr,
+        &m_dFlCEdLength);
+#endif
+  } else {
+    for (size_t k = 0; k < m_thelen.size(); ++k) {
+      unsigned int i(static_cast<unsigned int>(m_thelen[k]));
+      utils::Scalar normLength(muscleLengths(i) / m_optimalLength(i));
+      m_dFlCEdLength(i) = -2 * (normLength - 1) / 0.45 *
+                          exp(-((normLength - 1) * (normLength - 1)) / 0.45) /
+                          m_optimalLength(i);
+    }
+
+    // Each gaussian b * exp(-0.5 (l - m)^2 / s(l)^2) with s(l) = c + d * l
+    const double b[3] = {0.815, 0.433, 0.100};
+    const double m[3] = {1.055, 0.717, 1.000};
+    const double c[3] = {0.162, -0.030, 0.354};
+    const double d[3] = {0.063, 0.200, 0.0};
+    for (size_t k = 0; k < m_deGroote.size(); ++k) {
+      unsigned int i(static_cast<unsigned int>(m_deGroote[k]));
+      utils::Scalar normLength(muscleLengths(i) / m_optimalLength(i));
+      utils::Scalar dFlCE(0);
+      for (size_t j = 0; j < 3; ++j) {
+        utils::Scalar s(c[j] + d[j] * normLength);
+        utils::Scalar diff(normLength - m[j]);
+        utils::Scalar g(b[j] * exp(-0.5 * diff * diff / (s * s)));
+        dFlCE += g * (-diff / (s * s) + diff * diff * d[j] / (s * s * s));
+      }
+      m_dFlCEdLength(i) = dFlCE / m_optimalLength(i);
+    }
+  }
+
+  for (size_t k = 0; k < m_idealized.size(); ++k) {
+    m_dFlCEdLength(static_cast<unsigned int>(m_idealized[k])) = 0.0;
+  }
+
+  for (size_t k = 0; k < m_fatigable.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_fatigable[k]));
+    m_dFlCEdLength(i) =
+        m_dFlCEdLength(i) * m_fatigueModel[k]->fatigueState().activeFibers();
+  }
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeFlPEDerivative(
+    const utils::Vector& muscleLengths) {
+  for (size_t k = 0; k < m_hill.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_hill[k]));
+    utils::Scalar l(muscleLengths(i));
+    utils::Scalar dFlPE(
+        hillFlPE_1 / m_optimalLength(i) *
+        exp(hillFlPE_1 * (l / m_optimalLength(i) - 1) - hillFlPE_2));
+#ifdef BIORBD_USE_CASADI_MATH
+    m_dFlPEdLength(i) =
+        IF_ELSE_NAMESPACE::if_else_zero(IF_ELSE_NAMESPACE::gt(l, 0), dFlPE);
+#else
+    m_dFlPEdLength(i) = l > 0 ? dFlPE : 0;
+#endif
+  }
+
+  if (isCurveTablesUsed()) {
+#ifndef BIORBD_USE_CASADI_MATH
+    evaluateCurveTable(
+        curveTable(HILL_THELEN, FORCE_LENGTH_PASSIVE),
+        m_thelen,
+        muscleLengths,
+        m_optimalLength,
+        nullptr,
+        &m_dFlPEdLength);
+    evaluateCurveTable(
+        curveTable(HILL_DE_GROOTE, FORCE_LENGTH_PASSIVE),
+        m_deGroote,
+        muscleLengths,
+        m_optimalLength,
+        nullptr,
+        &m_dFlPEdLength);
+    for (size_t k = 0; k < m_thelen.size() + m_deGroote.size(); ++k) {
+      unsigned int i(static_cast<unsigned int>(
+          k < m_thelen.size() ? m_thelen[k] : m_deGroote[k - m_thelen.size()]));
+      m_dFlPEdLength(i) = m_dFlPEdLength(i) * m_passiveScale(i);
+    }
+#endif
+  } else {
+    for (size_t k = 0; k < m_thelen.size() + m_deGroote.size(); ++k) {
+      bool isThelen(k < m_thelen.size());
+      unsigned int i(static_cast<unsigned int>(
+          isThelen ? m_thelen[k] : m_deGroote[k - m_thelen.size()]));
+      utils::Scalar kpe(isThelen ? 5.0 : 4.0);
+      utils::Scalar normLength(muscleLengths(i) / m_optimalLength(i));
+      utils::Scalar dFlPE(
+          kpe / 0.6 * exp(kpe * (normLength - 1) / 0.6) / (exp(kpe) - 1) /
+          m_optimalLength(i));
+#ifdef BIORBD_USE_CASADI_MATH
+      m_dFlPEdLength(i) =
+          m_passiveScale(i) *
+          IF_ELSE_NAMESPACE::if_else_zero(
+              IF_ELSE_NAMESPACE::gt(normLength, 1), dFlPE);
+#else
+      m_dFlPEdLength(i) = m_passiveScale(i) > 0 && normLength > 1 ? dFlPE : 0;
+#endif
+    }
+  }
+
+  for (size_t k = 0; k < m_idealized.size(); ++k) {
+    m_dFlPEdLength(static_cast<unsigned int>(m_idealized[k])) = 0.0;
+  }
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeFvCEDerivative(
+    const utils::Vector& muscleVelocities) {
+  for (size_t k = 0; k < m_hill.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_hill[k]));
+    utils::Scalar v(muscleVelocities(i));
+    utils::Scalar vMax(m_maxShorteningSpeed(i));
+    utils::Scalar u(1 - v / vMax / hillFvCE_1);  // v <= 0
+    utils::Scalar w(1 - v / vMax / hillFvCE_2);  // v > 0
+#ifdef BIORBD_USE_CASADI_MATH
+    m_dFvCEdVelocity(i) = IF_ELSE_NAMESPACE::if_else(
+        IF_ELSE_NAMESPACE::le(v, 0),
+        (1 + 1 / hillFvCE_1) / (vMax * u * u),
+        -0.33 / (vMax * hillFvCE_2 * w * w));
+#else
+    m_dFvCEdVelocity(i) = v <= 0 ? (1 + 1 / hillFvCE_1) / (vMax * u * u)
+                                 : -0.33 / (vMax * hillFvCE_2 * w * w);
+#endif
+  }
+
+  if (isCurveTablesUsed()) {
+#ifndef BIORBD_USE_CASADI_MATH
+    evaluateCurveTable(
+        curveTable(HILL_THELEN, FORCE_VELOCITY),
+        m_thelen,
+        muscleVelocities,
+        m_velocityScale,
+        nullptr,
+        &m_dFvCEdVelocity);
+    evaluateCurveTable(
+        curveTable(HILL_DE_GROOTE, FORCE_VELOCITY),
+        m_deGroote,
+        muscleVelocities,
+        m_velocityScale,
+        nullptr,
+        &m_dFvCEdVelocity);
+#endif
+  } else {
+    for (size_t k = 0; k < m_thelen.size(); ++k) {
+      unsigned int i(static_cast<unsigned int>(m_thelen[k]));
+      utils::Scalar vNorm(m_optimalLength(i) * m_maxShorteningSpeed(i));
+      utils::Scalar normV(muscleVelocities(i) / vNorm);
+      const double kvce(0.06);
+      const double flen(1.6);
+      const double a(3.0 / 11.0);
+      const double b(3.0 / 11.0);
+      utils::Scalar den(1 + normV / kvce);
+#ifdef BIORBD_USE_CASADI_MATH
+      m_dFvCEdVelocity(i) =
+          IF_ELSE_NAMESPACE::if_else(
+              IF_ELSE_NAMESPACE::ge(normV, 0),
+              (flen - 1) / kvce / (den * den),
+              IF_ELSE_NAMESPACE::if_else(
+                  IF_ELSE_NAMESPACE::ge(normV, -1),
+                  (1 + a) * b / ((b - normV) * (b - normV)),
+                  0)) /
+          vNorm;
+#else
+      m_dFvCEdVelocity(i) =
+          (normV >= 0        ? (flen - 1) / kvce / (den * den)
+           : normV >= -1 ? (1 + a) * b / ((b - normV) * (b - normV))
+                         : 0) /
+          vNorm;
+#endif
+    }
+
+    for (size_t k = 0; k < m_deGroote.size(); ++k) {
+      unsigned int i(static_cast<unsigned int>(m_deGroote[k]));
+      utils::Scalar normV(muscleVelocities(i) / m_maxShorteningSpeed(i));
+      utils::Scalar x(-8.149 * normV + -0.374);
+      m_dFvCEdVelocity(i) =
+          -0.318 / std::sqrt(x * x + 1) * -8.149 / m_maxShorteningSpeed(i);
+    }
+  }
+
+  for (size_t k = 0; k < m_idealized.size(); ++k) {
+    m_dFvCEdVelocity(static_cast<unsigned int>(m_idealized[k])) = 0.0;
+  }
+
+  for (unsigned int i = 0; i < static_cast<unsigned int>(nbMuscles()); ++i) {
+    utils::Scalar dDamping(
+        m_dampingScale(i) / (m_optimalLength(i) * m_maxShorteningSpeed(i)));
+#ifdef BIORBD_USE_CASADI_MATH
+    m_dDampingdVelocity(i) = IF_ELSE_NAMESPACE::if_else_zero(
+        IF_ELSE_NAMESPACE::gt(muscleVelocities(i), 0), dDamping);
+#else
+    m_dDampingdVelocity(i) = muscleVelocities(i) > 0 ? dDamping : 0;
+#endif
+  }
+}
+
+void internal_forces::muscles::MuscleParameterSet::computeActivationDynamics(
+    const utils::Vector& excitations,
+    const utils::Vector& activations,
+    utils::Vector& activationsDot,
+    utils::Vector* derivatives,
+    bool alreadyNormalized) const {
+  if (!m_simpleState.empty()) {
+    utils::Error::raise(
+        "The muscle " + m_muscles[m_simpleState[0]]->name() +
+        " is not a dynamic muscle");
+  }
+
+  // First-order dynamics (see StateDynamics::timeDerivativeActivation):
+  // da/dt = (u - a) / (t_act * (0.5 + 1.5 * a)) if u > a
+  // da/dt = (u - a) * (0.5 + 1.5 * a) / t_deact otherwise
+  // with u and a bounded below by the minimal activation
+  for (const std::vector<size_t>* indices :
+       {&m_dynamicState, &m_buchananState}) {
+    for (size_t k = 0; k < indices->size(); ++k) {
+      unsigned int i(static_cast<unsigned int>((*indices)[k]));
+      utils::Scalar minActivation(m_minActivation(i));
+#ifdef BIORBD_USE_CASADI_MATH
+      utils::Scalar a(IF_ELSE_NAMESPACE::if_else(
+          IF_ELSE_NAMESPACE::lt(activations(i), minActivation),
+          minActivation,
+          activations(i)));
+      utils::Scalar u(IF_ELSE_NAMESPACE::if_else(
+          IF_ELSE_NAMESPACE::lt(excitations(i), minActivation),
+          minActivation,
+          excitations(i)));
+      utils::Scalar du(IF_ELSE_NAMESPACE::if_else(
+          IF_ELSE_NAMESPACE::lt(excitations(i), minActivation), 0, 1));
+#else
+      utils::Scalar a(
+          activations(i) < minActivation ? minActivation : activations(i));
+      utils::Scalar u(
+          excitations(i) < minActivation ? minActivation : excitations(i));
+      utils::Scalar du(excitations(i) < minActivation ? 0 : 1);
+#endif
+      if (!alreadyNormalized) {
+        u = u / m_maxExcitation(i);
+        du = du / m_maxExcitation(i);
+      }
+      utils::Scalar num(u - a);
+#ifdef BIORBD_USE_CASADI_MATH
+      utils::Scalar denom(IF_ELSE_NAMESPACE::if_else(
+          IF_ELSE_NAMESPACE::gt(num, 0),
+          m_torqueActivation(i) * (0.5 + 1.5 * a),
+          m_torqueDeactivation(i) / (0.5 + 1.5 * a)));
+#else
+      utils::Scalar denom(
+          num > 0 ? m_torqueActivation(i) * (0.5 + 1.5 * a)
+                  : m_torqueDeactivation(i) / (0.5 + 1.5 * a));
+#endif
+      activationsDot(i) = num / denom;
+      if (derivatives) {
+        (*derivatives)(i) = du / denom;
+      }
+    }
+  }
+
+  // Smooth dynamics (see StateDynamicsDeGroote::timeDerivativeActivation):
+  // da/dt = ((f + 0.5) / d_act + (0.5 - f) / d_deact) * (u - a)
+  // with f = 0.5 * tanh(0.1 * (u - a))
+  for (size_t k = 0; k < m_deGrooteState.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_deGrooteState[k]));
+    utils::Scalar a(activations(i));
+    utils::Scalar diff(excitations(i) - a);
+    utils::Scalar t(tanh(0.1 * diff));
+    utils::Scalar f(0.5 * t);
+    utils::Scalar denomActivation(m_torqueActivation(i) * (0.5 + 1.5 * a));
+    utils::Scalar denomDeactivation(m_torqueDeactivation(i) / (0.5 + 1.5 * a));
+    utils::Scalar rate(
+        (f + 0.5) / denomActivation + (0.5 - f) / denomDeactivation);
+    activationsDot(i) = rate * diff;
+    if (derivatives) {
+      (*derivatives)(i) =
+          rate + 0.05 * (1 - t * t) *
+                     (1 / denomActivation - 1 / denomDeactivation) * diff;
+    }
+  }
+}
+
+#ifndef BIORBD_USE_CASADI_MATH
+void internal_forces::muscles::MuscleParameterSet::evaluateCurveTable(
+    const internal_forces::muscles::MuscleCurveTable& table,
+    const std::vector<size_t>& indices,
+    const utils::Vector& x,
+    const utils::Vector& normalization,
+    utils::Vector* values,
+    utils::Vector* derivatives) const {
+  for (size_t k = 0; k < indices.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(indices[k]));
+    if (derivatives) {
+      double derivative;
+      double value(table.value(x(i) / normalization(i), derivative));
+      (*derivatives)(i) = derivative / normalization(i);
+      if (values) {
+        (*values)(i) = value;
+      }
+    } else {
+      (*values)(i) = table.value(x(i) / normalization(i));
+    }
+  }
+}
+#endif
@@ -1,26 +1,51 @@
 #define BIORBD_API_EXPORTS
 #include "InternalForces/Muscles/Muscles.h"
 
+#include <algorithm>
+
 #include "InternalForces/Muscles/Muscle.h"
+#include "InternalForces/Muscles/MuscleCurveTable.h"
 #include "InternalForces/Muscles/MuscleGroup.h"
+#include "InternalForces/Muscles/MuscleLengthSurrogate.h"
+#include "InternalForces/Muscles/MuscleParameterSet.h"
+#include "InternalForces/Muscles/State.h"
 #include "InternalForces/Muscles/StateDynamics.h"
+#include "InternalForces/PathKinematics.h"
+#include "InternalForces/PathModifiers.h"
 #include "RigidBody/GeneralizedCoordinates.h"
 #include "RigidBody/GeneralizedTorque.h"
 #include "RigidBody/GeneralizedVelocity.h"
 #include "RigidBody/Joints.h"
 #include "Utils/Error.h"
 #include "Utils/Matrix.h"
+#include "Utils/ThreadPool.h"
 
 using namespace BIORBD_NAMESPACE;
 
 internal_forces::muscles::Muscles::Muscles()
     : m_mus(
           std::make_shared<
-              std::vector<internal_forces::muscles::MuscleGroup>>()) {}
+              std::vector<internal_forces::muscles::MuscleGroup>>()),
+      m_muscleParameters(nullptr),
+      m_detachedMuscleParameters(nullptr),
+      m_musclePaths(nullptr),
+      m_musclePool(nullptr),
+      m_muscleList(
+          std::make_shared<
+              std::vector<std::shared_ptr<internal_forces::muscles::Muscle>>>()),
+      m_muscleChunks(std::make_shared<std::vector<std::vector<size_t>>>()),
+      m_lengthSurrogate(nullptr) {}
 
 internal_forces::muscles::Muscles::Muscles(
     const internal_forces::muscles::Muscles& other)
-    : m_mus(other.m_mus) {}
+    : m_mus(other.m_mus),
+      m_muscleParameters(other.m_muscleParameters),
+      m_detachedMuscleParameters(other.m_detachedMuscleParameters),
+      m_musclePaths(other.m_musclePaths),
+      m_musclePool(other.m_musclePool),
+      m_muscleList(other.m_muscleList),
+      m_muscleChunks(other.m_muscleChunks),
+      m_lengthSurrogate(other.m_lengthSurrogate) {}
 
 internal_forces::muscles::Muscles::~Muscles() {}
 
@@ -35,7 +60,31 @@ void internal_forces::muscles::Muscles::DeepCopy(
     const internal_forces::muscles::Muscles& other) {
   m_mus->resize(other.m_mus->size());
   for (size_t i = 0; i < other.m_mus->size(); ++i) {
-    (*m_mus)[i] = (*other.m_mus)[i];
+    (*m_mus)[i] = (*other.m_mus)[i].DeepCopy();
+  }
+  if (other.m_muscleParameters) {
+    compileMuscles();
+    if (other.m_muscleParameters->isCurveTablesUsed()) {
+      useMuscleCurveTables(
+          true,
+          other.m_muscleParameters->curveTable(HILL_THELEN, FORCE_LENGTH_ACTIVE)
+              .nbIntervals());
+    }
+  } else {
+    m_muscleParameters = nullptr;
+    m_musclePaths = nullptr;
+  }
+  m_detachedMuscleParameters = nullptr;
+  m_muscleList = std::make_shared<
+      std::vector<std::shared_ptr<internal_forces::muscles::Muscle>>>();
+  m_muscleChunks = std::make_shared<std::vector<std::vector<size_t>>>();
+  setMusclesNbThreads(other.musclesNbThreads());
+  if (other.m_lengthSurrogate) {
+    m_lengthSurrogate =
+        std::make_shared<internal_forces::muscles::MuscleLengthSurrogate>(
+            *other.m_lengthSurrogate);
+  } else {
+    m_lengthSurrogate = nullptr;
   }
 }
 
@@ -64,8 +113,8 @@ int internal_forces::muscles::Muscles::getMuscleGroupId(
 std::vector<std::shared_ptr<internal_forces::muscles::Muscle>>
 internal_forces::muscles::Muscles::muscles() const {
   std::vector<std::shared_ptr<internal_forces::muscles::Muscle>> m;
-  for (auto group : muscleGroups()) {
-    for (auto muscle : group.muscles()) {
+  for (const auto& group : *m_mus) {
+    for (const auto& muscle : group.muscles()) {
       m.push_back(muscle);
     }
   }
@@ -74,7 +123,7 @@ internal_forces::muscles::Muscles::muscles() const {
 
 internal_forces::muscles::Muscle& internal_forces::muscles::Muscles::muscle(
     size_t idx) const {
-  for (auto g : muscleGroups()) {
+  for (auto& g : *m_mus) {
     if (idx >= g.nbMuscles()) {
       idx -= g.nbMuscles();
     } else {
@@ -87,8 +136,8 @@ internal_forces::muscles::Muscle& internal_forces::muscles::Muscles::muscle(
 std::vector<utils::String> internal_forces::muscles::Muscles::muscleNames()
     const {
   std::vector<utils::String> names;
-  for (auto group : muscleGroups()) {
-    for (auto muscle : group.muscles()) {
+  for (const auto& group : *m_mus) {
+    for (const auto& muscle : group.muscles()) {
       names.push_back(muscle->name());
     }
   }
@@ -131,11 +180,58 @@ internal_forces::muscles::Muscles::muscleGroup(
 // From muscle activation (return muscle force)
 rigidbody::GeneralizedTorque
 internal_forces::muscles::Muscles::muscularJointTorque(const utils::Vector& F) {
+  utils::Vector tau;
+  muscularJointTorque(F, tau);
+  return rigidbody::GeneralizedTorque(tau);
+}
+
+void internal_forces::muscles::Muscles::muscularJointTorque(
+    const utils::Vector& F,
+    utils::Vector& tau) {
+  // The point table only visits the DoFs spanned by each muscle, the length
+  // jacobian is not copied
+  if (!m_musclePool && !m_lengthSurrogate && isMusclePathsFilled()) {
+    size_t nbDof(static_cast<size_t>(m_musclePaths->lengthJacobian().cols()));
+    if (static_cast<size_t>(tau.rows()) != nbDof) {
+      tau = utils::Vector(nbDof);
+    }
+    m_musclePaths->jointTorque(F, tau);
+    return;
+  }
+
   // Get the Jacobian matrix and get the forces of each muscle
   const utils::Matrix& jaco(musclesLengthJacobian());
+  if (tau.rows() != jaco.cols()) {
+    tau = utils::Vector(static_cast<size_t>(jaco.cols()));
+  }
+
+#ifndef BIORBD_USE_CASADI_MATH
+  if (m_musclePool) {
+    // Each task sums its own muscles, the partial sums are then reduced in
+    // a fixed order so the result does not depend on the scheduling
+    std::vector<utils::Vector> partialTorques(
+        m_musclePool->nbThreads(), utils::Vector::Zero(jaco.cols()));
+    runMuscleTasks([&](size_t chunk) {
+      const std::vector<size_t>& idx((*m_muscleChunks)[chunk]);
+      for (size_t i = 0; i < idx.size(); ++i) {
+        unsigned int row(static_cast<unsigned int>(idx[i]));
+        partialTorques[chunk] += jaco.row(row).transpose() * F(row);
+      }
+    });
+    tau.setZero();
+    for (size_t i = 0; i < partialTorques.size(); ++i) {
+      tau -= partialTorques[i];
+    }
+    return;
+  }
+#endif
 
   // Compute the reaction of the forces on the bodies
-  return rigidbody::GeneralizedTorque(-jaco.transpose() * F);
+#ifdef BIORBD_USE_CASADI_MATH
+  tau = -jaco.transpose() * F;
+#else
+  tau.noalias() = -(jaco.transpose() * F);
+#endif
 }
 
 // From Muscular Force
@@ -192,6 +288,94 @@ internal_forces::muscles::Muscles::muscularJointTorque(
   return muscularJointTorque(muscleForces(emg, Q, Qdot, updateKin));
 }
 
+// From muscle activation (return muscle force)
+rigidbody::GeneralizedTorque
+internal_forces::muscles::Muscles::muscularJointTorqueFromActivations(
+    const utils::Vector& activations) {
+  return muscularJointTorque(muscleForces(activations));
+}
+
+// From muscle activation (do not return muscle force)
+rigidbody::GeneralizedTorque
+internal_forces::muscles::Muscles::muscularJointTorqueFromActivations(
+    rigidbody::Joints& updatedModel,
+    const utils::Vector& activations,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    bool updateMuscleParameters) {
+  return muscularJointTorque(muscleForces(
+      updatedModel, activations, Q, Qdot, updateMuscleParameters));
+}
+
+// From muscle activation (do not return muscle force)
+rigidbody::GeneralizedTorque
+internal_forces::muscles::Muscles::muscularJointTorqueFromActivations(
+    const utils::Vector& activations,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    int updateKin) {
+  return muscularJointTorque(muscleForces(activations, Q, Qdot, updateKin));
+}
+
+void internal_forces::muscles::Muscles::muscleForcesDerivatives(
+    const utils::Vector& activations,
+    utils::Vector& dFdActivations,
+    utils::Vector& dFdLengths,
+    utils::Vector& dFdVelocities) {
+  size_t nbMus(nbMuscleTotal());
+  utils::Error::check(
+      static_cast<size_t>(activations.size()) == nbMus,
+      "Activations must be of size nbMuscleTotal");
+  if (static_cast<size_t>(dFdActivations.size()) != nbMus) {
+    dFdActivations = utils::Vector(nbMus);
+  }
+  if (static_cast<size_t>(dFdLengths.size()) != nbMus) {
+    dFdLengths = utils::Vector(nbMus);
+  }
+  if (static_cast<size_t>(dFdVelocities.size()) != nbMus) {
+    dFdVelocities = utils::Vector(nbMus);
+  }
+
+  internal_forces::muscles::MuscleParameterSet& parameters(
+      batchedMuscleParameters());
+  parameters.updateKinematics();
+  parameters.computeForceDerivatives(
+      activations, dFdActivations, dFdLengths, dFdVelocities);
+}
+
+utils::Matrix
+internal_forces::muscles::Muscles::muscularJointTorqueActivationsJacobian(
+    const utils::Vector& activations) {
+  utils::Vector dFdActivations;
+  utils::Vector dFdLengths;
+  utils::Vector dFdVelocities;
+  muscleForcesDerivatives(
+      activations, dFdActivations, dFdLengths, dFdVelocities);
+
+  // The moment arms do not depend on the activations
+  const utils::Matrix& jaco(musclesLengthJacobian());
+  unsigned int nbMus(static_cast<unsigned int>(jaco.rows()));
+  unsigned int nbDof(static_cast<unsigned int>(jaco.cols()));
+  utils::Matrix out(nbDof, nbMus);
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    for (unsigned int j = 0; j < nbDof; ++j) {
+      out(j, i) = -jaco(i, j) * dFdActivations(i);
+    }
+  }
+  return out;
+}
+
+utils::Matrix
+internal_forces::muscles::Muscles::muscularJointTorqueActivationsJacobian(
+    const utils::Vector& activations,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    int updateKin) {
+  // Update the muscular position
+  if (updateKin >= 1) updateMuscles(Q, Qdot, updateKin >= 2);
+  return muscularJointTorqueActivationsJacobian(activations);
+}
+
 utils::Vector internal_forces::muscles::Muscles::activationDot(
     const std::vector<std::shared_ptr<internal_forces::muscles::State>>& emg,
     bool areadyNormalized) {
@@ -214,6 +398,31 @@ utils::Vector internal_forces::muscles::Muscles::muscleForces(
   // Output variable
   utils::Vector forces(nbMuscleTotal());
 
+  if (m_muscleParameters) {
+    internal_forces::muscles::MuscleParameterSet& parameters(
+        muscleParameters());
+    utils::Vector activations(nbMuscleTotal());
+    for (size_t i = 0; i < emg.size(); ++i) {
+      activations(static_cast<unsigned int>(i)) = emg[i]->activation();
+    }
+    parameters.updateKinematics();
+    parameters.computeForces(activations, forces);
+    return forces;
+  }
+
+#ifndef BIORBD_USE_CASADI_MATH
+  if (m_musclePool) {
+    runMuscleTasks([&](size_t chunk) {
+      const std::vector<size_t>& idx((*m_muscleChunks)[chunk]);
+      for (size_t i = 0; i < idx.size(); ++i) {
+        forces(static_cast<unsigned int>(idx[i])) =
+            (*m_muscleList)[idx[i]]->force(*emg[idx[i]]);
+      }
+    });
+    return forces;
+  }
+#endif
+
   size_t cmpMus(0);
   for (size_t i = 0; i < m_mus->size(); ++i) {  // muscle group
     for (size_t j = 0; j < (*m_mus)[i].nbMuscles(); ++j) {
@@ -227,6 +436,116 @@ utils::Vector internal_forces::muscles::Muscles::muscleForces(
   return forces;
 }
 
+utils::Vector internal_forces::muscles::Muscles::activationDot(
+    const utils::Vector& excitations,
+    const utils::Vector& activations,
+    bool areadyNormalized) {
+  utils::Error::check(
+      static_cast<size_t>(excitations.size()) == nbMuscleTotal() &&
+          static_cast<size_t>(activations.size()) == nbMuscleTotal(),
+      "Excitations and activations must be of size nbMuscleTotal");
+  utils::Vector activationDot(nbMuscleTotal());
+
+  if (m_muscleParameters &&
+      muscleParameters()
+          .stateIndices(internal_forces::muscles::STATE_TYPE::BUCHANAN)
+          .empty()) {
+    muscleParameters().computeActivationsDot(
+        excitations, activations, activationDot, areadyNormalized);
+    return activationDot;
+  }
+
+  size_t cmp(0);
+  for (size_t i = 0; i < m_mus->size(); ++i) {
+    for (size_t j = 0; j < (*m_mus)[i].nbMuscles(); ++j) {
+      internal_forces::muscles::Muscle& muscle((*m_mus)[i].muscle(j));
+      std::shared_ptr<internal_forces::muscles::StateDynamics> state(
+          std::dynamic_pointer_cast<internal_forces::muscles::StateDynamics>(
+              muscle.m_state));
+      utils::Error::check(
+          state != nullptr,
+          "The muscle " + muscle.name() + " is not a dynamic muscle");
+      unsigned int idx(static_cast<unsigned int>(cmp));
+      activationDot(idx) = state->timeDerivativeActivation(
+          excitations(idx),
+          activations(idx),
+          muscle.characteristics(),
+          areadyNormalized);
+      ++cmp;
+    }
+  }
+
+  return activationDot;
+}
+
+utils::Vector internal_forces::muscles::Muscles::muscleForces(
+    const utils::Vector& activations) {
+  utils::Error::check(
+      static_cast<size_t>(activations.size()) == nbMuscleTotal(),
+      "Activations must be of size nbMuscleTotal");
+
+  // Output variable
+  utils::Vector forces(nbMuscleTotal());
+
+  if (m_muscleParameters) {
+    internal_forces::muscles::MuscleParameterSet& parameters(
+        muscleParameters());
+    parameters.updateKinematics();
+    parameters.computeForces(activations, forces);
+    return forces;
+  }
+
+#ifndef BIORBD_USE_CASADI_MATH
+  if (m_musclePool) {
+    runMuscleTasks([&](size_t chunk) {
+      // A state per task as only the activation is used
+      internal_forces::muscles::State state;
+      const std::vector<size_t>& idx((*m_muscleChunks)[chunk]);
+      for (size_t i = 0; i < idx.size(); ++i) {
+        unsigned int j(static_cast<unsigned int>(idx[i]));
+        state.setActivation(activations(j), true);
+        forces(j) = (*m_muscleList)[idx[i]]->force(state);
+      }
+    });
+    return forces;
+  }
+#endif
+
+  // A single state is shared by all the muscles as only the activation is used
+  internal_forces::muscles::State state;
+  size_t cmpMus(0);
+  for (size_t i = 0; i < m_mus->size(); ++i) {  // muscle group
+    for (size_t j = 0; j < (*m_mus)[i].nbMuscles(); ++j) {
+      unsigned int idx(static_cast<unsigned int>(cmpMus));
+      state.setActivation(activations(idx), true);
+      forces(idx, 0) = ((*m_mus)[i].muscle(j).force(state));
+      ++cmpMus;
+    }
+  }
+  return forces;
+}
+
+utils::Vector internal_forces::muscles::Muscles::muscleForces(
+    rigidbody::Joints& updatedModel,
+    const utils::Vector& activations,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    bool updateMuscleParameters) {
+  // Update the muscular position
+  if (updateMuscleParameters) updateMuscles(updatedModel, Q, Qdot);
+  return muscleForces(activations);
+}
+
+utils::Vector internal_forces::muscles::Muscles::muscleForces(
+    const utils::Vector& activations,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    int updateKin) {
+  // Update the muscular position
+  if (updateKin >= 1) updateMuscles(Q, Qdot, updateKin >= 2);
+  return muscleForces(activations);
+}
+
 utils::Vector internal_forces::muscles::Muscles::muscleForces(
     rigidbody::Joints& updatedModel,
     const std::vector<std::shared_ptr<internal_forces::muscles::State>>& emg,
@@ -248,11 +567,75 @@ utils::Vector internal_forces::muscles::Muscles::muscleForces(
   return muscleForces(emg);
 }
 
+void internal_forces::muscles::Muscles::compileMuscles() {
+  // The curve tables do not depend on the muscles, they are carried over
+  std::shared_ptr<internal_forces::muscles::MuscleParameterSet> previous(
+      m_muscleParameters);
+  m_muscleParameters =
+      std::make_shared<internal_forces::muscles::MuscleParameterSet>(
+          muscles());
+  if (previous && previous->isCurveTablesUsed()) {
+    m_muscleParameters->useCurveTables(
+        true,
+        previous->curveTable(HILL_THELEN, FORCE_LENGTH_ACTIVE).nbIntervals());
+  }
+
+  // The point table needs the model, it is filled at the next update
+  m_musclePaths = std::make_shared<internal_forces::PathKinematics>();
+  m_detachedMuscleParameters = nullptr;
+}
+
+bool internal_forces::muscles::Muscles::isMusclesCompiled() const {
+  return m_muscleParameters != nullptr;
+}
+
+internal_forces::muscles::MuscleParameterSet&
+internal_forces::muscles::Muscles::muscleParameters() {
+  utils::Error::check(
+      m_muscleParameters != nullptr,
+      "The muscles must be compiled first (see compileMuscles)");
+  // Muscles may have been added since the last compilation
+  if (m_muscleParameters->nbMuscles() != nbMuscles()) {
+    compileMuscles();
+  }
+  return *m_muscleParameters;
+}
+
+internal_forces::muscles::MuscleParameterSet&
+internal_forces::muscles::Muscles::batchedMuscleParameters() {
+  if (m_muscleParameters) {
+    return muscleParameters();
+  }
+
+  // Kept aside, so the muscles are still computed one by one elsewhere
+  if (!m_detachedMuscleParameters ||
+      m_detachedMuscleParameters->nbMuscles() != nbMuscles()) {
+    m_detachedMuscleParameters =
+        std::make_shared<internal_forces::muscles::MuscleParameterSet>(
+            muscles());
+  }
+  return *m_detachedMuscleParameters;
+}
+
+void internal_forces::muscles::Muscles::useMuscleCurveTables(
+    bool use,
+    size_t nbIntervals) {
+  muscleParameters().useCurveTables(use, nbIntervals);
+}
+
 size_t internal_forces::muscles::Muscles::nbMuscleGroups() const {
   return m_mus->size();
 }
 
 utils::Matrix internal_forces::muscles::Muscles::musclesLengthJacobian() {
+  // The surrogate or the point table already assembled the matrix
+  if (m_lengthSurrogate) {
+    return m_lengthSurrogate->lengthJacobian();
+  }
+  if (isMusclePathsFilled()) {
+    return m_musclePaths->lengthJacobian();
+  }
+
   // Assuming that this is also a Joints type (via BiorbdModel)
   const rigidbody::Joints& model = dynamic_cast<rigidbody::Joints&>(*this);
 
@@ -319,8 +702,29 @@ size_t internal_forces::muscles::Muscles::nbMuscles() const {
 void internal_forces::muscles::Muscles::updateMuscles(
     rigidbody::Joints& updatedModel,
     const rigidbody::GeneralizedCoordinates& Q) {
+  if (m_lengthSurrogate) {
+    updateMusclesFromSurrogate(Q, nullptr);
+    return;
+  }
+  if (m_musclePaths) {
+    updateMusclePaths(updatedModel, Q, nullptr);
+    return;
+  }
+
+#ifndef BIORBD_USE_CASADI_MATH
+  if (m_musclePool) {
+    runMuscleTasks([&](size_t chunk) {
+      const std::vector<size_t>& idx((*m_muscleChunks)[chunk]);
+      for (size_t i = 0; i < idx.size(); ++i) {
+        (*m_muscleList)[idx[i]]->updateOrientations(updatedModel, Q);
+      }
+    });
+    return;
+  }
+#endif
+
   // Update all the muscles
-  for (auto group : *m_mus) {  // muscle group
+  for (auto& group : *m_mus) {  // muscle group
     for (size_t j = 0; j < group.nbMuscles(); ++j) {
       group.muscle(j).updateOrientations(updatedModel, Q);
     }
@@ -330,6 +734,12 @@ void internal_forces::muscles::Muscles::updateMuscles(
 void internal_forces::muscles::Muscles::updateMuscles(
     const rigidbody::GeneralizedCoordinates& Q,
     bool updateKin) {
+  // The surrogate does not need the kinematics
+  if (m_lengthSurrogate) {
+    updateMusclesFromSurrogate(Q, nullptr);
+    return;
+  }
+
 #ifdef BIORBD_USE_CASADI_MATH
   if (!updateKin) {
     utils::Error::raise(
@@ -352,8 +762,29 @@ void internal_forces::muscles::Muscles::updateMuscles(
     rigidbody::Joints& updatedModel,
     const rigidbody::GeneralizedCoordinates& Q,
     const rigidbody::GeneralizedVelocity& Qdot) {
+  if (m_lengthSurrogate) {
+    updateMusclesFromSurrogate(Q, &Qdot);
+    return;
+  }
+  if (m_musclePaths) {
+    updateMusclePaths(updatedModel, Q, &Qdot);
+    return;
+  }
+
+#ifndef BIORBD_USE_CASADI_MATH
+  if (m_musclePool) {
+    runMuscleTasks([&](size_t chunk) {
+      const std::vector<size_t>& idx((*m_muscleChunks)[chunk]);
+      for (size_t i = 0; i < idx.size(); ++i) {
+        (*m_muscleList)[idx[i]]->updateOrientations(updatedModel, Q, Qdot);
+      }
+    });
+    return;
+  }
+#endif
+
   // Update all the muscles
-  for (auto group : *m_mus) {  // muscle group
+  for (auto& group : *m_mus) {  // muscle group
     for (size_t j = 0; j < group.nbMuscles(); ++j) {
       group.muscle(j).updateOrientations(updatedModel, Q, Qdot);
     }
@@ -364,6 +795,12 @@ void internal_forces::muscles::Muscles::updateMuscles(
     const rigidbody::GeneralizedCoordinates& Q,
     const rigidbody::GeneralizedVelocity& Qdot,
     bool updateKin) {
+  // The surrogate does not need the kinematics
+  if (m_lengthSurrogate) {
+    updateMusclesFromSurrogate(Q, &Qdot);
+    return;
+  }
+
 #ifdef BIORBD_USE_CASADI_MATH
   if (!updateKin) {
     utils::Error::raise(
@@ -388,12 +825,17 @@ void internal_forces::muscles::Muscles::updateMuscles(
     std::vector<utils::Matrix>& jacoPointsInGlobal,
     const rigidbody::GeneralizedVelocity& Qdot) {
   size_t cmpMuscle = 0;
-  for (auto group : *m_mus)  // muscle  group
+  for (auto& group : *m_mus)  // muscle  group
     for (size_t j = 0; j < group.nbMuscles(); ++j) {
       group.muscle(j).updateOrientations(
           musclePointsInGlobal[cmpMuscle], jacoPointsInGlobal[cmpMuscle], Qdot);
       ++cmpMuscle;
     }
+
+  // The point table is now outdated
+  if (m_musclePaths) {
+    m_musclePaths->clear();
+  }
 }
 
 std::vector<std::shared_ptr<internal_forces::muscles::State>>
@@ -405,15 +847,247 @@ internal_forces::muscles::Muscles::stateSet() {
   return out;
 }
 
+std::vector<std::shared_ptr<internal_forces::muscles::State>>
+internal_forces::muscles::Muscles::stateSet(
+    const utils::Vector& excitations,
+    const utils::Vector& activations) {
+  utils::Error::check(
+      static_cast<size_t>(excitations.size()) == nbMuscleTotal() &&
+          static_cast<size_t>(activations.size()) == nbMuscleTotal(),
+      "Excitations and activations must be of size nbMuscleTotal");
+
+  std::vector<std::shared_ptr<internal_forces::muscles::State>> out;
+  size_t cmp(0);
+  for (size_t i = 0; i < m_mus->size(); ++i) {
+    for (size_t j = 0; j < (*m_mus)[i].nbMuscles(); ++j) {
+      std::shared_ptr<internal_forces::muscles::State>& state(
+          (*m_mus)[i].muscle(j).m_state);
+      unsigned int idx(static_cast<unsigned int>(cmp));
+      state->setExcitation(excitations(idx));
+      state->setActivation(activations(idx));
+      out.push_back(state);
+      ++cmp;
+    }
+  }
+  return out;
+}
+
 void internal_forces::muscles::Muscles::updateMuscles(
     std::vector<std::vector<utils::Vector3d>>& musclePointsInGlobal,
     std::vector<utils::Matrix>& jacoPointsInGlobal) {
   // Updater all the muscles
   size_t cmpMuscle = 0;
-  for (auto group : *m_mus)  // muscle group
+  for (auto& group : *m_mus)  // muscle group
     for (size_t j = 0; j < group.nbMuscles(); ++j) {
       group.muscle(j).updateOrientations(
           musclePointsInGlobal[cmpMuscle], jacoPointsInGlobal[cmpMuscle]);
       ++cmpMuscle;
     }
+
+  // The point table is now outdated
+  if (m_musclePaths) {
+    m_musclePaths->clear();
+  }
+}
+
+bool internal_forces::muscles::Muscles::isMusclePathsFilled() const {
+  return m_musclePaths && m_musclePaths->nbPaths() != 0 &&
+         m_musclePaths->nbPaths() == nbMuscles();
+}
+
+void internal_forces::muscles::Muscles::updateMusclePaths(
+    rigidbody::Joints& updatedModel,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity* Qdot) {
+  internal_forces::PathKinematics& paths(*m_musclePaths);
+
+  // Build the point table at the first update (or if muscles were added)
+  if (!isMusclePathsFilled()) {
+    paths.clear();
+    for (auto& group : *m_mus) {
+      for (size_t j = 0; j < group.nbMuscles(); ++j) {
+        internal_forces::muscles::Muscle& muscle(group.muscle(j));
+        paths.addPath(
+            updatedModel,
+            muscle.position().originInLocal(),
+            muscle.position().insertionInLocal(),
+            muscle.pathModifier());
+      }
+    }
+  }
+
+  // Positions and Jacobians of all the points in one sweep
+  paths.update(updatedModel, Q);
+
+  auto updateMuscle = [&](size_t idx,
+                          internal_forces::muscles::Muscle& muscle) {
+    if (paths.isBatched(idx)) {
+      // The length and its jacobian are read from the table
+      if (Qdot) {
+        muscle.updateOrientations(
+            paths.pointsInGlobal(idx),
+            paths.pointsJacobian(idx),
+            paths.lengths(),
+            paths.lengthJacobian(),
+            idx,
+            *Qdot);
+      } else {
+        muscle.updateOrientations(
+            paths.pointsInGlobal(idx),
+            paths.pointsJacobian(idx),
+            paths.lengths(),
+            paths.lengthJacobian(),
+            idx);
+      }
+    } else {
+      // Wrapping muscles are computed on their own
+      if (Qdot) {
+        muscle.updateOrientations(updatedModel, Q, *Qdot);
+      } else {
+        muscle.updateOrientations(updatedModel, Q);
+      }
+      paths.lengthJacobian().block(
+          static_cast<unsigned int>(idx),
+          0,
+          1,
+          static_cast<unsigned int>(updatedModel.dof_count)) =
+          muscle.position().jacobianLength();
+    }
+  };
+
+#ifndef BIORBD_USE_CASADI_MATH
+  if (m_musclePool) {
+    runMuscleTasks([&](size_t chunk) {
+      const std::vector<size_t>& idx((*m_muscleChunks)[chunk]);
+      for (size_t i = 0; i < idx.size(); ++i) {
+        updateMuscle(idx[i], *(*m_muscleList)[idx[i]]);
+      }
+    });
+    return;
+  }
+#endif
+
+  size_t cmpMuscle(0);
+  for (auto& group : *m_mus) {  // muscle group
+    for (size_t j = 0; j < group.nbMuscles(); ++j) {
+      updateMuscle(cmpMuscle++, group.muscle(j));
+    }
+  }
+}
+
+void internal_forces::muscles::Muscles::updateMusclesFromSurrogate(
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity* Qdot) {
+  internal_forces::muscles::MuscleLengthSurrogate& surrogate(
+      *m_lengthSurrogate);
+  surrogate.update(Q);
+  const utils::Vector& lengths(surrogate.lengths());
+  const utils::Matrix& jacobian(surrogate.lengthJacobian());
+
+  size_t cmpMuscle(0);
+  for (auto& group : *m_mus) {  // muscle group
+    for (size_t j = 0; j < group.nbMuscles(); ++j) {
+      if (Qdot) {
+        group.muscle(j).updateOrientations(
+            lengths, jacobian, cmpMuscle++, *Qdot);
+      } else {
+        group.muscle(j).updateOrientations(lengths, jacobian, cmpMuscle++);
+      }
+    }
+  }
+}
+
+void internal_forces::muscles::Muscles::setMusclesNbThreads(size_t nbThreads) {
+  if (nbThreads <= 1) {
+    m_musclePool = nullptr;
+    m_muscleList->clear();
+    m_muscleChunks->clear();
+    return;
+  }
+#ifdef BIORBD_USE_CASADI_MATH
+  utils::Error::raise("Multithreaded muscles are not available with CasADi");
+#else
+  m_musclePool = std::make_shared<utils::ThreadPool>(nbThreads);
+  partitionMuscles();
+#endif
+}
+
+size_t internal_forces::muscles::Muscles::musclesNbThreads() const {
+  return m_musclePool ? m_musclePool->nbThreads() : 1;
+}
+
+void internal_forces::muscles::Muscles::setMuscleLengthSurrogate(
+    const std::shared_ptr<internal_forces::muscles::MuscleLengthSurrogate>&
+        surrogate) {
+  if (surrogate) {
+    utils::Error::check(
+        surrogate->nbMuscles() == nbMuscles(),
+        "The surrogate must approximate all the muscles");
+    for (size_t i = 0; i < nbMuscles(); ++i) {
+      utils::Error::check(
+          surrogate->muscleName(i) == muscle(i).name(),
+          "The muscles of the surrogate must be the muscles of the model");
+    }
+    const rigidbody::Joints* model(dynamic_cast<rigidbody::Joints*>(this));
+    utils::Error::check(
+        !model || surrogate->nbDof() == model->nbDof(),
+        "The surrogate must be fitted on the degrees of freedom of the model");
+  }
+  m_lengthSurrogate = surrogate;
+}
+
+bool internal_forces::muscles::Muscles::isMuscleLengthSurrogateUsed() const {
+  return m_lengthSurrogate != nullptr;
+}
+
+internal_forces::muscles::MuscleLengthSurrogate&
+internal_forces::muscles::Muscles::muscleLengthSurrogate() {
+  utils::Error::check(
+      m_lengthSurrogate != nullptr,
+      "No surrogate of the muscle lengths is set");
+  return *m_lengthSurrogate;
+}
+
+void internal_forces::muscles::Muscles::partitionMuscles() {
+  *m_muscleList = muscles();
+  const std::vector<std::shared_ptr<internal_forces::muscles::Muscle>>&
+      list(*m_muscleList);
+
+  // Rough cost of a muscle update: wrapping is much heavier than a point
+  std::vector<size_t> cost(list.size());
+  for (size_t i = 0; i < list.size(); ++i) {
+    const internal_forces::PathModifiers& modifiers(list[i]->pathModifier());
+    cost[i] = modifiers.nbWraps() != 0 ? 10 * modifiers.nbWraps()
+                                       : 2 + modifiers.nbVia();
+  }
+
+  // Longest muscles first, each one given to the least loaded task
+  std::vector<size_t> order(list.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return cost[a] > cost[b];
+  });
+  size_t nbChunks(m_musclePool->nbThreads());
+  std::vector<size_t> load(nbChunks, 0);
+  m_muscleChunks->assign(nbChunks, std::vector<size_t>());
+  for (size_t i = 0; i < order.size(); ++i) {
+    size_t chunk(static_cast<size_t>(
+        std::min_element(load.begin(), load.end()) - load.begin()));
+    (*m_muscleChunks)[chunk].push_back(order[i]);
+    load[chunk] += cost[order[i]];
+  }
+  for (size_t i = 0; i < nbChunks; ++i) {
+    std::sort((*m_muscleChunks)[i].begin(), (*m_muscleChunks)[i].end());
+  }
+}
+
+void internal_forces::muscles::Muscles::runMuscleTasks(
+    const std::function<void(size_t)>& task) {
+  // Muscles may have been added since the last partition
+  if (m_muscleList->size() != nbMuscles()) {
+    partitionMuscles();
+  }
+  m_musclePool->run(m_muscleChunks->size(), task);
 }
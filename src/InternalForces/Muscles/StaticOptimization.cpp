@@ -3,6 +3,14 @@
 #include "InternalForces/Muscles/StaticOptimization.h"
 
 #include <IpIpoptApplication.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#if IPOPT_VERSION_MAJOR > 3 || \
+    (IPOPT_VERSION_MAJOR == 3 && IPOPT_VERSION_MINOR >= 14)
+#include <IpLinearSolvers.h>
+#endif
 
 #include "BiorbdModel.h"
 #include "InternalForces/Muscles/StateDynamics.h"
@@ -11,6 +19,8 @@
 #include "RigidBody/GeneralizedTorque.h"
 #include "RigidBody/GeneralizedVelocity.h"
 #include "Utils/Error.h"
+#include "Utils/Matrix.h"
+#include "Utils/ThreadPool.h"
 #include "Utils/Vector.h"
 
 using namespace BIORBD_NAMESPACE;
@@ -31,8 +41,11 @@ internal_forces::muscles::StaticOptimization::StaticOptimization(
           std::make_shared<utils::Vector>(m_model.nbMuscles())),
       m_pNormFactor(pNormFactor),
       m_verbose(verbose),
-      m_staticOptimProblem(),
-      m_alreadyRun(false) {
+      m_solutions(std::make_shared<utils::Matrix>()),
+      m_alreadyRun(false),
+      m_isSolverSerialized(false),
+      m_nbSolving(std::make_shared<std::atomic<size_t>>(0)),
+      m_maxConcurrentSolves(std::make_shared<std::atomic<size_t>>(0)) {
   m_allQ.push_back(Q);
   m_allQdot.push_back(Qdot);
   m_allTorqueTarget.push_back(torqueTarget);
@@ -56,8 +69,11 @@ internal_forces::muscles::StaticOptimization::StaticOptimization(
           std::make_shared<utils::Vector>(m_model.nbMuscles())),
       m_pNormFactor(pNormFactor),
       m_verbose(verbose),
-      m_staticOptimProblem(),
-      m_alreadyRun(false) {
+      m_solutions(std::make_shared<utils::Matrix>()),
+      m_alreadyRun(false),
+      m_isSolverSerialized(false),
+      m_nbSolving(std::make_shared<std::atomic<size_t>>(0)),
+      m_maxConcurrentSolves(std::make_shared<std::atomic<size_t>>(0)) {
   m_allQ.push_back(Q);
   m_allQdot.push_back(Qdot);
   m_allTorqueTarget.push_back(torqueTarget);
@@ -86,7 +102,11 @@ internal_forces::muscles::StaticOptimization::StaticOptimization(
           std::make_shared<utils::Vector>(m_model.nbMuscles())),
       m_pNormFactor(pNormFactor),
       m_verbose(verbose),
-      m_alreadyRun(false) {
+      m_solutions(std::make_shared<utils::Matrix>()),
+      m_alreadyRun(false),
+      m_isSolverSerialized(false),
+      m_nbSolving(std::make_shared<std::atomic<size_t>>(0)),
+      m_maxConcurrentSolves(std::make_shared<std::atomic<size_t>>(0)) {
   m_allQ.push_back(Q);
   m_allQdot.push_back(Qdot);
   m_allTorqueTarget.push_back(torqueTarget);
@@ -122,7 +142,11 @@ internal_forces::muscles::StaticOptimization::StaticOptimization(
           std::make_shared<utils::Vector>(m_model.nbMuscles())),
       m_pNormFactor(pNormFactor),
       m_verbose(verbose),
-      m_alreadyRun(false) {
+      m_solutions(std::make_shared<utils::Matrix>()),
+      m_alreadyRun(false),
+      m_isSolverSerialized(false),
+      m_nbSolving(std::make_shared<std::atomic<size_t>>(0)),
+      m_maxConcurrentSolves(std::make_shared<std::atomic<size_t>>(0)) {
   for (unsigned int i = 0; i < m_model.nbMuscles(); ++i) {
     (*m_initialActivationGuess)[i] = initialActivationGuess;
   }
@@ -146,7 +170,11 @@ internal_forces::muscles::StaticOptimization::StaticOptimization(
           std::make_shared<utils::Vector>(m_model.nbMuscles())),
       m_pNormFactor(pNormFactor),
       m_verbose(verbose),
-      m_alreadyRun(false) {
+      m_solutions(std::make_shared<utils::Matrix>()),
+      m_alreadyRun(false),
+      m_isSolverSerialized(false),
+      m_nbSolving(std::make_shared<std::atomic<size_t>>(0)),
+      m_maxConcurrentSolves(std::make_shared<std::atomic<size_t>>(0)) {
   if (initialActivationGuess.size() != m_model.nbMuscles()) {
     utils::Error::raise(
         "Initial guess must either be a single value or a vector "
@@ -174,7 +202,11 @@ internal_forces::muscles::StaticOptimization::StaticOptimization(
           std::make_shared<utils::Vector>(m_model.nbMuscles())),
       m_pNormFactor(pNormFactor),
       m_verbose(verbose),
-      m_alreadyRun(false) {
+      m_solutions(std::make_shared<utils::Matrix>()),
+      m_alreadyRun(false),
+      m_isSolverSerialized(false),
+      m_nbSolving(std::make_shared<std::atomic<size_t>>(0)),
+      m_maxConcurrentSolves(std::make_shared<std::atomic<size_t>>(0)) {
   if (initialActivationGuess.size() != m_model.nbMuscles()) {
     utils::Error::raise(
         "Initial guess must either be a single value or a vector "
@@ -188,15 +220,37 @@ internal_forces::muscles::StaticOptimization::StaticOptimization(
   }
 }
 
-void internal_forces::muscles::StaticOptimization::run(
-    bool useLinearizedState) {
-  // Setup the Ipopt problem
+// Serialize the solves of the linear solvers that are not reentrant (MUMPS)
+static std::mutex& nonReentrantSolverMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// A reentrant linear solver available to Ipopt (empty if there is none)
+static std::string reentrantLinearSolver() {
+#if IPOPT_VERSION_MAJOR > 3 || \
+    (IPOPT_VERSION_MAJOR == 3 && IPOPT_VERSION_MINOR >= 14)
+  IpoptLinearSolver available(IpoptGetAvailableLinearSolvers(false));
+  if (available & IPOPTLINEARSOLVER_MA57) {
+    return "ma57";
+  }
+  if (available & IPOPTLINEARSOLVER_MA27) {
+    return "ma27";
+  }
+  if (available & IPOPTLINEARSOLVER_SPRAL) {
+    return "spral";
+  }
+#endif
+  return "";
+}
+
+// Setup an Ipopt application
+static Ipopt::SmartPtr<Ipopt::IpoptApplication> createIpoptApplication() {
   Ipopt::SmartPtr<Ipopt::IpoptApplication> app = IpoptApplicationFactory();
   app->Options()->SetNumericValue("tol", 1e-7);
   app->Options()->SetStringValue("mu_strategy", "adaptive");
   // app->Options()->SetStringValue("output_file", "ipopt.out");
-  app->Options()->SetStringValue("hessian_approximation", "limited-memory");
-  app->Options()->SetStringValue("derivative_test", "first-order");
+  app->Options()->SetStringValue("hessian_approximation", "exact");
   app->Options()->SetIntegerValue("max_iter", 10000);
   app->Options()->SetIntegerValue("print_level", 5);
 
@@ -204,41 +258,151 @@ void internal_forces::muscles::StaticOptimization::run(
   status = app->Initialize();
   utils::Error::check(
       status == Ipopt::Solve_Succeeded, "Ipopt initialization failed");
+  return app;
+}
+
+void internal_forces::muscles::StaticOptimization::run(
+    bool useLinearizedState) {
+  Ipopt::SmartPtr<Ipopt::IpoptApplication> app(createIpoptApplication());
+  *m_solutions = utils::Matrix(m_model.nbMuscles(), m_allQ.size());
+  m_isSolverSerialized = false;
+  *m_maxConcurrentSolves = 0;
+
+  // Take the solution of each optimization as the initial guess of the next
+  solveFrames(
+      m_model,
+      *app,
+      0,
+      m_allQ.size(),
+      *m_initialActivationGuess,
+      useLinearizedState,
+      false);
+  m_alreadyRun = true;
+}
+
+void internal_forces::muscles::StaticOptimization::runParallel(
+    size_t nbThreads,
+    bool useLinearizedState,
+    size_t chunkSize) {
+  size_t nbFrames(m_allQ.size());
+  *m_solutions = utils::Matrix(m_model.nbMuscles(), nbFrames);
+  utils::ThreadPool pool(nbThreads);
+  size_t nbTasks(std::max<size_t>(1, std::min(pool.nbThreads(), nbFrames)));
+  if (chunkSize == 0) {
+    chunkSize = std::max<size_t>(1, (nbFrames + nbTasks - 1) / nbTasks);
+  }
+  size_t nbChunks((nbFrames + chunkSize - 1) / chunkSize);
+  nbTasks = std::max<size_t>(1, std::min(nbTasks, nbChunks));
+
+  // MUMPS, the default linear solver of Ipopt, is not reentrant. Unless it
+  // was explicitly asked for (e.g. in an ipopt.opt file), a reentrant solver
+  // replaces it so the frames are really solved concurrently
+  std::string linearSolver;
+  m_isSolverSerialized = false;
+  if (nbTasks > 1) {
+    bool isUserSolver(createIpoptApplication()->Options()->GetStringValue(
+        "linear_solver", linearSolver, ""));
+    if (!isUserSolver) {
+      linearSolver = reentrantLinearSolver();
+    }
+    m_isSolverSerialized = linearSolver.empty() || linearSolver == "mumps";
+    utils::Error::warning(
+        !m_isSolverSerialized,
+        "The linear solver of Ipopt is MUMPS, which is not reentrant (no "
+        "ma57, ma27 or spral is available), so the solves of runParallel are "
+        "serialized between the threads");
+  }
+  *m_maxConcurrentSolves = 0;
+
+  // Each task owns a deep copy of the model and an application, and solves
+  // every nbTasks-th chunk
+  pool.run(nbTasks, [&](size_t task) {
+    Model model(m_model.DeepCopy());
+    Ipopt::SmartPtr<Ipopt::IpoptApplication> app(createIpoptApplication());
+    if (!m_isSolverSerialized && !linearSolver.empty()) {
+      app->Options()->SetStringValue("linear_solver", linearSolver);
+    }
+    for (size_t chunk = task; chunk < nbChunks; chunk += nbTasks) {
+      utils::Vector activationGuess(*m_initialActivationGuess);
+      solveFrames(
+          model,
+          *app,
+          chunk * chunkSize,
+          std::min(nbFrames, (chunk + 1) * chunkSize),
+          activationGuess,
+          useLinearizedState,
+          m_isSolverSerialized);
+    }
+  });
+  m_alreadyRun = true;
+}
 
-  for (unsigned int i = 0; i < m_allQ.size(); ++i) {
+void internal_forces::muscles::StaticOptimization::solveFrames(
+    Model& model,
+    Ipopt::IpoptApplication& app,
+    size_t first,
+    size_t last,
+    utils::Vector& activationGuess,
+    bool useLinearizedState,
+    bool isSolverSerialized) {
+  for (size_t i = first; i < last; ++i) {
+    Ipopt::SmartPtr<Ipopt::TNLP> problem;
     if (useLinearizedState)
-      m_staticOptimProblem.push_back(
-          new internal_forces::muscles::StaticOptimizationIpoptLinearized(
-              m_model,
-              m_allQ[i],
-              m_allQdot[i],
-              m_allTorqueTarget[i],
-              *m_initialActivationGuess,
-              m_useResidualTorque,
-              m_pNormFactor,
-              m_verbose));
+      problem = new internal_forces::muscles::StaticOptimizationIpoptLinearized(
+          model,
+          m_allQ[i],
+          m_allQdot[i],
+          m_allTorqueTarget[i],
+          activationGuess,
+          m_useResidualTorque,
+          m_pNormFactor,
+          m_verbose);
     else
-      m_staticOptimProblem.push_back(
-          new internal_forces::muscles::StaticOptimizationIpopt(
-              m_model,
-              m_allQ[i],
-              m_allQdot[i],
-              m_allTorqueTarget[i],
-              *m_initialActivationGuess,
-              m_useResidualTorque,
-              m_pNormFactor,
-              m_verbose));
+      problem = new internal_forces::muscles::StaticOptimizationIpopt(
+          model,
+          m_allQ[i],
+          m_allQdot[i],
+          m_allTorqueTarget[i],
+          activationGuess,
+          m_useResidualTorque,
+          m_pNormFactor,
+          m_verbose);
     // Optimize!
-    status = app->OptimizeTNLP(m_staticOptimProblem[i]);
+    if (isSolverSerialized) {
+      std::lock_guard<std::mutex> lock(nonReentrantSolverMutex());
+      optimize(app, problem);
+    } else {
+      optimize(app, problem);
+    }
 
-    // Take the solution of the previous optimization as the solution for the
-    // next optimization
-    *m_initialActivationGuess =
+    // Only the solution is kept, the problem is released
+    activationGuess =
         static_cast<internal_forces::muscles::StaticOptimizationIpopt*>(
-            Ipopt::GetRawPtr(m_staticOptimProblem[i]))
+            Ipopt::GetRawPtr(problem))
             ->finalSolution();
+    m_solutions->col(static_cast<unsigned int>(i)) = activationGuess;
   }
-  m_alreadyRun = true;
+}
+
+void internal_forces::muscles::StaticOptimization::optimize(
+    Ipopt::IpoptApplication& app,
+    const Ipopt::SmartPtr<Ipopt::TNLP>& problem) {
+  size_t nbSolving(++*m_nbSolving);
+  size_t maxSolving(*m_maxConcurrentSolves);
+  while (nbSolving > maxSolving &&
+         !m_maxConcurrentSolves->compare_exchange_weak(maxSolving, nbSolving)) {
+  }
+  app.OptimizeTNLP(problem);
+  --*m_nbSolving;
+}
+
+bool internal_forces::muscles::StaticOptimization::isSolverSerialized() const {
+  return m_isSolverSerialized;
+}
+
+size_t internal_forces::muscles::StaticOptimization::maxConcurrentSolves()
+    const {
+  return *m_maxConcurrentSolves;
 }
 
 std::vector<utils::Vector>
@@ -251,10 +415,7 @@ internal_forces::muscles::StaticOptimization::finalSolution() {
         "the optimized solution");
   } else {
     for (unsigned int i = 0; i < m_allQ.size(); ++i) {
-      res.push_back(
-          static_cast<internal_forces::muscles::StaticOptimizationIpopt*>(
-              Ipopt::GetRawPtr(m_staticOptimProblem[i]))
-              ->finalSolution());
+      res.push_back(m_solutions->col(i));
     }
   }
 
@@ -270,9 +431,18 @@ utils::Vector internal_forces::muscles::StaticOptimization::finalSolution(
         "yet, you should optimize it first to get "
         "the optimized solution");
   } else {
-    res = static_cast<internal_forces::muscles::StaticOptimizationIpopt*>(
-              Ipopt::GetRawPtr(m_staticOptimProblem[index]))
-              ->finalSolution();
+    res = m_solutions->col(index);
   }
   return res;
 }
+
+const utils::Matrix&
+internal_forces::muscles::StaticOptimization::finalSolutionMatrix() const {
+  if (!m_alreadyRun) {
+    utils::Error::raise(
+        "Problem has not been ran through the optimization process "
+        "yet, you should optimize it first to get "
+        "the optimized solution");
+  }
+  return *m_solutions;
+}
@@ -1,10 +1,11 @@
 #define BIORBD_API_EXPORTS
 #include "InternalForces/Muscles/StaticOptimizationIpopt.h"
 
-#include <iomanip>
+#include <cmath>
 #include <iostream>
 
 #include "BiorbdModel.h"
+#include "InternalForces/Muscles/MuscleParameterSet.h"
 #include "InternalForces/Muscles/StateDynamics.h"
 #include "RigidBody/GeneralizedCoordinates.h"
 #include "RigidBody/GeneralizedTorque.h"
@@ -34,6 +35,7 @@ internal_forces::muscles::StaticOptimizationIpopt::StaticOptimizationIpopt(
       m_nbTorque(std::make_shared<unsigned int>(model.nbGeneralizedTorque())),
       m_nbTorqueResidual(std::make_shared<unsigned int>(*m_nbQ)),
       m_eps(std::make_shared<double>(eps)),
+      m_lengthJacobian(std::make_shared<utils::Matrix>()),
       m_activations(std::make_shared<utils::Vector>(activationInit)),
       m_Q(std::make_shared<rigidbody::GeneralizedCoordinates>(Q)),
       m_Qdot(std::make_shared<rigidbody::GeneralizedVelocity>(Qdot)),
@@ -60,7 +62,9 @@ internal_forces::muscles::StaticOptimizationIpopt::StaticOptimizationIpopt(
     s = std::make_shared<internal_forces::muscles::State>();
   }
 
+  // The moment arms do not depend on the activations, they are computed once
   m_model.updateMuscles(*m_Q, *m_Qdot, true);
+  *m_lengthJacobian = m_model.musclesLengthJacobian();
   if (!useResidual) {
     m_torqueResidual->setZero();
     *m_nbTorqueResidual = 0;
@@ -89,7 +93,7 @@ bool internal_forces::muscles::StaticOptimizationIpopt::get_nlp_info(
   } else {
     nnz_jac_g = static_cast<int>(*m_nbMus) * static_cast<int>(*m_nbTorque);
   }
-  nnz_h_lag = static_cast<int>(*m_nbTorque) * static_cast<int>(*m_nbTorque);
+  nnz_h_lag = n;
 
   if (*m_verbose >= 2) {
     std::cout << "n: " << n << std::endl;
@@ -190,14 +194,14 @@ bool internal_forces::muscles::StaticOptimizationIpopt::eval_grad_f(
     dispatch(x);
   }
 
-  utils::Vector grad_activ(m_activations->normGradient(*m_pNormFactor, true));
-  utils::Vector grad_residual(m_torqueResidual->normGradient(2, true));
-
+  // d(sum |a|^p) / da = p * a * |a|^(p - 2)
+  double p(static_cast<double>(*m_pNormFactor));
   for (unsigned i = 0; i < *m_nbMus; i++) {
-    grad_f[i] = grad_activ[i];
+    double a((*m_activations)[i]);
+    grad_f[i] = p * a * std::pow(std::fabs(a), p - 2);
   }
   for (unsigned int i = 0; i < *m_nbTorqueResidual; i++) {
-    grad_f[i + *m_nbMus] = *m_torquePonderation * grad_residual[i];
+    grad_f[i + *m_nbMus] = *m_torquePonderation * 2 * (*m_torqueResidual)[i];
   }
   return true;
 }
@@ -258,37 +262,15 @@ bool internal_forces::muscles::StaticOptimizationIpopt::eval_jac_g(
     if (new_x) {
       dispatch(x);
     }
-    const rigidbody::GeneralizedTorque &GeneralizedTorqueMusc(
-        m_model.muscularJointTorque(*m_states));
+    // dTau / da = -J^T * diag(dF / da)
+    utils::Vector dFda;
+    utils::Vector dFdl;
+    utils::Vector dFdv;
+    m_model.muscleForcesDerivatives(*m_activations, dFda, dFdl, dFdv);
     unsigned int k(0);
     for (unsigned int j = 0; j < *m_nbMus; ++j) {
-      std::vector<std::shared_ptr<internal_forces::muscles::State>>
-          stateEpsilon;
-      for (unsigned int i = 0; i < *m_nbMus; ++i) {
-        unsigned int delta(0);
-        if (i == j) {
-          delta = 1;
-        }
-        stateEpsilon.push_back(
-            std::make_shared<internal_forces::muscles::State>(
-                internal_forces::muscles::State(
-                    0, (*m_activations)[i] + delta * *m_eps)));
-      }
-      const rigidbody::GeneralizedTorque &GeneralizedTorqueCalculEpsilon(
-          m_model.muscularJointTorque(stateEpsilon));
       for (unsigned int i = 0; i < static_cast<unsigned int>(m); i++) {
-        values[k++] =
-            (GeneralizedTorqueCalculEpsilon[i] - GeneralizedTorqueMusc[i]) /
-            *m_eps;
-        if (*m_verbose >= 3) {
-          std::cout << std::setprecision(20) << std::endl;
-          std::cout << "values[" << k - 1 << "]: " << values[k - 1]
-                    << std::endl;
-          std::cout << "GeneralizedTorqueCalculEpsilon[" << i
-                    << "]: " << GeneralizedTorqueCalculEpsilon[i] << std::endl;
-          std::cout << "GeneralizedTorqueMusc[" << i
-                    << "]: " << GeneralizedTorqueMusc[i] << std::endl;
-        }
+        values[k++] = -(*m_lengthJacobian)(j, i) * dFda[j];
       }
     }
     for (unsigned int j = 0; j < *m_nbTorqueResidual; j++) {
@@ -312,6 +294,44 @@ bool internal_forces::muscles::StaticOptimizationIpopt::eval_jac_g(
   return true;
 }
 
+bool internal_forces::muscles::StaticOptimizationIpopt::eval_h(
+    Ipopt::Index n,
+    const Ipopt::Number *x,
+    bool new_x,
+    Ipopt::Number obj_factor,
+    Ipopt::Index,
+    const Ipopt::Number *lambda,
+    bool,
+    Ipopt::Index,
+    Ipopt::Index *iRow,
+    Ipopt::Index *jCol,
+    Ipopt::Number *values) {
+  assert(static_cast<unsigned int>(n) == *m_nbMus + *m_nbTorqueResidual);
+  if (values == nullptr) {
+    for (Ipopt::Index i = 0; i < n; ++i) {
+      iRow[i] = i;
+      jCol[i] = i;
+    }
+    return true;
+  }
+
+  if (new_x) {
+    dispatch(x);
+  }
+
+  // d2(sum |a|^p) / da2 = p * (p - 1) * |a|^(p - 2)
+  double p(static_cast<double>(*m_pNormFactor));
+  for (unsigned int i = 0; i < *m_nbMus; ++i) {
+    values[i] = obj_factor * p * (p - 1) *
+                std::pow(std::fabs((*m_activations)[i]), p - 2);
+  }
+  for (unsigned int i = 0; i < *m_nbTorqueResidual; ++i) {
+    values[i + *m_nbMus] = obj_factor * *m_torquePonderation * 2;
+  }
+  addConstraintsHessian(lambda, values);
+  return true;
+}
+
 void internal_forces::muscles::StaticOptimizationIpopt::finalize_solution(
     Ipopt::SolverReturn,
     Ipopt::Index,
@@ -361,6 +381,24 @@ utils::Vector internal_forces::muscles::StaticOptimizationIpopt::finalResidual()
   return *m_finalResidual;
 }
 
+void internal_forces::muscles::StaticOptimizationIpopt::addConstraintsHessian(
+    const Ipopt::Number *lambda,
+    Ipopt::Number *values) {
+  // d2Tau / da2 = -J^T * diag(d2F / da2), the residuals are linear
+  internal_forces::muscles::MuscleParameterSet &parameters(
+      m_model.batchedMuscleParameters());
+  utils::Vector d2Fda2(*m_nbMus);
+  parameters.updateKinematics();
+  parameters.computeForceActivationSecondDerivatives(*m_activations, d2Fda2);
+  for (unsigned int j = 0; j < *m_nbMus; ++j) {
+    double curvature(0);
+    for (unsigned int i = 0; i < *m_nbTorque; ++i) {
+      curvature -= lambda[i] * (*m_lengthJacobian)(j, i);
+    }
+    values[j] += curvature * d2Fda2[j];
+  }
+}
+
 void internal_forces::muscles::StaticOptimizationIpopt::dispatch(
     const Ipopt::Number *x) {
   for (unsigned int i = 0; i < *m_nbMus; i++) {
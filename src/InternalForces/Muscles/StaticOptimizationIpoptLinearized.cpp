@@ -2,6 +2,7 @@
 #include "InternalForces/Muscles/StaticOptimizationIpoptLinearized.h"
 
 #include "BiorbdModel.h"
+#include "InternalForces/Muscles/MuscleParameterSet.h"
 #include "InternalForces/Muscles/State.h"
 #include "RigidBody/GeneralizedTorque.h"
 #include "Utils/Matrix.h"
@@ -36,32 +37,20 @@ internal_forces::muscles::StaticOptimizationIpoptLinearized::
 
 void internal_forces::muscles::StaticOptimizationIpoptLinearized::
     prepareJacobian() {
-  m_model.updateMuscles(*m_Q, *m_Qdot, true);
-  std::vector<std::shared_ptr<internal_forces::muscles::State>> state_zero;
+  // Each force only depends on its own activation, so the torque of a single
+  // fully activated muscle is -J^T * (F(1) - F(0)) for that muscle. The
+  // geometry was updated to the frame by the constructor of the parent
+  internal_forces::muscles::MuscleParameterSet& parameters(
+      m_model.batchedMuscleParameters());
+  utils::Vector forceInactive(*m_nbMus);
+  utils::Vector forceActive(*m_nbMus);
+  parameters.updateKinematics();
+  parameters.computeForces(utils::Vector::Zero(*m_nbMus), forceInactive);
+  parameters.computeForces(utils::Vector::Ones(*m_nbMus), forceActive);
   for (unsigned int i = 0; i < *m_nbMus; ++i) {
-    state_zero.push_back(
-        std::make_shared<internal_forces::muscles::State>(
-            internal_forces::muscles::State(0, 0)));
-  }
-  const rigidbody::GeneralizedTorque &GeneralizedTorque_zero(
-      m_model.muscularJointTorque(state_zero));
-  for (unsigned int i = 0; i < *m_nbMus; ++i) {
-    std::vector<std::shared_ptr<internal_forces::muscles::State>> state;
-    for (unsigned int j = 0; j < *m_nbMus; ++j) {
-      unsigned int delta;
-      if (j == i) {
-        delta = 1;
-      } else {
-        delta = 0;
-      }
-      state.push_back(
-          std::make_shared<internal_forces::muscles::State>(
-              internal_forces::muscles::State(0, delta * 1)));
-    }
-    const rigidbody::GeneralizedTorque &GeneralizedTorque(
-        m_model.muscularJointTorque(state, *m_Q.get(), *m_Qdot.get()));
     for (unsigned int j = 0; j < *m_nbTorque; ++j) {
-      (*m_jacobian)(j, i) = GeneralizedTorque(j) - GeneralizedTorque_zero(j);
+      (*m_jacobian)(j, i) =
+          -(*m_lengthJacobian)(i, j) * (forceActive(i) - forceInactive(i));
     }
   }
 }
@@ -138,3 +127,8 @@ bool internal_forces::muscles::StaticOptimizationIpoptLinearized::eval_jac_g(
   }
   return true;
 }
+
+void internal_forces::muscles::StaticOptimizationIpoptLinearized::
+    addConstraintsHessian(const Ipopt::Number*, Ipopt::Number*) {
+  // The linearized constraints have no curvature
+}
@@ -0,0 +1,227 @@
+#define BIORBD_API_EXPORTS
+#include "InternalForces/Muscles/StaticOptimizationQuadratic.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "BiorbdModel.h"
+#include "InternalForces/Muscles/MuscleParameterSet.h"
+#include "RigidBody/GeneralizedCoordinates.h"
+#include "RigidBody/GeneralizedTorque.h"
+#include "RigidBody/GeneralizedVelocity.h"
+#include "Utils/Error.h"
+#include "Utils/Matrix.h"
+#include "Utils/Vector.h"
+
+using namespace BIORBD_NAMESPACE;
+
+internal_forces::muscles::StaticOptimizationQuadratic::
+    StaticOptimizationQuadratic(
+        Model& model,
+        double torquePonderation,
+        double activationMin,
+        double activationMax)
+    : m_model(model),
+      m_torquePonderation(torquePonderation),
+      m_activationMin(activationMin),
+      m_activationMax(activationMax),
+      m_status(std::make_shared<std::vector<BOUND_STATUS>>(
+          model.nbMuscleTotal(), FREE)),
+      m_activations(std::make_shared<utils::Vector>(
+          utils::Vector::Constant(model.nbMuscleTotal(), activationMin))),
+      m_residualTorques(std::make_shared<utils::Vector>(
+          utils::Vector::Zero(model.nbGeneralizedTorque()))),
+      m_nbIterations(std::make_shared<size_t>(0)) {
+#ifdef BIORBD_USE_CASADI_MATH
+  utils::Error::raise(
+      "The quadratic static optimization is only available with the Eigen "
+      "backend");
+#endif
+  utils::Error::check(
+      torquePonderation > 0, "The weight of the residual torques must be > 0");
+  utils::Error::check(
+      activationMin < activationMax,
+      "The bounds of the activations are inverted");
+}
+
+internal_forces::muscles::StaticOptimizationQuadratic::
+    ~StaticOptimizationQuadratic() {}
+
+void internal_forces::muscles::StaticOptimizationQuadratic::solve(
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    const rigidbody::GeneralizedTorque& torqueTarget) {
+#ifndef BIORBD_USE_CASADI_MATH
+  unsigned int nbMus(static_cast<unsigned int>(m_model.nbMuscleTotal()));
+
+  // Linearize the muscular torque between null and full activations:
+  // tau = -J^T * (F(0) + diag(F(1) - F(0)) * a)
+  m_model.updateMuscles(Q, Qdot, true);
+  utils::Matrix lengthJacobian(m_model.musclesLengthJacobian());
+  internal_forces::muscles::MuscleParameterSet& parameters(
+      m_model.batchedMuscleParameters());
+  utils::Vector forceInactive(nbMus);
+  utils::Vector forceActive(nbMus);
+  parameters.updateKinematics();
+  parameters.computeForces(utils::Vector::Zero(nbMus), forceInactive);
+  parameters.computeForces(utils::Vector::Ones(nbMus), forceActive);
+
+  utils::Matrix A(-lengthJacobian.transpose());
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    A.col(i) *= forceActive(i) - forceInactive(i);
+  }
+  utils::Vector b(torqueTarget + lengthJacobian.transpose() * forceInactive);
+
+  // sum(a^2) + w * |b - A * a|^2 = 2 * (0.5 * a^T H a + g^T a) + constant
+  utils::Matrix H(m_torquePonderation * A.transpose() * A);
+  H.diagonal().array() += 1;
+  utils::Vector g(-m_torquePonderation * A.transpose() * b);
+  solveBoxQuadraticProgram(H, g);
+
+  *m_residualTorques = b - A * *m_activations;
+#else
+  utils::Error::raise(
+      "The quadratic static optimization is only available with the Eigen "
+      "backend");
+#endif
+}
+
+void internal_forces::muscles::StaticOptimizationQuadratic::resetActiveSet() {
+  std::fill(m_status->begin(), m_status->end(), FREE);
+}
+
+const utils::Vector&
+internal_forces::muscles::StaticOptimizationQuadratic::activations() const {
+  return *m_activations;
+}
+
+const utils::Vector&
+internal_forces::muscles::StaticOptimizationQuadratic::residualTorques()
+    const {
+  return *m_residualTorques;
+}
+
+size_t
+internal_forces::muscles::StaticOptimizationQuadratic::nbIterations() const {
+  return *m_nbIterations;
+}
+
+size_t
+internal_forces::muscles::StaticOptimizationQuadratic::nbActiveBounds() const {
+  return static_cast<size_t>(
+      std::count_if(m_status->begin(), m_status->end(), [](BOUND_STATUS s) {
+        return s != FREE;
+      }));
+}
+
+void internal_forces::muscles::StaticOptimizationQuadratic::
+    solveBoxQuadraticProgram(const utils::Matrix& H, const utils::Vector& g) {
+#ifndef BIORBD_USE_CASADI_MATH
+  unsigned int n(static_cast<unsigned int>(g.size()));
+  std::vector<BOUND_STATUS>& status(*m_status);
+  utils::Vector& x(*m_activations);
+
+  // Feasible starting point: the active bounds of the previous frame and the
+  // previous free values
+  for (unsigned int i = 0; i < n; ++i) {
+    if (status[i] == AT_MIN) {
+      x(i) = m_activationMin;
+    } else if (status[i] == AT_MAX) {
+      x(i) = m_activationMax;
+    } else {
+      x(i) = std::min(std::max(x(i), m_activationMin), m_activationMax);
+    }
+  }
+
+  // Each iteration either fixes or releases one bound, and a strictly convex
+  // problem never visits the same active set twice
+  double tolerance(1e-12 * (1 + g.lpNorm<Eigen::Infinity>()));
+  size_t maxIterations(10 * n + 100);
+  std::vector<unsigned int> free;
+  bool atMinimum(false);
+  *m_nbIterations = 0;
+  while (*m_nbIterations < maxIterations) {
+    ++*m_nbIterations;
+    utils::Vector gradient(H * x + g);
+
+    if (atMinimum) {
+      // Optimal on this active set, release the bound whose multiplier has
+      // the wrong sign the most
+      double worst(tolerance);
+      unsigned int toRelease(n);
+      for (unsigned int i = 0; i < n; ++i) {
+        double violation(0);
+        if (status[i] == AT_MIN) {
+          violation = -gradient(i);
+        } else if (status[i] == AT_MAX) {
+          violation = gradient(i);
+        }
+        if (violation > worst) {
+          worst = violation;
+          toRelease = i;
+        }
+      }
+      if (toRelease == n) {
+        return;
+      }
+      status[toRelease] = FREE;
+      atMinimum = false;
+      continue;
+    }
+
+    // Minimize on the free activations, the others staying at their bounds
+    free.clear();
+    for (unsigned int i = 0; i < n; ++i) {
+      if (status[i] == FREE) {
+        free.push_back(i);
+      }
+    }
+    unsigned int nbFree(static_cast<unsigned int>(free.size()));
+    utils::Vector step(utils::Vector::Zero(n));
+    if (nbFree) {
+      utils::Matrix HFree(nbFree, nbFree);
+      utils::Vector rhs(nbFree);
+      for (unsigned int i = 0; i < nbFree; ++i) {
+        for (unsigned int j = 0; j < nbFree; ++j) {
+          HFree(i, j) = H(free[i], free[j]);
+        }
+        rhs(i) = -gradient(free[i]);
+      }
+      utils::Vector stepFree(HFree.llt().solve(rhs));
+      for (unsigned int i = 0; i < nbFree; ++i) {
+        step(free[i]) = stepFree(i);
+      }
+    }
+
+    // Go as far as possible toward the minimum without leaving the bounds
+    double alpha(1);
+    unsigned int blocking(n);
+    BOUND_STATUS blockingStatus(FREE);
+    for (unsigned int i : free) {
+      double limit(alpha);
+      if (step(i) < 0) {
+        limit = (m_activationMin - x(i)) / step(i);
+      } else if (step(i) > 0) {
+        limit = (m_activationMax - x(i)) / step(i);
+      }
+      if (limit < alpha) {
+        alpha = std::max(limit, 0.0);
+        blocking = i;
+        blockingStatus = step(i) < 0 ? AT_MIN : AT_MAX;
+      }
+    }
+    x += alpha * step;
+    if (blocking != n) {
+      status[blocking] = blockingStatus;
+      x(blocking) =
+          blockingStatus == AT_MIN ? m_activationMin : m_activationMax;
+    } else {
+      atMinimum = true;
+    }
+  }
+  utils::Error::raise(
+      "The quadratic static optimization did not converge in " +
+      std::to_string(maxIterations) + " iterations");
+#endif
+}
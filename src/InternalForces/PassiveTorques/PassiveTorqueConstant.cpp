@@ -54,6 +54,11 @@ internal_forces::passive_torques::PassiveTorqueConstant::passiveTorque() {
   return *m_Torque;
 }
 
+const utils::Scalar &
+internal_forces::passive_torques::PassiveTorqueConstant::torque() const {
+  return *m_Torque;
+}
+
 void internal_forces::passive_torques::PassiveTorqueConstant::setType() {
   *m_type = internal_forces::passive_torques::TORQUE_TYPE::TORQUE_CONSTANT;
 }
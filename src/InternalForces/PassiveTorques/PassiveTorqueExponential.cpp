@@ -137,6 +137,56 @@ internal_forces::passive_torques::PassiveTorqueExponential::passiveTorque(
          *m_tauEq;
 }
 
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueExponential::k1() const {
+  return *m_k1;
+}
+
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueExponential::k2() const {
+  return *m_k2;
+}
+
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueExponential::b1() const {
+  return *m_b1;
+}
+
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueExponential::b2() const {
+  return *m_b2;
+}
+
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueExponential::qMid() const {
+  return *m_qMid;
+}
+
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueExponential::tauEq() const {
+  return *m_tauEq;
+}
+
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueExponential::pBeta() const {
+  return *m_pBeta;
+}
+
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueExponential::wMax() const {
+  return *m_wMax;
+}
+
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueExponential::sV() const {
+  return *m_sV;
+}
+
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueExponential::deltaP() const {
+  return *m_deltaP;
+}
+
 void internal_forces::passive_torques::PassiveTorqueExponential::setType() {
   *m_type = internal_forces::passive_torques::TORQUE_TYPE::TORQUE_EXPONENTIAL;
 }
@@ -71,6 +71,16 @@ internal_forces::passive_torques::PassiveTorqueLinear::passiveTorque(
   return Q[static_cast<unsigned int>(*m_dofIdx)] * *m_m + *m_b;
 }
 
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueLinear::slope() const {
+  return *m_m;
+}
+
+const utils::Scalar&
+internal_forces::passive_torques::PassiveTorqueLinear::torqueAtZero() const {
+  return *m_b;
+}
+
 void internal_forces::passive_torques::PassiveTorqueLinear::setType() {
   *m_type = internal_forces::passive_torques::TORQUE_TYPE::TORQUE_LINEAR;
 }
@@ -0,0 +1,185 @@
+#define BIORBD_API_EXPORTS
+#include "InternalForces/PassiveTorques/PassiveTorqueSet.h"
+
+#include "InternalForces/PassiveTorques/PassiveTorque.h"
+#include "InternalForces/PassiveTorques/PassiveTorqueConstant.h"
+#include "InternalForces/PassiveTorques/PassiveTorqueExponential.h"
+#include "InternalForces/PassiveTorques/PassiveTorqueLinear.h"
+#include "Utils/Error.h"
+
+using namespace BIORBD_NAMESPACE;
+
+internal_forces::passive_torques::PassiveTorqueSet::PassiveTorqueSet() {}
+
+internal_forces::passive_torques::PassiveTorqueSet::PassiveTorqueSet(
+    const std::vector<
+        std::shared_ptr<internal_forces::passive_torques::PassiveTorque>>&
+        passiveTorques) {
+  compile(passiveTorques);
+}
+
+internal_forces::passive_torques::PassiveTorqueSet::~PassiveTorqueSet() {}
+
+void internal_forces::passive_torques::PassiveTorqueSet::compile(
+    const std::vector<
+        std::shared_ptr<internal_forces::passive_torques::PassiveTorque>>&
+        passiveTorques) {
+  m_constant.clear();
+  m_linear.clear();
+  m_exponential.clear();
+  for (const std::shared_ptr<internal_forces::passive_torques::PassiveTorque>&
+           passiveTorque : passiveTorques) {
+    switch (passiveTorque->type()) {
+      case internal_forces::passive_torques::TORQUE_TYPE::TORQUE_CONSTANT:
+        m_constant.push_back(passiveTorque->index());
+        break;
+      case internal_forces::passive_torques::TORQUE_TYPE::TORQUE_LINEAR:
+        m_linear.push_back(passiveTorque->index());
+        break;
+      case internal_forces::passive_torques::TORQUE_TYPE::TORQUE_EXPONENTIAL:
+        m_exponential.push_back(passiveTorque->index());
+        break;
+      default:
+        utils::Error::raise("Passive Torque type not found");
+    }
+  }
+
+  m_torque = utils::Vector(m_constant.size());
+  m_slope = utils::Vector(m_linear.size());
+  m_torqueAtZero = utils::Vector(m_linear.size());
+  m_k1 = utils::Vector(m_exponential.size());
+  m_k2 = utils::Vector(m_exponential.size());
+  m_b1 = utils::Vector(m_exponential.size());
+  m_b2 = utils::Vector(m_exponential.size());
+  m_qMid = utils::Vector(m_exponential.size());
+  m_tauEq = utils::Vector(m_exponential.size());
+  m_deltaP = utils::Vector(m_exponential.size());
+  m_velocityFactor = utils::Vector(m_exponential.size());
+
+  // The parameters are stored in the order of the index lists
+  unsigned int constant(0);
+  unsigned int linear(0);
+  unsigned int exponential(0);
+  for (const std::shared_ptr<internal_forces::passive_torques::PassiveTorque>&
+           passiveTorque : passiveTorques) {
+    if (passiveTorque->type() ==
+        internal_forces::passive_torques::TORQUE_TYPE::TORQUE_CONSTANT) {
+      const internal_forces::passive_torques::PassiveTorqueConstant& p(
+          static_cast<
+              const internal_forces::passive_torques::PassiveTorqueConstant&>(
+              *passiveTorque));
+      m_torque(constant++) = p.torque();
+    } else if (
+        passiveTorque->type() ==
+        internal_forces::passive_torques::TORQUE_TYPE::TORQUE_LINEAR) {
+      const internal_forces::passive_torques::PassiveTorqueLinear& p(
+          static_cast<
+              const internal_forces::passive_torques::PassiveTorqueLinear&>(
+              *passiveTorque));
+      m_slope(linear) = p.slope();
+      m_torqueAtZero(linear++) = p.torqueAtZero();
+    } else {
+      const internal_forces::passive_torques::PassiveTorqueExponential& p(
+          static_cast<const internal_forces::passive_torques::
+                          PassiveTorqueExponential&>(*passiveTorque));
+      m_k1(exponential) = p.k1();
+      m_k2(exponential) = p.k2();
+      m_b1(exponential) = p.b1();
+      m_b2(exponential) = p.b2();
+      m_qMid(exponential) = p.qMid();
+      m_tauEq(exponential) = p.tauEq();
+      m_deltaP(exponential) = p.deltaP();
+      m_velocityFactor(exponential++) = p.pBeta() / (p.sV() * p.wMax());
+    }
+  }
+}
+
+size_t internal_forces::passive_torques::PassiveTorqueSet::nbPassiveTorques()
+    const {
+  return m_constant.size() + m_linear.size() + m_exponential.size();
+}
+
+const std::vector<size_t>&
+internal_forces::passive_torques::PassiveTorqueSet::indices(
+    internal_forces::passive_torques::TORQUE_TYPE type) const {
+  switch (type) {
+    case internal_forces::passive_torques::TORQUE_TYPE::TORQUE_CONSTANT:
+      return m_constant;
+    case internal_forces::passive_torques::TORQUE_TYPE::TORQUE_LINEAR:
+      return m_linear;
+    case internal_forces::passive_torques::TORQUE_TYPE::TORQUE_EXPONENTIAL:
+      return m_exponential;
+    default:
+      utils::Error::raise(
+          "Only TORQUE_CONSTANT, TORQUE_LINEAR and TORQUE_EXPONENTIAL have an "
+          "index list");
+  }
+#ifdef _WIN32
+  return m_constant;  // Will never reach here
+#endif
+}
+
+void internal_forces::passive_torques::PassiveTorqueSet::computeTorques(
+    const utils::Vector& Q,
+    const utils::Vector& Qdot,
+    utils::Vector& tau) const {
+  for (unsigned int i = 0; i < static_cast<unsigned int>(tau.rows()); ++i) {
+    tau(i) = 0;
+  }
+
+  for (size_t k = 0; k < m_constant.size(); ++k) {
+    tau(static_cast<unsigned int>(m_constant[k])) =
+        m_torque(static_cast<unsigned int>(k));
+  }
+
+  for (size_t k = 0; k < m_linear.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_linear[k]));
+    unsigned int p(static_cast<unsigned int>(k));
+    tau(i) = m_slope(p) * Q(i) + m_torqueAtZero(p);
+  }
+
+  // (b1 * exp(k1 * (q - qMid)) + b2 * exp(k2 * (q - qMid)))
+  //     * (1 - pBeta * qdot / (sV * wMax)) * (q - deltaP) + tauEq
+  for (size_t k = 0; k < m_exponential.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_exponential[k]));
+    unsigned int p(static_cast<unsigned int>(k));
+    utils::Scalar dq(Q(i) - m_qMid(p));
+    utils::Scalar stiffness(
+        m_b1(p) * exp(m_k1(p) * dq) + m_b2(p) * exp(m_k2(p) * dq));
+    tau(i) = stiffness * (1 - m_velocityFactor(p) * Qdot(i)) *
+                 (Q(i) - m_deltaP(p)) +
+             m_tauEq(p);
+  }
+}
+
+void internal_forces::passive_torques::PassiveTorqueSet::
+    computeTorqueDerivatives(
+        const utils::Vector& Q,
+        const utils::Vector& Qdot,
+        utils::Vector& dTaudQ,
+        utils::Vector& dTaudQdot) const {
+  for (unsigned int i = 0; i < static_cast<unsigned int>(dTaudQ.rows());
+       ++i) {
+    dTaudQ(i) = 0;
+    dTaudQdot(i) = 0;
+  }
+
+  for (size_t k = 0; k < m_linear.size(); ++k) {
+    dTaudQ(static_cast<unsigned int>(m_linear[k])) =
+        m_slope(static_cast<unsigned int>(k));
+  }
+
+  for (size_t k = 0; k < m_exponential.size(); ++k) {
+    unsigned int i(static_cast<unsigned int>(m_exponential[k]));
+    unsigned int p(static_cast<unsigned int>(k));
+    utils::Scalar dq(Q(i) - m_qMid(p));
+    utils::Scalar exp1(m_b1(p) * exp(m_k1(p) * dq));
+    utils::Scalar exp2(m_b2(p) * exp(m_k2(p) * dq));
+    utils::Scalar stiffness(exp1 + exp2);
+    utils::Scalar dStiffness(m_k1(p) * exp1 + m_k2(p) * exp2);
+    utils::Scalar elongation(Q(i) - m_deltaP(p));
+    dTaudQ(i) = (1 - m_velocityFactor(p) * Qdot(i)) *
+                (dStiffness * elongation + stiffness);
+    dTaudQdot(i) = -stiffness * m_velocityFactor(p) * elongation;
+  }
+}
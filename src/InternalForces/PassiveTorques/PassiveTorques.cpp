@@ -8,11 +8,13 @@
 #include "InternalForces/PassiveTorques/PassiveTorqueConstant.h"
 #include "InternalForces/PassiveTorques/PassiveTorqueExponential.h"
 #include "InternalForces/PassiveTorques/PassiveTorqueLinear.h"
+#include "InternalForces/PassiveTorques/PassiveTorqueSet.h"
 #include "RigidBody/GeneralizedCoordinates.h"
 #include "RigidBody/GeneralizedTorque.h"
 #include "RigidBody/GeneralizedVelocity.h"
 #include "RigidBody/Joints.h"
 #include "Utils/Error.h"
+#include "Utils/Matrix.h"
 
 using namespace BIORBD_NAMESPACE;
 
@@ -20,28 +22,39 @@ internal_forces::passive_torques::PassiveTorques::PassiveTorques()
     : m_pas(
           std::make_shared<std::vector<std::shared_ptr<
               internal_forces::passive_torques::PassiveTorque>>>()),
-      m_isDofSet(std::make_shared<std::vector<bool>>(true)) {
+      m_isDofSet(std::make_shared<std::vector<bool>>(true)),
+      m_passiveTorqueSet(std::make_shared<
+                         internal_forces::passive_torques::PassiveTorqueSet>()),
+      m_isPassiveTorqueSetCompiled(std::make_shared<bool>(false)) {
   (*m_isDofSet)[0] = false;
 }
 
 internal_forces::passive_torques::PassiveTorques::PassiveTorques(
     const internal_forces::passive_torques::PassiveTorques &other)
-    : m_pas(other.m_pas), m_isDofSet(other.m_isDofSet) {}
+    : m_pas(other.m_pas),
+      m_isDofSet(other.m_isDofSet),
+      m_passiveTorqueSet(other.m_passiveTorqueSet),
+      m_isPassiveTorqueSetCompiled(other.m_isPassiveTorqueSetCompiled) {}
 
 internal_forces::passive_torques::PassiveTorques::~PassiveTorques() {}
 
 void internal_forces::passive_torques::PassiveTorques::DeepCopy(
     const internal_forces::passive_torques::PassiveTorques &other) {
+  m_passiveTorqueSet =
+      std::make_shared<internal_forces::passive_torques::PassiveTorqueSet>();
+  m_isPassiveTorqueSetCompiled = std::make_shared<bool>(false);
   m_pas->resize(other.m_pas->size());
   for (size_t i = 0; i < other.m_pas->size(); ++i) {
-    if ((*other.m_pas)[i]->type() ==
+    if (!(*other.m_pas)[i]) {
+      (*m_pas)[i] = nullptr;
+    } else if (
+        (*other.m_pas)[i]->type() ==
         internal_forces::passive_torques::TORQUE_TYPE::TORQUE_CONSTANT) {
       (*m_pas)[i] = std::make_shared<
           internal_forces::passive_torques::PassiveTorqueConstant>(
           static_cast<
               const internal_forces::passive_torques::PassiveTorqueConstant &>(
               *(*other.m_pas)[i]));
-      return;
     } else if (
         (*other.m_pas)[i]->type() ==
         internal_forces::passive_torques::TORQUE_TYPE::TORQUE_LINEAR) {
@@ -50,7 +63,6 @@ void internal_forces::passive_torques::PassiveTorques::DeepCopy(
           static_cast<
               const internal_forces::passive_torques::PassiveTorqueLinear &>(
               *(*other.m_pas)[i]));
-      return;
     } else if (
         (*other.m_pas)[i]->type() ==
         internal_forces::passive_torques::TORQUE_TYPE::TORQUE_EXPONENTIAL) {
@@ -58,7 +70,6 @@ void internal_forces::passive_torques::PassiveTorques::DeepCopy(
           internal_forces::passive_torques::PassiveTorqueExponential>(
           static_cast<const internal_forces::passive_torques::
                           PassiveTorqueExponential &>(*(*other.m_pas)[i]));
-      return;
     }
   }
   *m_isDofSet = *other.m_isDofSet;
@@ -83,6 +94,8 @@ void internal_forces::passive_torques::PassiveTorques::addPassiveTorque(
     m_pas->resize(idx + 1);
     m_isDofSet->resize(idx + 1, false);
   }
+  *m_isPassiveTorqueSetCompiled = false;
+
   // Add a passive torque to the pool of passive torques according to its type
   if (other.type() ==
       internal_forces::passive_torques::TORQUE_TYPE::TORQUE_CONSTANT) {
@@ -136,37 +149,52 @@ rigidbody::GeneralizedTorque
 internal_forces::passive_torques::PassiveTorques::passiveJointTorque(
     const rigidbody::GeneralizedCoordinates &Q,
     const rigidbody::GeneralizedVelocity &Qdot) {
-  // Assuming that this is also a Joints type (via BiorbdModel)
-  const rigidbody::Joints &model = dynamic_cast<rigidbody::Joints &>(*this);
-  rigidbody::GeneralizedTorque GeneralizedTorque_all =
-      rigidbody::GeneralizedTorque(model);
+  rigidbody::GeneralizedTorque tau(static_cast<size_t>(Qdot.rows()));
+  passiveJointTorque(Q, Qdot, tau);
+  return tau;
+}
 
-  // If there are less actuators declared than dof, the vector must be enlarged
-  if (model.nbDof() >= m_pas->size()) {
-    m_pas->resize(model.nbDof() + 1);
-    m_isDofSet->resize(model.nbDof() + 1, false);
+void internal_forces::passive_torques::PassiveTorques::passiveJointTorque(
+    const rigidbody::GeneralizedCoordinates &Q,
+    const rigidbody::GeneralizedVelocity &Qdot,
+    utils::Vector &tau) {
+  if (!*m_isPassiveTorqueSetCompiled) {
+    compilePassiveTorques();
+  }
+  m_passiveTorqueSet->computeTorques(Q, Qdot, tau);
+}
+
+void internal_forces::passive_torques::PassiveTorques::
+    passiveJointTorqueJacobians(
+        const rigidbody::GeneralizedCoordinates &Q,
+        const rigidbody::GeneralizedVelocity &Qdot,
+        utils::Matrix &dTaudQ,
+        utils::Matrix &dTaudQdot) {
+  if (!*m_isPassiveTorqueSetCompiled) {
+    compilePassiveTorques();
+  }
+  unsigned int nbDof(static_cast<unsigned int>(Qdot.rows()));
+  utils::Vector dTaudQDiagonal(nbDof);
+  utils::Vector dTaudQdotDiagonal(nbDof);
+  m_passiveTorqueSet->computeTorqueDerivatives(
+      Q, Qdot, dTaudQDiagonal, dTaudQdotDiagonal);
+
+  dTaudQ = utils::Matrix::Zero(nbDof, nbDof);
+  dTaudQdot = utils::Matrix::Zero(nbDof, nbDof);
+  for (unsigned int i = 0; i < nbDof; ++i) {
+    dTaudQ(i, i) = dTaudQDiagonal(i);
+    dTaudQdot(i, i) = dTaudQdotDiagonal(i);
   }
+}
 
-  for (unsigned int i = 0; i < model.nbDof(); ++i) {
-    if (!(*m_isDofSet)[i]) {
-      GeneralizedTorque_all[i] = 0;
-    } else if (std::dynamic_pointer_cast<PassiveTorqueConstant>((*m_pas)[i])) {
-      GeneralizedTorque_all[i] =
-          std::static_pointer_cast<PassiveTorqueConstant>((*m_pas)[i])
-              ->passiveTorque();
-    } else if (std::dynamic_pointer_cast<PassiveTorqueLinear>((*m_pas)[i])) {
-      GeneralizedTorque_all[i] =
-          std::static_pointer_cast<PassiveTorqueLinear>((*m_pas)[i])
-              ->passiveTorque(Q);
-    } else if (std::dynamic_pointer_cast<PassiveTorqueExponential>(
-                   (*m_pas)[i])) {
-      GeneralizedTorque_all[i] =
-          std::static_pointer_cast<PassiveTorqueExponential>((*m_pas)[i])
-              ->passiveTorque(Q, Qdot);
-    } else {
-      utils::Error::raise(
-          "Wrong type (should never get here because of previous safety)");
+void internal_forces::passive_torques::PassiveTorques::compilePassiveTorques() {
+  std::vector<std::shared_ptr<internal_forces::passive_torques::PassiveTorque>>
+      passiveTorques;
+  for (size_t i = 0; i < m_pas->size(); ++i) {
+    if ((*m_pas)[i]) {
+      passiveTorques.push_back((*m_pas)[i]);
     }
   }
-  return GeneralizedTorque_all;
+  m_passiveTorqueSet->compile(passiveTorques);
+  *m_isPassiveTorqueSetCompiled = true;
 }
@@ -0,0 +1,270 @@
+#define BIORBD_API_EXPORTS
+#include "InternalForces/PathKinematics.h"
+
+#include <algorithm>
+#include <limits>
+#include <rbdl/Kinematics.h>
+
+#include "InternalForces/PathModifiers.h"
+#include "RigidBody/GeneralizedCoordinates.h"
+#include "RigidBody/Joints.h"
+#include "Utils/Error.h"
+#include "Utils/String.h"
+
+using namespace BIORBD_NAMESPACE;
+
+internal_forces::PathKinematics::PathKinematics()
+    : m_nbDof(0), m_isDofsComputed(false) {}
+
+internal_forces::PathKinematics::~PathKinematics() {}
+
+void internal_forces::PathKinematics::clear() {
+  m_nbDof = 0;
+  m_bodyId.clear();
+  m_bodyOrigin.clear();
+  m_bodyRotation.clear();
+  m_bodyJacobian.clear();
+  m_bodyDofs.clear();
+  m_pointBody.clear();
+  m_pointInLocal.clear();
+  m_firstPoint.clear();
+  m_isBatched.clear();
+  m_pointsInGlobal.clear();
+  m_pointsJacobian.clear();
+  m_pathDofs.clear();
+  m_isDofsComputed = false;
+  m_lengths = utils::Vector();
+  m_lengthJacobian = utils::Matrix();
+}
+
+size_t internal_forces::PathKinematics::addPath(
+    const rigidbody::Joints& model,
+    const utils::Vector3d& origin,
+    const utils::Vector3d& insertion,
+    const internal_forces::PathModifiers& pathModifiers) {
+  m_nbDof = model.dof_count;
+  m_firstPoint.push_back(m_pointInLocal.size());
+  m_pathDofs.push_back(std::vector<size_t>());
+  m_isDofsComputed = false;
+
+  if (pathModifiers.nbWraps() != 0) {
+    // The wrapping points move on the wrap, they cannot be tabulated
+    m_isBatched.push_back(false);
+    m_pointsInGlobal.push_back(std::vector<utils::Vector3d>());
+    m_pointsJacobian.push_back(utils::Matrix());
+  } else {
+    addPoint(model, origin);
+    for (size_t i = 0; i < pathModifiers.nbObjects(); ++i) {
+      const utils::Vector3d& node(pathModifiers.object(i));
+      utils::Error::check(
+          node.typeOfNode() == utils::NODE_TYPE::VIA_POINT,
+          "Length for this type of object was not implemented");
+      addPoint(model, node);
+    }
+    addPoint(model, insertion);
+
+    size_t nbPoints(m_pointInLocal.size() - m_firstPoint.back());
+    m_isBatched.push_back(true);
+    m_pointsInGlobal.push_back(
+        std::vector<utils::Vector3d>(nbPoints, utils::Vector3d(0, 0, 0)));
+    m_pointsJacobian.push_back(
+        utils::Matrix::Zero(
+            static_cast<unsigned int>(3 * nbPoints),
+            static_cast<unsigned int>(m_nbDof)));
+  }
+
+  m_lengths = utils::Vector::Zero(static_cast<unsigned int>(nbPaths()));
+  m_lengthJacobian = utils::Matrix::Zero(
+      static_cast<unsigned int>(nbPaths()), static_cast<unsigned int>(m_nbDof));
+  return nbPaths() - 1;
+}
+
+size_t internal_forces::PathKinematics::nbPaths() const {
+  return m_firstPoint.size();
+}
+
+bool internal_forces::PathKinematics::isBatched(size_t idx) const {
+  utils::Error::check(idx < nbPaths(), "Idx is higher than the number of paths");
+  return m_isBatched[idx];
+}
+
+void internal_forces::PathKinematics::update(
+    rigidbody::Joints& updatedModel,
+    const rigidbody::GeneralizedCoordinates& Q) {
+  // Frame and Jacobian of each body carrying at least one point
+  const utils::Vector3d zero(0, 0, 0);
+  for (size_t b = 0; b < m_bodyId.size(); ++b) {
+    m_bodyOrigin[b] = RigidBodyDynamics::CalcBodyToBaseCoordinates(
+        updatedModel, Q, m_bodyId[b], zero, false);
+    m_bodyRotation[b] = RigidBodyDynamics::CalcBodyWorldOrientation(
+        updatedModel, Q, m_bodyId[b], false);
+    m_bodyJacobian[b].setZero();
+    RigidBodyDynamics::CalcPointJacobian6D(
+        updatedModel, Q, m_bodyId[b], zero, m_bodyJacobian[b], false);
+  }
+  if (!m_isDofsComputed) {
+    computeDofs();
+  }
+
+  for (size_t p = 0; p < nbPaths(); ++p) {
+    if (!m_isBatched[p]) {
+      continue;
+    }
+    std::vector<utils::Vector3d>& points(m_pointsInGlobal[p]);
+    utils::Matrix& jaco(m_pointsJacobian[p]);
+    const std::vector<size_t>& pathDofs(m_pathDofs[p]);
+
+    // Position and Jacobian of the points: v_p = v_o + w x (p - o)
+    for (size_t i = 0; i < points.size(); ++i) {
+      size_t b(m_pointBody[m_firstPoint[p] + i]);
+      const utils::Matrix& G(m_bodyJacobian[b]);
+      utils::Vector3d r(
+          m_bodyRotation[b].transpose() * m_pointInLocal[m_firstPoint[p] + i]);
+      points[i] = m_bodyOrigin[b] + r;
+
+      unsigned int row(static_cast<unsigned int>(3 * i));
+      for (size_t k = 0; k < m_bodyDofs[b].size(); ++k) {
+        unsigned int c(static_cast<unsigned int>(m_bodyDofs[b][k]));
+        jaco(row + 0, c) = G(3, c) + G(1, c) * r(2) - G(2, c) * r(1);
+        jaco(row + 1, c) = G(4, c) + G(2, c) * r(0) - G(0, c) * r(2);
+        jaco(row + 2, c) = G(5, c) + G(0, c) * r(1) - G(1, c) * r(0);
+      }
+    }
+
+    // Length of the path and its Jacobian
+    unsigned int idx(static_cast<unsigned int>(p));
+    utils::Scalar length(0);
+    for (size_t k = 0; k < pathDofs.size(); ++k) {
+      m_lengthJacobian(idx, static_cast<unsigned int>(pathDofs[k])) = 0;
+    }
+    for (size_t i = 0; i < points.size() - 1; ++i) {
+      utils::Vector3d diff(points[i + 1] - points[i]);
+      utils::Scalar norm(diff.norm());
+      length += norm;
+
+      unsigned int row(static_cast<unsigned int>(3 * i));
+      for (size_t k = 0; k < pathDofs.size(); ++k) {
+        unsigned int c(static_cast<unsigned int>(pathDofs[k]));
+        m_lengthJacobian(idx, c) =
+            m_lengthJacobian(idx, c) +
+            (diff(0) * (jaco(row + 3, c) - jaco(row + 0, c)) +
+             diff(1) * (jaco(row + 4, c) - jaco(row + 1, c)) +
+             diff(2) * (jaco(row + 5, c) - jaco(row + 2, c))) /
+                norm;
+      }
+    }
+    m_lengths(idx) = length;
+  }
+}
+
+std::vector<utils::Vector3d>& internal_forces::PathKinematics::pointsInGlobal(
+    size_t idx) {
+  utils::Error::check(idx < nbPaths(), "Idx is higher than the number of paths");
+  return m_pointsInGlobal[idx];
+}
+
+utils::Matrix& internal_forces::PathKinematics::pointsJacobian(size_t idx) {
+  utils::Error::check(idx < nbPaths(), "Idx is higher than the number of paths");
+  return m_pointsJacobian[idx];
+}
+
+utils::Vector& internal_forces::PathKinematics::lengths() {
+  return m_lengths;
+}
+
+utils::Matrix& internal_forces::PathKinematics::lengthJacobian() {
+  return m_lengthJacobian;
+}
+
+const std::vector<size_t>& internal_forces::PathKinematics::dofs(
+    size_t idx) const {
+  utils::Error::check(
+      idx < nbPaths(), "Idx is higher than the number of paths");
+  utils::Error::check(
+      m_isDofsComputed, "The DoFs of the paths are known after an update");
+  return m_pathDofs[idx];
+}
+
+void internal_forces::PathKinematics::jointTorque(
+    const utils::Vector& forces,
+    utils::Vector& tau) const {
+  utils::Error::check(
+      m_isDofsComputed, "The DoFs of the paths are known after an update");
+  for (unsigned int c = 0; c < m_nbDof; ++c) {
+    tau(c) = 0;
+  }
+  for (size_t p = 0; p < nbPaths(); ++p) {
+    unsigned int idx(static_cast<unsigned int>(p));
+    const std::vector<size_t>& pathDofs(m_pathDofs[p]);
+    for (size_t k = 0; k < pathDofs.size(); ++k) {
+      unsigned int c(static_cast<unsigned int>(pathDofs[k]));
+      tau(c) = tau(c) - m_lengthJacobian(idx, c) * forces(idx);
+    }
+  }
+}
+
+void internal_forces::PathKinematics::computeDofs() {
+  // A column of the 6D Jacobian of a body is exactly zero (it is never
+  // written) if and only if the body does not depend on this DoF
+  std::vector<bool> isDof(m_nbDof);
+  for (size_t b = 0; b < m_bodyId.size(); ++b) {
+    m_bodyDofs[b].clear();
+    for (unsigned int c = 0; c < m_nbDof; ++c) {
+#ifdef BIORBD_USE_CASADI_MATH
+      m_bodyDofs[b].push_back(c);
+#else
+      if (!m_bodyJacobian[b].col(c).isZero(0)) {
+        m_bodyDofs[b].push_back(c);
+      }
+#endif
+    }
+  }
+
+  for (size_t p = 0; p < nbPaths(); ++p) {
+    m_pathDofs[p].clear();
+    std::fill(isDof.begin(), isDof.end(), !m_isBatched[p]);
+    if (m_isBatched[p]) {
+      for (size_t i = 0; i < m_pointsInGlobal[p].size(); ++i) {
+        size_t b(m_pointBody[m_firstPoint[p] + i]);
+        for (size_t k = 0; k < m_bodyDofs[b].size(); ++k) {
+          isDof[m_bodyDofs[b][k]] = true;
+        }
+      }
+    }
+    for (size_t c = 0; c < m_nbDof; ++c) {
+      if (isDof[c]) {
+        m_pathDofs[p].push_back(c);
+      }
+    }
+  }
+  m_isDofsComputed = true;
+}
+
+size_t internal_forces::PathKinematics::bodyIndex(
+    const rigidbody::Joints& model,
+    const utils::String& name) {
+  unsigned int id(model.GetBodyId(name.c_str()));
+  utils::Error::check(
+      id != std::numeric_limits<unsigned int>::max(),
+      utils::String("Segment ") + name + " could not be found in the model");
+
+  for (size_t b = 0; b < m_bodyId.size(); ++b) {
+    if (m_bodyId[b] == id) {
+      return b;
+    }
+  }
+  m_bodyId.push_back(id);
+  m_bodyOrigin.push_back(utils::Vector3d(0, 0, 0));
+  m_bodyRotation.push_back(utils::Matrix3d::Identity());
+  m_bodyJacobian.push_back(
+      utils::Matrix::Zero(6, static_cast<unsigned int>(m_nbDof)));
+  m_bodyDofs.push_back(std::vector<size_t>());
+  return m_bodyId.size() - 1;
+}
+
+void internal_forces::PathKinematics::addPoint(
+    const rigidbody::Joints& model,
+    const utils::Vector3d& point) {
+  m_pointBody.push_back(bodyIndex(model, point.parent()));
+  m_pointInLocal.push_back(point);
+}
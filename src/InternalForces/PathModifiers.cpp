@@ -2,6 +2,7 @@
 #include "InternalForces/PathModifiers.h"
 
 #include "InternalForces/ViaPoint.h"
+#include "InternalForces/WrappingEllipsoid.h"
 #include "InternalForces/WrappingHalfCylinder.h"
 #include "InternalForces/WrappingSphere.h"
 #include "Utils/Error.h"
@@ -26,8 +27,27 @@ void internal_forces::PathModifiers::DeepCopy(
     const internal_forces::PathModifiers& other) {
   m_obj->resize(other.m_obj->size());
   for (size_t i = 0; i < other.m_obj->size(); ++i) {
-    (*m_obj)[i] = std::make_shared<utils::Vector3d>();
-    *(*m_obj)[i] = (*other.m_obj)[i]->DeepCopy();
+    // Keep the actual type of the objects
+    const utils::Vector3d& object(*(*other.m_obj)[i]);
+    if (object.typeOfNode() == utils::NODE_TYPE::WRAPPING_SPHERE) {
+      (*m_obj)[i] = std::make_shared<internal_forces::WrappingSphere>(
+          static_cast<const internal_forces::WrappingSphere&>(object)
+              .DeepCopy());
+    } else if (object.typeOfNode() == utils::NODE_TYPE::WRAPPING_ELLIPSOID) {
+      (*m_obj)[i] = std::make_shared<internal_forces::WrappingEllipsoid>(
+          static_cast<const internal_forces::WrappingEllipsoid&>(object)
+              .DeepCopy());
+    } else if (
+        object.typeOfNode() == utils::NODE_TYPE::WRAPPING_HALF_CYLINDER) {
+      (*m_obj)[i] = std::make_shared<internal_forces::WrappingHalfCylinder>(
+          static_cast<const internal_forces::WrappingHalfCylinder&>(object)
+              .DeepCopy());
+    } else if (object.typeOfNode() == utils::NODE_TYPE::VIA_POINT) {
+      (*m_obj)[i] = std::make_shared<internal_forces::ViaPoint>(
+          static_cast<const internal_forces::ViaPoint&>(object).DeepCopy());
+    } else {
+      (*m_obj)[i] = std::make_shared<utils::Vector3d>(object.DeepCopy());
+    }
   }
   *m_nbWraps = *other.m_nbWraps;
   *m_nbVia = *other.m_nbVia;
@@ -36,24 +56,24 @@ void internal_forces::PathModifiers::DeepCopy(
 
 // Private method to assing values
 void internal_forces::PathModifiers::addPathChanger(utils::Vector3d& object) {
-  // Add a muscle to the pool of muscle depending on type
+  // Add a muscle to the pool of muscle depending on type. Via points and
+  // wrapping objects can be mixed, they are applied in the order they are added
   if (object.typeOfNode() == utils::NODE_TYPE::WRAPPING_SPHERE) {
-    utils::Error::check(
-        *m_nbVia == 0, "Cannot mix via points and wrapping objects yet");
     m_obj->push_back(
         std::make_shared<internal_forces::WrappingSphere>(
             static_cast<internal_forces::WrappingSphere&>(object)));
     ++*m_nbWraps;
+  } else if (object.typeOfNode() == utils::NODE_TYPE::WRAPPING_ELLIPSOID) {
+    m_obj->push_back(
+        std::make_shared<internal_forces::WrappingEllipsoid>(
+            dynamic_cast<internal_forces::WrappingEllipsoid&>(object)));
+    ++*m_nbWraps;
   } else if (object.typeOfNode() == utils::NODE_TYPE::WRAPPING_HALF_CYLINDER) {
-    utils::Error::check(
-        *m_nbVia == 0, "Cannot mix via points and wrapping objects yet");
     m_obj->push_back(
         std::make_shared<internal_forces::WrappingHalfCylinder>(
             dynamic_cast<internal_forces::WrappingHalfCylinder&>(object)));
     ++*m_nbWraps;
   } else if (object.typeOfNode() == utils::NODE_TYPE::VIA_POINT) {
-    utils::Error::check(
-        *m_nbWraps == 0, "Cannot mix via points and wrapping objects yet");
     m_obj->push_back(
         std::make_shared<internal_forces::ViaPoint>(
             dynamic_cast<internal_forces::ViaPoint&>(object)));
@@ -0,0 +1,580 @@
+#define BIORBD_API_EXPORTS
+#include "InternalForces/WrappingEllipsoid.h"
+
+#include <cmath>
+
+#include "RigidBody/Joints.h"
+#include "Utils/Matrix3d.h"
+#include "Utils/Rotation.h"
+#include "Utils/RotoTrans.h"
+#include "Utils/String.h"
+
+using namespace BIORBD_NAMESPACE;
+
+// Nodes and weights of the Gauss-Legendre quadrature (8 points, symmetric)
+static const double gaussLegendreNodes[4] = {
+    0.1834346424956498,
+    0.5255324099163290,
+    0.7966664774136267,
+    0.9602898564975363};
+static const double gaussLegendreWeights[4] = {
+    0.3626837833783620,
+    0.3137066458778873,
+    0.2223810344533745,
+    0.1012285362903763};
+
+#ifndef BIORBD_USE_CASADI_MATH
+// Largest angle turned by the normal of the ellipsoid during one step of the
+// integration of the geodesics, and maximal number of Newton iterations
+static const double geodesicStepAngle(0.01);
+static const unsigned int geodesicMaxIterations(50);
+
+typedef Eigen::Matrix<double, 6, 1> GeodesicState;
+typedef Eigen::Matrix<double, 6, 6> GeodesicMatrix;
+
+// Derivative of the state y = (x, v) of a unit speed geodesic of the surface
+// F(x) = sum(x_i^2 / a_i^2) - 1 = 0. The acceleration is normal to the
+// surface: a = -(v^T H v) / (g^T g) g, with g = H x the gradient of F and
+// H = diag(hessian) its (constant) Hessian. If required, the Jacobian of the
+// derivative with respect to y is also returned
+static void geodesicDerivative(
+    const utils::Vector3d& hessian,
+    const GeodesicState& y,
+    GeodesicState& dy,
+    GeodesicMatrix* jacobian) {
+  utils::Vector3d x(y.head<3>());
+  utils::Vector3d v(y.tail<3>());
+  utils::Vector3d g(hessian.cwiseProduct(x));
+  utils::Vector3d Hv(hessian.cwiseProduct(v));
+  double q(g.squaredNorm());
+  double k(v.dot(Hv) / q);
+  dy.head<3>() = v;
+  dy.tail<3>() = -k * g;
+  if (jacobian != nullptr) {
+    jacobian->setZero();
+    jacobian->block<3, 3>(0, 3).setIdentity();
+    jacobian->block<3, 3>(3, 0) =
+        2 * k / q * g * hessian.cwiseProduct(g).transpose();
+    jacobian->block<3, 3>(3, 0).diagonal() -= k * hessian;
+    jacobian->block<3, 3>(3, 3) = -2 / q * g * Hv.transpose();
+  }
+}
+
+// Integrate a geodesic over a given length (Runge-Kutta 4), along with the
+// derivative of the final state with respect to the initial one
+static void integrateGeodesic(
+    const utils::Vector3d& hessian,
+    double curvature,
+    double length,
+    GeodesicState& y,
+    GeodesicMatrix& transition) {
+  unsigned int nbSteps(static_cast<unsigned int>(
+      std::ceil(std::fabs(length) * curvature / geodesicStepAngle)));
+  nbSteps = std::max(nbSteps, 8u);
+  double h(length / nbSteps);
+  transition.setIdentity();
+
+  GeodesicState k[4];
+  GeodesicMatrix K[4];
+  GeodesicMatrix A;
+  for (unsigned int step = 0; step < nbSteps; ++step) {
+    geodesicDerivative(hessian, y, k[0], &A);
+    K[0] = A * transition;
+    geodesicDerivative(hessian, y + h / 2 * k[0], k[1], &A);
+    K[1] = A * (transition + h / 2 * K[0]);
+    geodesicDerivative(hessian, y + h / 2 * k[1], k[2], &A);
+    K[2] = A * (transition + h / 2 * K[1]);
+    geodesicDerivative(hessian, y + h * k[2], k[3], &A);
+    K[3] = A * (transition + h * K[2]);
+    y += h / 6 * (k[0] + 2 * k[1] + 2 * k[2] + k[3]);
+    transition += h / 6 * (K[0] + 2 * K[1] + 2 * K[2] + K[3]);
+  }
+}
+
+// Conditions on the path going from p1 to p2 around the ellipsoid, with the
+// unknowns z = (t1, s), t1 being the point where the path touches the
+// ellipsoid and s the length of the geodesic, leaving t1 in the direction of
+// the line coming from p1, up to the point t2:
+//   r0 = F(t1) (t1 is on the ellipsoid)
+//   r1 = g(t1).(t1 - p1) (the line coming from p1 is tangent at t1)
+//   r2 = n2.(p2 - t2), r3 = (v2 x n2).(p2 - t2) (p2 is on the tangent leaving
+//   the geodesic at t2, n2 being the normal and v2 the direction at t2)
+// The derivatives of the conditions and of t2 with respect to z and to the
+// nodes p = (p1, p2) are also returned
+static void geodesicConditions(
+    const utils::Vector3d& hessian,
+    double curvature,
+    const utils::Vector3d& p1,
+    const utils::Vector3d& p2,
+    const utils::Vector3d& t1,
+    double length,
+    Eigen::Vector4d& r,
+    Eigen::Matrix4d& r_z,
+    Eigen::Matrix<double, 4, 6>& r_p,
+    utils::Vector3d& t2,
+    utils::Vector3d& v2,
+    Eigen::Matrix<double, 3, 4>& t2_z,
+    utils::Matrix3d& t2_p1) {
+  // Leave t1 in the direction of the line coming from p1
+  utils::Vector3d d(t1 - p1);
+  double dNorm(d.norm());
+  utils::Vector3d v1(d / dNorm);
+  utils::Matrix3d v1_t1(
+      (utils::Matrix3d::Identity() - v1 * v1.transpose()) / dNorm);
+
+  GeodesicState y;
+  y << t1, v1;
+  GeodesicMatrix transition;
+  integrateGeodesic(hessian, curvature, length, y, transition);
+  GeodesicState dy;
+  geodesicDerivative(hessian, y, dy, nullptr);
+  Eigen::Matrix<double, 6, 3> y_t1(
+      transition.leftCols<3>() + transition.rightCols<3>() * v1_t1);
+  Eigen::Matrix<double, 6, 3> y_p1(-transition.rightCols<3>() * v1_t1);
+
+  // Conditions at t1
+  utils::Vector3d g1(hessian.cwiseProduct(t1));
+  r(0) = t1.dot(g1) / 2 - 1;
+  r(1) = g1.dot(d);
+  r_z.setZero();
+  r_p.setZero();
+  r_z.block<1, 3>(0, 0) = g1.transpose();
+  r_z.block<1, 3>(1, 0) = (hessian.cwiseProduct(d) + g1).transpose();
+  r_p.block<1, 3>(1, 0) = -g1.transpose();
+
+  // Conditions at t2 (the derivative of the normal is (I - n n^T) H / |g|)
+  t2 = y.head<3>();
+  v2 = y.tail<3>();
+  utils::Vector3d g2(hessian.cwiseProduct(t2));
+  double g2Norm(g2.norm());
+  utils::Vector3d n2(g2 / g2Norm);
+  utils::Vector3d binormal(v2.cross(n2));
+  utils::Vector3d w(p2 - t2);
+  utils::Vector3d c(w.cross(v2));
+  r(2) = n2.dot(w);
+  r(3) = binormal.dot(w);
+
+  Eigen::Matrix<double, 2, 6> r_y;
+  r_y.block<1, 3>(0, 0) =
+      (hessian.cwiseProduct(w - w.dot(n2) * n2) / g2Norm - n2).transpose();
+  r_y.block<1, 3>(0, 3).setZero();
+  r_y.block<1, 3>(1, 0) =
+      (hessian.cwiseProduct(c - c.dot(n2) * n2) / g2Norm - binormal)
+          .transpose();
+  r_y.block<1, 3>(1, 3) = n2.cross(w).transpose();
+  r_z.block<2, 3>(2, 0) = r_y * y_t1;
+  r_z.block<2, 1>(2, 3) = r_y * dy;
+  r_p.block<2, 3>(2, 0) = r_y * y_p1;
+  r_p.block<1, 3>(2, 3) = n2.transpose();
+  r_p.block<1, 3>(3, 3) = binormal.transpose();
+
+  t2_z.leftCols<3>() = y_t1.topRows<3>();
+  t2_z.col(3) = v2;
+  t2_p1 = y_p1.topRows<3>();
+}
+#endif
+
+internal_forces::WrappingEllipsoid::WrappingEllipsoid()
+    : internal_forces::WrappingObject(),
+      m_semiAxes(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_RTtoParent(std::make_shared<utils::RotoTrans>()),
+      m_p1Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_p2Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_lengthAroundWrap(std::make_shared<utils::Scalar>(0)) {
+  *m_typeOfNode = utils::NODE_TYPE::WRAPPING_ELLIPSOID;
+}
+
+internal_forces::WrappingEllipsoid::WrappingEllipsoid(
+    const utils::RotoTrans& rt,
+    const utils::Vector3d& semiAxes)
+    : internal_forces::WrappingObject(rt.trans()),
+      m_semiAxes(std::make_shared<utils::Vector3d>(semiAxes)),
+      m_RTtoParent(std::make_shared<utils::RotoTrans>(rt)),
+      m_p1Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_p2Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_lengthAroundWrap(std::make_shared<utils::Scalar>(0)) {
+  *m_typeOfNode = utils::NODE_TYPE::WRAPPING_ELLIPSOID;
+}
+
+internal_forces::WrappingEllipsoid::WrappingEllipsoid(
+    const utils::RotoTrans& rt,
+    const utils::Vector3d& semiAxes,
+    const utils::String& name,
+    const utils::String& parentName)
+    : internal_forces::WrappingObject(rt.trans(), name, parentName),
+      m_semiAxes(std::make_shared<utils::Vector3d>(semiAxes)),
+      m_RTtoParent(std::make_shared<utils::RotoTrans>(rt)),
+      m_p1Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_p2Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_lengthAroundWrap(std::make_shared<utils::Scalar>(0)) {
+  *m_typeOfNode = utils::NODE_TYPE::WRAPPING_ELLIPSOID;
+}
+
+internal_forces::WrappingEllipsoid
+internal_forces::WrappingEllipsoid::DeepCopy() const {
+  internal_forces::WrappingEllipsoid copy;
+  copy.DeepCopy(*this);
+  return copy;
+}
+
+void internal_forces::WrappingEllipsoid::DeepCopy(
+    const internal_forces::WrappingEllipsoid& other) {
+  internal_forces::WrappingObject::DeepCopy(other);
+  *m_semiAxes = other.m_semiAxes->DeepCopy();
+  *m_RTtoParent = *other.m_RTtoParent;
+  *m_p1Wrap = other.m_p1Wrap->DeepCopy();
+  *m_p2Wrap = other.m_p2Wrap->DeepCopy();
+  *m_lengthAroundWrap = *other.m_lengthAroundWrap;
+}
+
+void internal_forces::WrappingEllipsoid::wrapPoints(
+    const utils::RotoTrans& rt,
+    const utils::Vector3d& p1_bone,
+    const utils::Vector3d& p2_bone,
+    utils::Vector3d& p1,
+    utils::Vector3d& p2,
+    utils::Scalar* length) {
+  // Find the nodes in the RT reference (of the ellipsoid)
+  utils::Vector3d p1_local(p1_bone.applyRT(rt.transpose()));
+  utils::Vector3d p2_local(p2_bone.applyRT(rt.transpose()));
+
+  utils::Scalar lengthOnWrap(0);
+  wrapInLocal(p1_local, p2_local, p1, p2, lengthOnWrap);
+  if (length != nullptr) {
+    *length = lengthOnWrap;
+  }
+
+  // Reset the points in global (space)
+  p1.applyRT(rt);
+  p2.applyRT(rt);
+
+  // Store the values for a futur call
+  *m_p1Wrap = p1;
+  *m_p2Wrap = p2;
+  *m_lengthAroundWrap = lengthOnWrap;
+}
+
+void internal_forces::WrappingEllipsoid::wrapPoints(
+    rigidbody::Joints& model,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const utils::Vector3d& p1_bone,
+    const utils::Vector3d& p2_bone,
+    utils::Vector3d& p1,
+    utils::Vector3d& p2,
+    utils::Scalar* length) {
+  wrapPoints(RT(model, Q), p1_bone, p2_bone, p1, p2, length);
+}
+
+void internal_forces::WrappingEllipsoid::wrapPoints(
+    utils::Vector3d& p1,
+    utils::Vector3d& p2,
+    utils::Scalar* length) {
+  p1 = *m_p1Wrap;
+  p2 = *m_p2Wrap;
+  if (length != nullptr) {
+    *length = *m_lengthAroundWrap;
+  }
+}
+
+void internal_forces::WrappingEllipsoid::lengthGradient(
+    const utils::RotoTrans& rt,
+    const utils::Vector3d& p1_bone,
+    const utils::Vector3d& p2_bone,
+    utils::Vector3d& dLdp1,
+    utils::Vector3d& dLdp2) const {
+  utils::Vector3d p1(p1_bone.applyRT(rt.transpose()));
+  utils::Vector3d p2(p2_bone.applyRT(rt.transpose()));
+
+#ifdef BIORBD_USE_CASADI_MATH
+  // The path is the section of the ellipsoid, differentiated numerically
+  const double h(1e-6);
+  for (unsigned int i = 0; i < 3; ++i) {
+    utils::Vector3d p1Plus(p1);
+    utils::Vector3d p1Minus(p1);
+    p1Plus(i) = p1(i) + h;
+    p1Minus(i) = p1(i) - h;
+    dLdp1(i) =
+        (pathLengthInLocal(p1Plus, p2) - pathLengthInLocal(p1Minus, p2)) /
+        (2 * h);
+
+    utils::Vector3d p2Plus(p2);
+    utils::Vector3d p2Minus(p2);
+    p2Plus(i) = p2(i) + h;
+    p2Minus(i) = p2(i) - h;
+    dLdp2(i) =
+        (pathLengthInLocal(p1, p2Plus) - pathLengthInLocal(p1, p2Minus)) /
+        (2 * h);
+  }
+#else
+  // The path is the shortest one, so moving the points where it touches the
+  // ellipsoid does not change its length. Only the straight parts count.
+  utils::Vector3d p1_wrap(0, 0, 0);
+  utils::Vector3d p2_wrap(0, 0, 0);
+  utils::Scalar lengthOnWrap(0);
+  if (wrapInLocal(p1, p2, p1_wrap, p2_wrap, lengthOnWrap)) {
+    dLdp1 = (p1 - p1_wrap) / (p1 - p1_wrap).norm();
+    dLdp2 = (p2 - p2_wrap) / (p2 - p2_wrap).norm();
+  } else {
+    dLdp1 = (p1 - p2) / (p1 - p2).norm();
+    dLdp2 = -dLdp1;
+  }
+#endif
+
+  // Express the result back in global (space)
+  const utils::Rotation& rot(rt.rot());
+  dLdp1 = rot * dLdp1;
+  dLdp2 = rot * dLdp2;
+}
+
+#ifndef BIORBD_USE_CASADI_MATH
+void internal_forces::WrappingEllipsoid::wrapPointsJacobian(
+    const utils::RotoTrans& rt,
+    const utils::Vector3d& p1_bone,
+    const utils::Vector3d& p2_bone,
+    utils::Matrix3d& p1Wrap_p1,
+    utils::Matrix3d& p1Wrap_p2,
+    utils::Matrix3d& p2Wrap_p1,
+    utils::Matrix3d& p2Wrap_p2) const {
+  utils::Vector3d p1(p1_bone.applyRT(rt.transpose()));
+  utils::Vector3d p2(p2_bone.applyRT(rt.transpose()));
+  utils::Vector3d t1(0, 0, 0);
+  utils::Vector3d t2(0, 0, 0);
+  utils::Scalar lengthOnWrap(0);
+  if (!wrapInLocal(p1, p2, t1, t2, lengthOnWrap)) {
+    // The points are at one third and two thirds of the straight line
+    p1Wrap_p1 = utils::Matrix3d::Identity() * 2 / 3;
+    p1Wrap_p2 = utils::Matrix3d::Identity() / 3;
+    p2Wrap_p1 = utils::Matrix3d::Identity() / 3;
+    p2Wrap_p2 = utils::Matrix3d::Identity() * 2 / 3;
+    return;
+  }
+
+  // The conditions on the path hold whatever the nodes, so the derivative of
+  // the unknowns is z_p = -r_z^-1 r_p (implicit function theorem)
+  Eigen::Vector4d r;
+  Eigen::Matrix4d r_z;
+  Eigen::Matrix<double, 4, 6> r_p;
+  utils::Vector3d v2(0, 0, 0);
+  Eigen::Matrix<double, 3, 4> t2_z;
+  utils::Matrix3d t2_p1;
+  geodesicConditions(
+      geodesicHessian(),
+      geodesicCurvature(),
+      p1,
+      p2,
+      t1,
+      lengthOnWrap,
+      r,
+      r_z,
+      r_p,
+      t2,
+      v2,
+      t2_z,
+      t2_p1);
+  Eigen::Matrix<double, 4, 6> z_p(-r_z.partialPivLu().solve(r_p));
+
+  const utils::Rotation& rot(rt.rot());
+  p1Wrap_p1 = rot * z_p.block<3, 3>(0, 0) * rot.transpose();
+  p1Wrap_p2 = rot * z_p.block<3, 3>(0, 3) * rot.transpose();
+  p2Wrap_p1 =
+      rot * (t2_z * z_p.leftCols<3>() + t2_p1) * rot.transpose();
+  p2Wrap_p2 = rot * (t2_z * z_p.rightCols<3>()) * rot.transpose();
+}
+#endif
+
+const utils::RotoTrans& internal_forces::WrappingEllipsoid::RT(
+    rigidbody::Joints& model,
+    const rigidbody::GeneralizedCoordinates& Q,
+    bool updateKin) {
+  // Get the RotoTrans matrix of the ellipsoid in space
+  *m_RT = model.globalJCS(Q, *m_parentName, updateKin) * *m_RTtoParent;
+  return *m_RT;
+}
+
+void internal_forces::WrappingEllipsoid::setSemiAxes(
+    const utils::Vector3d& val) {
+  *m_semiAxes = val;
+}
+
+const utils::Vector3d& internal_forces::WrappingEllipsoid::semiAxes() const {
+  return *m_semiAxes;
+}
+
+bool internal_forces::WrappingEllipsoid::wrapInLocal(
+    const utils::Vector3d& p1,
+    const utils::Vector3d& p2,
+    utils::Vector3d& p1_wrap,
+    utils::Vector3d& p2_wrap,
+    utils::Scalar& length) const {
+  if (!sectionInLocal(p1, p2, p1_wrap, p2_wrap, length)) {
+    return false;
+  }
+
+#ifndef BIORBD_USE_CASADI_MATH
+  // On a sphere, the section is already the geodesic
+  const utils::Vector3d& axes(*m_semiAxes);
+  if (axes(0) == axes(1) && axes(1) == axes(2)) {
+    return true;
+  }
+
+  // Otherwise, the section is the starting point of the geodesic. As the
+  // section is a path around the ellipsoid, the shortest path cannot be longer.
+  // A longer geodesic is another one than the shortest, so the iterations are
+  // started again from points moved across the plane of the section. The
+  // section is kept if no shorter path is found
+  utils::Scalar bestLength(
+      (p1 - p1_wrap).norm() + length + (p2 - p2_wrap).norm());
+  utils::Vector3d normal(p1_wrap.cross(p2_wrap));
+  if (normal.norm() > 0) {
+    normal /= normal.norm();
+  }
+  const double offsets[7] = {0, 0.25, -0.25, 0.5, -0.5, 1, -1};
+  for (unsigned int i = 0; i < 7; ++i) {
+    // Start from the point of the section moved along the normal, projected
+    // back on the ellipsoid
+    utils::Vector3d t1(p1_wrap + offsets[i] * axes.minCoeff() * normal);
+    t1 /= std::sqrt(t1.cwiseQuotient(axes).squaredNorm());
+    utils::Vector3d t2(0, 0, 0);
+    utils::Scalar lengthOnGeodesic(length);
+    if (!geodesicInLocal(p1, p2, t1, t2, lengthOnGeodesic)) {
+      continue;
+    }
+    utils::Scalar totalLength(
+        (p1 - t1).norm() + lengthOnGeodesic + (p2 - t2).norm());
+    if (totalLength <= bestLength) {
+      p1_wrap = t1;
+      p2_wrap = t2;
+      length = lengthOnGeodesic;
+      break;
+    }
+  }
+#endif
+  return true;
+}
+
+bool internal_forces::WrappingEllipsoid::sectionInLocal(
+    const utils::Vector3d& p1,
+    const utils::Vector3d& p2,
+    utils::Vector3d& p1_wrap,
+    utils::Vector3d& p2_wrap,
+    utils::Scalar& length) const {
+  const utils::Vector3d& axes(*m_semiAxes);
+
+  // Scale the ellipsoid into a unit sphere
+  utils::Vector3d q1(p1(0) / axes(0), p1(1) / axes(1), p1(2) / axes(2));
+  utils::Vector3d q2(p2(0) / axes(0), p2(1) / axes(1), p2(2) / axes(2));
+  utils::Vector3d e1(0, 0, 0);
+  utils::Vector3d e2(0, 0, 0);
+  utils::Scalar theta1(0);
+  utils::Scalar theta2(0);
+  if (!greatCircleWrap(q1, q2, 1, e1, e2, theta1, theta2)) {
+    // add the two wrapping points on the straight line, each one at one third
+    // of length
+    utils::Vector3d vec((p2 - p1) / 3);
+    p1_wrap = p1 + vec;
+    p2_wrap = p1_wrap + vec;
+    length = vec.norm();
+    return false;
+  }
+
+  // Scale the points back on the ellipsoid
+  utils::Vector3d t1(std::cos(theta1) * e1 + std::sin(theta1) * e2);
+  utils::Vector3d t2(std::cos(theta2) * e1 + std::sin(theta2) * e2);
+  p1_wrap = utils::Vector3d(t1(0) * axes(0), t1(1) * axes(1), t1(2) * axes(2));
+  p2_wrap = utils::Vector3d(t2(0) * axes(0), t2(1) * axes(1), t2(2) * axes(2));
+
+  // Integrate the length of the scaled arc
+  utils::Scalar halfRange((theta2 - theta1) / 2);
+  utils::Scalar center((theta2 + theta1) / 2);
+  length = 0;
+  for (unsigned int i = 0; i < 4; ++i) {
+    for (int side = -1; side <= 1; side += 2) {
+      utils::Scalar theta(center + side * gaussLegendreNodes[i] * halfRange);
+      utils::Vector3d tangent(-std::sin(theta) * e1 + std::cos(theta) * e2);
+      utils::Vector3d scaled(
+          tangent(0) * axes(0), tangent(1) * axes(1), tangent(2) * axes(2));
+      length = length + gaussLegendreWeights[i] * halfRange * scaled.norm();
+    }
+  }
+  return true;
+}
+
+#ifdef BIORBD_USE_CASADI_MATH
+utils::Scalar internal_forces::WrappingEllipsoid::pathLengthInLocal(
+    const utils::Vector3d& p1,
+    const utils::Vector3d& p2) const {
+  utils::Vector3d p1_wrap(0, 0, 0);
+  utils::Vector3d p2_wrap(0, 0, 0);
+  utils::Scalar lengthOnWrap(0);
+  wrapInLocal(p1, p2, p1_wrap, p2_wrap, lengthOnWrap);
+  return (p1 - p1_wrap).norm() + lengthOnWrap + (p2 - p2_wrap).norm();
+}
+#else
+bool internal_forces::WrappingEllipsoid::geodesicInLocal(
+    const utils::Vector3d& p1,
+    const utils::Vector3d& p2,
+    utils::Vector3d& t1,
+    utils::Vector3d& t2,
+    utils::Scalar& length) const {
+  const utils::Vector3d& axes(*m_semiAxes);
+  double smallestAxis(axes.minCoeff());
+  double largestAxis(axes.maxCoeff());
+  utils::Vector3d hessian(geodesicHessian());
+  double curvature(geodesicCurvature());
+
+  // Newton iterations on the conditions of the path (see geodesicConditions)
+  utils::Vector3d t(t1);
+  double s(length);
+  Eigen::Vector4d r;
+  Eigen::Matrix4d r_z;
+  Eigen::Matrix<double, 4, 6> r_p;
+  utils::Vector3d v2(0, 0, 0);
+  Eigen::Matrix<double, 3, 4> t2_z;
+  utils::Matrix3d t2_p1;
+  bool isConverged(false);
+  for (unsigned int i = 0; i < geodesicMaxIterations; ++i) {
+    geodesicConditions(
+        hessian, curvature, p1, p2, t, s, r, r_z, r_p, t2, v2, t2_z, t2_p1);
+    if (std::fabs(r(0)) < 1e-12 && std::fabs(r(1)) < 1e-12 &&
+        std::fabs(r(2)) < 1e-12 * largestAxis &&
+        std::fabs(r(3)) < 1e-12 * largestAxis) {
+      isConverged = true;
+      break;
+    }
+
+    // Limit the step so the path does not jump to another side of the
+    // ellipsoid
+    Eigen::Vector4d dz(r_z.partialPivLu().solve(-r));
+    double ratio(std::max(
+        dz.head<3>().norm() / (smallestAxis / 4), -dz(3) / (s / 2)));
+    if (ratio > 1) {
+      dz /= ratio;
+    }
+    t += dz.head<3>();
+    s += dz(3);
+  }
+
+  // The line must reach p2 forward and the geodesic must go forward too
+  if (!isConverged || s <= 0 || v2.dot(p2 - t2) <= 0) {
+    return false;
+  }
+  t1 = t;
+  length = s;
+  return true;
+}
+
+utils::Vector3d internal_forces::WrappingEllipsoid::geodesicHessian() const {
+  const utils::Vector3d& axes(*m_semiAxes);
+  return utils::Vector3d(
+      2 / (axes(0) * axes(0)),
+      2 / (axes(1) * axes(1)),
+      2 / (axes(2) * axes(2)));
+}
+
+double internal_forces::WrappingEllipsoid::geodesicCurvature() const {
+  // Largest normal curvature of the ellipsoid
+  const utils::Vector3d& axes(*m_semiAxes);
+  double smallestAxis(axes.minCoeff());
+  return axes.maxCoeff() / (smallestAxis * smallestAxis);
+}
+#endif
@@ -3,6 +3,8 @@
 
 #include "RigidBody/Joints.h"
 #include "Utils/Matrix2d.h"
+#include "Utils/Matrix3d.h"
+#include "Utils/Rotation.h"
 #include "Utils/RotoTrans.h"
 #include "Utils/String.h"
 #include "Utils/Vector2d.h"
@@ -183,6 +185,123 @@ void internal_forces::WrappingHalfCylinder::wrapPoints(
   }
 }
 
+void internal_forces::WrappingHalfCylinder::lengthGradient(
+    const utils::RotoTrans& rt,
+    const utils::Vector3d& p1_bone,
+    const utils::Vector3d& p2_bone,
+    utils::Vector3d& dLdp1,
+    utils::Vector3d& dLdp2) const {
+  // The length is L = |p1 - t1| + computeLength(t1, t2) + |p2 - t2| where the
+  // points t1 and t2 leaving the cylinder depend on p1 and p2. The chain rule
+  // is applied through the same steps as wrapPoints
+
+  // Find the nodes in the RT reference (of the cylinder)
+  NodeMusclePair p_glob(p1_bone, p2_bone);
+  p_glob.m_p1->applyRT(rt.transpose());
+  p_glob.m_p2->applyRT(rt.transpose());
+  const utils::Vector3d& p1(*p_glob.m_p1);
+  const utils::Vector3d& p2(*p_glob.m_p2);
+
+  // Find the points leaving the cylinder and their derivative with respect to
+  // the nodes (tX_pY is the derivative of tX with respect to pY)
+  utils::Vector3d t1(0, 0, 0);
+  utils::Vector3d t2(0, 0, 0);
+  utils::Matrix3d t1_p1(utils::Matrix3d::Zero());
+  utils::Matrix3d t1_p2(utils::Matrix3d::Zero());
+  utils::Matrix3d t2_p1(utils::Matrix3d::Zero());
+  utils::Matrix3d t2_p2(utils::Matrix3d::Zero());
+  wrapPointsInLocal(p1, p2, t1, t2, t1_p1, t1_p2, t2_p1, t2_p2);
+
+  // Derivative of the straight parts
+  utils::Vector3d e1((p1 - t1) / (p1 - t1).norm());
+  utils::Vector3d e2((p2 - t2) / (p2 - t2).norm());
+
+  // Derivative of the part on the cylinder (see computeLength)
+  utils::Scalar n1(t1(0) * t1(0) + t1(1) * t1(1));
+  utils::Scalar n2(t2(0) * t2(0) + t2(1) * t2(1));
+  utils::Scalar n12(std::sqrt(n1 * n2));
+  utils::Scalar cosine((t1(0) * t2(0) + t1(1) * t2(1)) / n12);
+  utils::Scalar arc(std::acos(cosine) * radius());
+  utils::Scalar height(t1(2) - t2(2));
+  utils::Scalar lengthOnWrap(std::sqrt(arc * arc + height * height));
+  utils::Scalar sine2(1 - cosine * cosine);
+
+  // With a single point of contact (no length on the cylinder) or with points
+  // aligned with the axis of the cylinder (a cosine of +/-1), the derivative
+  // of the part on the cylinder is not defined. The points leaving the
+  // cylinder are then held fixed, which gives the straight-line Jacobian
+  const double eps(1e-10);
+#ifdef BIORBD_USE_CASADI_MATH
+  utils::Scalar isDefined = IF_ELSE_NAMESPACE::if_else(
+      IF_ELSE_NAMESPACE::gt(lengthOnWrap, eps),
+      IF_ELSE_NAMESPACE::gt(sine2, eps),
+      utils::Scalar(0));
+  utils::Scalar safeLength = IF_ELSE_NAMESPACE::if_else(
+      isDefined, lengthOnWrap, utils::Scalar(1));
+  utils::Scalar safeSine2 =
+      IF_ELSE_NAMESPACE::if_else(isDefined, sine2, utils::Scalar(1));
+#else
+  bool isDefined(lengthOnWrap > eps && sine2 > eps);
+  utils::Scalar safeLength(isDefined ? lengthOnWrap : 1);
+  utils::Scalar safeSine2(isDefined ? sine2 : 1);
+#endif
+  utils::Scalar dArc(-radius() / std::sqrt(safeSine2) * arc / safeLength);
+
+  utils::Vector3d dLdt1(
+      dArc * (t2(0) / n12 - cosine * t1(0) / n1),
+      dArc * (t2(1) / n12 - cosine * t1(1) / n1),
+      height / safeLength);
+  utils::Vector3d dLdt2(
+      dArc * (t1(0) / n12 - cosine * t2(0) / n2),
+      dArc * (t1(1) / n12 - cosine * t2(1) / n2),
+      -height / safeLength);
+  dLdt1 = dLdt1 - e1;
+  dLdt2 = dLdt2 - e2;
+#ifdef BIORBD_USE_CASADI_MATH
+  dLdt1 = IF_ELSE_NAMESPACE::if_else_zero(isDefined, dLdt1);
+  dLdt2 = IF_ELSE_NAMESPACE::if_else_zero(isDefined, dLdt2);
+#else
+  if (!isDefined) {
+    dLdt1.setZero();
+    dLdt2.setZero();
+  }
+#endif
+
+  // Chain rule, then express the result back in global (space)
+  utils::Vector3d dLdp1_local(
+      e1 + t1_p1.transpose() * dLdt1 + t2_p1.transpose() * dLdt2);
+  utils::Vector3d dLdp2_local(
+      e2 + t1_p2.transpose() * dLdt1 + t2_p2.transpose() * dLdt2);
+  const utils::Rotation& rot(rt.rot());
+  dLdp1 = rot * dLdp1_local;
+  dLdp2 = rot * dLdp2_local;
+}
+
+#ifndef BIORBD_USE_CASADI_MATH
+void internal_forces::WrappingHalfCylinder::wrapPointsJacobian(
+    const utils::RotoTrans& rt,
+    const utils::Vector3d& p1_bone,
+    const utils::Vector3d& p2_bone,
+    utils::Matrix3d& p1Wrap_p1,
+    utils::Matrix3d& p1Wrap_p2,
+    utils::Matrix3d& p2Wrap_p1,
+    utils::Matrix3d& p2Wrap_p2) const {
+  utils::Vector3d p1(p1_bone.applyRT(rt.transpose()));
+  utils::Vector3d p2(p2_bone.applyRT(rt.transpose()));
+  utils::Vector3d t1(0, 0, 0);
+  utils::Vector3d t2(0, 0, 0);
+  wrapPointsInLocal(
+      p1, p2, t1, t2, p1Wrap_p1, p1Wrap_p2, p2Wrap_p1, p2Wrap_p2);
+
+  // Express the derivatives back in global (space)
+  const utils::Rotation& rot(rt.rot());
+  p1Wrap_p1 = rot * p1Wrap_p1 * rot.transpose();
+  p1Wrap_p2 = rot * p1Wrap_p2 * rot.transpose();
+  p2Wrap_p1 = rot * p2Wrap_p1 * rot.transpose();
+  p2Wrap_p2 = rot * p2Wrap_p2 * rot.transpose();
+}
+#endif
+
 const utils::RotoTrans& internal_forces::WrappingHalfCylinder::RT(
     rigidbody::Joints& model,
     const rigidbody::GeneralizedCoordinates& Q,
@@ -244,6 +363,36 @@ void internal_forces::WrappingHalfCylinder::findTangentToCircle(
   selectTangents(m, p_tan);
 }
 
+void internal_forces::WrappingHalfCylinder::tangentToCircleJacobian(
+    const utils::Vector3d& p,
+    utils::Matrix3d& jaco) const {
+  // Derivative of Q0 +/- T as computed in findTangentToCircle
+  utils::Scalar r2(radius() * radius());
+  utils::Scalar p_dot(p(0) * p(0) + p(1) * p(1));
+  utils::Scalar sq(std::sqrt(p_dot - r2));
+  utils::Scalar f(radius() * sq / p_dot);  // T = f * [-p(1), p(0)]
+  utils::Scalar df(radius() * (r2 - p_dot / 2) / (p_dot * p_dot * sq) * 2);
+
+  // Select the same tangent as selectTangents
+  utils::Scalar Q0x(r2 / p_dot * p(0));
+  utils::Scalar Tx(-f * p(1));
+#ifdef BIORBD_USE_CASADI_MATH
+  utils::Scalar s = IF_ELSE_NAMESPACE::if_else(
+      IF_ELSE_NAMESPACE::ge(Q0x - Tx, Q0x + Tx),
+      utils::Scalar(-1),
+      utils::Scalar(1));
+#else
+  utils::Scalar s(Q0x - Tx >= Q0x + Tx ? -1 : 1);
+#endif
+
+  utils::Scalar dQ0(-2 * r2 / (p_dot * p_dot));
+  jaco = utils::Matrix3d::Zero();
+  jaco(0, 0) = r2 / p_dot + dQ0 * p(0) * p(0) + s * (-df * p(1) * p(0));
+  jaco(0, 1) = dQ0 * p(0) * p(1) + s * (-df * p(1) * p(1) - f);
+  jaco(1, 0) = dQ0 * p(1) * p(0) + s * (df * p(0) * p(0) + f);
+  jaco(1, 1) = r2 / p_dot + dQ0 * p(1) * p(1) + s * (df * p(0) * p(1));
+}
+
 void internal_forces::WrappingHalfCylinder::selectTangents(
     const NodeMusclePair& p1,
     utils::Vector3d& p_tan) const {
@@ -340,6 +489,78 @@ bool internal_forces::WrappingHalfCylinder::findVerticalNode(
   return true;
 }
 
+void internal_forces::WrappingHalfCylinder::verticalNodeJacobian(
+    const NodeMusclePair& pointsInGlobal,
+    const utils::Vector3d& pointToWrap,
+    utils::Matrix3d& jacoP1,
+    utils::Matrix3d& jacoP2) const {
+  // The height computed in findVerticalNode is h = lambda * (p1_z - p2_z) +
+  // p2_z, where lambda = (p2 - t) . w / |w|^2 in the XY plane, with w = p2 - p1
+  const utils::Vector3d& p1(*pointsInGlobal.m_p1);
+  const utils::Vector3d& p2(*pointsInGlobal.m_p2);
+  utils::Scalar w0(p2(0) - p1(0));
+  utils::Scalar w1(p2(1) - p1(1));
+  utils::Scalar g0(p2(0) - pointToWrap(0));
+  utils::Scalar g1(p2(1) - pointToWrap(1));
+  utils::Scalar n(w0 * w0 + w1 * w1);
+  utils::Scalar lambda((g0 * w0 + g1 * w1) / n);
+  utils::Scalar h0((g0 - 2 * lambda * w0) / n);
+  utils::Scalar h1((g1 - 2 * lambda * w1) / n);
+  utils::Scalar dz(p1(2) - p2(2));
+
+  // dg/dp1 = -dt/dp1 and dg/dp2 = I - dt/dp2 (and dw/dp1 = -I, dw/dp2 = I)
+  for (unsigned int i = 0; i < 2; ++i) {
+    utils::Scalar dLambdaP1(
+        -(w0 * jacoP1(0, i) + w1 * jacoP1(1, i)) / n - (i == 0 ? h0 : h1));
+    utils::Scalar dLambdaP2(
+        ((i == 0 ? w0 : w1) - w0 * jacoP2(0, i) - w1 * jacoP2(1, i)) / n +
+        (i == 0 ? h0 : h1));
+    jacoP1(2, i) = dz * dLambdaP1;
+    jacoP2(2, i) = dz * dLambdaP2;
+  }
+  jacoP1(2, 2) = lambda;
+  jacoP2(2, 2) = 1 - lambda;
+}
+
+void internal_forces::WrappingHalfCylinder::wrapPointsInLocal(
+    const utils::Vector3d& p1,
+    const utils::Vector3d& p2,
+    utils::Vector3d& t1,
+    utils::Vector3d& t2,
+    utils::Matrix3d& t1_p1,
+    utils::Matrix3d& t1_p2,
+    utils::Matrix3d& t2_p1,
+    utils::Matrix3d& t2_p2) const {
+  NodeMusclePair p_glob(p1, p2);
+  utils::Vector3d p1_tan(0, 0, 0);
+  utils::Vector3d p2_tan(0, 0, 0);
+  findTangentToCircle(p1, p1_tan);
+  findTangentToCircle(p2, p2_tan);
+  NodeMusclePair tanPoints(p1_tan, p2_tan);
+
+  t1_p1 = utils::Matrix3d::Zero();
+  t1_p2 = utils::Matrix3d::Zero();
+  t2_p1 = utils::Matrix3d::Zero();
+  t2_p2 = utils::Matrix3d::Zero();
+  if (findVerticalNode(p_glob, tanPoints)) {
+    tangentToCircleJacobian(p1, t1_p1);
+    tangentToCircleJacobian(p2, t2_p2);
+    verticalNodeJacobian(p_glob, *tanPoints.m_p1, t1_p1, t1_p2);
+    verticalNodeJacobian(p_glob, *tanPoints.m_p2, t2_p1, t2_p2);
+  } else {
+    // The points are at one third and two thirds of the straight line
+    utils::Vector3d vec((p2 - p1) / 3);
+    *tanPoints.m_p1 = p1 + vec;
+    *tanPoints.m_p2 = *tanPoints.m_p1 + vec;
+    t1_p1 = utils::Matrix3d::Identity() * 2 / 3;
+    t1_p2 = utils::Matrix3d::Identity() / 3;
+    t2_p1 = utils::Matrix3d::Identity() / 3;
+    t2_p2 = utils::Matrix3d::Identity() * 2 / 3;
+  }
+  t1 = *tanPoints.m_p1;
+  t2 = *tanPoints.m_p2;
+}
+
 #ifndef BIORBD_USE_CASADI_MATH
 bool internal_forces::WrappingHalfCylinder::checkIfWraps(
     const NodeMusclePair& pointsInGlobal,
@@ -1,6 +1,10 @@
 #define BIORBD_API_EXPORTS
 #include "InternalForces/WrappingObject.h"
 
+#include <cmath>
+
+#include "Utils/Error.h"
+#include "Utils/Matrix3d.h"
 #include "Utils/RotoTrans.h"
 #include "Utils/String.h"
 
@@ -57,6 +61,74 @@ void internal_forces::WrappingObject::DeepCopy(
   *m_RT = *other.m_RT;
 }
 
+void internal_forces::WrappingObject::lengthGradient(
+    const utils::RotoTrans &,
+    const utils::Vector3d &,
+    const utils::Vector3d &,
+    utils::Vector3d &,
+    utils::Vector3d &) const {
+  utils::Error::raise(
+      "Length gradient for this type of wrapping object was not implemented");
+}
+
+#ifndef BIORBD_USE_CASADI_MATH
+void internal_forces::WrappingObject::wrapPointsJacobian(
+    const utils::RotoTrans &,
+    const utils::Vector3d &,
+    const utils::Vector3d &,
+    utils::Matrix3d &,
+    utils::Matrix3d &,
+    utils::Matrix3d &,
+    utils::Matrix3d &) const {
+  utils::Error::raise(
+      "Jacobian of the wrapping points for this type of wrapping object was "
+      "not implemented");
+}
+#endif
+
 const utils::RotoTrans &internal_forces::WrappingObject::RT() const {
   return *m_RT;
 }
+
+bool internal_forces::WrappingObject::greatCircleWrap(
+    const utils::Vector3d &p1,
+    const utils::Vector3d &p2,
+    const utils::Scalar &radius,
+    utils::Vector3d &e1,
+    utils::Vector3d &e2,
+    utils::Scalar &theta1,
+    utils::Scalar &theta2) {
+  // Plane of the path
+  utils::Scalar d1(p1.norm());
+  utils::Scalar d2(p2.norm());
+  e1 = p1 / d1;
+  utils::Vector3d ortho(p2 - p2.dot(e1) * e1);
+  utils::Scalar orthoNorm(ortho.norm());
+#ifndef BIORBD_USE_CASADI_MATH
+  if (d1 <= radius || d2 <= radius) {
+    // A node is inside the sphere, the path cannot wrap
+    return false;
+  }
+  if (orthoNorm < 1e-12) {
+    // The nodes are aligned with the center, any plane containing them will do
+    ortho = e1.cross(
+        std::fabs(e1(0)) < 0.9 ? utils::Vector3d(1, 0, 0)
+                               : utils::Vector3d(0, 1, 0));
+    orthoNorm = ortho.norm();
+  }
+#endif
+  e2 = ortho / orthoNorm;
+
+  // Angle of the points where the tangents from the nodes touch the circle
+  utils::Scalar phi(std::atan2(p2.dot(e2), p2.dot(e1)));
+  theta1 = std::acos(radius / d1);
+  theta2 = phi - std::acos(radius / d2);
+
+#ifdef BIORBD_USE_CASADI_MATH
+  return true;
+#else
+  // If the tangents cross before touching the circle, the straight line does
+  // not pass through the sphere
+  return theta2 > theta1;
+#endif
+}
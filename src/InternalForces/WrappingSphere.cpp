@@ -1,6 +1,9 @@
 #define BIORBD_API_EXPORTS
 #include "InternalForces/WrappingSphere.h"
 
+#include "RigidBody/Joints.h"
+#include "Utils/Matrix3d.h"
+#include "Utils/Rotation.h"
 #include "Utils/RotoTrans.h"
 #include "Utils/String.h"
 
@@ -8,7 +11,10 @@ using namespace BIORBD_NAMESPACE;
 
 internal_forces::WrappingSphere::WrappingSphere()
     : internal_forces::WrappingObject(),
-      m_dia(std::make_shared<utils::Scalar>(0)) {
+      m_dia(std::make_shared<utils::Scalar>(0)),
+      m_p1Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_p2Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_lengthAroundWrap(std::make_shared<utils::Scalar>(0)) {
   *m_typeOfNode = utils::NODE_TYPE::WRAPPING_SPHERE;
 }
 
@@ -18,9 +24,10 @@ internal_forces::WrappingSphere::WrappingSphere(
     const utils::Scalar& z,
     const utils::Scalar& diameter)
     : internal_forces::WrappingObject(x, y, z),
-      m_dia(std::make_shared<utils::Scalar>(diameter))
-
-{
+      m_dia(std::make_shared<utils::Scalar>(diameter)),
+      m_p1Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_p2Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_lengthAroundWrap(std::make_shared<utils::Scalar>(0)) {
   *m_typeOfNode = utils::NODE_TYPE::WRAPPING_SPHERE;
 }
 
@@ -32,7 +39,10 @@ internal_forces::WrappingSphere::WrappingSphere(
     const utils::String& name,
     const utils::String& parentName)
     : internal_forces::WrappingObject(x, y, z, name, parentName),
-      m_dia(std::make_shared<utils::Scalar>(diameter)) {
+      m_dia(std::make_shared<utils::Scalar>(diameter)),
+      m_p1Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_p2Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_lengthAroundWrap(std::make_shared<utils::Scalar>(0)) {
   *m_typeOfNode = utils::NODE_TYPE::WRAPPING_SPHERE;
 }
 
@@ -40,7 +50,10 @@ internal_forces::WrappingSphere::WrappingSphere(
     const utils::Vector3d& v,
     const utils::Scalar& diameter)
     : internal_forces::WrappingObject(v),
-      m_dia(std::make_shared<utils::Scalar>(diameter)) {
+      m_dia(std::make_shared<utils::Scalar>(diameter)),
+      m_p1Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_p2Wrap(std::make_shared<utils::Vector3d>(0, 0, 0)),
+      m_lengthAroundWrap(std::make_shared<utils::Scalar>(0)) {
   *m_typeOfNode = utils::NODE_TYPE::WRAPPING_SPHERE;
 }
 
@@ -55,12 +68,161 @@ void internal_forces::WrappingSphere::DeepCopy(
     const internal_forces::WrappingSphere& other) {
   internal_forces::WrappingObject::DeepCopy(other);
   *m_dia = *other.m_dia;
+  *m_p1Wrap = other.m_p1Wrap->DeepCopy();
+  *m_p2Wrap = other.m_p2Wrap->DeepCopy();
+  *m_lengthAroundWrap = *other.m_lengthAroundWrap;
+}
+
+void internal_forces::WrappingSphere::wrapPoints(
+    const utils::RotoTrans& rt,
+    const utils::Vector3d& p1_bone,
+    const utils::Vector3d& p2_bone,
+    utils::Vector3d& p1,
+    utils::Vector3d& p2,
+    utils::Scalar* length) {
+  // Find the nodes in the RT reference (of the sphere)
+  utils::Vector3d p1_local(p1_bone.applyRT(rt.transpose()));
+  utils::Vector3d p2_local(p2_bone.applyRT(rt.transpose()));
+
+  utils::Scalar lengthOnWrap(0);
+  wrapInLocal(p1_local, p2_local, p1, p2, lengthOnWrap);
+  if (length != nullptr) {
+    *length = lengthOnWrap;
+  }
+
+  // Reset the points in global (space)
+  p1.applyRT(rt);
+  p2.applyRT(rt);
+
+  // Store the values for a futur call
+  *m_p1Wrap = p1;
+  *m_p2Wrap = p2;
+  *m_lengthAroundWrap = lengthOnWrap;
 }
 
+void internal_forces::WrappingSphere::wrapPoints(
+    rigidbody::Joints& model,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const utils::Vector3d& p1_bone,
+    const utils::Vector3d& p2_bone,
+    utils::Vector3d& p1,
+    utils::Vector3d& p2,
+    utils::Scalar* length) {
+  wrapPoints(RT(model, Q), p1_bone, p2_bone, p1, p2, length);
+}
+
+void internal_forces::WrappingSphere::wrapPoints(
+    utils::Vector3d& p1,
+    utils::Vector3d& p2,
+    utils::Scalar* length) {
+  p1 = *m_p1Wrap;
+  p2 = *m_p2Wrap;
+  if (length != nullptr) {
+    *length = *m_lengthAroundWrap;
+  }
+}
+
+void internal_forces::WrappingSphere::lengthGradient(
+    const utils::RotoTrans& rt,
+    const utils::Vector3d& p1_bone,
+    const utils::Vector3d& p2_bone,
+    utils::Vector3d& dLdp1,
+    utils::Vector3d& dLdp2) const {
+  utils::Vector3d p1(p1_bone.applyRT(rt.transpose()));
+  utils::Vector3d p2(p2_bone.applyRT(rt.transpose()));
+  utils::Vector3d p1_wrap(0, 0, 0);
+  utils::Vector3d p2_wrap(0, 0, 0);
+  utils::Scalar lengthOnWrap(0);
+
+  // The path is the shortest one, so moving the points where it touches the
+  // sphere does not change its length. Only the straight parts count.
+  if (wrapInLocal(p1, p2, p1_wrap, p2_wrap, lengthOnWrap)) {
+    dLdp1 = (p1 - p1_wrap) / (p1 - p1_wrap).norm();
+    dLdp2 = (p2 - p2_wrap) / (p2 - p2_wrap).norm();
+  } else {
+    dLdp1 = (p1 - p2) / (p1 - p2).norm();
+    dLdp2 = -dLdp1;
+  }
+
+  // Express the result back in global (space)
+  const utils::Rotation& rot(rt.rot());
+  dLdp1 = rot * dLdp1;
+  dLdp2 = rot * dLdp2;
+}
+
+#ifndef BIORBD_USE_CASADI_MATH
+void internal_forces::WrappingSphere::wrapPointsJacobian(
+    const utils::RotoTrans& rt,
+    const utils::Vector3d& p1_bone,
+    const utils::Vector3d& p2_bone,
+    utils::Matrix3d& p1Wrap_p1,
+    utils::Matrix3d& p1Wrap_p2,
+    utils::Matrix3d& p2Wrap_p1,
+    utils::Matrix3d& p2Wrap_p2) const {
+  utils::Vector3d p1(p1_bone.applyRT(rt.transpose()));
+  utils::Vector3d p2(p2_bone.applyRT(rt.transpose()));
+  utils::Vector3d t1(0, 0, 0);
+  utils::Vector3d t2(0, 0, 0);
+  utils::Scalar lengthOnWrap(0);
+  if (!wrapInLocal(p1, p2, t1, t2, lengthOnWrap)) {
+    // The points are at one third and two thirds of the straight line
+    p1Wrap_p1 = utils::Matrix3d::Identity() * 2 / 3;
+    p1Wrap_p2 = utils::Matrix3d::Identity() / 3;
+    p2Wrap_p1 = utils::Matrix3d::Identity() / 3;
+    p2Wrap_p2 = utils::Matrix3d::Identity() * 2 / 3;
+    return;
+  }
+
+  // Each point t leaving the sphere toward the node p is defined by
+  // |t|^2 = r^2 (on the sphere), t.p = r^2 (tangent to the line from p) and
+  // t.(p1 x p2) = 0 (in the plane of the path). The derivative of t is found
+  // by differentiating these three conditions
+  utils::Vector3d normal(p1.cross(p2));
+  bool isPlaneDefined(normal.norm() > 1e-12 * p1.norm() * p2.norm());
+  if (!isPlaneDefined) {
+    // The nodes are aligned with the center, the plane is held fixed
+    normal = t1.cross(t2);
+  }
+
+  utils::Matrix3d A1;
+  A1.row(0) = 2 * t1.transpose();
+  A1.row(1) = p1.transpose();
+  A1.row(2) = normal.transpose();
+  utils::Matrix3d A2;
+  A2.row(0) = 2 * t2.transpose();
+  A2.row(1) = p2.transpose();
+  A2.row(2) = normal.transpose();
+
+  utils::Matrix3d B1_p1(utils::Matrix3d::Zero());
+  utils::Matrix3d B1_p2(utils::Matrix3d::Zero());
+  utils::Matrix3d B2_p1(utils::Matrix3d::Zero());
+  utils::Matrix3d B2_p2(utils::Matrix3d::Zero());
+  B1_p1.row(1) = t1.transpose();
+  B2_p2.row(1) = t2.transpose();
+  if (isPlaneDefined) {
+    B1_p1.row(2) = p2.cross(t1).transpose();
+    B1_p2.row(2) = t1.cross(p1).transpose();
+    B2_p1.row(2) = p2.cross(t2).transpose();
+    B2_p2.row(2) = t2.cross(p1).transpose();
+  }
+
+  utils::Matrix3d A1Inverse(A1.inverse());
+  utils::Matrix3d A2Inverse(A2.inverse());
+  const utils::Rotation& rot(rt.rot());
+  p1Wrap_p1 = -rot * A1Inverse * B1_p1 * rot.transpose();
+  p1Wrap_p2 = -rot * A1Inverse * B1_p2 * rot.transpose();
+  p2Wrap_p1 = -rot * A2Inverse * B2_p1 * rot.transpose();
+  p2Wrap_p2 = -rot * A2Inverse * B2_p2 * rot.transpose();
+}
+#endif
+
 const utils::RotoTrans& internal_forces::WrappingSphere::RT(
-    rigidbody::Joints&,
-    const rigidbody::GeneralizedCoordinates&,
-    bool) {
+    rigidbody::Joints& model,
+    const rigidbody::GeneralizedCoordinates& Q,
+    bool updateKin) {
+  // The sphere is not rotated relative to its parent
+  *m_RT = model.globalJCS(Q, *m_parentName, updateKin) *
+          utils::RotoTrans(utils::Rotation(), *this);
   return *m_RT;
 }
 
@@ -71,3 +233,30 @@ void internal_forces::WrappingSphere::setDiameter(const utils::Scalar& val) {
 const utils::Scalar& internal_forces::WrappingSphere::diameter() const {
   return *m_dia;
 }
+
+bool internal_forces::WrappingSphere::wrapInLocal(
+    const utils::Vector3d& p1,
+    const utils::Vector3d& p2,
+    utils::Vector3d& p1_wrap,
+    utils::Vector3d& p2_wrap,
+    utils::Scalar& length) const {
+  utils::Scalar radius(*m_dia / 2);
+  utils::Vector3d e1(0, 0, 0);
+  utils::Vector3d e2(0, 0, 0);
+  utils::Scalar theta1(0);
+  utils::Scalar theta2(0);
+  if (!greatCircleWrap(p1, p2, radius, e1, e2, theta1, theta2)) {
+    // add the two wrapping points on the straight line, each one at one third
+    // of length
+    utils::Vector3d vec((p2 - p1) / 3);
+    p1_wrap = p1 + vec;
+    p2_wrap = p1_wrap + vec;
+    length = vec.norm();
+    return false;
+  }
+
+  p1_wrap = radius * (std::cos(theta1) * e1 + std::sin(theta1) * e2);
+  p2_wrap = radius * (std::cos(theta2) * e1 + std::sin(theta2) * e2);
+  length = radius * (theta2 - theta1);
+  return true;
+}
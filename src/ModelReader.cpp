@@ -59,7 +59,9 @@
 #include "InternalForces/Geometry.h"
 #include "InternalForces/PathModifiers.h"
 #include "InternalForces/ViaPoint.h"
+#include "InternalForces/WrappingEllipsoid.h"
 #include "InternalForces/WrappingHalfCylinder.h"
+#include "InternalForces/WrappingSphere.h"
 #endif
 #ifdef MODULE_VTP_FILES_READER
 #include "tinyxml2.h"
@@ -1472,6 +1474,7 @@ void Reader::readModelFile(const utils::Path &path, Model *model) {
         bool RTinMatrix(false);
         double radius(0);
         double length(0);
+        utils::Vector3d semiAxes(0, 0, 0);
 
         // Read file
         while (file.read(property_tag) &&
@@ -1513,19 +1516,35 @@ void Reader::readModelFile(const utils::Path &path, Model *model) {
             file.read(radius, variable);
           } else if (!property_tag.tolower().compare("length")) {
             file.read(length, variable);
+          } else if (!property_tag.tolower().compare("semiaxes")) {
+            readVector3d(file, variable, semiAxes);
           }
         }
         utils::Error::check(parent != "", "Parent was not defined");
+        std::shared_ptr<internal_forces::WrappingObject> wrap;
         if (!wrapType.tolower().compare("halfcylinder")) {
           utils::Error::check(
               radius > 0.0, "Radius must be defined and positive");
           utils::Error::check(length >= 0.0, "Length was must be positive");
+          wrap = std::make_shared<internal_forces::WrappingHalfCylinder>(
+              RT, radius, length, name, parent);
+        } else if (!wrapType.tolower().compare("sphere")) {
+          utils::Error::check(
+              radius > 0.0, "Radius must be defined and positive");
+          utils::Vector3d center(RT.trans());
+          wrap = std::make_shared<internal_forces::WrappingSphere>(
+              center(0), center(1), center(2), 2 * radius, name, parent);
+        } else if (!wrapType.tolower().compare("ellipsoid")) {
+          utils::Error::check(
+              semiAxes(0) > 0.0 && semiAxes(1) > 0.0 && semiAxes(2) > 0.0,
+              "Semiaxes must be defined and positive");
+          wrap = std::make_shared<internal_forces::WrappingEllipsoid>(
+              RT, semiAxes, name, parent);
         } else {
           utils::Error::raise(
-              "Wrapping type must be defined (choices: 'halfcylinder')");
+              "Wrapping type must be defined (choices: 'halfcylinder', "
+              "'sphere', 'ellipsoid')");
         }
-        internal_forces::WrappingHalfCylinder cylinder(
-            RT, radius, length, name, parent);
         if (isMuscle) {
           idxMuscleGroup = model->getMuscleGroupId(musclegroup);
           utils::Error::check(
@@ -1534,10 +1553,10 @@ void Reader::readModelFile(const utils::Path &path, Model *model) {
           utils::Error::check(idxMuscle != -1, "No muscle was provided!");
           model->muscleGroup(idxMuscleGroup)
               .muscle(idxMuscle)
-              .addPathObject(cylinder);
+              .addPathObject(*wrap);
         } else if (isLigament) {
           idxLigament = model->ligamentID(ligament);
-          model->ligament(idxLigament).addPathObject(cylinder);
+          model->ligament(idxLigament).addPathObject(*wrap);
         }
       }
     }
@@ -1564,6 +1583,9 @@ void Reader::readModelFile(const utils::Path &path, Model *model) {
     model->closeActuator();
   }
 #endif  // MODULE_ACTUATORS
+#ifdef MODULE_PASSIVE_TORQUES
+  model->compilePassiveTorques();
+#endif  // MODULE_PASSIVE_TORQUES
   // Close file
   // std::cout << "Model file successfully loaded" << std::endl;
   file.close();
@@ -0,0 +1,710 @@
+#define BIORBD_API_EXPORTS
+#include "RigidBody/ContactSurface.h"
+
+#ifndef BIORBD_USE_CASADI_MATH
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "RigidBody/Mesh.h"
+#include "RigidBody/MeshFace.h"
+#include "Utils/Error.h"
+#include "Utils/Matrix.h"
+#include "Utils/Matrix3d.h"
+
+using namespace BIORBD_NAMESPACE;
+
+// Maximal number of triangles in a leaf of the hierarchy
+static const size_t maxTrianglesInLeaf(4);
+
+// Size of the traversal stack, more than the depth of any median split tree
+static const size_t maxStackSize(64);
+
+// Closest point of the triangle abc to x, from the Voronoi regions of the
+// triangle (Ericson, Real-Time Collision Detection)
+static utils::Vector3d closestPointOnTriangle(
+    const utils::Vector3d& x,
+    const utils::Vector3d& a,
+    const utils::Vector3d& b,
+    const utils::Vector3d& c) {
+  utils::Vector3d ab(b - a);
+  utils::Vector3d ac(c - a);
+  utils::Vector3d ap(x - a);
+  double d1(ab.dot(ap));
+  double d2(ac.dot(ap));
+  if (d1 <= 0 && d2 <= 0) {
+    return a;
+  }
+
+  utils::Vector3d bp(x - b);
+  double d3(ab.dot(bp));
+  double d4(ac.dot(bp));
+  if (d3 >= 0 && d4 <= d3) {
+    return b;
+  }
+
+  double vc(d1 * d4 - d3 * d2);
+  if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+    return a + d1 / (d1 - d3) * ab;
+  }
+
+  utils::Vector3d cp(x - c);
+  double d5(ab.dot(cp));
+  double d6(ac.dot(cp));
+  if (d6 >= 0 && d5 <= d6) {
+    return c;
+  }
+
+  double vb(d5 * d2 - d1 * d6);
+  if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+    return a + d2 / (d2 - d6) * ac;
+  }
+
+  double va(d3 * d6 - d5 * d4);
+  if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+    return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * (c - b);
+  }
+
+  double denominator(1. / (va + vb + vc));
+  return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+// Closest points of the segments p1q1 and p2q2 (Ericson, Real-Time Collision
+// Detection), return their squared distance
+static double closestPointsOnSegments(
+    const utils::Vector3d& p1,
+    const utils::Vector3d& q1,
+    const utils::Vector3d& p2,
+    const utils::Vector3d& q2,
+    utils::Vector3d& c1,
+    utils::Vector3d& c2) {
+  utils::Vector3d d1(q1 - p1);
+  utils::Vector3d d2(q2 - p2);
+  utils::Vector3d r(p1 - p2);
+  double a(d1.dot(d1));
+  double e(d2.dot(d2));
+  double f(d2.dot(r));
+  double s(0);
+  double t(0);
+  if (a <= 1e-16 && e <= 1e-16) {
+    s = 0;
+    t = 0;
+  } else if (a <= 1e-16) {
+    t = std::min(std::max(f / e, 0.), 1.);
+  } else {
+    double c(d1.dot(r));
+    if (e <= 1e-16) {
+      s = std::min(std::max(-c / a, 0.), 1.);
+    } else {
+      double b(d1.dot(d2));
+      double denominator(a * e - b * b);
+      if (denominator != 0) {
+        s = std::min(std::max((b * f - c * e) / denominator, 0.), 1.);
+      }
+      t = (b * s + f) / e;
+      if (t < 0) {
+        t = 0;
+        s = std::min(std::max(-c / a, 0.), 1.);
+      } else if (t > 1) {
+        t = 1;
+        s = std::min(std::max((b - c) / a, 0.), 1.);
+      }
+    }
+  }
+  c1 = p1 + d1 * s;
+  c2 = p2 + d2 * t;
+  return (c1 - c2).squaredNorm();
+}
+
+// If the segment pq crosses the triangle abc (Moller-Trumbore)
+static bool segmentIntersectsTriangle(
+    const utils::Vector3d& p,
+    const utils::Vector3d& q,
+    const utils::Vector3d& a,
+    const utils::Vector3d& b,
+    const utils::Vector3d& c,
+    utils::Vector3d& point) {
+  utils::Vector3d direction(q - p);
+  utils::Vector3d ab(b - a);
+  utils::Vector3d ac(c - a);
+  utils::Vector3d h(direction.cross(ac));
+  double determinant(ab.dot(h));
+  if (std::fabs(determinant) < 1e-16) {
+    return false;
+  }
+  double inverse(1. / determinant);
+  utils::Vector3d ap(p - a);
+  double u(inverse * ap.dot(h));
+  if (u < 0 || u > 1) {
+    return false;
+  }
+  utils::Vector3d k(ap.cross(ab));
+  double v(inverse * direction.dot(k));
+  if (v < 0 || u + v > 1) {
+    return false;
+  }
+  double t(inverse * ac.dot(k));
+  if (t < 0 || t > 1) {
+    return false;
+  }
+  point = p + t * direction;
+  return true;
+}
+
+// Closest points of the triangles A and B, return their squared distance (0
+// if the triangles intersect)
+static double closestPointsOnTriangles(
+    const utils::Vector3d* A,
+    const utils::Vector3d* B,
+    utils::Vector3d& pointA,
+    utils::Vector3d& pointB) {
+  for (size_t i = 0; i < 3; ++i) {
+    if (segmentIntersectsTriangle(
+            A[i], A[(i + 1) % 3], B[0], B[1], B[2], pointA) ||
+        segmentIntersectsTriangle(
+            B[i], B[(i + 1) % 3], A[0], A[1], A[2], pointA)) {
+      pointB = pointA;
+      return 0;
+    }
+  }
+
+  // Otherwise, the closest points are on a vertex or on two edges
+  double best(std::numeric_limits<double>::max());
+  utils::Vector3d ca(0, 0, 0);
+  utils::Vector3d cb(0, 0, 0);
+  for (size_t i = 0; i < 3; ++i) {
+    cb = closestPointOnTriangle(A[i], B[0], B[1], B[2]);
+    double d((A[i] - cb).squaredNorm());
+    if (d < best) {
+      best = d;
+      pointA = A[i];
+      pointB = cb;
+    }
+    ca = closestPointOnTriangle(B[i], A[0], A[1], A[2]);
+    d = (B[i] - ca).squaredNorm();
+    if (d < best) {
+      best = d;
+      pointA = ca;
+      pointB = B[i];
+    }
+    for (size_t j = 0; j < 3; ++j) {
+      d = closestPointsOnSegments(
+          A[i], A[(i + 1) % 3], B[j], B[(j + 1) % 3], ca, cb);
+      if (d < best) {
+        best = d;
+        pointA = ca;
+        pointB = cb;
+      }
+    }
+  }
+  return best;
+}
+
+// Angle of the triangle abc around a point of the triangle: the angle of
+// the corner if the point is on a vertex, pi if it is on an edge and 2 pi if
+// it is inside the face
+static double angleAtPoint(
+    const utils::Vector3d& point,
+    const utils::Vector3d& a,
+    const utils::Vector3d& b,
+    const utils::Vector3d& c,
+    double tolerance) {
+  const utils::Vector3d* vertices[3] = {&a, &b, &c};
+  for (size_t i = 0; i < 3; ++i) {
+    if ((point - *vertices[i]).norm() <= tolerance) {
+      utils::Vector3d u(*vertices[(i + 1) % 3] - *vertices[i]);
+      utils::Vector3d v(*vertices[(i + 2) % 3] - *vertices[i]);
+      double cosine(u.dot(v) / (u.norm() * v.norm()));
+      return std::acos(std::min(std::max(cosine, -1.), 1.));
+    }
+  }
+  utils::Vector3d p1(0, 0, 0);
+  utils::Vector3d p2(0, 0, 0);
+  for (size_t i = 0; i < 3; ++i) {
+    if (closestPointsOnSegments(
+            point,
+            point,
+            *vertices[i],
+            *vertices[(i + 1) % 3],
+            p1,
+            p2) <= tolerance * tolerance) {
+      return M_PI;
+    }
+  }
+  return 2 * M_PI;
+}
+
+// Axis aligned box containing the box [lower, upper] once transformed
+static void transformBox(
+    const utils::Vector3d& lower,
+    const utils::Vector3d& upper,
+    const utils::Matrix3d& rotation,
+    const utils::Vector3d& translation,
+    utils::Vector3d& transformedLower,
+    utils::Vector3d& transformedUpper) {
+  utils::Vector3d center(rotation * ((lower + upper) / 2) + translation);
+  utils::Vector3d halfSize(rotation.cwiseAbs() * ((upper - lower) / 2));
+  transformedLower = center - halfSize;
+  transformedUpper = center + halfSize;
+}
+
+// Squared distance between two axis aligned boxes (0 if they overlap)
+static double squaredDistanceBetweenBoxes(
+    const utils::Vector3d& lower1,
+    const utils::Vector3d& upper1,
+    const utils::Vector3d& lower2,
+    const utils::Vector3d& upper2) {
+  double d(0);
+  for (unsigned int i = 0; i < 3; ++i) {
+    double gap(std::max(lower2(i) - upper1(i), lower1(i) - upper2(i)));
+    if (gap > 0) {
+      d += gap * gap;
+    }
+  }
+  return d;
+}
+
+rigidbody::ContactSurface::ContactSurface() {}
+
+rigidbody::ContactSurface::ContactSurface(const rigidbody::Mesh& mesh) {
+  for (rigidbody::MeshFace face : mesh.faces()) {
+    std::vector<int> vertex(face.face());
+    for (size_t k = 0; k < vertex.size(); ++k) {
+      utils::Error::check(
+          vertex[k] >= 0 && static_cast<size_t>(vertex[k]) < mesh.nbVertex(),
+          "The faces of the mesh refer to a vertex that does not exist");
+    }
+    for (size_t k = 1; k + 1 < vertex.size(); ++k) {
+      addTriangle(
+          mesh.point(static_cast<size_t>(vertex[0])),
+          mesh.point(static_cast<size_t>(vertex[k])),
+          mesh.point(static_cast<size_t>(vertex[k + 1])));
+    }
+  }
+  utils::Error::check(nbTriangles() > 0, "The mesh does not have any face");
+  buildHierarchy();
+}
+
+rigidbody::ContactSurface::ContactSurface(
+    const utils::Matrix& heights,
+    const utils::Vector3d& origin,
+    double spacingX,
+    double spacingY) {
+  utils::Error::check(
+      heights.rows() >= 2 && heights.cols() >= 2,
+      "The grid of heights must have at least 2 rows and 2 columns");
+  utils::Error::check(
+      spacingX > 0 && spacingY > 0, "The spacing of the grid must be positive");
+
+  for (unsigned int i = 0; i + 1 < heights.rows(); ++i) {
+    for (unsigned int j = 0; j + 1 < heights.cols(); ++j) {
+      utils::Vector3d p00(
+          origin(0) + i * spacingX,
+          origin(1) + j * spacingY,
+          origin(2) + heights(i, j));
+      utils::Vector3d p10(
+          origin(0) + (i + 1) * spacingX,
+          origin(1) + j * spacingY,
+          origin(2) + heights(i + 1, j));
+      utils::Vector3d p11(
+          origin(0) + (i + 1) * spacingX,
+          origin(1) + (j + 1) * spacingY,
+          origin(2) + heights(i + 1, j + 1));
+      utils::Vector3d p01(
+          origin(0) + i * spacingX,
+          origin(1) + (j + 1) * spacingY,
+          origin(2) + heights(i, j + 1));
+
+      // Counterclockwise when seen from above, so the normals point up
+      addTriangle(p00, p10, p11);
+      addTriangle(p00, p11, p01);
+    }
+  }
+  buildHierarchy();
+}
+
+rigidbody::ContactSurface::~ContactSurface() {}
+
+size_t rigidbody::ContactSurface::nbTriangles() const {
+  return m_normal.size();
+}
+
+const utils::Vector3d& rigidbody::ContactSurface::triangleNormal(
+    size_t idx) const {
+  utils::Error::check(
+      idx < nbTriangles(), "Idx is higher than the number of triangles");
+  return m_normal[idx];
+}
+
+bool rigidbody::ContactSurface::closestPoint(
+    const utils::Vector3d& x,
+    double maxDistance,
+    utils::Vector3d& point,
+    size_t& triangle) const {
+  double best(maxDistance * maxDistance);
+  bool isFound(false);
+
+  // The last closest triangle bounds the search from the start
+  if (triangle < nbTriangles()) {
+    utils::Vector3d p(closestPointOnTriangle(x, triangle));
+    double d((x - p).squaredNorm());
+    if (d <= best) {
+      best = d;
+      point = p;
+      isFound = true;
+    }
+  }
+
+  if (m_nodeMin.empty()) {
+    return isFound;
+  }
+  size_t stack[maxStackSize];
+  size_t stackSize(0);
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    size_t node(stack[--stackSize]);
+    if (squaredDistanceToNode(x, node) > best) {
+      continue;
+    }
+
+    if (m_nodeCount[node] > 0) {
+      for (size_t k = m_nodeLeft[node];
+           k < m_nodeLeft[node] + m_nodeCount[node];
+           ++k) {
+        size_t t(m_order[k]);
+        utils::Vector3d p(closestPointOnTriangle(x, t));
+        double d((x - p).squaredNorm());
+        if (d < best) {
+          best = d;
+          point = p;
+          triangle = t;
+          isFound = true;
+        }
+      }
+      continue;
+    }
+
+    // Visit the closest child first, so it is at the top of the stack
+    size_t left(m_nodeLeft[node]);
+    size_t right(m_nodeRight[node]);
+    if (squaredDistanceToNode(x, left) < squaredDistanceToNode(x, right)) {
+      std::swap(left, right);
+    }
+    utils::Error::check(
+        stackSize + 2 <= maxStackSize, "The contact surface is too deep");
+    stack[stackSize++] = left;
+    stack[stackSize++] = right;
+  }
+  return isFound;
+}
+
+void rigidbody::ContactSurface::boundingBox(
+    const utils::Matrix3d& rotation,
+    const utils::Vector3d& translation,
+    utils::Vector3d& lower,
+    utils::Vector3d& upper) const {
+  utils::Error::check(!m_nodeMin.empty(), "The contact surface is empty");
+  transformBox(m_nodeMin[0], m_nodeMax[0], rotation, translation, lower, upper);
+}
+
+bool rigidbody::ContactSurface::distance(
+    const rigidbody::ContactSurface& other,
+    const utils::Matrix3d& rotation,
+    const utils::Vector3d& translation,
+    double maxDistance,
+    double& distance,
+    utils::Vector3d& point,
+    utils::Vector3d& otherPoint) const {
+  if (m_nodeMin.empty() || other.m_nodeMin.empty()) {
+    return false;
+  }
+  double best(maxDistance * maxDistance);
+  bool isFound(false);
+
+  // Simultaneous descent of both hierarchies
+  std::pair<size_t, size_t> stack[2 * maxStackSize];
+  size_t stackSize(0);
+  stack[stackSize++] = std::make_pair(0, 0);
+  utils::Vector3d lower(0, 0, 0);
+  utils::Vector3d upper(0, 0, 0);
+  utils::Vector3d A[3];
+  utils::Vector3d B[maxTrianglesInLeaf][3];
+  utils::Vector3d pointA(0, 0, 0);
+  utils::Vector3d pointB(0, 0, 0);
+  while (stackSize > 0 && best > 0) {
+    size_t node(stack[stackSize - 1].first);
+    size_t otherNode(stack[stackSize - 1].second);
+    --stackSize;
+    transformBox(
+        other.m_nodeMin[otherNode],
+        other.m_nodeMax[otherNode],
+        rotation,
+        translation,
+        lower,
+        upper);
+    if (squaredDistanceBetweenBoxes(
+            m_nodeMin[node], m_nodeMax[node], lower, upper) > best) {
+      continue;
+    }
+
+    bool isLeaf(m_nodeCount[node] > 0);
+    bool isOtherLeaf(other.m_nodeCount[otherNode] > 0);
+    if (isLeaf && isOtherLeaf) {
+      size_t nbOther(other.m_nodeCount[otherNode]);
+      for (size_t l = 0; l < nbOther; ++l) {
+        size_t t(other.m_order[other.m_nodeLeft[otherNode] + l]);
+        B[l][0] = rotation * other.m_vertexA[t] + translation;
+        B[l][1] = rotation * other.m_vertexB[t] + translation;
+        B[l][2] = rotation * other.m_vertexC[t] + translation;
+      }
+      for (size_t k = 0; k < m_nodeCount[node]; ++k) {
+        size_t t(m_order[m_nodeLeft[node] + k]);
+        A[0] = m_vertexA[t];
+        A[1] = m_vertexB[t];
+        A[2] = m_vertexC[t];
+        for (size_t l = 0; l < nbOther; ++l) {
+          double d(closestPointsOnTriangles(A, B[l], pointA, pointB));
+          if (d <= best) {
+            best = d;
+            point = pointA;
+            otherPoint = pointB;
+            isFound = true;
+          }
+        }
+      }
+      continue;
+    }
+
+    // Split the node which is not a leaf, or the largest one
+    utils::Error::check(
+        stackSize + 2 <= 2 * maxStackSize, "The contact surface is too deep");
+    if (!isLeaf &&
+        (isOtherLeaf || (m_nodeMax[node] - m_nodeMin[node]).squaredNorm() >=
+                            (upper - lower).squaredNorm())) {
+      stack[stackSize++] = std::make_pair(m_nodeRight[node], otherNode);
+      stack[stackSize++] = std::make_pair(m_nodeLeft[node], otherNode);
+    } else {
+      stack[stackSize++] = std::make_pair(node, other.m_nodeRight[otherNode]);
+      stack[stackSize++] = std::make_pair(node, other.m_nodeLeft[otherNode]);
+    }
+  }
+  if (isFound) {
+    distance = std::sqrt(best);
+  }
+  return isFound;
+}
+
+double rigidbody::ContactSurface::penetration(
+    const rigidbody::ContactSurface& other,
+    const utils::Matrix3d& rotation,
+    const utils::Vector3d& translation) const {
+  if (m_nodeMin.empty() || other.m_nodeMin.empty()) {
+    return 0;
+  }
+  double maxDistance((m_nodeMax[0] - m_nodeMin[0]).norm());
+  double depth(0);
+  size_t triangle(nbTriangles());
+  utils::Vector3d point(0, 0, 0);
+  utils::Vector3d lower(0, 0, 0);
+  utils::Vector3d upper(0, 0, 0);
+
+  // Descent of the other hierarchy, only its leaves overlapping the box of
+  // this surface can have a vertex inside it
+  size_t stack[maxStackSize];
+  size_t stackSize(0);
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    size_t otherNode(stack[--stackSize]);
+    transformBox(
+        other.m_nodeMin[otherNode],
+        other.m_nodeMax[otherNode],
+        rotation,
+        translation,
+        lower,
+        upper);
+    if (squaredDistanceBetweenBoxes(
+            m_nodeMin[0], m_nodeMax[0], lower, upper) > 0) {
+      continue;
+    }
+
+    if (other.m_nodeCount[otherNode] == 0) {
+      utils::Error::check(
+          stackSize + 2 <= maxStackSize, "The contact surface is too deep");
+      stack[stackSize++] = other.m_nodeRight[otherNode];
+      stack[stackSize++] = other.m_nodeLeft[otherNode];
+      continue;
+    }
+
+    for (size_t k = other.m_nodeLeft[otherNode];
+         k < other.m_nodeLeft[otherNode] + other.m_nodeCount[otherNode];
+         ++k) {
+      size_t t(other.m_order[k]);
+      const utils::Vector3d* vertices[3] = {
+          &other.m_vertexA[t], &other.m_vertexB[t], &other.m_vertexC[t]};
+      for (size_t i = 0; i < 3; ++i) {
+        utils::Vector3d x(rotation * *vertices[i] + translation);
+        if (squaredDistanceToNode(x, 0) > 0 ||
+            !closestPoint(x, maxDistance, point, triangle)) {
+          continue;
+        }
+        // Behind the faces around the closest point means inside the surface
+        utils::Vector3d d(x - point);
+        if (d.dot(pseudoNormal(point, triangle)) < 0) {
+          depth = std::max(depth, d.norm());
+        }
+      }
+    }
+  }
+  return depth;
+}
+
+void rigidbody::ContactSurface::addTriangle(
+    const utils::Vector3d& a,
+    const utils::Vector3d& b,
+    const utils::Vector3d& c) {
+  utils::Vector3d normal((b - a).cross(c - a));
+  double norm(normal.norm());
+  if (norm < 1e-16) {
+    // A degenerated triangle cannot be touched
+    return;
+  }
+  m_vertexA.push_back(a);
+  m_vertexB.push_back(b);
+  m_vertexC.push_back(c);
+  m_normal.push_back(normal / norm);
+}
+
+void rigidbody::ContactSurface::buildHierarchy() {
+  m_nodeMin.clear();
+  m_nodeMax.clear();
+  m_nodeLeft.clear();
+  m_nodeRight.clear();
+  m_nodeCount.clear();
+  m_order.resize(nbTriangles());
+  for (size_t t = 0; t < nbTriangles(); ++t) {
+    m_order[t] = t;
+  }
+  if (nbTriangles() > 0) {
+    buildNode(0, nbTriangles());
+  }
+}
+
+size_t rigidbody::ContactSurface::buildNode(size_t first, size_t last) {
+  size_t node(m_nodeMin.size());
+  utils::Vector3d lower(m_vertexA[m_order[first]]);
+  utils::Vector3d upper(m_vertexA[m_order[first]]);
+  utils::Vector3d lowerCentroid(1e300, 1e300, 1e300);
+  utils::Vector3d upperCentroid(-1e300, -1e300, -1e300);
+  for (size_t k = first; k < last; ++k) {
+    size_t t(m_order[k]);
+    lower = lower.cwiseMin(m_vertexA[t]).cwiseMin(m_vertexB[t]).cwiseMin(
+        m_vertexC[t]);
+    upper = upper.cwiseMax(m_vertexA[t]).cwiseMax(m_vertexB[t]).cwiseMax(
+        m_vertexC[t]);
+    utils::Vector3d centroid((m_vertexA[t] + m_vertexB[t] + m_vertexC[t]) / 3);
+    lowerCentroid = lowerCentroid.cwiseMin(centroid);
+    upperCentroid = upperCentroid.cwiseMax(centroid);
+  }
+  m_nodeMin.push_back(lower);
+  m_nodeMax.push_back(upper);
+  m_nodeLeft.push_back(first);
+  m_nodeRight.push_back(0);
+  m_nodeCount.push_back(last - first);
+  if (last - first <= maxTrianglesInLeaf) {
+    return node;
+  }
+
+  // Median split along the largest extent of the centroids
+  int axis(0);
+  (upperCentroid - lowerCentroid).maxCoeff(&axis);
+  size_t middle((first + last) / 2);
+  std::nth_element(
+      m_order.begin() + static_cast<std::ptrdiff_t>(first),
+      m_order.begin() + static_cast<std::ptrdiff_t>(middle),
+      m_order.begin() + static_cast<std::ptrdiff_t>(last),
+      [this, axis](size_t i, size_t j) {
+        return m_vertexA[i](axis) + m_vertexB[i](axis) + m_vertexC[i](axis) <
+               m_vertexA[j](axis) + m_vertexB[j](axis) + m_vertexC[j](axis);
+      });
+
+  size_t left(buildNode(first, middle));
+  size_t right(buildNode(middle, last));
+  m_nodeLeft[node] = left;
+  m_nodeRight[node] = right;
+  m_nodeCount[node] = 0;
+  return node;
+}
+
+utils::Vector3d rigidbody::ContactSurface::closestPointOnTriangle(
+    const utils::Vector3d& x,
+    size_t idx) const {
+  return ::closestPointOnTriangle(
+      x, m_vertexA[idx], m_vertexB[idx], m_vertexC[idx]);
+}
+
+utils::Vector3d rigidbody::ContactSurface::pseudoNormal(
+    const utils::Vector3d& point,
+    size_t triangle) const {
+  double tolerance(1e-9 * (m_nodeMax[0] - m_nodeMin[0]).norm());
+  if (angleAtPoint(
+          point,
+          m_vertexA[triangle],
+          m_vertexB[triangle],
+          m_vertexC[triangle],
+          tolerance) == 2 * M_PI) {
+    return m_normal[triangle];
+  }
+
+  // On an edge or a vertex, sum the normals of all the triangles touching
+  // the point, weighted by their angle at the point (Baerentzen and Aanaes)
+  utils::Vector3d normal(0, 0, 0);
+  size_t stack[maxStackSize];
+  size_t stackSize(0);
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    size_t node(stack[--stackSize]);
+    if (squaredDistanceToNode(point, node) > tolerance * tolerance) {
+      continue;
+    }
+
+    if (m_nodeCount[node] > 0) {
+      for (size_t k = m_nodeLeft[node];
+           k < m_nodeLeft[node] + m_nodeCount[node];
+           ++k) {
+        size_t t(m_order[k]);
+        if ((point - closestPointOnTriangle(point, t)).squaredNorm() <=
+            tolerance * tolerance) {
+          normal += angleAtPoint(
+                        point,
+                        m_vertexA[t],
+                        m_vertexB[t],
+                        m_vertexC[t],
+                        tolerance) *
+                    m_normal[t];
+        }
+      }
+      continue;
+    }
+
+    utils::Error::check(
+        stackSize + 2 <= maxStackSize, "The contact surface is too deep");
+    stack[stackSize++] = m_nodeLeft[node];
+    stack[stackSize++] = m_nodeRight[node];
+  }
+  return normal;
+}
+
+double rigidbody::ContactSurface::squaredDistanceToNode(
+    const utils::Vector3d& x,
+    size_t node) const {
+  double d(0);
+  for (unsigned int i = 0; i < 3; ++i) {
+    if (x(i) < m_nodeMin[node](i)) {
+      d += (m_nodeMin[node](i) - x(i)) * (m_nodeMin[node](i) - x(i));
+    } else if (x(i) > m_nodeMax[node](i)) {
+      d += (x(i) - m_nodeMax[node](i)) * (x(i) - m_nodeMax[node](i));
+    }
+  }
+  return d;
+}
+#endif
@@ -183,7 +183,7 @@ std::vector<utils::SpatialVector> rigidbody::Contacts::calcLoopConstraintForces(
       updatedConstraintForcesOutput;
 
   // retrieve the model and the contacts
-  rigidbody::Contacts CS =
+  rigidbody::Contacts &CS =
       dynamic_cast<rigidbody::Contacts *>(this)->getConstraints();
 
 #ifdef BIORBD_USE_CASADI_MATH
@@ -9,8 +9,10 @@
 #include "RigidBody/NodeSegment.h"
 #include "RigidBody/Segment.h"
 #include "RigidBody/SoftContactNode.h"
+#include "RigidBody/SoftContactSet.h"
 #include "RigidBody/SoftContacts.h"
 #include "Utils/Error.h"
+#include "Utils/Matrix.h"
 #include "Utils/Rotation.h"
 #include "Utils/RotoTransNode.h"
 #include "Utils/SpatialVector.h"
@@ -185,6 +187,52 @@ rigidbody::ExternalForceSet::computeSpatialVectors(
   return out;
 }
 
+#ifndef BIORBD_USE_CASADI_MATH
+void rigidbody::ExternalForceSet::computeSoftContactJacobians(
+    rigidbody::Joints& updatedModel,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    utils::Matrix& dTauDq,
+    utils::Matrix& dTauDqdot) {
+  utils::Error::check(
+      updatedModel.nbQ() == updatedModel.nbQdot(),
+      "The soft contact jacobians are not implemented for models with "
+      "quaternions (nbQ != nbQdot)");
+  unsigned int nbDof(static_cast<unsigned int>(updatedModel.nbQdot()));
+  dTauDq = utils::Matrix::Zero(nbDof, nbDof);
+  dTauDqdot = utils::Matrix::Zero(nbDof, nbDof);
+  if (!m_useSoftContacts || m_model.nbSoftContacts() == 0) return;
+
+  // Same forces as combineSoftContactForces, then their derivatives
+  if (m_model.isSoftContactsCompiled()) {
+    rigidbody::SoftContactSet& softContacts(m_model.softContactSet());
+    softContacts.updateKinematics(updatedModel, Q, Qdot);
+    if (m_model.nbContactSurfaces() > 0) {
+      m_model.updateSoftContactPlanes(softContacts.positions());
+    }
+    softContacts.computeForces();
+    softContacts.addGeneralizedForceJacobians(
+        updatedModel, Q, Qdot, dTauDq, dTauDqdot);
+    return;
+  }
+
+  // Otherwise the contacts are batched in a set of their own, built once
+  // their planes are updated, so the model stays not compiled
+  if (m_model.nbContactSurfaces() > 0) {
+    std::vector<utils::Vector3d> positions;
+    for (size_t j = 0; j < m_model.nbSoftContacts(); j++) {
+      positions.push_back(m_model.softContact(Q, j, false));
+    }
+    m_model.updateSoftContactPlanes(positions);
+  }
+  rigidbody::SoftContactSet softContacts(m_model.detachedSoftContactSet());
+  softContacts.updateKinematics(updatedModel, Q, Qdot);
+  softContacts.computeForces();
+  softContacts.addGeneralizedForceJacobians(
+      updatedModel, Q, Qdot, dTauDq, dTauDqdot);
+}
+#endif
+
 bool rigidbody::ExternalForceSet::hasExternalForceInLocalReferenceFrame()
     const {
   return m_externalForcesInLocal.size() > 0;
@@ -307,6 +355,30 @@ void rigidbody::ExternalForceSet::combineSoftContactForces(
   // Do not waste time computing forces on empty vector
   if (m_model.nbSoftContacts() == 0) return;
 
+  // All the contacts in a single pass over the bodies and the contacts
+  if (m_model.isSoftContactsCompiled()) {
+    rigidbody::SoftContactSet& softContacts(m_model.softContactSet());
+    softContacts.updateKinematics(updatedModel, Q, Qdot);
+#ifndef BIORBD_USE_CASADI_MATH
+    if (m_model.nbContactSurfaces() > 0) {
+      m_model.updateSoftContactPlanes(softContacts.positions());
+    }
+#endif
+    softContacts.computeForces();
+    softContacts.combineForces(out);
+    return;
+  }
+
+#ifndef BIORBD_USE_CASADI_MATH
+  if (m_model.nbContactSurfaces() > 0) {
+    std::vector<utils::Vector3d> positions;
+    for (size_t j = 0; j < m_model.nbSoftContacts(); j++) {
+      positions.push_back(m_model.softContact(Q, j, false));
+    }
+    m_model.updateSoftContactPlanes(positions);
+  }
+#endif
+
   for (size_t j = 0; j < m_model.nbSoftContacts(); j++) {
     rigidbody::SoftContactNode& contact(m_model.softContact(j));
     const rigidbody::Segment& segment(updatedModel.segment(contact.parent()));
@@ -230,15 +230,24 @@ std::vector<rigidbody::Segment> &rigidbody::Joints::segments() const {
 rigidbody::GeneralizedTorque rigidbody::Joints::computeDampedTau(
     const rigidbody::GeneralizedVelocity &Qdot) const {
   rigidbody::GeneralizedTorque dampings(*this);
+  computeDampedTau(Qdot, dampings);
+  return dampings;
+}
+
+void rigidbody::Joints::computeDampedTau(
+    const rigidbody::GeneralizedVelocity &Qdot,
+    utils::Vector &tau) const {
+  if (static_cast<size_t>(tau.rows()) != nbGeneralizedTorque()) {
+    tau = utils::Vector(nbGeneralizedTorque());
+  }
 
   size_t count(0);
   for (auto &segment : *m_segments) {
     for (auto &damping : segment.jointDampings()) {
-      dampings[count] = damping * Qdot[count];
+      tau[count] = damping * Qdot[count];
       count++;
     }
   }
-  return dampings;
 }
 
 size_t rigidbody::Joints::nbSegment() const { return m_segments->size(); }
@@ -1647,7 +1656,7 @@ rigidbody::Joints::ForwardDynamicsConstraintsDirect(
     const rigidbody::GeneralizedVelocity &Qdot,
     const rigidbody::GeneralizedTorque &Tau,
     bool updateKin) {
-  rigidbody::Contacts CS =
+  rigidbody::Contacts &CS =
       dynamic_cast<rigidbody::Contacts *>(this)->getConstraints();
   return ForwardDynamicsConstraintsDirect(Q, Qdot, Tau, CS, updateKin);
 }
@@ -1659,7 +1668,7 @@ rigidbody::Joints::ForwardDynamicsConstraintsDirect(
     const rigidbody::GeneralizedTorque &Tau,
     rigidbody::ExternalForceSet &externalForces,
     bool updateKin) {
-  rigidbody::Contacts CS =
+  rigidbody::Contacts &CS =
       dynamic_cast<rigidbody::Contacts *>(this)->getConstraints();
   return this->ForwardDynamicsConstraintsDirect(
       Q, Qdot, Tau, CS, externalForces, updateKin);
@@ -1719,7 +1728,7 @@ rigidbody::Joints::ContactForcesFromForwardDynamicsConstraintsDirect(
     const rigidbody::GeneralizedVelocity &Qdot,
     const rigidbody::GeneralizedTorque &Tau,
     rigidbody::ExternalForceSet &externalForces) {
-  rigidbody::Contacts CS =
+  rigidbody::Contacts &CS =
       dynamic_cast<rigidbody::Contacts *>(this)->getConstraints();
   this->ForwardDynamicsConstraintsDirect(Q, Qdot, Tau, CS, externalForces);
   return CS.getForce();
@@ -1729,7 +1738,7 @@ rigidbody::GeneralizedVelocity
 rigidbody::Joints::ComputeConstraintImpulsesDirect(
     const rigidbody::GeneralizedCoordinates &Q,
     const rigidbody::GeneralizedVelocity &QdotPre) {
-  rigidbody::Contacts CS =
+  rigidbody::Contacts &CS =
       dynamic_cast<rigidbody::Contacts *>(this)->getConstraints();
   if (CS.nbContacts() == 0) {
     return QdotPre;
@@ -1740,8 +1749,6 @@ rigidbody::Joints::ComputeConstraintImpulsesDirect(
     rigidbody::Joints &model = *this;
 #endif
 
-    CS = dynamic_cast<rigidbody::Contacts *>(this)->getConstraints();
-
     rigidbody::GeneralizedVelocity QdotPost(model);
     RigidBodyDynamics::ComputeConstraintImpulsesDirect(
         model, Q, QdotPre, CS, QdotPost);
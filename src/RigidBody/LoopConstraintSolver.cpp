@@ -0,0 +1,353 @@
+#define BIORBD_API_EXPORTS
+#include "RigidBody/LoopConstraintSolver.h"
+
+#ifndef BIORBD_USE_CASADI_MATH
+#include <algorithm>
+#include <cmath>
+#include <Eigen/QR>
+#include <rbdl/Constraints.h>
+
+#include "BiorbdModel.h"
+#include "RigidBody/Contacts.h"
+#include "RigidBody/ExternalForceSet.h"
+#include "RigidBody/GeneralizedAcceleration.h"
+#include "RigidBody/GeneralizedCoordinates.h"
+#include "RigidBody/GeneralizedTorque.h"
+#include "RigidBody/GeneralizedVelocity.h"
+#include "RigidBody/Joints.h"
+#include "Utils/Error.h"
+
+using namespace BIORBD_NAMESPACE;
+
+// Relative pivot under which a constraint is considered redundant
+static const double rankThreshold(1e-10);
+
+// Reciprocal condition number under which the partition is chosen again
+static const double conditionThreshold(1e-8);
+
+rigidbody::LoopConstraintSolver::LoopConstraintSolver(
+    Model& model,
+    bool useNullSpace)
+    : m_model(model),
+      m_constraints(model.getConstraints()),
+      m_useNullSpace(useNullSpace),
+      m_alpha(0),
+      m_beta(0),
+      m_isPartitioned(false),
+      m_nbPartitionedConstraints(0) {}
+
+rigidbody::LoopConstraintSolver::~LoopConstraintSolver() {}
+
+void rigidbody::LoopConstraintSolver::setNullSpace(bool useNullSpace) {
+  m_useNullSpace = useNullSpace;
+}
+
+bool rigidbody::LoopConstraintSolver::isNullSpace() const {
+  return m_useNullSpace;
+}
+
+void rigidbody::LoopConstraintSolver::setStabilization(
+    double alpha,
+    double beta) {
+  m_alpha = alpha;
+  m_beta = beta;
+}
+
+size_t rigidbody::LoopConstraintSolver::nbConstraints() const {
+  return m_constraints.size();
+}
+
+size_t rigidbody::LoopConstraintSolver::nbIndependentConstraints() const {
+  return m_rows.size();
+}
+
+const std::vector<unsigned int>&
+rigidbody::LoopConstraintSolver::dependentCoordinates() const {
+  return m_dependent;
+}
+
+const std::vector<unsigned int>&
+rigidbody::LoopConstraintSolver::independentCoordinates() const {
+  return m_independent;
+}
+
+rigidbody::GeneralizedAcceleration
+rigidbody::LoopConstraintSolver::forwardDynamics(
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    const rigidbody::GeneralizedTorque& Tau) {
+  rigidbody::ExternalForceSet forceSet(m_model);
+  return forwardDynamics(Q, Qdot, Tau, forceSet);
+}
+
+rigidbody::GeneralizedAcceleration
+rigidbody::LoopConstraintSolver::forwardDynamics(
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    const rigidbody::GeneralizedTorque& Tau,
+    rigidbody::ExternalForceSet& externalForces) {
+  rigidbody::Joints& updatedModel = m_model.UpdateKinematicsCustom(&Q, &Qdot);
+  auto fExt = externalForces.computeRbdlSpatialVectors(updatedModel, Q, Qdot);
+  rigidbody::GeneralizedTorque dampedTau(Tau - m_model.computeDampedTau(Qdot));
+
+  // Mass matrix, nonlinear effects, Jacobian and acceleration of the
+  // constraints (including the stabilization of the loops of the model),
+  // computed in the workspace of the constraint set
+  RigidBodyDynamics::CalcConstrainedSystemVariables(
+      updatedModel, Q, Qdot, dampedTau, m_constraints, &fExt);
+  const Eigen::MatrixXd& G(m_constraints.G);
+  m_gamma = m_constraints.gamma;
+  if (m_alpha != 0 || m_beta != 0) {
+    m_error.resize(G.rows());
+    RigidBodyDynamics::CalcConstraintsPositionError(
+        updatedModel, Q, m_constraints, m_error, false);
+    m_gamma -= 2 * m_alpha * (G * Qdot) + m_beta * m_beta * m_error;
+  }
+  if (!m_isPartitioned || m_nbPartitionedConstraints != nbConstraints()) {
+    // Constraints may have been added to the model since the partition
+    partition(G);
+  }
+
+  utils::Vector effects(dampedTau - m_constraints.C);
+  rigidbody::GeneralizedAcceleration Qddot(m_model);
+  m_forces = utils::Vector::Zero(G.rows());
+  if (m_useNullSpace) {
+    solveNullSpace(G, effects, Qddot);
+  } else {
+    solveRangeSpace(G, effects, Qddot);
+  }
+  m_constraints.force = m_forces;
+  return Qddot;
+}
+
+const utils::Vector& rigidbody::LoopConstraintSolver::forces() const {
+  return m_forces;
+}
+
+bool rigidbody::LoopConstraintSolver::projectPositions(
+    rigidbody::GeneralizedCoordinates& Q,
+    double tolerance,
+    size_t maxIterations) {
+  utils::Error::check(
+      m_model.nbQ() == m_model.nbQdot(),
+      "The projection of the positions is not available with quaternions");
+  utils::Matrix G(utils::Matrix::Zero(nbConstraints(), m_model.nbQdot()));
+  m_error.resize(static_cast<unsigned int>(nbConstraints()));
+  for (size_t it = 0; it <= maxIterations; ++it) {
+    RigidBodyDynamics::CalcConstraintsPositionError(
+        m_model, Q, m_constraints, m_error, true);
+    if (m_error.size() == 0 || m_error.lpNorm<Eigen::Infinity>() < tolerance) {
+      return true;
+    }
+    if (it == maxIterations) {
+      break;
+    }
+
+    // Newton step on the dependent coordinates only
+    RigidBodyDynamics::CalcConstraintsJacobian(
+        m_model, Q, m_constraints, G, false);
+    if (!m_isPartitioned || m_nbPartitionedConstraints != nbConstraints()) {
+      // Constraints may have been added to the model since the partition
+      partition(G);
+    }
+    factorizeDependent(G);
+    utils::Vector error(m_rows.size());
+    for (size_t i = 0; i < m_rows.size(); ++i) {
+      error(static_cast<unsigned int>(i)) = m_error(m_rows[i]);
+    }
+    utils::Vector step(m_dependentFactorization.solve(error));
+    for (size_t i = 0; i < m_dependent.size(); ++i) {
+      Q(m_dependent[i]) -= step(static_cast<unsigned int>(i));
+    }
+  }
+  return false;
+}
+
+void rigidbody::LoopConstraintSolver::projectVelocities(
+    const rigidbody::GeneralizedCoordinates& Q,
+    rigidbody::GeneralizedVelocity& Qdot) {
+  utils::Matrix G(utils::Matrix::Zero(nbConstraints(), m_model.nbQdot()));
+  RigidBodyDynamics::CalcConstraintsJacobian(
+      m_model, Q, m_constraints, G, true);
+  if (!m_isPartitioned || m_nbPartitionedConstraints != nbConstraints()) {
+    // Constraints may have been added to the model since the partition
+    partition(G);
+  }
+  factorizeDependent(G);
+
+  // G_d * Qdot_d = -G_i * Qdot_i
+  utils::Vector rhs(utils::Vector::Zero(m_rows.size()));
+  for (size_t i = 0; i < m_rows.size(); ++i) {
+    for (size_t j = 0; j < m_independent.size(); ++j) {
+      rhs(static_cast<unsigned int>(i)) -=
+          G(m_rows[i], m_independent[j]) * Qdot(m_independent[j]);
+    }
+  }
+  utils::Vector dependentVelocity(m_dependentFactorization.solve(rhs));
+  for (size_t i = 0; i < m_dependent.size(); ++i) {
+    Qdot(m_dependent[i]) = dependentVelocity(static_cast<unsigned int>(i));
+  }
+}
+
+void rigidbody::LoopConstraintSolver::partition(const Eigen::MatrixXd& G) {
+  unsigned int nbRows(static_cast<unsigned int>(G.rows()));
+  unsigned int nbDof(static_cast<unsigned int>(G.cols()));
+
+  // Independent constraints: the pivots of a column pivoting QR of G^T
+  Eigen::ColPivHouseholderQR<Eigen::MatrixXd> rowQr(nbDof, nbRows);
+  rowQr.setThreshold(rankThreshold);
+  rowQr.compute(G.transpose());
+  unsigned int rank(static_cast<unsigned int>(rowQr.rank()));
+  m_rows.clear();
+  for (unsigned int i = 0; i < rank; ++i) {
+    m_rows.push_back(
+        static_cast<unsigned int>(rowQr.colsPermutation().indices()(i)));
+  }
+  std::sort(m_rows.begin(), m_rows.end());
+
+  // Dependent coordinates: the pivots of a column pivoting QR of G_rows
+  m_jacobian.resize(rank, nbDof);
+  for (unsigned int i = 0; i < rank; ++i) {
+    m_jacobian.row(i) = G.row(m_rows[i]);
+  }
+  Eigen::ColPivHouseholderQR<Eigen::MatrixXd> colQr(m_jacobian);
+  std::vector<bool> isDependent(nbDof, false);
+  for (unsigned int i = 0; i < rank; ++i) {
+    isDependent[colQr.colsPermutation().indices()(i)] = true;
+  }
+  m_dependent.clear();
+  m_independent.clear();
+  for (unsigned int j = 0; j < nbDof; ++j) {
+    if (isDependent[j]) {
+      m_dependent.push_back(j);
+    } else {
+      m_independent.push_back(j);
+    }
+  }
+  m_isPartitioned = true;
+  m_nbPartitionedConstraints = nbRows;
+}
+
+void rigidbody::LoopConstraintSolver::factorizeDependent(
+    const Eigen::MatrixXd& G) {
+  for (unsigned int attempt = 0; attempt < 2; ++attempt) {
+    unsigned int rank(static_cast<unsigned int>(m_rows.size()));
+    m_dependentJacobian.resize(rank, rank);
+    for (unsigned int i = 0; i < rank; ++i) {
+      for (unsigned int j = 0; j < rank; ++j) {
+        m_dependentJacobian(i, j) = G(m_rows[i], m_dependent[j]);
+      }
+    }
+    m_dependentFactorization.compute(m_dependentJacobian);
+    if (rank == 0 || m_dependentFactorization.rcond() > conditionThreshold) {
+      return;
+    }
+    // The mechanism moved too far from where the partition was chosen
+    partition(G);
+  }
+}
+
+void rigidbody::LoopConstraintSolver::solveRangeSpace(
+    const Eigen::MatrixXd& G,
+    const utils::Vector& effects,
+    rigidbody::GeneralizedAcceleration& Qddot) {
+  m_massFactorization.compute(m_constraints.H);
+  utils::Error::check(
+      m_massFactorization.info() == Eigen::Success,
+      "The mass matrix is not positive definite");
+  Qddot = m_massFactorization.solve(effects);
+  if (m_rows.empty()) {
+    return;
+  }
+
+  for (unsigned int attempt = 0; attempt < 2; ++attempt) {
+    // Schur complement G H^-1 G^T = (L^-1 G^T)^T (L^-1 G^T)
+    unsigned int rank(static_cast<unsigned int>(m_rows.size()));
+    m_scaledJacobian.resize(G.cols(), rank);
+    for (unsigned int i = 0; i < rank; ++i) {
+      m_scaledJacobian.col(i) = G.row(m_rows[i]).transpose();
+    }
+    m_massFactorization.matrixL().solveInPlace(m_scaledJacobian);
+    m_schur = m_scaledJacobian.transpose() * m_scaledJacobian;
+    m_reducedFactorization.compute(m_schur);
+    if (m_reducedFactorization.info() == Eigen::Success) {
+      break;
+    }
+    utils::Error::check(
+        attempt == 0, "The constraints could not be factorized");
+    partition(G);
+  }
+
+  // lambda = (G H^-1 G^T)^-1 (gamma - G H^-1 (tau - C))
+  unsigned int rank(static_cast<unsigned int>(m_rows.size()));
+  utils::Vector rhs(rank);
+  for (unsigned int i = 0; i < rank; ++i) {
+    rhs(i) = m_gamma(m_rows[i]) - G.row(m_rows[i]).dot(Qddot);
+  }
+  utils::Vector lambda(m_reducedFactorization.solve(rhs));
+  for (unsigned int i = 0; i < rank; ++i) {
+    m_forces(m_rows[i]) = lambda(i);
+  }
+
+  // Qddot += H^-1 G^T lambda = L^-T (L^-1 G^T) lambda
+  utils::Vector correction(m_scaledJacobian * lambda);
+  m_massFactorization.matrixU().solveInPlace(correction);
+  Qddot += correction;
+}
+
+void rigidbody::LoopConstraintSolver::solveNullSpace(
+    const Eigen::MatrixXd& G,
+    const utils::Vector& effects,
+    rigidbody::GeneralizedAcceleration& Qddot) {
+  factorizeDependent(G);
+  const Eigen::MatrixXd& H(m_constraints.H);
+  unsigned int nbDof(static_cast<unsigned int>(G.cols()));
+  unsigned int rank(static_cast<unsigned int>(m_rows.size()));
+  unsigned int nbFree(nbDof - rank);
+
+  // Qddot = N * Qddot_i + particular, with G_d Qddot_d = gamma - G_i Qddot_i
+  utils::Matrix independentJacobian(rank, nbFree);
+  utils::Vector gamma(rank);
+  for (unsigned int i = 0; i < rank; ++i) {
+    for (unsigned int j = 0; j < nbFree; ++j) {
+      independentJacobian(i, j) = G(m_rows[i], m_independent[j]);
+    }
+    gamma(i) = m_gamma(m_rows[i]);
+  }
+  utils::Matrix dependentPart(
+      m_dependentFactorization.solve(independentJacobian));
+  utils::Vector dependentAcceleration(m_dependentFactorization.solve(gamma));
+  m_nullSpace = utils::Matrix::Zero(nbDof, nbFree);
+  utils::Vector particular(utils::Vector::Zero(nbDof));
+  for (unsigned int j = 0; j < nbFree; ++j) {
+    m_nullSpace(m_independent[j], j) = 1;
+  }
+  for (unsigned int i = 0; i < rank; ++i) {
+    m_nullSpace.row(m_dependent[i]) = -dependentPart.row(i);
+    particular(m_dependent[i]) = dependentAcceleration(i);
+  }
+
+  // (N^T H N) Qddot_i = N^T (tau - C - H particular)
+  m_reducedMass = m_nullSpace.transpose() * H * m_nullSpace;
+  m_reducedFactorization.compute(m_reducedMass);
+  utils::Error::check(
+      m_reducedFactorization.info() == Eigen::Success,
+      "The reduced mass matrix is not positive definite");
+  utils::Vector residual(effects - H * particular);
+  utils::Vector independentAcceleration(
+      m_reducedFactorization.solve(m_nullSpace.transpose() * residual));
+  Qddot = m_nullSpace * independentAcceleration + particular;
+
+  // G^T lambda = H Qddot - (tau - C), the dependent rows are enough
+  utils::Vector generalizedForces(H * Qddot - effects);
+  utils::Vector dependentForces(rank);
+  for (unsigned int i = 0; i < rank; ++i) {
+    dependentForces(i) = generalizedForces(m_dependent[i]);
+  }
+  utils::Vector lambda(
+      m_dependentFactorization.transpose().solve(dependentForces));
+  for (unsigned int i = 0; i < rank; ++i) {
+    m_forces(m_rows[i]) = lambda(i);
+  }
+}
+#endif
@@ -0,0 +1,342 @@
+#define BIORBD_API_EXPORTS
+#include "RigidBody/RigidContactSolver.h"
+
+#ifndef BIORBD_USE_CASADI_MATH
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <rbdl/Constraints.h>
+
+#include "BiorbdModel.h"
+#include "RigidBody/Contacts.h"
+#include "RigidBody/ExternalForceSet.h"
+#include "RigidBody/GeneralizedCoordinates.h"
+#include "RigidBody/GeneralizedTorque.h"
+#include "RigidBody/GeneralizedVelocity.h"
+#include "RigidBody/Joints.h"
+#include "RigidBody/NodeSegment.h"
+#include "Utils/Error.h"
+#include "Utils/String.h"
+
+using namespace BIORBD_NAMESPACE;
+
+rigidbody::RigidContactSolver::RigidContactSolver(
+    Model& model,
+    double friction,
+    unsigned int normalAxis)
+    : m_model(model),
+      m_constraints(model.getConstraints()),
+      m_normalAxis(normalAxis),
+      m_friction(friction),
+      m_restitution(0),
+      m_stabilization(0.2),
+      m_maxIterations(100),
+      m_tolerance(1e-10),
+      m_nbIterations(0),
+      m_nbClassifiedConstraints(0) {
+  utils::Error::check(normalAxis < 3, "The normal axis must be 0, 1 or 2");
+  utils::Error::check(friction >= 0, "The friction must be positive");
+  classifyConstraints();
+}
+
+rigidbody::RigidContactSolver::~RigidContactSolver() {}
+
+void rigidbody::RigidContactSolver::setFriction(double friction) {
+  utils::Error::check(friction >= 0, "The friction must be positive");
+  m_friction = friction;
+}
+
+double rigidbody::RigidContactSolver::friction() const {
+  return m_friction;
+}
+
+void rigidbody::RigidContactSolver::setRestitution(double restitution) {
+  utils::Error::check(
+      restitution >= 0 && restitution <= 1,
+      "The restitution must be between 0 and 1");
+  m_restitution = restitution;
+}
+
+double rigidbody::RigidContactSolver::restitution() const {
+  return m_restitution;
+}
+
+void rigidbody::RigidContactSolver::setStabilization(double stabilization) {
+  utils::Error::check(
+      stabilization >= 0 && stabilization <= 1,
+      "The stabilization must be between 0 and 1");
+  m_stabilization = stabilization;
+}
+
+double rigidbody::RigidContactSolver::stabilization() const {
+  return m_stabilization;
+}
+
+void rigidbody::RigidContactSolver::setIterations(
+    size_t maxIterations,
+    double tolerance) {
+  m_maxIterations = maxIterations;
+  m_tolerance = tolerance;
+}
+
+size_t rigidbody::RigidContactSolver::nbUnilateralContacts() const {
+  return m_normalRows.size();
+}
+
+rigidbody::GeneralizedVelocity rigidbody::RigidContactSolver::timeStep(
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    const rigidbody::GeneralizedTorque& Tau,
+    double dt) {
+  rigidbody::ExternalForceSet forceSet(m_model);
+  return timeStep(Q, Qdot, Tau, dt, forceSet);
+}
+
+rigidbody::GeneralizedVelocity rigidbody::RigidContactSolver::timeStep(
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    const rigidbody::GeneralizedTorque& Tau,
+    double dt,
+    rigidbody::ExternalForceSet& externalForces) {
+  rigidbody::Joints& updatedModel = m_model.UpdateKinematicsCustom(&Q, &Qdot);
+  auto fExt = externalForces.computeRbdlSpatialVectors(updatedModel, Q, Qdot);
+  rigidbody::GeneralizedTorque dampedTau(Tau - m_model.computeDampedTau(Qdot));
+
+  RigidBodyDynamics::CalcConstrainedSystemVariables(
+      updatedModel, Q, Qdot, dampedTau, m_constraints, &fExt);
+  utils::Vector effects(dt * (dampedTau - m_constraints.C));
+  if (m_nbClassifiedConstraints != m_constraints.size()) {
+    // Constraints were added to the model since they were classified
+    classifyConstraints();
+  }
+  updateGaps(Q);
+  rigidbody::GeneralizedVelocity QdotPost(m_model);
+  solve(Qdot, effects, dt, QdotPost);
+  return QdotPost;
+}
+
+rigidbody::GeneralizedVelocity rigidbody::RigidContactSolver::impact(
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& QdotPre) {
+  rigidbody::Joints& updatedModel =
+      m_model.UpdateKinematicsCustom(&Q, &QdotPre);
+  rigidbody::GeneralizedTorque Tau(m_model);
+  Tau.setZero();
+
+  RigidBodyDynamics::CalcConstrainedSystemVariables(
+      updatedModel, Q, QdotPre, Tau, m_constraints);
+  utils::Vector effects(utils::Vector::Zero(m_model.nbQdot()));
+  if (m_nbClassifiedConstraints != m_constraints.size()) {
+    // Constraints were added to the model since they were classified
+    classifyConstraints();
+  }
+  updateGaps(Q);
+  rigidbody::GeneralizedVelocity QdotPost(m_model);
+  solve(QdotPre, effects, 0, QdotPost);
+  return QdotPost;
+}
+
+const utils::Vector& rigidbody::RigidContactSolver::impulses() const {
+  return m_impulses;
+}
+
+const utils::Vector& rigidbody::RigidContactSolver::gaps() const {
+  return m_gaps;
+}
+
+size_t rigidbody::RigidContactSolver::nbIterations() const {
+  return m_nbIterations;
+}
+
+void rigidbody::RigidContactSolver::resetWarmStart() {
+  m_impulses.setZero();
+}
+
+void rigidbody::RigidContactSolver::classifyConstraints() {
+  // The rigid contacts are added one row per axis, named after the contact
+  // with the axis as suffix (see Contacts::AddConstraint)
+  std::map<std::string, std::vector<unsigned int>> contactRows;
+  std::map<std::string, size_t> contactIndex;
+  for (size_t i = 0; i < m_constraints.rigidContacts().size(); ++i) {
+    contactRows[m_constraints.rigidContacts()[i].name()];
+    contactIndex[m_constraints.rigidContacts()[i].name()] = i;
+  }
+
+  const char normalSuffix("XYZ"[m_normalAxis]);
+  size_t nbRows(m_constraints.size());
+  std::vector<bool> isContact(nbRows, false);
+  std::map<std::string, int> normalRow;
+  for (unsigned int i = 0; i < nbRows; ++i) {
+    const std::string& name(m_constraints.name[i]);
+    if (name.size() < 3 || name[name.size() - 2] != '_') {
+      continue;
+    }
+    std::string contact(name.substr(0, name.size() - 2));
+    if (contactRows.find(contact) == contactRows.end()) {
+      continue;
+    }
+    contactRows[contact].push_back(i);
+    if (name[name.size() - 1] == normalSuffix) {
+      normalRow[contact] = static_cast<int>(i);
+    }
+    isContact[i] = true;
+  }
+
+  m_bilateralRows.clear();
+  m_normalRows.clear();
+  m_tangentRows.clear();
+  m_contactIndices.clear();
+  for (unsigned int i = 0; i < nbRows; ++i) {
+    if (!isContact[i]) {
+      m_bilateralRows.push_back(i);
+    }
+  }
+  for (auto it = contactRows.begin(); it != contactRows.end(); ++it) {
+    if (normalRow.find(it->first) == normalRow.end()) {
+      // Not declared along the normal, the contact stays bilateral
+      m_bilateralRows.insert(
+          m_bilateralRows.end(), it->second.begin(), it->second.end());
+      continue;
+    }
+    unsigned int normal(static_cast<unsigned int>(normalRow[it->first]));
+    m_normalRows.push_back(normal);
+    m_contactIndices.push_back(contactIndex[it->first]);
+    m_tangentRows.push_back(std::vector<unsigned int>());
+    for (size_t k = 0; k < it->second.size(); ++k) {
+      if (it->second[k] != normal) {
+        m_tangentRows.back().push_back(it->second[k]);
+      }
+    }
+    utils::Error::check(
+        m_tangentRows.back().size() <= 2,
+        "The names of the rigid contacts must be unique");
+  }
+  std::sort(m_bilateralRows.begin(), m_bilateralRows.end());
+  m_impulses = utils::Vector::Zero(static_cast<unsigned int>(nbRows));
+  m_gaps = utils::Vector::Zero(static_cast<unsigned int>(m_normalRows.size()));
+  m_nbClassifiedConstraints = nbRows;
+}
+
+void rigidbody::RigidContactSolver::updateGaps(
+    const rigidbody::GeneralizedCoordinates& Q) {
+  // The ground is the plane through the origin normal to the normal axis. The
+  // kinematics is already updated by the caller
+  for (size_t c = 0; c < m_normalRows.size(); ++c) {
+    m_gaps(static_cast<unsigned int>(c)) =
+        m_model.rigidContact(Q, m_contactIndices[c], false)(m_normalAxis);
+  }
+}
+
+void rigidbody::RigidContactSolver::solve(
+    const rigidbody::GeneralizedVelocity& Qdot,
+    const utils::Vector& effects,
+    double dt,
+    rigidbody::GeneralizedVelocity& QdotPost) {
+  m_massFactorization.compute(m_constraints.H);
+  utils::Error::check(
+      m_massFactorization.info() == Eigen::Success,
+      "The mass matrix is not positive definite");
+  QdotPost = Qdot + m_massFactorization.solve(effects);
+  m_nbIterations = 0;
+  if (m_impulses.size() == 0) {
+    return;
+  }
+
+  // Delassus matrix G H^-1 G^T = (L^-1 G^T)^T (L^-1 G^T), built once per call
+  const Eigen::MatrixXd& G(m_constraints.G);
+  m_scaledJacobian = G.transpose();
+  m_massFactorization.matrixL().solveInPlace(m_scaledJacobian);
+  m_delassus = m_scaledJacobian.transpose() * m_scaledJacobian;
+
+  // Velocity of the constraints without impulses. A contact only pushes if
+  // it would go through the ground by the end of the step, so the normal
+  // velocity is aimed at -gap / dt when the contact is away from the ground
+  // (v_n >= -gap / dt). When it is in the ground, the normal velocity is aimed
+  // at pushing a part of the penetration out during the step and, if the
+  // contact was approaching, at -restitution times that velocity. An impact
+  // (dt = 0) only involves the contacts that touch the ground
+  m_velocity = G * QdotPost;
+  m_isActive.assign(m_normalRows.size(), true);
+  for (size_t c = 0; c < m_normalRows.size(); ++c) {
+    unsigned int n(m_normalRows[c]);
+    double gap(m_gaps(static_cast<unsigned int>(c)));
+    if (gap > 0) {
+      if (dt > 0) {
+        m_velocity(n) += gap / dt;
+      } else {
+        m_isActive[c] = false;
+      }
+    } else {
+      if (dt > 0) {
+        m_velocity(n) += m_stabilization * gap / dt;
+      }
+      m_velocity(n) += m_restitution * std::min(G.row(n).dot(Qdot), 0.0);
+    }
+    if (!m_isActive[c]) {
+      m_impulses(n) = 0;
+      for (size_t k = 0; k < m_tangentRows[c].size(); ++k) {
+        m_impulses(m_tangentRows[c][k]) = 0;
+      }
+    }
+  }
+
+  // Projected Gauss-Seidel, starting from the impulses of the previous call
+  for (m_nbIterations = 1; m_nbIterations <= m_maxIterations;
+       ++m_nbIterations) {
+    double change(0);
+    for (size_t k = 0; k < m_bilateralRows.size(); ++k) {
+      unsigned int i(m_bilateralRows[k]);
+      if (m_delassus(i, i) <= 0) {
+        continue;
+      }
+      double residual(m_delassus.row(i).dot(m_impulses) + m_velocity(i));
+      double delta(-residual / m_delassus(i, i));
+      m_impulses(i) += delta;
+      change = std::max(change, std::fabs(delta));
+    }
+    for (size_t c = 0; c < m_normalRows.size(); ++c) {
+      if (!m_isActive[c]) {
+        continue;
+      }
+      unsigned int n(m_normalRows[c]);
+      double previous(m_impulses(n));
+      if (m_delassus(n, n) > 0) {
+        double residual(m_delassus.row(n).dot(m_impulses) + m_velocity(n));
+        m_impulses(n) = std::max(0.0, previous - residual / m_delassus(n, n));
+      }
+      change = std::max(change, std::fabs(m_impulses(n) - previous));
+
+      // Friction, projected on the Coulomb disk of the new normal impulse
+      const std::vector<unsigned int>& tangents(m_tangentRows[c]);
+      double initial[2] = {0, 0};
+      double norm(0);
+      for (size_t k = 0; k < tangents.size(); ++k) {
+        unsigned int t(tangents[k]);
+        initial[k] = m_impulses(t);
+        if (m_delassus(t, t) > 0) {
+          double residual(m_delassus.row(t).dot(m_impulses) + m_velocity(t));
+          m_impulses(t) -= residual / m_delassus(t, t);
+        }
+        norm += m_impulses(t) * m_impulses(t);
+      }
+      norm = std::sqrt(norm);
+      double bound(m_friction * m_impulses(n));
+      double scale(norm > bound ? (norm > 0 ? bound / norm : 0) : 1);
+      for (size_t k = 0; k < tangents.size(); ++k) {
+        unsigned int t(tangents[k]);
+        m_impulses(t) *= scale;
+        change = std::max(change, std::fabs(m_impulses(t) - initial[k]));
+      }
+    }
+    if (change < m_tolerance) {
+      break;
+    }
+  }
+  m_nbIterations = std::min(m_nbIterations, m_maxIterations);
+
+  // QdotPost += H^-1 G^T p = L^-T (L^-1 G^T) p
+  utils::Vector correction(m_scaledJacobian * m_impulses);
+  m_massFactorization.matrixU().solveInPlace(correction);
+  QdotPost += correction;
+}
+#endif
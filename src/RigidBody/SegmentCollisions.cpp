@@ -0,0 +1,188 @@
+#define BIORBD_API_EXPORTS
+#include "RigidBody/SegmentCollisions.h"
+
+#ifndef BIORBD_USE_CASADI_MATH
+#include <algorithm>
+#include <limits>
+
+#include "RigidBody/ContactSurface.h"
+#include "RigidBody/GeneralizedCoordinates.h"
+#include "RigidBody/Joints.h"
+#include "RigidBody/Mesh.h"
+#include "RigidBody/Segment.h"
+#include "RigidBody/SegmentCharacteristics.h"
+#include "Utils/Error.h"
+#include "Utils/Rotation.h"
+#include "Utils/RotoTrans.h"
+#include "Utils/String.h"
+
+using namespace BIORBD_NAMESPACE;
+
+rigidbody::SegmentCollisions::SegmentCollisions() {}
+
+rigidbody::SegmentCollisions::SegmentCollisions(
+    const rigidbody::Joints& model,
+    bool ignoreAdjacentSegments) {
+  build(model, ignoreAdjacentSegments);
+}
+
+rigidbody::SegmentCollisions::~SegmentCollisions() {}
+
+void rigidbody::SegmentCollisions::build(
+    const rigidbody::Joints& model,
+    bool ignoreAdjacentSegments) {
+  m_segment.clear();
+  m_meshes.clear();
+  for (size_t i = 0; i < model.nbSegment(); ++i) {
+    const rigidbody::Mesh& mesh(model.segment(i).characteristics().mesh());
+    if (!mesh.hasMesh() || mesh.faces().empty()) {
+      continue;
+    }
+    m_segment.push_back(i);
+    m_meshes.push_back(std::make_shared<rigidbody::ContactSurface>(mesh));
+  }
+  m_rotation.assign(m_meshes.size(), utils::Matrix3d::Identity());
+  m_translation.assign(m_meshes.size(), utils::Vector3d(0, 0, 0));
+  m_lower.assign(m_meshes.size(), utils::Vector3d(0, 0, 0));
+  m_upper.assign(m_meshes.size(), utils::Vector3d(0, 0, 0));
+
+  m_first.clear();
+  m_second.clear();
+  for (size_t i = 0; i < m_meshes.size(); ++i) {
+    const rigidbody::Segment& first(model.segment(m_segment[i]));
+    for (size_t j = i + 1; j < m_meshes.size(); ++j) {
+      const rigidbody::Segment& second(model.segment(m_segment[j]));
+      if (ignoreAdjacentSegments &&
+          (!first.parent().compare(second.name()) ||
+           !second.parent().compare(first.name()))) {
+        continue;
+      }
+      m_first.push_back(i);
+      m_second.push_back(j);
+    }
+  }
+  m_distance.assign(nbPairs(), 0);
+  m_isColliding.assign(nbPairs(), false);
+  m_penetration.assign(nbPairs(), 0);
+  m_firstPoint.assign(nbPairs(), utils::Vector3d(0, 0, 0));
+  m_secondPoint.assign(nbPairs(), utils::Vector3d(0, 0, 0));
+}
+
+size_t rigidbody::SegmentCollisions::nbPairs() const {
+  return m_first.size();
+}
+
+size_t rigidbody::SegmentCollisions::firstSegment(size_t idx) const {
+  utils::Error::check(
+      idx < nbPairs(), "Idx is higher than the number of pairs");
+  return m_segment[m_first[idx]];
+}
+
+size_t rigidbody::SegmentCollisions::secondSegment(size_t idx) const {
+  utils::Error::check(
+      idx < nbPairs(), "Idx is higher than the number of pairs");
+  return m_segment[m_second[idx]];
+}
+
+void rigidbody::SegmentCollisions::update(
+    rigidbody::Joints& model,
+    const rigidbody::GeneralizedCoordinates& Q,
+    double maxDistance,
+    bool updateKin) {
+  update(model.allGlobalJCS(Q, updateKin), maxDistance);
+}
+
+void rigidbody::SegmentCollisions::update(
+    const std::vector<utils::RotoTrans>& jcs,
+    double maxDistance) {
+  // Broad phase, the box of each mesh is moved with its segment
+  for (size_t m = 0; m < m_meshes.size(); ++m) {
+    utils::Error::check(
+        m_segment[m] < jcs.size(), "There must be one frame per segment");
+    m_rotation[m] = jcs[m_segment[m]].rot();
+    m_translation[m] = jcs[m_segment[m]].trans();
+    m_meshes[m]->boundingBox(
+        m_rotation[m], m_translation[m], m_lower[m], m_upper[m]);
+  }
+
+  for (size_t p = 0; p < nbPairs(); ++p) {
+    size_t i(m_first[p]);
+    size_t j(m_second[p]);
+    m_distance[p] = std::numeric_limits<double>::infinity();
+    m_isColliding[p] = false;
+    m_penetration[p] = 0;
+
+    bool isFar(false);
+    for (unsigned int k = 0; k < 3; ++k) {
+      if (m_lower[j](k) - m_upper[i](k) > maxDistance ||
+          m_lower[i](k) - m_upper[j](k) > maxDistance) {
+        isFar = true;
+      }
+    }
+    if (isFar) {
+      continue;
+    }
+
+    // Narrow phase, in the reference frame of the first mesh
+    utils::Matrix3d rotation(m_rotation[i].transpose() * m_rotation[j]);
+    utils::Vector3d translation(
+        m_rotation[i].transpose() * (m_translation[j] - m_translation[i]));
+    utils::Vector3d firstPoint(0, 0, 0);
+    utils::Vector3d secondPoint(0, 0, 0);
+    if (!m_meshes[i]->distance(
+            *m_meshes[j],
+            rotation,
+            translation,
+            maxDistance,
+            m_distance[p],
+            firstPoint,
+            secondPoint)) {
+      m_distance[p] = std::numeric_limits<double>::infinity();
+      continue;
+    }
+    m_firstPoint[p] = m_rotation[i] * firstPoint + m_translation[i];
+    m_secondPoint[p] = m_rotation[i] * secondPoint + m_translation[i];
+
+    if (m_distance[p] == 0) {
+      m_isColliding[p] = true;
+      utils::Matrix3d inverseRotation(rotation.transpose());
+      m_penetration[p] = std::max(
+          m_meshes[i]->penetration(*m_meshes[j], rotation, translation),
+          m_meshes[j]->penetration(
+              *m_meshes[i], inverseRotation, -(inverseRotation * translation)));
+    }
+  }
+}
+
+double rigidbody::SegmentCollisions::distance(size_t idx) const {
+  utils::Error::check(
+      idx < nbPairs(), "Idx is higher than the number of pairs");
+  return m_distance[idx];
+}
+
+bool rigidbody::SegmentCollisions::isColliding(size_t idx) const {
+  utils::Error::check(
+      idx < nbPairs(), "Idx is higher than the number of pairs");
+  return m_isColliding[idx];
+}
+
+double rigidbody::SegmentCollisions::penetration(size_t idx) const {
+  utils::Error::check(
+      idx < nbPairs(), "Idx is higher than the number of pairs");
+  return m_penetration[idx];
+}
+
+const utils::Vector3d& rigidbody::SegmentCollisions::firstPoint(
+    size_t idx) const {
+  utils::Error::check(
+      idx < nbPairs(), "Idx is higher than the number of pairs");
+  return m_firstPoint[idx];
+}
+
+const utils::Vector3d& rigidbody::SegmentCollisions::secondPoint(
+    size_t idx) const {
+  utils::Error::check(
+      idx < nbPairs(), "Idx is higher than the number of pairs");
+  return m_secondPoint[idx];
+}
+#endif
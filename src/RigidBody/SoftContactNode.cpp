@@ -115,6 +115,21 @@ utils::SpatialVector rigidbody::SoftContactNode::computeForceAtOrigin(
   return out;
 }
 
+void rigidbody::SoftContactNode::setContactPlane(
+    const utils::Vector3d &origin,
+    const utils::Vector3d &normal) {
+  m_contactPlane->first = origin;
+  m_contactPlane->second = normal;
+}
+
+const utils::Vector3d &rigidbody::SoftContactNode::contactPlaneOrigin() const {
+  return m_contactPlane->first;
+}
+
+const utils::Vector3d &rigidbody::SoftContactNode::contactPlaneNormal() const {
+  return m_contactPlane->second;
+}
+
 void rigidbody::SoftContactNode::setType() {
   *m_typeOfNode = utils::NODE_TYPE::SOFT_CONTACT;
 }
@@ -0,0 +1,417 @@
+#define BIORBD_API_EXPORTS
+#include "RigidBody/SoftContactSet.h"
+
+#include <cmath>
+#include <limits>
+#include <rbdl/Kinematics.h>
+
+#include "RigidBody/GeneralizedCoordinates.h"
+#include "RigidBody/GeneralizedVelocity.h"
+#include "RigidBody/Joints.h"
+#include "RigidBody/Segment.h"
+#include "RigidBody/SoftContactNode.h"
+#include "RigidBody/SoftContactSphere.h"
+#include "Utils/Error.h"
+#include "Utils/String.h"
+#include "Utils/UtilsEnum.h"
+
+using namespace BIORBD_NAMESPACE;
+
+rigidbody::SoftContactSet::SoftContactSet() {}
+
+rigidbody::SoftContactSet::SoftContactSet(
+    const rigidbody::Joints& model,
+    const std::vector<std::shared_ptr<rigidbody::SoftContactNode>>&
+        contacts) {
+  compile(model, contacts);
+}
+
+rigidbody::SoftContactSet::~SoftContactSet() {}
+
+void rigidbody::SoftContactSet::compile(
+    const rigidbody::Joints& model,
+    const std::vector<std::shared_ptr<rigidbody::SoftContactNode>>&
+        contacts) {
+  unsigned int nbContacts(static_cast<unsigned int>(contacts.size()));
+  m_bodyId.clear();
+  m_bodyOrigin.clear();
+  m_bodyRotation.clear();
+  m_bodyAngularVelocity.clear();
+  m_bodyVelocity.clear();
+  m_contactBody.clear();
+  m_outIndex.clear();
+  m_pointInLocal.clear();
+  m_planeOrigin.clear();
+  m_planeNormal.clear();
+
+  m_radius = utils::Vector::Zero(nbContacts);
+  m_stiffness = utils::Vector::Zero(nbContacts);
+  m_damping = utils::Vector::Zero(nbContacts);
+  m_muStatic = utils::Vector::Zero(nbContacts);
+  m_muDynamic = utils::Vector::Zero(nbContacts);
+  m_muViscous = utils::Vector::Zero(nbContacts);
+  m_transitionVelocity = utils::Vector::Zero(nbContacts);
+
+  for (size_t i = 0; i < contacts.size(); ++i) {
+    const rigidbody::SoftContactNode& contact(*contacts[i]);
+    utils::Error::check(
+        contact.typeOfNode() == utils::NODE_TYPE::SOFT_CONTACT_SPHERE,
+        "Soft contact type not found");
+    const rigidbody::SoftContactSphere& sphere(
+        static_cast<const rigidbody::SoftContactSphere&>(contact));
+
+    unsigned int id(model.GetBodyId(contact.parent().c_str()));
+    utils::Error::check(
+        id != std::numeric_limits<unsigned int>::max(),
+        utils::String("Segment ") + contact.parent() +
+            " could not be found in the model");
+    m_contactBody.push_back(bodyIndex(id));
+    // Do not subtract 1 because 0 is the base
+    m_outIndex.push_back(
+        model.segment(contact.parent())
+            .getLastDofIndexInGeneralizedCoordinates(model) +
+        1);
+    m_pointInLocal.push_back(contact);
+    m_planeOrigin.push_back(contact.contactPlaneOrigin());
+    m_planeNormal.push_back(contact.contactPlaneNormal());
+
+    unsigned int idx(static_cast<unsigned int>(i));
+    m_radius(idx) = sphere.radius();
+    m_stiffness(idx) = sphere.stiffness();
+    m_damping(idx) = sphere.damping();
+    m_muStatic(idx) = sphere.muStatic();
+    m_muDynamic(idx) = sphere.muDynamic();
+    m_muViscous(idx) = sphere.muViscous();
+    m_transitionVelocity(idx) = sphere.transitionVelocity();
+  }
+
+  m_positions.assign(contacts.size(), utils::Vector3d(0, 0, 0));
+  m_velocities.assign(contacts.size(), utils::Vector3d(0, 0, 0));
+  m_angularVelocities.assign(contacts.size(), utils::Vector3d(0, 0, 0));
+  m_forces.assign(contacts.size(), utils::Vector3d(0, 0, 0));
+  m_forcesAtOrigin.assign(
+      contacts.size(), utils::SpatialVector(0., 0., 0., 0., 0., 0.));
+}
+
+size_t rigidbody::SoftContactSet::nbSoftContacts() const {
+  return m_contactBody.size();
+}
+
+void rigidbody::SoftContactSet::setContactPlane(
+    size_t idx,
+    const utils::Vector3d& origin,
+    const utils::Vector3d& normal) {
+  utils::Error::check(
+      idx < nbSoftContacts(), "Idx is higher than the number of contacts");
+  m_planeOrigin[idx] = origin;
+  m_planeNormal[idx] = normal;
+}
+
+void rigidbody::SoftContactSet::updateKinematics(
+    rigidbody::Joints& updatedModel,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot) {
+  // Frame and velocity of each body carrying at least one contact
+  const utils::Vector3d zero(0, 0, 0);
+  for (size_t b = 0; b < m_bodyId.size(); ++b) {
+    m_bodyOrigin[b] = RigidBodyDynamics::CalcBodyToBaseCoordinates(
+        updatedModel, Q, m_bodyId[b], zero, false);
+    m_bodyRotation[b] = RigidBodyDynamics::CalcBodyWorldOrientation(
+        updatedModel, Q, m_bodyId[b], false);
+    RigidBodyDynamics::Math::SpatialVector v(
+        RigidBodyDynamics::CalcPointVelocity6D(
+            updatedModel, Q, Qdot, m_bodyId[b], zero, false));
+    m_bodyAngularVelocity[b] = v.block(0, 0, 3, 1);
+    m_bodyVelocity[b] = v.block(3, 0, 3, 1);
+  }
+
+  // Position and velocity of the contacts: v_p = v_o + w x (p - o)
+  for (size_t i = 0; i < nbSoftContacts(); ++i) {
+    size_t b(m_contactBody[i]);
+    utils::Vector3d r(m_bodyRotation[b].transpose() * m_pointInLocal[i]);
+    m_positions[i] = m_bodyOrigin[b] + r;
+    m_velocities[i] = m_bodyVelocity[b] + m_bodyAngularVelocity[b].cross(r);
+    m_angularVelocities[i] = m_bodyAngularVelocity[b];
+  }
+}
+
+void rigidbody::SoftContactSet::computeForces() {
+  // Same as SoftContactSphere::computeForce and applicationPoint
+  const utils::Scalar eps(1e-16);
+  const utils::Scalar bv(50);
+  const utils::Scalar bd(300);
+  for (size_t i = 0; i < nbSoftContacts(); ++i) {
+    unsigned int idx(static_cast<unsigned int>(i));
+    const utils::Vector3d& x(m_positions[i]);
+    const utils::Vector3d& dx(m_velocities[i]);
+    const utils::Vector3d& normal(m_planeNormal[i]);
+    const utils::Scalar& radius(m_radius(idx));
+    const utils::Scalar& damping(m_damping(idx));
+
+    // Decomposition into normal and tangent velocities
+    utils::Scalar normalVelocity = dx.dot(normal);
+    utils::Vector3d tangentVelocity =
+        dx - normalVelocity * normal +
+        (radius * normal).cross(m_angularVelocities[i]);
+
+    // Penetration of the sphere in the plane
+    utils::Vector3d xInPlane(x - m_planeOrigin[i]);
+    utils::Scalar delta = -(xInPlane.dot(normal) - radius);
+    utils::Scalar deltaDot = -normalVelocity;
+
+    utils::Scalar fslope =
+        (0.5 + 0.5 * std::tanh(bd * delta) + eps) *
+        (0.5 + 0.5 * std::tanh(bv * (deltaDot + 2. / 3. / damping) + eps));
+
+    // Hertz's model with Hunt-Crossley's damping
+    utils::Scalar deltaSquaredRooted(std::sqrt(delta * delta));
+    utils::Scalar forceFactor =
+        4. / 3. * m_stiffness(idx) * std::sqrt(radius) *
+        std::sqrt(deltaSquaredRooted * deltaSquaredRooted * deltaSquaredRooted);
+    utils::Scalar normalForce =
+        forceFactor * (1. + 1.5 * damping * deltaDot) * fslope;
+
+    utils::Scalar tangentVelocityNorm(
+        std::sqrt(tangentVelocity.squaredNorm() + 1e-5));
+    utils::Scalar frictionVelocity =
+        tangentVelocityNorm / m_transitionVelocity(idx);
+    utils::Scalar stribeck(0.25 * frictionVelocity * frictionVelocity + 0.75);
+    utils::Scalar forceFriction =
+        normalForce * m_muDynamic(idx) * std::tanh(4. * frictionVelocity) +
+        normalForce * (m_muStatic(idx) - m_muDynamic(idx)) * frictionVelocity /
+            (stribeck * stribeck) +
+        normalForce * m_muViscous(idx) * tangentVelocityNorm;
+
+    m_forces[i] = normalForce * normal +
+                  forceFriction * -tangentVelocity / tangentVelocityNorm;
+
+    // Transport at the origin from the application point
+    utils::Vector3d applicationPoint(xInPlane - delta * normal);
+    m_forcesAtOrigin[i].block(0, 0, 3, 1) =
+        m_forces[i].cross(-applicationPoint);
+    m_forcesAtOrigin[i].block(3, 0, 3, 1) = m_forces[i];
+  }
+}
+
+#ifndef BIORBD_USE_CASADI_MATH
+void rigidbody::SoftContactSet::addGeneralizedForceJacobians(
+    rigidbody::Joints& updatedModel,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot,
+    utils::Matrix& dTauDq,
+    utils::Matrix& dTauDqdot) {
+  utils::Error::check(
+      updatedModel.nbQuat() == 0,
+      "The soft contact derivatives are not available with quaternions");
+  unsigned int nbDof(static_cast<unsigned int>(updatedModel.nbQdot()));
+  utils::Error::check(
+      static_cast<unsigned int>(dTauDq.rows()) == nbDof &&
+          static_cast<unsigned int>(dTauDq.cols()) == nbDof &&
+          static_cast<unsigned int>(dTauDqdot.rows()) == nbDof &&
+          static_cast<unsigned int>(dTauDqdot.cols()) == nbDof,
+      "The derivatives must be of size nbQdot x nbQdot");
+
+  // Motion of each dof at the origin of the world (S_j) and velocity due to
+  // the dofs after it (sum of S_l * qdot_l for l > j). As the dofs of a body
+  // are ordered from the root, dS_l/dq_j = S_j x S_l for all l > j.
+  const utils::Vector3d zero(0, 0, 0);
+  m_bodyMotion.resize(m_bodyId.size());
+  m_bodyMotionAfter.resize(m_bodyId.size());
+  for (size_t b = 0; b < m_bodyId.size(); ++b) {
+    utils::Matrix& S(m_bodyMotion[b]);
+    utils::Matrix& V(m_bodyMotionAfter[b]);
+    S = utils::Matrix::Zero(6, nbDof);
+    V = utils::Matrix::Zero(6, nbDof);
+    RigidBodyDynamics::CalcPointJacobian6D(
+        updatedModel, Q, m_bodyId[b], zero, S, false);
+    for (unsigned int j = 0; j < nbDof; ++j) {
+      utils::Vector3d w(S.block(0, j, 3, 1));
+      S.block(3, j, 3, 1) -= w.cross(m_bodyOrigin[b]);
+    }
+    for (unsigned int j = nbDof; j > 1; --j) {
+      V.col(j - 2) = V.col(j - 1) + S.col(j - 1) * Qdot(j - 1);
+    }
+  }
+
+  const double eps(1e-16);
+  const double bv(50);
+  const double bd(300);
+  const utils::Matrix3d identity(utils::Matrix3d::Identity());
+  std::vector<utils::Vector3d> lever(nbDof, zero);
+  for (size_t i = 0; i < nbSoftContacts(); ++i) {
+    unsigned int idx(static_cast<unsigned int>(i));
+    size_t b(m_contactBody[i]);
+    const utils::Matrix& S(m_bodyMotion[b]);
+    const utils::Matrix& V(m_bodyMotionAfter[b]);
+    const utils::Vector3d& x(m_positions[i]);
+    const utils::Vector3d& w(m_angularVelocities[i]);
+    const utils::Vector3d& normal(m_planeNormal[i]);
+    const utils::Vector3d& force(m_forces[i]);
+    double radius(m_radius(idx));
+    double damping(m_damping(idx));
+    double stiffness(m_stiffness(idx));
+    double transitionVelocity(m_transitionVelocity(idx));
+
+    // Same intermediate values as computeForces
+    double normalVelocity(m_velocities[i].dot(normal));
+    utils::Vector3d tangentVelocity(
+        m_velocities[i] - normalVelocity * normal +
+        (radius * normal).cross(w));
+    utils::Vector3d xInPlane(x - m_planeOrigin[i]);
+    double delta(-(xInPlane.dot(normal) - radius));
+    double deltaDot(-normalVelocity);
+
+    double tanhDelta(std::tanh(bd * delta));
+    double tanhDeltaDot(
+        std::tanh(bv * (deltaDot + 2. / 3. / damping) + eps));
+    double slopeDelta(0.5 + 0.5 * tanhDelta + eps);
+    double slopeDeltaDot(0.5 + 0.5 * tanhDeltaDot);
+    double absDelta(std::fabs(delta));
+    double forceFactor(
+        4. / 3. * stiffness * std::sqrt(radius) * absDelta *
+        std::sqrt(absDelta));
+    double huntCrossley(1. + 1.5 * damping * deltaDot);
+    double normalForce(forceFactor * huntCrossley * slopeDelta * slopeDeltaDot);
+
+    // Normal force: d/d(delta) and d/d(deltaDot)
+    double dForceFactor(
+        2. * stiffness * std::sqrt(radius) * std::sqrt(absDelta) *
+        (delta > 0 ? 1. : (delta < 0 ? -1. : 0.)));
+    double dNormalDelta(
+        dForceFactor * huntCrossley * slopeDelta * slopeDeltaDot +
+        forceFactor * huntCrossley * 0.5 * bd * (1 - tanhDelta * tanhDelta) *
+            slopeDeltaDot);
+    double dNormalDeltaDot(
+        forceFactor * 1.5 * damping * slopeDelta * slopeDeltaDot +
+        forceFactor * huntCrossley * slopeDelta * 0.5 * bv *
+            (1 - tanhDeltaDot * tanhDeltaDot));
+
+    // Friction: F = N * n - N * g(s) / s * vt, with s the smoothed norm of vt
+    double s(std::sqrt(tangentVelocity.squaredNorm() + 1e-5));
+    double frictionVelocity(s / transitionVelocity);
+    double stribeck(0.25 * frictionVelocity * frictionVelocity + 0.75);
+    double tanhFriction(std::tanh(4. * frictionVelocity));
+    double muDifference(m_muStatic(idx) - m_muDynamic(idx));
+    double g(
+        m_muDynamic(idx) * tanhFriction +
+        muDifference * frictionVelocity / (stribeck * stribeck) +
+        m_muViscous(idx) * s);
+    double dg(
+        (4. * m_muDynamic(idx) * (1 - tanhFriction * tanhFriction) +
+         muDifference *
+             (1. / (stribeck * stribeck) -
+              frictionVelocity * frictionVelocity /
+                  (stribeck * stribeck * stribeck))) /
+            transitionVelocity +
+        m_muViscous(idx));
+    double h(g / s);
+    double dh((dg * s - g) / (s * s));
+
+    utils::Vector3d dForceNormal(normal - h * tangentVelocity);
+    utils::Matrix3d dForceTangent(
+        -normalForce * h * identity -
+        normalForce * dh / s * tangentVelocity *
+            tangentVelocity.transpose());
+    utils::Matrix3d normalCross;
+    normalCross << 0, -normal(2), normal(1), normal(2), 0, -normal(0),
+        -normal(1), normal(0), 0;
+    utils::Matrix3d dForcePosition(
+        -dNormalDelta * dForceNormal * normal.transpose());
+    utils::Matrix3d dForceVelocity(
+        -dNormalDeltaDot * dForceNormal * normal.transpose() +
+        dForceTangent * (identity - normal * normal.transpose()));
+    utils::Matrix3d dForceAngularVelocity(dForceTangent * radius * normalCross);
+
+    // The generalized force is the force projected on the motion of the dofs
+    // at the application point: tau_j = (u_j + w_j x a) . F
+    utils::Vector3d applicationPoint(xInPlane - delta * normal);
+    for (unsigned int j = 0; j < nbDof; ++j) {
+      utils::Vector3d wj(S.block(0, j, 3, 1));
+      utils::Vector3d uj(S.block(3, j, 3, 1));
+      lever[j] = uj + wj.cross(applicationPoint);
+    }
+
+    for (unsigned int k = 0; k < nbDof; ++k) {
+      utils::Vector3d wk(S.block(0, k, 3, 1));
+      utils::Vector3d uk(S.block(3, k, 3, 1));
+      if (wk.squaredNorm() == 0 && uk.squaredNorm() == 0) {
+        continue;
+      }
+      utils::Vector3d wAfter(V.block(0, k, 3, 1));
+      utils::Vector3d uAfter(V.block(3, k, 3, 1));
+
+      // Variation of the kinematics of the contact with q_k and qdot_k
+      utils::Vector3d dx(uk + wk.cross(x));
+      utils::Vector3d dw(wk.cross(wAfter));
+      utils::Vector3d du(wk.cross(uAfter) + uk.cross(wAfter));
+      utils::Vector3d dv(du + dw.cross(x) + w.cross(dx));
+      utils::Vector3d dForceQ(
+          dForcePosition * dx + dForceVelocity * dv +
+          dForceAngularVelocity * dw);
+      utils::Vector3d dForceQdot(
+          dForceVelocity * dx + dForceAngularVelocity * wk);
+      utils::Vector3d dApplicationPoint(dx + normal * normal.dot(dx));
+
+      for (unsigned int j = 0; j < nbDof; ++j) {
+        utils::Vector3d wj(S.block(0, j, 3, 1));
+        dTauDqdot(j, k) += lever[j].dot(dForceQdot);
+        double dTau(
+            lever[j].dot(dForceQ) + wj.cross(dApplicationPoint).dot(force));
+        if (j > k) {
+          // The motion of the dofs after q_k turns with it
+          utils::Vector3d uj(S.block(3, j, 3, 1));
+          dTau += (wk.cross(uj) + uk.cross(wj) +
+                   wk.cross(wj).cross(applicationPoint))
+                      .dot(force);
+        }
+        dTauDq(j, k) += dTau;
+      }
+    }
+  }
+}
+#endif
+
+void rigidbody::SoftContactSet::combineForces(
+    std::vector<utils::SpatialVector>& out) const {
+  for (size_t i = 0; i < nbSoftContacts(); ++i) {
+    out[m_outIndex[i]] += m_forcesAtOrigin[i];
+  }
+}
+
+const std::vector<utils::Vector3d>& rigidbody::SoftContactSet::positions()
+    const {
+  return m_positions;
+}
+
+const std::vector<utils::Vector3d>& rigidbody::SoftContactSet::velocities()
+    const {
+  return m_velocities;
+}
+
+const std::vector<utils::Vector3d>&
+rigidbody::SoftContactSet::angularVelocities() const {
+  return m_angularVelocities;
+}
+
+const std::vector<utils::Vector3d>& rigidbody::SoftContactSet::forces() const {
+  return m_forces;
+}
+
+const std::vector<utils::SpatialVector>&
+rigidbody::SoftContactSet::forcesAtOrigin() const {
+  return m_forcesAtOrigin;
+}
+
+size_t rigidbody::SoftContactSet::bodyIndex(unsigned int id) {
+  for (size_t b = 0; b < m_bodyId.size(); ++b) {
+    if (m_bodyId[b] == id) {
+      return b;
+    }
+  }
+  m_bodyId.push_back(id);
+  m_bodyOrigin.push_back(utils::Vector3d(0, 0, 0));
+  m_bodyRotation.push_back(utils::Matrix3d::Identity());
+  m_bodyAngularVelocity.push_back(utils::Vector3d(0, 0, 0));
+  m_bodyVelocity.push_back(utils::Vector3d(0, 0, 0));
+  return m_bodyId.size() - 1;
+}
@@ -1,11 +1,15 @@
 #define BIORBD_API_EXPORTS
 #include "RigidBody/SoftContacts.h"
 
+#include <limits>
+
+#include "RigidBody/ContactSurface.h"
 #include "RigidBody/GeneralizedCoordinates.h"
 #include "RigidBody/GeneralizedVelocity.h"
 #include "RigidBody/Joints.h"
 #include "RigidBody/Segment.h"
 #include "RigidBody/SoftContactNode.h"
+#include "RigidBody/SoftContactSet.h"
 #include "RigidBody/SoftContactSphere.h"
 #include "Utils/Error.h"
 #include "Utils/SpatialVector.h"
@@ -16,7 +20,15 @@ using namespace BIORBD_NAMESPACE;
 
 rigidbody::SoftContacts::SoftContacts()
     : m_softContacts(
-          std::make_shared<std::vector<std::shared_ptr<SoftContactNode>>>()) {}
+          std::make_shared<std::vector<std::shared_ptr<SoftContactNode>>>()),
+      m_softContactSet(nullptr),
+      m_contactSurfaces(
+          std::make_shared<std::vector<std::shared_ptr<ContactSurface>>>()),
+      m_contactSurfaceHint(std::make_shared<std::vector<size_t>>()),
+      m_contactTriangleHint(std::make_shared<std::vector<size_t>>()),
+      m_declaredContactPlanes(std::make_shared<
+                              std::vector<std::pair<utils::Vector3d,
+                                                    utils::Vector3d>>>()) {}
 
 rigidbody::SoftContacts rigidbody::SoftContacts::DeepCopy() const {
   rigidbody::SoftContacts copy;
@@ -29,11 +41,27 @@ void rigidbody::SoftContacts::DeepCopy(const rigidbody::SoftContacts &other) {
   for (size_t i = 0; i < other.m_softContacts->size(); ++i) {
     if ((*other.m_softContacts)[i]->typeOfNode() ==
         utils::NODE_TYPE::SOFT_CONTACT_SPHERE) {
-      (*m_softContacts)[i] = std::make_shared<rigidbody::SoftContactSphere>();
+      std::shared_ptr<rigidbody::SoftContactSphere> sphere(
+          std::make_shared<rigidbody::SoftContactSphere>());
+      sphere->DeepCopy(static_cast<const rigidbody::SoftContactSphere &>(
+          *(*other.m_softContacts)[i]));
+      (*m_softContacts)[i] = sphere;
     } else {
       utils::Error::raise("DeepCopy failed");
     }
-    (*m_softContacts)[i]->DeepCopy(*((*other.m_softContacts)[i]));
+  }
+
+  // The surfaces are not modified once built, they can be shared
+  *m_contactSurfaces = *other.m_contactSurfaces;
+  *m_contactSurfaceHint = *other.m_contactSurfaceHint;
+  *m_contactTriangleHint = *other.m_contactTriangleHint;
+  *m_declaredContactPlanes = *other.m_declaredContactPlanes;
+
+  // The joints may not be copied yet, the set is filled at the first use
+  if (other.m_softContactSet) {
+    m_softContactSet = std::make_shared<rigidbody::SoftContactSet>();
+  } else {
+    m_softContactSet = nullptr;
   }
 }
 
@@ -54,12 +82,139 @@ void rigidbody::SoftContacts::addSoftContact(
   if (contact.typeOfNode() == utils::NODE_TYPE::SOFT_CONTACT_SPHERE) {
     m_softContacts->push_back(
         std::make_shared<rigidbody::SoftContactSphere>(contact));
+    m_declaredContactPlanes->push_back(std::make_pair(
+        contact.contactPlaneOrigin(), contact.contactPlaneNormal()));
   } else {
     utils::Error::raise(
         utils::String("The ") + contact.typeOfNode() + " does not exist");
   }
+  if (m_softContactSet) {
+    compileSoftContacts();
+  }
+}
+
+void rigidbody::SoftContacts::compileSoftContacts() {
+  // Assuming that this is also a joint type (via BiorbdModel)
+  const rigidbody::Joints &model =
+      dynamic_cast<const rigidbody::Joints &>(*this);
+  m_softContactSet =
+      std::make_shared<rigidbody::SoftContactSet>(model, *m_softContacts);
+}
+
+bool rigidbody::SoftContacts::isSoftContactsCompiled() const {
+  return m_softContactSet != nullptr;
+}
+
+rigidbody::SoftContactSet &rigidbody::SoftContacts::softContactSet() {
+  utils::Error::check(
+      isSoftContactsCompiled(),
+      "The soft contacts are not compiled, call compileSoftContacts first");
+  if (m_softContactSet->nbSoftContacts() != nbSoftContacts()) {
+    compileSoftContacts();
+  }
+  return *m_softContactSet;
+}
+
+rigidbody::SoftContactSet rigidbody::SoftContacts::detachedSoftContactSet()
+    const {
+  // Assuming that this is also a joint type (via BiorbdModel)
+  const rigidbody::Joints &model =
+      dynamic_cast<const rigidbody::Joints &>(*this);
+  return rigidbody::SoftContactSet(model, *m_softContacts);
 }
 
+#ifndef BIORBD_USE_CASADI_MATH
+void rigidbody::SoftContacts::addContactSurface(
+    const rigidbody::ContactSurface &surface) {
+  m_contactSurfaces->push_back(
+      std::make_shared<rigidbody::ContactSurface>(surface));
+}
+
+size_t rigidbody::SoftContacts::nbContactSurfaces() const {
+  return m_contactSurfaces->size();
+}
+
+const rigidbody::ContactSurface &rigidbody::SoftContacts::contactSurface(
+    size_t idx) const {
+  utils::Error::check(
+      idx < nbContactSurfaces(),
+      "Idx is higher than the number of contact surfaces");
+  return *(*m_contactSurfaces)[idx];
+}
+
+void rigidbody::SoftContacts::updateSoftContactPlanes(
+    const std::vector<utils::Vector3d> &positions) {
+  utils::Error::check(
+      positions.size() == nbSoftContacts(),
+      "The number of positions must be equal to the number of soft contacts");
+  size_t nbSurfaces(nbContactSurfaces());
+  m_contactSurfaceHint->resize(nbSoftContacts(), nbSurfaces);
+  m_contactTriangleHint->resize(nbSoftContacts(), 0);
+  bool isSetUpToDate(
+      m_softContactSet &&
+      m_softContactSet->nbSoftContacts() == nbSoftContacts());
+
+  for (size_t i = 0; i < nbSoftContacts(); ++i) {
+    rigidbody::SoftContactNode &contact(softContact(i));
+    const utils::Vector3d &x(positions[i]);
+    double radius(
+        static_cast<const rigidbody::SoftContactSphere &>(contact).radius());
+
+    // Each surface only has to be closer than the closest one so far
+    double maxDistance(2 * radius);
+    size_t closestSurface(nbSurfaces);
+    size_t closestTriangle(0);
+    utils::Vector3d closest(0, 0, 0);
+    for (size_t s = 0; s < nbSurfaces; ++s) {
+      size_t triangle(
+          s == (*m_contactSurfaceHint)[i] ? (*m_contactTriangleHint)[i]
+                                          : std::numeric_limits<size_t>::max());
+      utils::Vector3d point(0, 0, 0);
+      if ((*m_contactSurfaces)[s]->closestPoint(
+              x, maxDistance, point, triangle)) {
+        maxDistance = (x - point).norm();
+        closestSurface = s;
+        closestTriangle = triangle;
+        closest = point;
+      }
+    }
+
+    // The declared plane is kept if no surface is within reach, or if the
+    // sphere is closer to it (or deeper in it) than to the closest surface
+    const std::pair<utils::Vector3d, utils::Vector3d> &declared(
+        (*m_declaredContactPlanes)[i]);
+    utils::Vector3d origin(declared.first);
+    utils::Vector3d normal(declared.second);
+    if (closestSurface < nbSurfaces) {
+      (*m_contactSurfaceHint)[i] = closestSurface;
+      (*m_contactTriangleHint)[i] = closestTriangle;
+      const utils::Vector3d &faceNormal(
+          (*m_contactSurfaces)[closestSurface]->triangleNormal(
+              closestTriangle));
+      utils::Vector3d d(x - closest);
+      double distance(d.norm());
+      bool isOutside(d.dot(faceNormal) > 0);
+      double planeDistance((x - declared.first).dot(declared.second));
+      if ((isOutside ? distance : -distance) < planeDistance) {
+        origin = closest;
+        if (distance > 1e-12 && isOutside) {
+          // Tangent to the sphere, which is the face itself inside the
+          // triangle
+          normal = d / distance;
+        } else {
+          normal = faceNormal;
+        }
+      }
+    }
+
+    contact.setContactPlane(origin, normal);
+    if (isSetUpToDate) {
+      m_softContactSet->setContactPlane(i, origin, normal);
+    }
+  }
+}
+#endif
+
 rigidbody::SoftContactNode &rigidbody::SoftContacts::softContact(size_t idx) {
   return *(*m_softContacts)[idx];
 }
@@ -0,0 +1,102 @@
+#define BIORBD_API_EXPORTS
+#include "Utils/ThreadPool.h"
+
+using namespace BIORBD_NAMESPACE;
+
+utils::ThreadPool::ThreadPool(size_t nbThreads)
+    : m_task(nullptr),
+      m_nbTasks(0),
+      m_nextTask(0),
+      m_nbDone(0),
+      m_generation(0),
+      m_stop(false) {
+  if (nbThreads == 0) {
+    nbThreads = std::thread::hardware_concurrency();
+  }
+  for (size_t i = 1; i < nbThreads; ++i) {
+    m_workers.push_back(std::thread(&utils::ThreadPool::work, this));
+  }
+}
+
+utils::ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wakeUp.notify_all();
+  for (size_t i = 0; i < m_workers.size(); ++i) {
+    m_workers[i].join();
+  }
+}
+
+size_t utils::ThreadPool::nbThreads() const {
+  return m_workers.size() + 1;
+}
+
+void utils::ThreadPool::run(
+    size_t nbTasks,
+    const std::function<void(size_t)>& task) {
+  if (nbTasks == 0) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> runLock(m_runMutex);
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_task = &task;
+  m_nbTasks = nbTasks;
+  m_nextTask = 0;
+  m_nbDone = 0;
+  m_error = nullptr;
+  ++m_generation;
+  m_wakeUp.notify_all();
+
+  // The calling thread works as well
+  processTasks(lock);
+  while (m_nbDone != m_nbTasks) {
+    m_done.wait(lock);
+  }
+  m_task = nullptr;
+
+  if (m_error) {
+    std::exception_ptr error(m_error);
+    m_error = nullptr;
+    lock.unlock();
+    std::rethrow_exception(error);
+  }
+}
+
+void utils::ThreadPool::work() {
+  size_t generation(0);
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    while (!m_stop && m_generation == generation) {
+      m_wakeUp.wait(lock);
+    }
+    if (m_stop) {
+      return;
+    }
+    generation = m_generation;
+    processTasks(lock);
+  }
+}
+
+void utils::ThreadPool::processTasks(std::unique_lock<std::mutex>& lock) {
+  while (m_nextTask < m_nbTasks) {
+    size_t idx(m_nextTask++);
+    const std::function<void(size_t)>& task(*m_task);
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      task(idx);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    if (error && !m_error) {
+      m_error = error;
+    }
+    if (++m_nbDone == m_nbTasks) {
+      m_done.notify_all();
+    }
+  }
+}
@@ -12,6 +12,7 @@
 #include "RigidBody/GeneralizedCoordinates.h"
 #include "RigidBody/GeneralizedTorque.h"
 #include "RigidBody/GeneralizedVelocity.h"
+#include "Utils/Matrix.h"
 
 using namespace BIORBD_NAMESPACE;
 
@@ -371,6 +372,130 @@ TEST(Actuators, jointTorqueFromAllTypesOfActuators) {
   }
 }
 
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(Actuators, compiledTorquesAndJacobians) {
+  Model model(modelPathWithAllActuators);
+  unsigned int nbDof(static_cast<unsigned int>(model.nbGeneralizedTorque()));
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  utils::Vector activation(nbDof);
+  for (unsigned int i = 0; i < nbDof; ++i) {
+    Q(i) = 0.3 * i - 0.5;
+    Qdot(i) = i % 2 ? -1.1 : 0.8;
+    activation(i) = i % 3 ? 0.6 : -0.4;
+  }
+
+  // Compare with the actuators evaluated one by one
+  std::pair<rigidbody::GeneralizedTorque, rigidbody::GeneralizedTorque>
+      torqueMax(model.torqueMax(Q, Qdot));
+  std::vector<std::pair<
+      std::shared_ptr<internal_forces::actuator::Actuator>,
+      std::shared_ptr<internal_forces::actuator::Actuator>>>
+      actuators;
+  for (size_t i = 0; i < model.nbActuators(); ++i) {
+    actuators.push_back(model.actuator(i));
+  }
+  internal_forces::actuator::ActuatorSet set(actuators);
+  EXPECT_EQ(set.nbDof(), nbDof);
+  EXPECT_EQ(
+      set.indices(internal_forces::actuator::TYPE::GAUSS3P),
+      set.indices(internal_forces::actuator::TYPE::GAUSS6P));
+  for (unsigned int i = 0; i < nbDof; ++i) {
+    for (unsigned int p = 0; p < 2; ++p) {
+      std::shared_ptr<internal_forces::actuator::Actuator> actuator(
+          p == 0 ? model.actuator(i).first : model.actuator(i).second);
+      double expected;
+      switch (actuator->type()) {
+        case internal_forces::actuator::TYPE::CONSTANT:
+          expected = std::static_pointer_cast<
+                         internal_forces::actuator::ActuatorConstant>(actuator)
+                         ->torqueMax();
+          break;
+        case internal_forces::actuator::TYPE::LINEAR:
+          expected = std::static_pointer_cast<
+                         internal_forces::actuator::ActuatorLinear>(actuator)
+                         ->torqueMax(Q);
+          break;
+        case internal_forces::actuator::TYPE::GAUSS3P:
+          expected = std::static_pointer_cast<
+                         internal_forces::actuator::ActuatorGauss3p>(actuator)
+                         ->torqueMax(Q, Qdot);
+          break;
+        case internal_forces::actuator::TYPE::GAUSS6P:
+          expected = std::static_pointer_cast<
+                         internal_forces::actuator::ActuatorGauss6p>(actuator)
+                         ->torqueMax(Q, Qdot);
+          break;
+        default:
+          expected = std::static_pointer_cast<
+                         internal_forces::actuator::ActuatorSigmoidGauss3p>(
+                         actuator)
+                         ->torqueMax(Q, Qdot);
+      }
+      EXPECT_NEAR(
+          p == 0 ? torqueMax.first(i) : torqueMax.second(i),
+          expected,
+          requiredPrecision);
+    }
+  }
+
+  // The preallocated overload gives the same torques
+  rigidbody::GeneralizedTorque tau(model.torque(activation, Q, Qdot));
+  utils::Vector tauBuffer(nbDof);
+  model.torque(activation, Q, Qdot, tauBuffer);
+  for (unsigned int i = 0; i < nbDof; ++i) {
+    EXPECT_NEAR(tauBuffer(i), tau(i), requiredPrecision);
+  }
+
+  // The analytic jacobians match the finite differences
+  utils::Matrix dTaudActivation;
+  utils::Matrix dTaudQ;
+  utils::Matrix dTaudQdot;
+  model.torqueJacobians(
+      activation, Q, Qdot, dTaudActivation, dTaudQ, dTaudQdot);
+  double h(1e-6);
+  for (unsigned int j = 0; j < nbDof; ++j) {
+    utils::Vector activationPlus(activation);
+    utils::Vector activationMinus(activation);
+    activationPlus(j) += h;
+    activationMinus(j) -= h;
+    rigidbody::GeneralizedCoordinates QPlus(Q);
+    rigidbody::GeneralizedCoordinates QMinus(Q);
+    QPlus(j) += h;
+    QMinus(j) -= h;
+    rigidbody::GeneralizedVelocity QdotPlus(Qdot);
+    rigidbody::GeneralizedVelocity QdotMinus(Qdot);
+    QdotPlus(j) += h;
+    QdotMinus(j) -= h;
+    utils::Vector dActivation(
+        (model.torque(activationPlus, Q, Qdot) -
+         model.torque(activationMinus, Q, Qdot)) /
+        (2 * h));
+    utils::Vector dQ(
+        (model.torque(activation, QPlus, Qdot) -
+         model.torque(activation, QMinus, Qdot)) /
+        (2 * h));
+    utils::Vector dQdot(
+        (model.torque(activation, Q, QdotPlus) -
+         model.torque(activation, Q, QdotMinus)) /
+        (2 * h));
+    for (unsigned int i = 0; i < nbDof; ++i) {
+      EXPECT_NEAR(dTaudActivation(i, j), dActivation(i), 1e-5);
+      EXPECT_NEAR(dTaudQ(i, j), dQ(i), 1e-4);
+      EXPECT_NEAR(dTaudQdot(i, j), dQdot(i), 1e-4);
+    }
+  }
+
+  // A deep copy recompiles its own actuators
+  internal_forces::actuator::Actuators copy;
+  copy.DeepCopy(model);
+  rigidbody::GeneralizedTorque tauCopy(copy.torque(activation, Q, Qdot));
+  for (unsigned int i = 0; i < nbDof; ++i) {
+    EXPECT_NEAR(tauCopy(i), tau(i), requiredPrecision);
+  }
+}
+#endif
+
 TEST(ActuatorSigmoidGauss3p, torqueMax) {
   // A model is loaded so Q can be > 0 in size, it is not used otherwise
   Model model(modelPathWithAllActuators);
@@ -6,6 +6,7 @@
 #include <rbdl/Dynamics.h>
 
 #include "BiorbdModel.h"
+#include "InternalForceAccumulator.h"
 #include "ModelWriter.h"
 #include "RigidBody/GeneralizedCoordinates.h"
 #include "RigidBody/GeneralizedTorque.h"
@@ -36,6 +37,9 @@ static std::string modelPathWithObj("models/violin.bioMod");
 static std::string modelPathWithVtp("models/thoraxWithVtp.bioMod");
 #endif
 static std::string modelPathWithStl("models/pendulum.bioMod");
+#if defined(MODULE_MUSCLES) && defined(MODULE_LIGAMENTS)
+static std::string modelPathWithLigaments("models/arm26_WithLigaments.bioMod");
+#endif
 
 TEST(FileIO, OpenModel) {
   EXPECT_NO_THROW(Model model(modelPathForGeneralTesting));
@@ -122,3 +126,116 @@ TEST(MeshFile, FileIoStl) {
   Model model(modelPathWithStl);
 }
 #endif
+
+#ifndef BIORBD_USE_CASADI_MATH
+#if defined(MODULE_MUSCLES) && defined(MODULE_LIGAMENTS)
+TEST(InternalForces, accumulateMusclesAndLigaments) {
+  Model model(modelPathWithLigaments);
+  unsigned int nbMus(static_cast<unsigned int>(model.nbMuscleTotal()));
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  for (unsigned int i = 0; i < model.nbQ(); ++i) {
+    Q[i] = 0.3 + 0.4 * i;
+    Qdot[i] = -0.5 + 0.7 * i;
+  }
+  utils::Vector activations(nbMus);
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    activations[i] = 0.2 + 0.03 * i;
+  }
+
+  // Call by call
+  model.updateMuscles(Q, Qdot, true);
+  utils::Vector expectedMuscleForces(model.muscleForces(activations));
+  rigidbody::GeneralizedTorque expectedMuscles(
+      model.muscularJointTorque(expectedMuscleForces));
+  utils::Vector expectedLigamentForces(model.ligamentForces(Q, Qdot));
+  rigidbody::GeneralizedTorque expectedLigaments(
+      model.ligamentsJointTorque(Q, Qdot));
+
+  InternalForceAccumulator& accumulator(model.internalForceAccumulator());
+  EXPECT_FALSE(accumulator.isBreakdownKept());
+  accumulator.keepBreakdown();
+  const rigidbody::GeneralizedTorque& tau(
+      model.internalForces(Q, Qdot, activations, utils::Vector()));
+  for (unsigned int i = 0; i < model.nbGeneralizedTorque(); ++i) {
+    EXPECT_NEAR(
+        tau[i], expectedMuscles[i] + expectedLigaments[i], requiredPrecision);
+    EXPECT_NEAR(
+        accumulator.torque(MUSCLE_FORCES)[i],
+        expectedMuscles[i],
+        requiredPrecision);
+    EXPECT_NEAR(
+        accumulator.torque(LIGAMENT_FORCES)[i],
+        expectedLigaments[i],
+        requiredPrecision);
+    EXPECT_NEAR(accumulator.torque(ACTUATOR_TORQUES)[i], 0, requiredPrecision);
+  }
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    EXPECT_NEAR(
+        accumulator.muscleForces()[i],
+        expectedMuscleForces[i],
+        requiredPrecision);
+  }
+  for (unsigned int i = 0; i < model.nbLigaments(); ++i) {
+    EXPECT_NEAR(
+        accumulator.ligamentForces()[i],
+        expectedLigamentForces[i],
+        requiredPrecision);
+  }
+
+  // A disabled source is skipped
+  accumulator.enable(LIGAMENT_FORCES, false);
+  EXPECT_FALSE(accumulator.isEnabled(LIGAMENT_FORCES));
+  model.internalForces(Q, Qdot, activations, utils::Vector());
+  EXPECT_EQ(accumulator.ligamentForces().size(), 0);
+  for (unsigned int i = 0; i < model.nbGeneralizedTorque(); ++i) {
+    EXPECT_NEAR(accumulator.torque()[i], expectedMuscles[i], requiredPrecision);
+    EXPECT_NEAR(accumulator.torque(LIGAMENT_FORCES)[i], 0, requiredPrecision);
+  }
+
+  // The muscle activations must match the muscles
+  EXPECT_THROW(
+      model.internalForces(Q, Qdot, utils::Vector(1), utils::Vector()),
+      std::runtime_error);
+}
+#endif
+
+#ifdef MODULE_ACTUATORS
+TEST(InternalForces, accumulateActuatorsAndDampings) {
+  Model model(modelPathForGeneralTesting);
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  utils::Vector activations(static_cast<unsigned int>(model.nbActuators()));
+  for (unsigned int i = 0; i < model.nbQ(); ++i) {
+    Q[i] = 0.1 * i;
+    Qdot[i] = 0.2 - 0.05 * i;
+  }
+  for (unsigned int i = 0; i < model.nbActuators(); ++i) {
+    activations[i] = i % 2 ? 0.5 : -0.3;
+  }
+
+  // The joint dampings are left to the forward dynamics by default
+  InternalForceAccumulator& accumulator(model.internalForceAccumulator());
+  EXPECT_FALSE(accumulator.isEnabled(JOINT_DAMPINGS));
+  rigidbody::GeneralizedTorque expected(model.torque(activations, Q, Qdot));
+  const rigidbody::GeneralizedTorque& tau(
+      model.internalForces(Q, Qdot, utils::Vector(), activations));
+  for (unsigned int i = 0; i < model.nbGeneralizedTorque(); ++i) {
+    EXPECT_NEAR(tau[i], expected[i], requiredPrecision);
+  }
+
+  accumulator.enable(JOINT_DAMPINGS);
+  rigidbody::GeneralizedTorque expectedDamped(
+      expected - model.computeDampedTau(Qdot));
+  model.internalForces(Q, Qdot, utils::Vector(), activations);
+  for (unsigned int i = 0; i < model.nbGeneralizedTorque(); ++i) {
+    EXPECT_NEAR(tau[i], expectedDamped[i], requiredPrecision);
+  }
+
+  // The breakdown is only available when requested
+  EXPECT_THROW(
+      model.internalForceAccumulator().torque(ACTUATOR_TORQUES),
+      std::runtime_error);
+}
+#endif
+#endif
@@ -682,6 +682,74 @@ TEST(LigamentTorque, torqueFromLigaments) {
   }
 }
 
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(LigamentForce, compiledLigaments) {
+  Model model(modelPathForGenericTest);
+  Model compiled(modelPathForGenericTest);
+  EXPECT_FALSE(compiled.isLigamentsCompiled());
+  compiled.compileLigaments();
+  EXPECT_TRUE(compiled.isLigamentsCompiled());
+
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  Q = Q.setOnes() / 10;
+  Qdot = Qdot.setOnes() / 10;
+
+  utils::Vector F(model.ligamentForces(Q, Qdot));
+  utils::Vector FCompiled(compiled.ligamentForces(Q, Qdot));
+  std::vector<double> ExpectedForce(
+      {500.00056194583868, 27.517183773325474, 139.51352848156762});
+  for (unsigned int i = 0; i < model.nbLigaments(); ++i) {
+    EXPECT_NEAR(FCompiled(i), F(i), requiredPrecision);
+    EXPECT_NEAR(FCompiled(i), ExpectedForce[i], requiredPrecision);
+
+    // The forces are written back to the ligaments
+    EXPECT_NEAR(
+        compiled.ligament(i).Compound::force(), F(i), requiredPrecision);
+  }
+
+  // The table fills the length jacobian and visits only the spanned DoFs
+  utils::Matrix jaco(model.ligamentsLengthJacobian());
+  utils::Matrix jacoCompiled(compiled.ligamentsLengthJacobian());
+  for (unsigned int i = 0; i < jaco.rows(); ++i) {
+    for (unsigned int j = 0; j < jaco.cols(); ++j) {
+      EXPECT_NEAR(jacoCompiled(i, j), jaco(i, j), requiredPrecision);
+    }
+  }
+  rigidbody::GeneralizedTorque tau(model.ligamentsJointTorque(F));
+  rigidbody::GeneralizedTorque tauCompiled(
+      compiled.ligamentsJointTorque(FCompiled));
+  for (unsigned int i = 0; i < tau.size(); ++i) {
+    EXPECT_NEAR(tauCompiled(i), tau(i), requiredPrecision);
+  }
+
+  // Each ligament is listed once, under its own type
+  internal_forces::ligaments::LigamentSet set(compiled.ligaments());
+  size_t nbIndices(0);
+  for (internal_forces::ligaments::LIGAMENT_TYPE type :
+       {internal_forces::ligaments::LIGAMENT_TYPE::LIGAMENT_CONSTANT,
+        internal_forces::ligaments::LIGAMENT_TYPE::LIGAMENT_SPRING_LINEAR,
+        internal_forces::ligaments::LIGAMENT_TYPE::
+            LIGAMENT_SPRING_SECOND_ORDER}) {
+    for (size_t idx : set.indices(type)) {
+      EXPECT_EQ(compiled.ligament(idx).type(), type);
+      ++nbIndices;
+    }
+  }
+  EXPECT_EQ(nbIndices, compiled.nbLigaments());
+
+  // A deep copy gets all the ligaments and its own compiled set
+  internal_forces::ligaments::Ligaments copy;
+  copy.DeepCopy(compiled);
+  EXPECT_EQ(copy.nbLigaments(), compiled.nbLigaments());
+  EXPECT_TRUE(copy.isLigamentsCompiled());
+  for (size_t i = 0; i < copy.nbLigaments(); ++i) {
+    EXPECT_NE(&copy.ligament(i), &compiled.ligament(i));
+    EXPECT_EQ(copy.ligament(i).type(), compiled.ligament(i).type());
+  }
+}
+#endif
+
 TEST(LigamentCharacterics, unittest) {
   {
     internal_forces::ligaments::LigamentCharacteristics charact;
@@ -1,19 +1,26 @@
 #include "biorbdConfig.h"
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <iostream>
+#include <thread>
 
 #include <rbdl/Dynamics.h>
 
 #include "BiorbdModel.h"
 #include "InternalForces/Muscles/all.h"
 #include "InternalForces/all.h"
+#include "RigidBody/ExternalForceSet.h"
 #include "RigidBody/GeneralizedAcceleration.h"
 #include "RigidBody/GeneralizedCoordinates.h"
 #include "RigidBody/GeneralizedTorque.h"
 #include "RigidBody/GeneralizedVelocity.h"
 #include "RigidBody/NodeSegment.h"
 #include "Utils/Matrix.h"
+#include "Utils/Matrix3d.h"
+#include "Utils/Rotation.h"
 #include "Utils/RotoTrans.h"
 #include "Utils/String.h"
 
@@ -25,6 +32,11 @@ static std::string modelPathForMuscleForce("models/arm26.bioMod");
 static std::string modelPathForBuchananDynamics("models/arm26_buchanan.bioMod");
 static std::string modelPathForDeGrooteDynamics("models/arm26_degroote.bioMod");
 static std::string modelPathForMuscleJacobian("models/arm26.bioMod");
+static std::string modelPathWithWrapping("models/WrappingObjectExample.bioMod");
+static std::string modelPathWithWrappingChain(
+    "models/WrappingChainExample.bioMod");
+static std::string modelPathWithConsecutiveWrapping(
+    "models/WrappingConsecutiveExample.bioMod");
 static size_t muscleGroupForMuscleJacobian(1);
 static size_t muscleForMuscleJacobian(1);
 
@@ -2461,6 +2473,80 @@ TEST(FatigueDynamiqueState, DeepCopy) {
   }
 }
 
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(FatigueStateSet, batchedXia) {
+  Model model(modelPathForXiaDerivativeTest);
+  size_t nbMus(model.nbMuscleTotal());
+  internal_forces::muscles::FatigueStateSet fatigue(model.muscles());
+  EXPECT_EQ(fatigue.nbMuscles(), nbMus);
+  EXPECT_GE(fatigue.indices().size(), 1u);
+
+  // The batched derivative matches the per-muscle one in the three branches
+  // of the command
+  size_t idx(fatigue.indices()[0]);
+  unsigned int col(static_cast<unsigned int>(idx));
+  internal_forces::muscles::FatigueModel& fatigueModel(
+      dynamic_cast<internal_forces::muscles::FatigueModel&>(
+          model.muscle(idx)));
+  internal_forces::muscles::FatigueDynamicStateXia& state(
+      dynamic_cast<internal_forces::muscles::FatigueDynamicStateXia&>(
+          fatigueModel.fatigueState()));
+  std::vector<std::vector<double>> allStates = {
+      {0.2, 0.1, 0.7}, {0.2, 0.7, 0.1}, {0.9, 0.1, 0.0}};
+  utils::Vector targets(utils::Vector::Constant(nbMus, 0.5));
+  for (const std::vector<double>& fibers : allStates) {
+    fatigueModel.setFatigueState(fibers[0], fibers[1], fibers[2]);
+    fatigue.gatherStates();
+    utils::Matrix statesDot;
+    fatigue.timeDerivativeState(targets, statesDot);
+
+    internal_forces::muscles::StateDynamics emg(0, 0.5);
+    state.timeDerivativeState(emg, model.muscle(idx).characteristics());
+    EXPECT_NEAR(statesDot(0, col), state.activeFibersDot(), requiredPrecision);
+    EXPECT_NEAR(
+        statesDot(1, col), state.fatiguedFibersDot(), requiredPrecision);
+    EXPECT_NEAR(statesDot(2, col), state.restingFibersDot(), requiredPrecision);
+  }
+
+  // The implicit integration follows a fine explicit one and conserves the
+  // fibers
+  fatigueModel.setFatigueState(0.0, 0.0, 1.0);
+  fatigue.gatherStates();
+  utils::Matrix reference(fatigue.states());
+  utils::Matrix statesDot;
+  for (size_t s = 0; s < 100000; ++s) {
+    fatigue.timeDerivativeState(targets, reference, statesDot);
+    reference += 1e-4 * statesDot;
+  }
+  fatigue.integrate(targets, 1e-2, 1000);
+  for (unsigned int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(fatigue.states()(i, col), reference(i, col), 1e-5);
+  }
+  EXPECT_NEAR(fatigue.states().col(col).sum(), 1.0, requiredPrecision);
+
+  // A sequence of targets gives the same result as constant ones
+  fatigueModel.setFatigueState(0.0, 0.0, 1.0);
+  internal_forces::muscles::FatigueStateSet sequence(model.muscles());
+  utils::Matrix activeFibers;
+  sequence.integrate(
+      utils::Matrix(targets.replicate(1, 1000)), 1e-2, &activeFibers);
+  EXPECT_NEAR(
+      activeFibers(col, 999), fatigue.states()(0, col), requiredPrecision);
+
+  // The muscles are only modified when the states are scattered
+  EXPECT_NEAR(fatigueModel.fatigueState().activeFibers(), 0, requiredPrecision);
+  fatigue.scatterStates();
+  EXPECT_NEAR(
+      fatigueModel.fatigueState().activeFibers(),
+      fatigue.states()(0, col),
+      requiredPrecision);
+  EXPECT_NEAR(
+      fatigueModel.fatigueState().fatiguedFibers(),
+      fatigue.states()(1, col),
+      requiredPrecision);
+}
+#endif
+
 TEST(FatigueParameters, unitTest) {
   internal_forces::muscles::FatigueParameters fatigueParameters;
   fatigueParameters.setFatigueRate(25.0);
@@ -2876,6 +2962,184 @@ TEST(WrappingHalfCylinder, unitTest) {
   }
 }
 
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(WrappingHalfCylinder, lengthGradientDegenerate) {
+  utils::RotoTrans rt(
+      utils::Vector3d(0., 0., 0.), utils::Vector3d(0., 0., 0.), "xyz");
+  internal_forces::WrappingHalfCylinder cylinder(rt, 0.5, 1.);
+
+  // Points in a plane containing the axis of the cylinder: the points leaving
+  // the cylinder have the same angle, the straight-line Jacobian is expected
+  utils::Vector3d p1(2., 0., -1.);
+  utils::Vector3d p2(4., 0., 1.);
+  utils::Vector3d dLdp1(0, 0, 0);
+  utils::Vector3d dLdp2(0, 0, 0);
+  cylinder.lengthGradient(rt, p1, p2, dLdp1, dLdp2);
+  std::vector<double> expected({std::sqrt(0.5), 0, std::sqrt(0.5)});
+  for (unsigned int i = 0; i < 3; ++i) {
+    EXPECT_FALSE(std::isnan(dLdp1(i)));
+    EXPECT_FALSE(std::isnan(dLdp2(i)));
+    EXPECT_NEAR(dLdp1(i), -expected[i], requiredPrecision);
+    EXPECT_NEAR(dLdp2(i), expected[i], requiredPrecision);
+  }
+}
+
+TEST(WrappingSphere, wrapPoints) {
+  utils::RotoTrans rt(
+      utils::Vector3d(0.1, 0.2, 0.3), utils::Vector3d(1., 2., 3.), "xyz");
+  internal_forces::WrappingSphere sphere(0, 0, 0, 1.);
+  const utils::Vector3d p1Local(2., 0.1, 0.);
+  const utils::Vector3d p2Local(-1.5, 0.2, 0.1);
+  utils::Vector3d p1(p1Local.applyRT(rt));
+  utils::Vector3d p2(p2Local.applyRT(rt));
+
+  utils::Vector3d p1Wrap(0, 0, 0);
+  utils::Vector3d p2Wrap(0, 0, 0);
+  utils::Scalar lengthOnWrap(0);
+  sphere.wrapPoints(rt, p1, p2, p1Wrap, p2Wrap, &lengthOnWrap);
+
+  // The straight parts are tangent to the sphere
+  double radius(0.5);
+  double d1(p1Local.norm());
+  double d2(p2Local.norm());
+  double phi(std::acos(p1Local.dot(p2Local) / (d1 * d2)));
+  EXPECT_NEAR(
+      (p1 - p1Wrap).norm(), std::sqrt(d1 * d1 - radius * radius),
+      requiredPrecision);
+  EXPECT_NEAR(
+      (p2 - p2Wrap).norm(), std::sqrt(d2 * d2 - radius * radius),
+      requiredPrecision);
+  EXPECT_NEAR(
+      lengthOnWrap,
+      radius * (phi - std::acos(radius / d1) - std::acos(radius / d2)),
+      requiredPrecision);
+
+  // The derivative of the length
+  utils::Vector3d dLdp1(0, 0, 0);
+  utils::Vector3d dLdp2(0, 0, 0);
+  sphere.lengthGradient(rt, p1, p2, dLdp1, dLdp2);
+  double eps(1e-6);
+  for (unsigned int i = 0; i < 3; ++i) {
+    utils::Vector3d lengths(0, 0, 0);
+    for (int side = -1; side <= 1; side += 2) {
+      utils::Vector3d p1Moved(p1);
+      p1Moved(i) += side * eps;
+      sphere.wrapPoints(rt, p1Moved, p2, p1Wrap, p2Wrap, &lengthOnWrap);
+      double length((p1Moved - p1Wrap).norm() + lengthOnWrap +
+                    (p2 - p2Wrap).norm());
+      lengths(side + 1) = length;
+    }
+    EXPECT_NEAR(dLdp1(i), (lengths(2) - lengths(0)) / (2 * eps), 1e-6);
+  }
+}
+
+TEST(WrappingEllipsoid, sphereEquivalence) {
+  utils::RotoTrans rt(
+      utils::Vector3d(0.1, 0.2, 0.3), utils::Vector3d(1., 2., 3.), "xyz");
+  internal_forces::WrappingSphere sphere(
+      utils::Vector3d(1., 2., 3.), 0.6);
+  internal_forces::WrappingEllipsoid ellipsoid(
+      rt, utils::Vector3d(0.3, 0.3, 0.3));
+  utils::Vector3d p1(1.8, 2.1, 3.);
+  utils::Vector3d p2(0.2, 2.2, 3.1);
+
+  utils::Vector3d p1Sphere(0, 0, 0);
+  utils::Vector3d p2Sphere(0, 0, 0);
+  utils::Scalar lengthSphere(0);
+  sphere.wrapPoints(
+      utils::RotoTrans(utils::Rotation(), sphere),
+      p1,
+      p2,
+      p1Sphere,
+      p2Sphere,
+      &lengthSphere);
+  utils::Vector3d p1Ellipsoid(0, 0, 0);
+  utils::Vector3d p2Ellipsoid(0, 0, 0);
+  utils::Scalar lengthEllipsoid(0);
+  ellipsoid.wrapPoints(rt, p1, p2, p1Ellipsoid, p2Ellipsoid, &lengthEllipsoid);
+
+  EXPECT_NEAR(lengthEllipsoid, lengthSphere, 1e-6);
+  for (unsigned int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(p1Ellipsoid(i), p1Sphere(i), requiredPrecision);
+    EXPECT_NEAR(p2Ellipsoid(i), p2Sphere(i), requiredPrecision);
+  }
+}
+
+TEST(WrappingEllipsoid, geodesic) {
+  utils::RotoTrans rt(
+      utils::Vector3d(0.1, 0.2, 0.3), utils::Vector3d(1., 2., 3.), "xyz");
+  utils::Vector3d semiAxes(0.3, 0.2, 0.25);
+  internal_forces::WrappingEllipsoid ellipsoid(rt, semiAxes);
+  const utils::Vector3d p1Local(0.6, 0.05, 0.02);
+  const utils::Vector3d p2Local(-0.5, 0.1, -0.05);
+  utils::Vector3d p1(p1Local.applyRT(rt));
+  utils::Vector3d p2(p2Local.applyRT(rt));
+
+  utils::Vector3d p1Wrap(0, 0, 0);
+  utils::Vector3d p2Wrap(0, 0, 0);
+  utils::Scalar lengthOnWrap(0);
+  ellipsoid.wrapPoints(rt, p1, p2, p1Wrap, p2Wrap, &lengthOnWrap);
+
+  // The points are on the ellipsoid and the straight parts are tangent to it
+  const std::vector<utils::Vector3d> nodes = {p1, p2};
+  const std::vector<utils::Vector3d> wraps = {p1Wrap, p2Wrap};
+  for (size_t i = 0; i < 2; ++i) {
+    utils::Vector3d node(nodes[i].applyRT(rt.transpose()));
+    utils::Vector3d wrap(wraps[i].applyRT(rt.transpose()));
+    utils::Vector3d gradient(wrap.cwiseQuotient(semiAxes).cwiseQuotient(
+        semiAxes));
+    EXPECT_NEAR(wrap.dot(gradient), 1, requiredPrecision);
+    EXPECT_NEAR(
+        gradient.dot(node - wrap) / gradient.norm(), 0, requiredPrecision);
+  }
+
+  // The derivatives of the length and of the points
+  utils::Vector3d dLdp1(0, 0, 0);
+  utils::Vector3d dLdp2(0, 0, 0);
+  ellipsoid.lengthGradient(rt, p1, p2, dLdp1, dLdp2);
+  utils::Matrix3d p1Wrap_p1;
+  utils::Matrix3d p1Wrap_p2;
+  utils::Matrix3d p2Wrap_p1;
+  utils::Matrix3d p2Wrap_p2;
+  ellipsoid.wrapPointsJacobian(
+      rt, p1, p2, p1Wrap_p1, p1Wrap_p2, p2Wrap_p1, p2Wrap_p2);
+  double eps(1e-7);
+  for (unsigned int i = 0; i < 3; ++i) {
+    for (unsigned int node = 0; node < 2; ++node) {
+      std::vector<double> lengths;
+      std::vector<utils::Vector3d> firstPoints;
+      std::vector<utils::Vector3d> secondPoints;
+      for (int side = -1; side <= 1; side += 2) {
+        utils::Vector3d p1Moved(p1);
+        utils::Vector3d p2Moved(p2);
+        (node == 0 ? p1Moved : p2Moved)(i) += side * eps;
+        ellipsoid.wrapPoints(
+            rt, p1Moved, p2Moved, p1Wrap, p2Wrap, &lengthOnWrap);
+        lengths.push_back(
+            (p1Moved - p1Wrap).norm() + lengthOnWrap +
+            (p2Moved - p2Wrap).norm());
+        firstPoints.push_back(p1Wrap);
+        secondPoints.push_back(p2Wrap);
+      }
+      EXPECT_NEAR(
+          (node == 0 ? dLdp1 : dLdp2)(i),
+          (lengths[1] - lengths[0]) / (2 * eps),
+          1e-6);
+      for (unsigned int j = 0; j < 3; ++j) {
+        EXPECT_NEAR(
+            (node == 0 ? p1Wrap_p1 : p1Wrap_p2)(j, i),
+            (firstPoints[1](j) - firstPoints[0](j)) / (2 * eps),
+            1e-5);
+        EXPECT_NEAR(
+            (node == 0 ? p2Wrap_p1 : p2Wrap_p2)(j, i),
+            (secondPoints[1](j) - secondPoints[0](j)) / (2 * eps),
+            1e-5);
+      }
+    }
+  }
+}
+#endif
+
 TEST(WrappingHalfCylinder, deepCopy) {
   Model model(modelPathForMuscleForce);
   utils::RotoTrans rt(
@@ -2998,6 +3262,515 @@ TEST(MuscleForce, torqueFromMuscles) {
   }
 }
 
+TEST(MuscleForce, fromActivationVector) {
+  Model model(modelPathForMuscleForce);
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  Q.setOnes();
+  Qdot.setOnes();
+  utils::Vector activations(model.nbMuscleTotal());
+  utils::Vector excitations(model.nbMuscleTotal());
+  for (unsigned int i = 0; i < model.nbMuscleTotal(); ++i) {
+    activations[i] = 0.2;
+    excitations[i] = 0.1 * (i + 1);
+  }
+
+  std::vector<double> TauExpected({-11.018675667414932, -1.7483464272594329});
+  rigidbody::GeneralizedTorque Tau(
+      model.muscularJointTorqueFromActivations(activations, Q, Qdot));
+  for (unsigned int i = 0; i < Tau.size(); ++i) {
+    SCALAR_TO_DOUBLE(val, Tau(i));
+    EXPECT_NEAR(val, TauExpected[i], requiredPrecision);
+  }
+
+  // The compiled kernels must give the same result
+  model.compileMuscles();
+  Tau = model.muscularJointTorqueFromActivations(activations, Q, Qdot);
+  for (unsigned int i = 0; i < Tau.size(); ++i) {
+    SCALAR_TO_DOUBLE(val, Tau(i));
+    EXPECT_NEAR(val, TauExpected[i], requiredPrecision);
+  }
+
+  // Activation dot from vectors and from states
+  std::vector<std::shared_ptr<internal_forces::muscles::State>> states;
+  for (unsigned int i = 0; i < model.nbMuscleTotal(); ++i) {
+    SCALAR_TO_DOUBLE(e, excitations(i));
+    SCALAR_TO_DOUBLE(a, activations(i));
+    states.push_back(
+        std::make_shared<internal_forces::muscles::StateDynamics>(e, a));
+  }
+  utils::Vector activationDotFromStates(model.activationDot(states));
+  utils::Vector activationDotFromVectors(
+      model.activationDot(excitations, activations));
+  for (unsigned int i = 0; i < model.nbMuscleTotal(); ++i) {
+    SCALAR_TO_DOUBLE(val, activationDotFromVectors(i));
+    SCALAR_TO_DOUBLE(expected, activationDotFromStates(i));
+    EXPECT_NEAR(val, expected, requiredPrecision);
+  }
+
+  // The state set is filled from the vectors
+  std::vector<std::shared_ptr<internal_forces::muscles::State>> stateSet(
+      model.stateSet(excitations, activations));
+  EXPECT_EQ(stateSet.size(), model.nbMuscleTotal());
+  for (unsigned int i = 0; i < model.nbMuscleTotal(); ++i) {
+    SCALAR_TO_DOUBLE(e, stateSet[i]->excitation());
+    SCALAR_TO_DOUBLE(a, stateSet[i]->activation());
+    EXPECT_NEAR(e, 0.1 * (i + 1), requiredPrecision);
+    EXPECT_NEAR(a, 0.2, requiredPrecision);
+  }
+}
+
+TEST(MuscleForce, compiledForce) {
+  Model model(modelPathForMuscleForce);
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  Q = Q.setOnes() / 10;
+  Qdot = Qdot.setOnes() / 10;
+  std::vector<std::shared_ptr<internal_forces::muscles::State>> states;
+  for (size_t i = 0; i < model.nbMuscleTotal(); ++i) {
+    states.push_back(
+        std::make_shared<internal_forces::muscles::StateDynamics>(0, 0.2));
+  }
+  model.updateMuscles(Q, Qdot, true);
+
+  EXPECT_FALSE(model.isMusclesCompiled());
+  model.compileMuscles();
+  EXPECT_TRUE(model.isMusclesCompiled());
+  EXPECT_EQ(model.muscleParameters().nbMuscles(), model.nbMuscleTotal());
+  EXPECT_EQ(
+      model.muscleParameters()
+          .indices(internal_forces::muscles::MUSCLE_TYPE::HILL)
+          .size(),
+      2);
+  EXPECT_EQ(
+      model.muscleParameters()
+          .indices(internal_forces::muscles::MUSCLE_TYPE::HILL_THELEN)
+          .size(),
+      3);
+  EXPECT_EQ(
+      model.muscleParameters()
+          .indices(internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE)
+          .size(),
+      1);
+
+  const utils::Vector& F = model.muscleForces(states);
+  std::vector<double> ExpectedForce(
+      {165.19678913804927,
+       178.49448510433558,
+       90.97584591669964,
+       92.59497473343656,
+       74.287046497422935,
+       198.53590160321016});
+  for (unsigned int i = 0; i < model.nbMuscleTotal(); ++i) {
+    SCALAR_TO_DOUBLE(val, F(i));
+    EXPECT_NEAR(val, ExpectedForce[i], requiredPrecision);
+  }
+
+  // The forces are written back to the muscles
+  for (unsigned int i = 0; i < model.nbMuscleTotal(); ++i) {
+    SCALAR_TO_DOUBLE(
+        val, static_cast<internal_forces::Compound&>(model.muscle(i)).force());
+    EXPECT_NEAR(val, ExpectedForce[i], requiredPrecision);
+  }
+
+  // Each element must match the per-muscle computation
+  const internal_forces::muscles::MuscleParameterSet& parameters(
+      model.muscleParameters());
+  for (unsigned int i = 0; i < model.nbMuscleTotal(); ++i) {
+    internal_forces::muscles::HillType& muscle(
+        dynamic_cast<internal_forces::muscles::HillType&>(model.muscle(i)));
+    SCALAR_TO_DOUBLE(FlCE, parameters.FlCE()(i));
+    SCALAR_TO_DOUBLE(FlCE_ref, muscle.FlCE(*states[i]));
+    EXPECT_NEAR(FlCE, FlCE_ref, requiredPrecision);
+    SCALAR_TO_DOUBLE(FlPE, parameters.FlPE()(i));
+    SCALAR_TO_DOUBLE(FlPE_ref, muscle.FlPE());
+    EXPECT_NEAR(FlPE, FlPE_ref, requiredPrecision);
+    SCALAR_TO_DOUBLE(FvCE, parameters.FvCE()(i));
+    SCALAR_TO_DOUBLE(FvCE_ref, muscle.FvCE());
+    EXPECT_NEAR(FvCE, FvCE_ref, requiredPrecision);
+  }
+
+#ifndef BIORBD_USE_CASADI_MATH
+  // Out of range activations are bounded as in State::setActivation
+  utils::Vector activations(model.nbMuscleTotal());
+  utils::Vector bounded(model.nbMuscleTotal());
+  for (unsigned int i = 0; i < model.nbMuscleTotal(); ++i) {
+    activations(i) = i % 2 ? 1.5 : -0.5;
+    bounded(i) = i % 2 ? 1.0 : 0.0;
+  }
+  utils::Vector FOut(model.muscleForces(activations));
+  utils::Vector FBounded(model.muscleForces(bounded));
+  for (unsigned int i = 0; i < model.nbMuscleTotal(); ++i) {
+    EXPECT_NEAR(FOut(i), FBounded(i), requiredPrecision);
+  }
+#endif
+}
+
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(MuscleForce, multithreaded) {
+  Model model(modelPathForMuscleForce);
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  Q.setOnes();
+  Qdot.setOnes();
+  utils::Vector activations(model.nbMuscleTotal());
+  for (unsigned int i = 0; i < model.nbMuscleTotal(); ++i) {
+    activations[i] = 0.2;
+  }
+
+  EXPECT_EQ(model.musclesNbThreads(), 1);
+  model.setMusclesNbThreads(3);
+  EXPECT_EQ(model.musclesNbThreads(), 3);
+
+  std::vector<double> TauExpected({-11.018675667414932, -1.7483464272594329});
+  for (size_t compiled = 0; compiled < 2; ++compiled) {
+    if (compiled) {
+      model.compileMuscles();
+    }
+    // Run several times so the workers are reused
+    for (size_t k = 0; k < 5; ++k) {
+      rigidbody::GeneralizedTorque Tau(
+          model.muscularJointTorqueFromActivations(activations, Q, Qdot));
+      for (unsigned int i = 0; i < Tau.size(); ++i) {
+        SCALAR_TO_DOUBLE(val, Tau(i));
+        EXPECT_NEAR(val, TauExpected[i], requiredPrecision);
+      }
+    }
+  }
+
+  // Back to serial
+  model.setMusclesNbThreads(1);
+  EXPECT_EQ(model.musclesNbThreads(), 1);
+  rigidbody::GeneralizedTorque Tau(
+      model.muscularJointTorqueFromActivations(activations, Q, Qdot));
+  for (unsigned int i = 0; i < Tau.size(); ++i) {
+    SCALAR_TO_DOUBLE(val, Tau(i));
+    EXPECT_NEAR(val, TauExpected[i], requiredPrecision);
+  }
+}
+
+TEST(MuscleForce, forceDerivatives) {
+  Model model(modelPathForMuscleForce);
+  internal_forces::muscles::MuscleParameterSet& parameters(
+      model.batchedMuscleParameters());
+  unsigned int nbMus(static_cast<unsigned int>(model.nbMuscleTotal()));
+  double h(1e-6);
+
+  // Short and long muscles, in eccentric and concentric contraction
+  std::vector<double> lengthScales({0.8, 1.3});
+  std::vector<double> velocityScales({-0.3, 0.2});
+  for (size_t s = 0; s < lengthScales.size(); ++s) {
+    for (size_t t = 0; t < velocityScales.size(); ++t) {
+      utils::Vector activations(nbMus);
+      utils::Vector lengths(nbMus);
+      utils::Vector velocities(nbMus);
+      for (unsigned int i = 0; i < nbMus; ++i) {
+        activations[i] = 0.1 + 0.1 * i;
+        lengths[i] = lengthScales[s] * parameters.optimalLength()[i];
+        velocities[i] = velocityScales[t] * parameters.optimalLength()[i] *
+                        parameters.maxShorteningSpeed()[i];
+      }
+
+      utils::Vector dFda(nbMus);
+      utils::Vector dFdl(nbMus);
+      utils::Vector dFdv(nbMus);
+      parameters.computeForceDerivatives(
+          activations, lengths, velocities, dFda, dFdl, dFdv);
+
+      // Each force only depends on its own muscle, so all the muscles can be
+      // perturbed at once
+      utils::Vector Fp(nbMus);
+      utils::Vector Fm(nbMus);
+      utils::Vector ones(utils::Vector::Ones(nbMus));
+      std::vector<utils::Vector*> derivatives({&dFda, &dFdl, &dFdv});
+      for (size_t k = 0; k < 3; ++k) {
+        utils::Vector dA(k == 0 ? ones * h : ones * 0);
+        utils::Vector dL(k == 1 ? ones * h : ones * 0);
+        utils::Vector dV(k == 2 ? ones * h : ones * 0);
+        parameters.computeForces(
+            activations + dA, lengths + dL, velocities + dV, Fp);
+        parameters.computeForces(
+            activations - dA, lengths - dL, velocities - dV, Fm);
+        for (unsigned int i = 0; i < nbMus; ++i) {
+          double finiteDifference((Fp[i] - Fm[i]) / (2 * h));
+          EXPECT_NEAR(
+              (*derivatives[k])[i],
+              finiteDifference,
+              1e-5 * std::max(1.0, std::fabs(finiteDifference)));
+        }
+      }
+    }
+  }
+
+  // Joint torque with respect to the activations
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  Q.setOnes();
+  Qdot.setOnes();
+  utils::Vector activations(nbMus);
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    activations[i] = 0.2 + 0.05 * i;
+  }
+  utils::Matrix dTauda(
+      model.muscularJointTorqueActivationsJacobian(activations, Q, Qdot));
+  EXPECT_EQ(dTauda.rows(), model.nbDof());
+  EXPECT_EQ(dTauda.cols(), nbMus);
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    utils::Vector dA(utils::Vector::Zero(nbMus));
+    dA[i] = h;
+    rigidbody::GeneralizedTorque TauP(
+        model.muscularJointTorqueFromActivations(activations + dA));
+    rigidbody::GeneralizedTorque TauM(
+        model.muscularJointTorqueFromActivations(activations - dA));
+    for (unsigned int j = 0; j < model.nbDof(); ++j) {
+      double finiteDifference((TauP[j] - TauM[j]) / (2 * h));
+      EXPECT_NEAR(
+          dTauda(j, i),
+          finiteDifference,
+          1e-5 * std::max(1.0, std::fabs(finiteDifference)));
+    }
+  }
+
+  // The derivatives did not switch the model to the compiled muscles
+  EXPECT_FALSE(model.isMusclesCompiled());
+  EXPECT_THROW(model.muscleParameters(), std::runtime_error);
+}
+
+TEST(MuscleForce, curveTables) {
+  Model model(modelPathForMuscleForce);
+  model.compileMuscles();
+  unsigned int nbMus(static_cast<unsigned int>(model.nbMuscleTotal()));
+  utils::Vector activations(nbMus);
+  utils::Vector lengths(nbMus);
+  utils::Vector velocities(nbMus);
+  std::vector<double> lengthScales({0.8, 1.3, 2.4});
+  std::vector<double> velocityScales({-0.3, 0.2, 1.2});
+
+  // Analytic forces of short, long and overstretched muscles
+  std::vector<utils::Vector> forces;
+  for (size_t s = 0; s < lengthScales.size(); ++s) {
+    internal_forces::muscles::MuscleParameterSet& parameters(
+        model.muscleParameters());
+    for (unsigned int i = 0; i < nbMus; ++i) {
+      activations[i] = 0.1 + 0.1 * i;
+      lengths[i] = lengthScales[s] * parameters.optimalLength()[i];
+      velocities[i] = velocityScales[s] * parameters.optimalLength()[i] *
+                      parameters.maxShorteningSpeed()[i];
+    }
+    forces.push_back(utils::Vector(nbMus));
+    parameters.computeForces(activations, lengths, velocities, forces[s]);
+  }
+
+  EXPECT_FALSE(model.muscleParameters().isCurveTablesUsed());
+  model.useMuscleCurveTables(true);
+  model.compileMuscles();
+  internal_forces::muscles::MuscleParameterSet& parameters(
+      model.muscleParameters());
+  EXPECT_TRUE(parameters.isCurveTablesUsed());
+  EXPECT_EQ(
+      parameters
+          .curveTable(
+              internal_forces::muscles::MUSCLE_TYPE::HILL_DE_GROOTE,
+              internal_forces::muscles::MUSCLE_CURVE::FORCE_VELOCITY)
+          .nbIntervals(),
+      1000);
+  EXPECT_LT(parameters.curveTablesMaxError(), 1e-6);
+  EXPECT_THROW(
+      parameters.curveTable(
+          internal_forces::muscles::MUSCLE_TYPE::HILL,
+          internal_forces::muscles::MUSCLE_CURVE::FORCE_LENGTH_ACTIVE),
+      std::runtime_error);
+  EXPECT_THROW(model.useMuscleCurveTables(true, 999), std::runtime_error);
+  EXPECT_TRUE(parameters.isCurveTablesUsed());
+
+  double h(1e-6);
+  for (size_t s = 0; s < lengthScales.size(); ++s) {
+    for (unsigned int i = 0; i < nbMus; ++i) {
+      lengths[i] = lengthScales[s] * parameters.optimalLength()[i];
+      velocities[i] = velocityScales[s] * parameters.optimalLength()[i] *
+                      parameters.maxShorteningSpeed()[i];
+    }
+    utils::Vector F(nbMus);
+    parameters.computeForces(activations, lengths, velocities, F);
+    for (unsigned int i = 0; i < nbMus; ++i) {
+      EXPECT_NEAR(
+          F[i],
+          forces[s][i],
+          10 * parameters.curveTablesMaxError() *
+              parameters.forceIsoMax()[i]);
+    }
+
+    // The derivatives are the ones of the interpolated curves
+    utils::Vector dFda(nbMus);
+    utils::Vector dFdl(nbMus);
+    utils::Vector dFdv(nbMus);
+    parameters.computeForceDerivatives(
+        activations, lengths, velocities, dFda, dFdl, dFdv);
+    utils::Vector Fp(nbMus);
+    utils::Vector Fm(nbMus);
+    utils::Vector dX(utils::Vector::Ones(nbMus) * h);
+    parameters.computeForces(activations, lengths + dX, velocities, Fp);
+    parameters.computeForces(activations, lengths - dX, velocities, Fm);
+    for (unsigned int i = 0; i < nbMus; ++i) {
+      double finiteDifference((Fp[i] - Fm[i]) / (2 * h));
+      EXPECT_NEAR(
+          dFdl[i],
+          finiteDifference,
+          1e-5 * std::max(1.0, std::fabs(finiteDifference)));
+    }
+    parameters.computeForces(activations, lengths, velocities + dX, Fp);
+    parameters.computeForces(activations, lengths, velocities - dX, Fm);
+    for (unsigned int i = 0; i < nbMus; ++i) {
+      double finiteDifference((Fp[i] - Fm[i]) / (2 * h));
+      EXPECT_NEAR(
+          dFdv[i],
+          finiteDifference,
+          1e-5 * std::max(1.0, std::fabs(finiteDifference)));
+    }
+  }
+
+  // The tables are dropped when going back to the analytic curves
+  model.useMuscleCurveTables(false);
+  EXPECT_FALSE(model.muscleParameters().isCurveTablesUsed());
+  EXPECT_EQ(model.muscleParameters().curveTablesMaxError(), 0);
+}
+
+TEST(MuscleForce, muscleDrivenForwardDynamics) {
+  Model model(modelPathForMuscleForce);
+  unsigned int nbMus(static_cast<unsigned int>(model.nbMuscleTotal()));
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  for (unsigned int i = 0; i < model.nbQ(); ++i) {
+    Q[i] = 0.3 + 0.4 * i;
+    Qdot[i] = -0.5 + 0.7 * i;
+  }
+  utils::Vector excitations(nbMus);
+  utils::Vector activations(nbMus);
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    excitations[i] = 0.6 - 0.05 * i;
+    activations[i] = 0.2 + 0.1 * i;
+  }
+
+  // Call by call
+  model.updateMuscles(Q, Qdot, true);
+  utils::Vector expectedForces(model.muscleForces(activations));
+  rigidbody::GeneralizedAcceleration expectedQddot(model.ForwardDynamics(
+      Q, Qdot, model.muscularJointTorque(expectedForces)));
+  utils::Vector expectedActivationsDot(
+      model.activationDot(excitations, activations));
+
+  for (bool compiled : {false, true}) {
+    if (compiled) {
+      model.compileMuscles();
+    }
+    utils::Vector forces;
+    rigidbody::GeneralizedAcceleration Qddot(
+        model.muscleDrivenForwardDynamics(Q, Qdot, activations, &forces));
+    for (unsigned int i = 0; i < model.nbQddot(); ++i) {
+      EXPECT_NEAR(Qddot[i], expectedQddot[i], requiredPrecision);
+    }
+    for (unsigned int i = 0; i < nbMus; ++i) {
+      EXPECT_NEAR(forces[i], expectedForces[i], requiredPrecision);
+    }
+
+    rigidbody::ExternalForceSet externalForces(model.externalForceSet());
+    utils::Vector activationsDot;
+    Qddot = model.muscleDrivenForwardDynamics(
+        Q, Qdot, excitations, activations, externalForces, activationsDot);
+    for (unsigned int i = 0; i < model.nbQddot(); ++i) {
+      EXPECT_NEAR(Qddot[i], expectedQddot[i], requiredPrecision);
+    }
+    for (unsigned int i = 0; i < nbMus; ++i) {
+      EXPECT_NEAR(
+          activationsDot[i], expectedActivationsDot[i], requiredPrecision);
+    }
+  }
+}
+
+TEST(MuscleForce, batchedActivationDynamics) {
+  double h(1e-7);
+  for (const std::string& path :
+       {modelPathForMuscleForce, modelPathForDeGrooteDynamics}) {
+    Model model(path);
+    unsigned int nbMus(static_cast<unsigned int>(model.nbMuscleTotal()));
+    utils::Vector excitations(nbMus);
+    utils::Vector activations(nbMus);
+    for (unsigned int i = 0; i < nbMus; ++i) {
+      // Activating and deactivating muscles, one below the minimal activation
+      excitations[i] = i % 2 ? 0.8 - 0.05 * i : 0.1 + 0.02 * i;
+      activations[i] = i == 0 ? 0 : 0.4 + 0.03 * i;
+    }
+
+    // Muscle by muscle
+    std::vector<utils::Vector> allExpected;
+    for (bool normalized : {true, false}) {
+      allExpected.push_back(
+          model.activationDot(excitations, activations, normalized));
+    }
+
+    // Batched, through the compiled muscles
+    model.compileMuscles();
+    for (bool normalized : {true, false}) {
+      const utils::Vector& expected(allExpected[normalized ? 0 : 1]);
+      utils::Vector activationsDot(
+          model.activationDot(excitations, activations, normalized));
+      utils::Vector batched(nbMus);
+      utils::Vector derivatives(nbMus);
+      internal_forces::muscles::MuscleParameterSet& parameters(
+          model.muscleParameters());
+      parameters.computeActivationsDotDerivative(
+          excitations, activations, batched, derivatives, normalized);
+      for (unsigned int i = 0; i < nbMus; ++i) {
+        EXPECT_NEAR(activationsDot[i], expected[i], requiredPrecision);
+        EXPECT_NEAR(batched[i], expected[i], requiredPrecision);
+      }
+
+      // Derivative with respect to the excitations
+      utils::Vector dE(utils::Vector::Ones(nbMus) * h);
+      utils::Vector plus(nbMus);
+      utils::Vector minus(nbMus);
+      parameters.computeActivationsDot(
+          excitations + dE, activations, plus, normalized);
+      parameters.computeActivationsDot(
+          excitations - dE, activations, minus, normalized);
+      for (unsigned int i = 0; i < nbMus; ++i) {
+        double finiteDifference((plus[i] - minus[i]) / (2 * h));
+        EXPECT_NEAR(
+            derivatives[i],
+            finiteDifference,
+            1e-5 * std::max(1.0, std::fabs(finiteDifference)));
+      }
+    }
+  }
+
+  // Excitation dynamics of the Buchanan muscles
+  Model model(modelPathForBuchananDynamics);
+  unsigned int nbMus(static_cast<unsigned int>(model.nbMuscleTotal()));
+  internal_forces::muscles::MuscleParameterSet& parameters(
+      model.batchedMuscleParameters());
+  EXPECT_EQ(
+      parameters.stateIndices(internal_forces::muscles::STATE_TYPE::BUCHANAN)
+          .size(),
+      nbMus);
+  utils::Vector neuralCommands(nbMus);
+  utils::Vector excitations(nbMus);
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    neuralCommands[i] = 0.2 + 0.1 * i;
+    excitations[i] = 0.5;
+  }
+  utils::Vector excitationsDot(nbMus);
+  parameters.computeActivationsDot(neuralCommands, excitations, excitationsDot);
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    internal_forces::muscles::StateDynamicsBuchanan state(
+        neuralCommands[i], excitations[i]);
+    EXPECT_NEAR(
+        excitationsDot[i],
+        state.timeDerivativeExcitation(model.muscle(i).characteristics(), true),
+        requiredPrecision);
+  }
+}
+#endif
+
 TEST(MuscleCharacterics, unittest) {
   {
     internal_forces::muscles::Characteristics charact;
@@ -3231,6 +4004,283 @@ TEST(MuscleJacobian, jacobianLength) {
   }
 }
 
+TEST(MuscleJacobian, jacobianLengthCompiled) {
+  Model modelRef(modelPathForMuscleJacobian);
+  Model model(modelPathForMuscleJacobian);
+  model.compileMuscles();
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  Q.setOnes();
+  Qdot = Qdot.setOnes() / 10;
+  modelRef.updateMuscles(Q, Qdot, true);
+  model.updateMuscles(Q, Qdot, true);
+
+  // Moment-arm matrix assembled from the point table
+  utils::Matrix jacoRef(modelRef.musclesLengthJacobian());
+  utils::Matrix jaco(model.musclesLengthJacobian());
+  EXPECT_EQ(jaco.rows(), jacoRef.rows());
+  EXPECT_EQ(jaco.cols(), jacoRef.cols());
+  for (unsigned int i = 0; i < jaco.rows(); ++i) {
+    for (unsigned int j = 0; j < jaco.cols(); ++j) {
+      SCALAR_TO_DOUBLE(val, jaco(i, j));
+      SCALAR_TO_DOUBLE(valRef, jacoRef(i, j));
+      EXPECT_NEAR(val, valRef, requiredPrecision);
+    }
+  }
+
+  // Each muscle is updated as well
+  for (size_t i = 0; i < model.nbMuscles(); ++i) {
+    const internal_forces::muscles::MuscleGeometry& geo(
+        model.muscle(i).position());
+    const internal_forces::muscles::MuscleGeometry& geoRef(
+        modelRef.muscle(i).position());
+    SCALAR_TO_DOUBLE(length, geo.length());
+    SCALAR_TO_DOUBLE(lengthRef, geoRef.length());
+    EXPECT_NEAR(length, lengthRef, requiredPrecision);
+    SCALAR_TO_DOUBLE(velocity, geo.velocity());
+    SCALAR_TO_DOUBLE(velocityRef, geoRef.velocity());
+    EXPECT_NEAR(velocity, velocityRef, requiredPrecision);
+    EXPECT_EQ(geo.pointsInGlobal().size(), geoRef.pointsInGlobal().size());
+    for (size_t j = 0; j < geo.pointsInGlobal().size(); ++j) {
+      for (unsigned int k = 0; k < 3; ++k) {
+        SCALAR_TO_DOUBLE(point, geo.pointsInGlobal()[j](k));
+        SCALAR_TO_DOUBLE(pointRef, geoRef.pointsInGlobal()[j](k));
+        EXPECT_NEAR(point, pointRef, requiredPrecision);
+      }
+    }
+  }
+}
+
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(MuscleJacobian, jacobianLengthWrapping) {
+  Model model(modelPathWithWrapping);
+  rigidbody::GeneralizedCoordinates Q(model);
+  double eps(1e-6);
+
+  std::vector<double> positions = {0.1, -0.5};
+  for (double position : positions) {
+    Q = Q.setOnes() * position;
+    model.updateMuscles(Q, true);
+    utils::Matrix jaco(model.musclesLengthJacobian());
+
+    // Compare with the numerical derivative of the length
+    for (unsigned int j = 0; j < model.nbQ(); ++j) {
+      rigidbody::GeneralizedCoordinates Qplus(Q);
+      rigidbody::GeneralizedCoordinates Qminus(Q);
+      Qplus(j) += eps;
+      Qminus(j) -= eps;
+      model.updateMuscles(Qplus, true);
+      double lengthPlus(model.muscle(0).position().musculoTendonLength());
+      model.updateMuscles(Qminus, true);
+      double lengthMinus(model.muscle(0).position().musculoTendonLength());
+      EXPECT_NEAR(jaco(0, j), (lengthPlus - lengthMinus) / (2 * eps), 1e-6);
+    }
+  }
+}
+#endif
+
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(MuscleJacobian, jacobianLengthWrappingChain) {
+  // A sphere, a via point and an ellipsoid on the same path
+  Model model(modelPathWithWrappingChain);
+  rigidbody::GeneralizedCoordinates Q(model);
+  double eps(1e-6);
+
+  std::vector<double> positions = {0.1, -0.2};
+  for (double position : positions) {
+    Q = Q.setOnes() * position;
+    model.updateMuscles(Q, true);
+    EXPECT_EQ(model.muscle(0).position().pointsInGlobal().size(), 7);
+    utils::Matrix jaco(model.musclesLengthJacobian());
+
+    // Compare with the numerical derivative of the length
+    for (unsigned int j = 0; j < model.nbQ(); ++j) {
+      rigidbody::GeneralizedCoordinates Qplus(Q);
+      rigidbody::GeneralizedCoordinates Qminus(Q);
+      Qplus(j) += eps;
+      Qminus(j) -= eps;
+      model.updateMuscles(Qplus, true);
+      double lengthPlus(model.muscle(0).position().musculoTendonLength());
+      model.updateMuscles(Qminus, true);
+      double lengthMinus(model.muscle(0).position().musculoTendonLength());
+      EXPECT_NEAR(jaco(0, j), (lengthPlus - lengthMinus) / (2 * eps), 1e-5);
+    }
+  }
+}
+#endif
+
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(MuscleJacobian, jacobianLengthWrappingConsecutive) {
+  // A sphere and an ellipsoid with no via point in between
+  Model model(modelPathWithConsecutiveWrapping);
+  rigidbody::GeneralizedCoordinates Q(model);
+  double eps(1e-6);
+
+  std::vector<double> positions = {0.1, -0.2};
+  for (double position : positions) {
+    Q = Q.setOnes() * position;
+    model.updateMuscles(Q, true);
+    EXPECT_EQ(model.muscle(0).position().pointsInGlobal().size(), 6);
+    utils::Matrix jaco(model.musclesLengthJacobian());
+
+    // Compare with the numerical derivative of the length
+    for (unsigned int j = 0; j < model.nbQ(); ++j) {
+      rigidbody::GeneralizedCoordinates Qplus(Q);
+      rigidbody::GeneralizedCoordinates Qminus(Q);
+      Qplus(j) += eps;
+      Qminus(j) -= eps;
+      model.updateMuscles(Qplus, true);
+      double lengthPlus(model.muscle(0).position().musculoTendonLength());
+      model.updateMuscles(Qminus, true);
+      double lengthMinus(model.muscle(0).position().musculoTendonLength());
+      EXPECT_NEAR(jaco(0, j), (lengthPlus - lengthMinus) / (2 * eps), 1e-5);
+    }
+  }
+}
+
+TEST(MuscleJacobian, wrappingPointsOnTheirSegment) {
+  // The points on the wrapping objects are held fixed on the segment of the
+  // object, so their jacobian is the one of a point of that segment
+  Model model(modelPathWithConsecutiveWrapping);
+  rigidbody::GeneralizedCoordinates Q(model);
+  Q = Q.setOnes() * 0.1;
+  model.updateMuscles(Q, true);
+  const std::vector<utils::Vector3d> points(
+      model.muscle(0).position().pointsInGlobal());
+  utils::Matrix jaco(model.muscle(0).position().jacobian());
+  std::vector<utils::String> parents = {"Seg0", "Seg0", "Seg1", "Seg1"};
+  double eps(1e-6);
+  for (unsigned int k = 0; k < parents.size(); ++k) {
+    const utils::Vector3d local(
+        points[k + 1].applyRT(model.globalJCS(Q, parents[k]).transpose()));
+    for (unsigned int j = 0; j < model.nbQ(); ++j) {
+      rigidbody::GeneralizedCoordinates Qplus(Q);
+      rigidbody::GeneralizedCoordinates Qminus(Q);
+      Qplus(j) += eps;
+      Qminus(j) -= eps;
+      utils::Vector3d positionPlus(
+          local.applyRT(model.globalJCS(Qplus, parents[k])));
+      utils::Vector3d positionMinus(
+          local.applyRT(model.globalJCS(Qminus, parents[k])));
+      for (unsigned int i = 0; i < 3; ++i) {
+        EXPECT_NEAR(
+            jaco(3 * (k + 1) + i, j),
+            (positionPlus(i) - positionMinus(i)) / (2 * eps),
+            1e-6);
+      }
+    }
+  }
+}
+#endif
+
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(MuscleLengthSurrogate, fitAndEvaluate) {
+  Model model(modelPathForMuscleJacobian);
+  std::shared_ptr<internal_forces::muscles::MuscleLengthSurrogate> surrogate(
+      std::make_shared<internal_forces::muscles::MuscleLengthSurrogate>());
+  surrogate->fit(model, model, 6);
+  EXPECT_EQ(surrogate->nbMuscles(), model.nbMuscles());
+
+  rigidbody::GeneralizedCoordinates Q(model);
+  Q(0) = 0.3;
+  Q(1) = 0.8;
+  model.updateMuscles(Q, true);
+  utils::Matrix jacobianExact(model.musclesLengthJacobian());
+  surrogate->update(Q);
+  utils::Vector lengths(surrogate->lengths());
+  utils::Matrix jacobian(surrogate->lengthJacobian());
+  for (size_t i = 0; i < model.nbMuscles(); ++i) {
+    unsigned int idx(static_cast<unsigned int>(i));
+    EXPECT_GT(surrogate->spannedDofs(i).size(), 0);
+    EXPECT_LT(surrogate->validationMaxLengthError(i), 1e-3);
+    EXPECT_LT(surrogate->validationMaxJacobianError(i), 1e-2);
+    EXPECT_NEAR(
+        lengths(idx), model.muscle(i).position().musculoTendonLength(), 1e-3);
+    for (unsigned int j = 0; j < model.nbQ(); ++j) {
+      EXPECT_NEAR(jacobian(idx, j), jacobianExact(idx, j), 1e-2);
+    }
+  }
+
+  // The jacobian is the derivative of the polynomials
+  double eps(1e-6);
+  for (unsigned int j = 0; j < model.nbQ(); ++j) {
+    rigidbody::GeneralizedCoordinates Qmoved(Q);
+    Qmoved(j) += eps;
+    surrogate->update(Qmoved);
+    utils::Vector lengthsPlus(surrogate->lengths());
+    Qmoved(j) -= 2 * eps;
+    surrogate->update(Qmoved);
+    utils::Vector lengthsMinus(surrogate->lengths());
+    for (unsigned int i = 0; i < model.nbMuscles(); ++i) {
+      EXPECT_NEAR(
+          jacobian(i, j), (lengthsPlus(i) - lengthsMinus(i)) / (2 * eps), 1e-6);
+    }
+  }
+
+  // Once written and read back, the surrogate gives the same values
+  utils::String savePath("temporarySurrogate.txt");
+  surrogate->write(savePath);
+  std::shared_ptr<internal_forces::muscles::MuscleLengthSurrogate> readBack(
+      std::make_shared<internal_forces::muscles::MuscleLengthSurrogate>(
+          savePath));
+  remove(savePath.c_str());
+  EXPECT_THROW(
+      surrogate->write(utils::String("noSuchFolder/temporarySurrogate.txt")),
+      std::runtime_error);
+  readBack->update(Q);
+  for (unsigned int i = 0; i < model.nbMuscles(); ++i) {
+    EXPECT_NEAR(readBack->lengths()(i), lengths(i), 1e-10);
+    EXPECT_NEAR(
+        readBack->validationMaxLengthError(i),
+        surrogate->validationMaxLengthError(i),
+        1e-10);
+  }
+
+  // The muscles can be updated from the surrogate
+  rigidbody::GeneralizedVelocity Qdot(model);
+  Qdot(0) = 1.1;
+  Qdot(1) = -0.4;
+  model.setMuscleLengthSurrogate(readBack);
+  EXPECT_TRUE(model.isMuscleLengthSurrogateUsed());
+  model.updateMuscles(Q, Qdot, true);
+  utils::Matrix jacobianFromMuscles(model.musclesLengthJacobian());
+  for (unsigned int i = 0; i < model.nbMuscles(); ++i) {
+    EXPECT_NEAR(
+        model.muscle(i).position().musculoTendonLength(), lengths(i), 1e-10);
+    EXPECT_NEAR(
+        model.muscle(i).position().velocity(),
+        (jacobian.row(i) * Qdot)(0),
+        1e-10);
+    for (unsigned int j = 0; j < model.nbQ(); ++j) {
+      EXPECT_NEAR(jacobianFromMuscles(i, j), jacobian(i, j), 1e-10);
+    }
+  }
+  model.setMuscleLengthSurrogate(nullptr);
+  EXPECT_FALSE(model.isMuscleLengthSurrogateUsed());
+
+  // A surrogate fitted on other degrees of freedom is refused
+  surrogate->write(savePath);
+  std::ifstream original(savePath.c_str());
+  std::string content(
+      (std::istreambuf_iterator<char>(original)),
+      std::istreambuf_iterator<char>());
+  original.close();
+  std::string nbDofTag("nbdof " + std::to_string(model.nbDof()));
+  content.replace(
+      content.find(nbDofTag),
+      nbDofTag.size(),
+      "nbdof " + std::to_string(model.nbDof() + 1));
+  std::ofstream modified(savePath.c_str());
+  modified << content;
+  modified.close();
+  std::shared_ptr<internal_forces::muscles::MuscleLengthSurrogate> otherDofs(
+      std::make_shared<internal_forces::muscles::MuscleLengthSurrogate>(
+          savePath));
+  remove(savePath.c_str());
+  EXPECT_THROW(model.setMuscleLengthSurrogate(otherDofs), std::runtime_error);
+}
+#endif
+
 #ifndef BIORBD_USE_CASADI_MATH
 TEST(MuscleFatigue, FatigueXiaDerivativeViaPointers) {
   // Prepare the model
@@ -3556,6 +4606,80 @@ TEST(MuscleFatigue, FatigueXiaSetStateLimitsTest) {
 }
 #endif
 
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(StaticOptimQuadratic, optimalityAndWarmStart) {
+  Model model(modelPathForMuscleForce);
+  size_t nbMus(model.nbMuscleTotal());
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  rigidbody::GeneralizedTorque Tau(model);
+  for (size_t i = 0; i < Q.size(); ++i) {
+    Q[i] = 0.3 + static_cast<double>(i) * 0.2;
+    Qdot[i] = 0.1;
+    Tau[i] = 20 - static_cast<double>(i) * 15;
+  }
+
+  double torquePonderation(1000);
+  internal_forces::muscles::StaticOptimizationQuadratic optim(
+      model, torquePonderation);
+  optim.solve(Q, Qdot, Tau);
+  utils::Vector activations(optim.activations());
+  utils::Vector residuals(optim.residualTorques());
+
+  // Torque of each muscle fully activated alone, relative to no activation
+  std::vector<std::shared_ptr<internal_forces::muscles::State>> states;
+  for (size_t i = 0; i < nbMus; ++i) {
+    states.push_back(
+        std::make_shared<internal_forces::muscles::StateDynamics>(0, 0));
+  }
+  model.updateMuscles(Q, Qdot, true);
+  utils::Vector tau0(model.muscularJointTorque(states));
+  utils::Matrix A(tau0.size(), nbMus);
+  for (size_t i = 0; i < nbMus; ++i) {
+    states[i]->setActivation(1);
+    A.col(static_cast<unsigned int>(i)) =
+        model.muscularJointTorque(states) - tau0;
+    states[i]->setActivation(0);
+  }
+
+  // The residuals close the linearized torque balance
+  utils::Vector expectedResiduals(Tau - tau0 - A * activations);
+  for (unsigned int i = 0; i < residuals.size(); ++i) {
+    EXPECT_NEAR(residuals(i), expectedResiduals(i), 1e-8);
+  }
+
+  // Karush-Kuhn-Tucker conditions of sum(a^2) + w * sum(r^2)
+  utils::Vector gradient(
+      2 * activations - 2 * torquePonderation * A.transpose() * residuals);
+  double scale(1 + 2 * torquePonderation * A.norm() * Tau.norm());
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    EXPECT_GE(activations(i), 0.0001 - 1e-12);
+    EXPECT_LE(activations(i), 0.9999 + 1e-12);
+    if (activations(i) <= 0.0001) {
+      EXPECT_GE(gradient(i), -1e-9 * scale);
+    } else if (activations(i) >= 0.9999) {
+      EXPECT_LE(gradient(i), 1e-9 * scale);
+    } else {
+      EXPECT_NEAR(gradient(i), 0, 1e-9 * scale);
+    }
+  }
+
+  // Solving the same frame again starts from the optimal active set
+  optim.solve(Q, Qdot, Tau);
+  EXPECT_LE(optim.nbIterations(), 2u);
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    EXPECT_NEAR(optim.activations()(i), activations(i), 1e-10);
+  }
+
+  // And from scratch, the same solution is found
+  optim.resetActiveSet();
+  optim.solve(Q, Qdot, Tau);
+  for (unsigned int i = 0; i < nbMus; ++i) {
+    EXPECT_NEAR(optim.activations()(i), activations(i), 1e-10);
+  }
+}
+#endif
+
 #ifdef MODULE_STATIC_OPTIM
 
 TEST(StaticOptim, OneFrameNoActivations) {
@@ -3826,4 +4950,186 @@ TEST(StaticOptim, MultiFrameNoActivationVector) {
 #endif
 }
 
+TEST(StaticOptim, analyticalDerivatives) {
+#ifdef BIORBD_USE_CASADI_MATH
+  std::cout << "StaticOptim is not tested for CasADi backend" << std::endl;
+
+#else
+  Model model(modelPathForMuscleForce);
+
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  rigidbody::GeneralizedTorque Tau(model);
+  for (size_t i = 0; i < Q.size(); ++i) {
+    Q[i] = static_cast<double>(i) * 1.1;
+    Qdot[i] = static_cast<double>(i) * 1.1;
+    Tau[i] = static_cast<double>(i) * 1.1;
+  }
+  utils::Vector activations(model.nbMuscles());
+  for (unsigned int i = 0; i < model.nbMuscles(); ++i) {
+    activations[i] = 0.2 + 0.1 * i;
+  }
+
+  // The HillType muscles of the model make the constraints nonlinear
+  Ipopt::SmartPtr<internal_forces::muscles::StaticOptimizationIpopt> problem(
+      new internal_forces::muscles::StaticOptimizationIpopt(
+          model, Q, Qdot, Tau, activations, true, 3));
+  Ipopt::Index n, m, nnzJac, nnzHess;
+  Ipopt::TNLP::IndexStyleEnum style;
+  problem->get_nlp_info(n, m, nnzJac, nnzHess, style);
+  EXPECT_EQ(nnzHess, n);
+
+  std::vector<Ipopt::Number> x(n, 0.5);
+  for (unsigned int i = 0; i < model.nbMuscles(); ++i) {
+    x[i] = activations[i];
+  }
+  std::vector<Ipopt::Number> lambda(m);
+  for (Ipopt::Index i = 0; i < m; ++i) {
+    lambda[i] = 1.0 + i;
+  }
+  std::vector<Ipopt::Index> iRow(nnzJac), jCol(nnzJac);
+  std::vector<Ipopt::Index> iRowH(nnzHess), jColH(nnzHess);
+  std::vector<Ipopt::Number> jac(nnzJac), hess(nnzHess);
+  problem->eval_jac_g(
+      n, x.data(), true, m, nnzJac, iRow.data(), jCol.data(), nullptr);
+  problem->eval_jac_g(
+      n, x.data(), true, m, nnzJac, nullptr, nullptr, jac.data());
+  problem->eval_h(
+      n,
+      x.data(),
+      true,
+      1.0,
+      m,
+      lambda.data(),
+      true,
+      nnzHess,
+      iRowH.data(),
+      jColH.data(),
+      nullptr);
+  problem->eval_h(
+      n,
+      x.data(),
+      true,
+      1.0,
+      m,
+      lambda.data(),
+      true,
+      nnzHess,
+      nullptr,
+      nullptr,
+      hess.data());
+
+  // Derivative of the lagrangian along a variable
+  auto lagrangianGradient = [&](std::vector<Ipopt::Number>& xk,
+                                Ipopt::Index j) {
+    std::vector<Ipopt::Number> gradF(n), jacK(nnzJac);
+    problem->eval_grad_f(n, xk.data(), true, gradF.data());
+    problem->eval_jac_g(
+        n, xk.data(), true, m, nnzJac, nullptr, nullptr, jacK.data());
+    double out(gradF[j]);
+    for (Ipopt::Index k = 0; k < nnzJac; ++k) {
+      if (jCol[k] == j) {
+        out += lambda[iRow[k]] * jacK[k];
+      }
+    }
+    return out;
+  };
+
+  double h(1e-6);
+  for (Ipopt::Index j = 0; j < n; ++j) {
+    std::vector<Ipopt::Number> xp(x), xm(x);
+    xp[j] += h;
+    xm[j] -= h;
+    std::vector<Ipopt::Number> gp(m), gm(m);
+    problem->eval_g(n, xp.data(), true, m, gp.data());
+    problem->eval_g(n, xm.data(), true, m, gm.data());
+    for (Ipopt::Index k = 0; k < nnzJac; ++k) {
+      if (jCol[k] == j) {
+        double finiteDifference((gp[iRow[k]] - gm[iRow[k]]) / (2 * h));
+        EXPECT_NEAR(
+            jac[k],
+            finiteDifference,
+            1e-5 * std::max(1.0, std::fabs(finiteDifference)));
+      }
+    }
+
+    EXPECT_EQ(iRowH[j], j);
+    EXPECT_EQ(jColH[j], j);
+    double finiteDifference(
+        (lagrangianGradient(xp, j) - lagrangianGradient(xm, j)) / (2 * h));
+    EXPECT_NEAR(
+        hess[j],
+        finiteDifference,
+        1e-5 * std::max(1.0, std::fabs(finiteDifference)));
+  }
+#endif
+}
+
+TEST(StaticOptim, MultiFrameParallel) {
+#ifdef BIORBD_USE_CASADI_MATH
+  std::cout << "StaticOptim is not tested for CasADi backend" << std::endl;
+
+#else
+  Model model(modelPathForMuscleForce);
+
+  std::vector<rigidbody::GeneralizedCoordinates> allQ;
+  std::vector<rigidbody::GeneralizedVelocity> allQdot;
+  std::vector<rigidbody::GeneralizedTorque> allTau;
+  for (size_t frame = 0; frame < 4; ++frame) {
+    rigidbody::GeneralizedCoordinates Q(model);
+    rigidbody::GeneralizedVelocity Qdot(model);
+    rigidbody::GeneralizedTorque Tau(model);
+    for (size_t i = 0; i < Q.size(); ++i) {
+      Q[i] = static_cast<double>(i) * 1.1 + static_cast<double>(frame) * 0.1;
+      Qdot[i] = static_cast<double>(i) * 1.1;
+      Tau[i] = static_cast<double>(i) * 1.1;
+    }
+    allQ.push_back(Q);
+    allQdot.push_back(Qdot);
+    allTau.push_back(Tau);
+  }
+
+  internal_forces::muscles::StaticOptimization sequential(
+      model, allQ, allQdot, allTau);
+  sequential.run();
+
+  // The threads solve on deep copies of the model, which share nothing with
+  // the original
+  Model otherModel(model.DeepCopy());
+  double optimalLength(model.muscle(0).characteristics().optimalLength());
+  otherModel.muscle(0).characteristics().setOptimalLength(2 * optimalLength);
+  EXPECT_NEAR(
+      model.muscle(0).characteristics().optimalLength(),
+      optimalLength,
+      requiredPrecision);
+  otherModel.muscle(0).characteristics().setOptimalLength(optimalLength);
+
+  internal_forces::muscles::StaticOptimization parallel(
+      otherModel, allQ, allQdot, allTau);
+  parallel.runParallel(2, true, 2);
+
+  // The two chunks are solved at the same time, unless the linear solver of
+  // Ipopt is not reentrant
+  EXPECT_FALSE(sequential.isSolverSerialized());
+  EXPECT_EQ(sequential.maxConcurrentSolves(), 1);
+  if (parallel.isSolverSerialized()) {
+    EXPECT_EQ(parallel.maxConcurrentSolves(), 1);
+  } else if (std::thread::hardware_concurrency() > 1) {
+    EXPECT_EQ(parallel.maxConcurrentSolves(), 2);
+  }
+
+  const utils::Matrix& expected(sequential.finalSolutionMatrix());
+  const utils::Matrix& actual(parallel.finalSolutionMatrix());
+  EXPECT_EQ(actual.rows(), model.nbMuscles());
+  EXPECT_EQ(actual.cols(), 4);
+  for (unsigned int j = 0; j < 4; ++j) {
+    utils::Vector activations(parallel.finalSolution(j));
+    for (unsigned int i = 0; i < model.nbMuscles(); ++i) {
+      EXPECT_NEAR(actual(i, j), expected(i, j), 1e-5);
+      EXPECT_NEAR(activations(i), actual(i, j), 1e-12);
+    }
+  }
+#endif
+}
+
 #endif
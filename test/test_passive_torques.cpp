@@ -1,5 +1,7 @@
 #include "biorbdConfig.h"
 
+#include <algorithm>
+#include <cmath>
 #include <gtest/gtest.h>
 #include <iostream>
 
@@ -12,6 +14,7 @@
 #include "RigidBody/GeneralizedCoordinates.h"
 #include "RigidBody/GeneralizedTorque.h"
 #include "RigidBody/GeneralizedVelocity.h"
+#include "Utils/Matrix.h"
 
 using namespace BIORBD_NAMESPACE;
 
@@ -161,3 +164,72 @@ TEST(PassiveTorques, onlyOnePassiveTorque) {
         static_cast<double>(tau(i, 0)), torqueExpected[i], requiredPrecision);
   }
 }
+
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(PassiveTorques, compiledTorquesAndJacobians) {
+  Model model(modelPathForGeneralTesting);
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  for (unsigned int i = 0; i < model.nbQ(); ++i) {
+    Q[i] = 0.3 + 0.2 * i;
+    Qdot[i] = -0.5 + 0.4 * i;
+  }
+
+  // Same torques as the passive torques evaluated one by one
+  utils::Vector tau(model.nbGeneralizedTorque());
+  model.passiveJointTorque(Q, Qdot, tau);
+  for (unsigned int i = 0; i < model.nbGeneralizedTorque(); ++i) {
+    const std::shared_ptr<internal_forces::passive_torques::PassiveTorque>&
+        passiveTorque(model.getPassiveTorque(i));
+    utils::Scalar expected(0);
+    if (passiveTorque->type() ==
+        internal_forces::passive_torques::TORQUE_CONSTANT) {
+      expected = passiveTorque->passiveTorque();
+    } else if (
+        passiveTorque->type() ==
+        internal_forces::passive_torques::TORQUE_LINEAR) {
+      expected = std::static_pointer_cast<
+                     internal_forces::passive_torques::PassiveTorqueLinear>(
+                     passiveTorque)
+                     ->passiveTorque(Q);
+    } else {
+      expected =
+          std::static_pointer_cast<
+              internal_forces::passive_torques::PassiveTorqueExponential>(
+              passiveTorque)
+              ->passiveTorque(Q, Qdot);
+    }
+    EXPECT_NEAR(tau[i], expected, requiredPrecision);
+  }
+  EXPECT_EQ(model.nbPassiveTorques(), 3);
+
+  // Analytic jacobians against finite differences
+  utils::Matrix dTaudQ;
+  utils::Matrix dTaudQdot;
+  model.passiveJointTorqueJacobians(Q, Qdot, dTaudQ, dTaudQdot);
+  double h(1e-6);
+  for (unsigned int j = 0; j < model.nbQ(); ++j) {
+    rigidbody::GeneralizedCoordinates QPlus(Q);
+    rigidbody::GeneralizedCoordinates QMinus(Q);
+    QPlus[j] += h;
+    QMinus[j] -= h;
+    rigidbody::GeneralizedVelocity QdotPlus(Qdot);
+    rigidbody::GeneralizedVelocity QdotMinus(Qdot);
+    QdotPlus[j] += h;
+    QdotMinus[j] -= h;
+    utils::Vector dQ(
+        (model.passiveJointTorque(QPlus, Qdot) -
+         model.passiveJointTorque(QMinus, Qdot)) /
+        (2 * h));
+    utils::Vector dQdot(
+        (model.passiveJointTorque(Q, QdotPlus) -
+         model.passiveJointTorque(Q, QdotMinus)) /
+        (2 * h));
+    for (unsigned int i = 0; i < model.nbGeneralizedTorque(); ++i) {
+      EXPECT_NEAR(dTaudQ(i, j), dQ[i], 1e-5 * std::max(1.0, fabs(dQ[i])));
+      EXPECT_NEAR(
+          dTaudQdot(i, j), dQdot[i], 1e-5 * std::max(1.0, fabs(dQdot[i])));
+    }
+  }
+}
+#endif
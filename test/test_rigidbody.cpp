@@ -1,26 +1,35 @@
 #include "biorbdConfig.h"
 
+#include <cmath>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <string.h>
 
+#include <rbdl/Constraints.h>
 #include <rbdl/Dynamics.h>
 #include <rbdl/rbdl_math.h>
 
 #include "BiorbdModel.h"
+#include "ModelReader.h"
+#include "RigidBody/ContactSurface.h"
 #include "RigidBody/ExternalForceSet.h"
 #include "RigidBody/GeneralizedAcceleration.h"
 #include "RigidBody/GeneralizedCoordinates.h"
 #include "RigidBody/GeneralizedTorque.h"
 #include "RigidBody/GeneralizedVelocity.h"
 #include "RigidBody/IMU.h"
+#include "RigidBody/LoopConstraintSolver.h"
 #include "RigidBody/Mesh.h"
 #include "RigidBody/NodeSegment.h"
+#include "RigidBody/RigidContactSolver.h"
 #include "RigidBody/Segment.h"
 #include "RigidBody/SegmentCharacteristics.h"
+#include "RigidBody/SegmentCollisions.h"
+#include "RigidBody/SoftContactSet.h"
 #include "RigidBody/SoftContactSphere.h"
 #include "Utils/Matrix.h"
 #include "Utils/Matrix3d.h"
+#include "Utils/Path.h"
 #include "Utils/Range.h"
 #include "Utils/SpatialTransform.h"
 #include "Utils/SpatialVector.h"
@@ -51,6 +60,9 @@ static std::string modelWithRigidContactsExternalForces(
 static std::string modelWithSoftContactRigidContactsExternalForces(
     "models/cubeWithSoftContactsRigidContactsExternalForces.bioMod");
 static std::string modelWithSoftContact("models/cubeWithSoftContacts.bioMod");
+static std::string modelForCollision("models/cubesForCollision.bioMod");
+static std::string modelWithUnilateralContact(
+    "models/pointMassWithRigidContact.bioMod");
 
 TEST(Gravity, change) {
   Model model(modelPathForGeneralTesting);
@@ -669,6 +681,167 @@ TEST(SoftContacts, ForceAtOrigin) {
   }
 }
 
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(SoftContacts, contactSurfaceHeightfield) {
+  Model model(modelWithSoftContact);
+  DECLARE_GENERALIZED_COORDINATES(Q, model);
+  DECLARE_GENERALIZED_VELOCITY(Qdot, model);
+  FILL_VECTOR(Q, std::vector<double>({-2.01, -3.01, -3.01, 0.1}));
+  FILL_VECTOR(Qdot, std::vector<double>({-2.01, -3.01, -3.01, 0.1}));
+  std::vector<RigidBodyDynamics::Math::SpatialVector> forceExpected =
+      model.externalForceSet(false, true)
+          .computeRbdlSpatialVectors(
+              model.UpdateKinematicsCustom(&Q, &Qdot), Q, Qdot);
+
+  // A flat ground is the same as the default contact plane
+  utils::Matrix heights(utils::Matrix::Zero(3, 3));
+  model.addContactSurface(rigidbody::ContactSurface(
+      heights, utils::Vector3d(-50, -50, 0), 50, 50));
+  EXPECT_EQ(model.nbContactSurfaces(), 1);
+  EXPECT_EQ(model.contactSurface(0).nbTriangles(), 8);
+
+  for (size_t k = 0; k < 2; ++k) {
+    if (k == 1) {
+      model.compileSoftContacts();
+    }
+    auto &updatedModel = model.UpdateKinematicsCustom(&Q, &Qdot);
+    std::vector<RigidBodyDynamics::Math::SpatialVector> forceInRbdl =
+        model.externalForceSet(false, true)
+            .computeRbdlSpatialVectors(updatedModel, Q, Qdot);
+    for (size_t i = 0; i < forceExpected.size(); ++i) {
+      for (size_t j = 0; j < 6; ++j) {
+        EXPECT_NEAR(forceInRbdl[i](j), forceExpected[i](j), 1e-6);
+      }
+    }
+  }
+}
+
+TEST(SoftContacts, contactSurfacePlanes) {
+  Model model(modelWithSoftContact);
+
+  // A pyramid of height 1 on the declared plane of the contacts (z = 0)
+  utils::Matrix heights(utils::Matrix::Zero(3, 3));
+  heights(1, 1) = 1;
+  model.addContactSurface(
+      rigidbody::ContactSurface(heights, utils::Vector3d(-1, -1, 0), 1, 1));
+
+  // Checks the plane of the first contact when placed at x (the second one
+  // stays beside the pyramid, closer to the declared plane)
+  auto expectPlane = [&](const utils::Vector3d& x,
+                         const utils::Vector3d& origin,
+                         const utils::Vector3d& normal) {
+    std::vector<utils::Vector3d> positions(
+        {x, utils::Vector3d(3, 3, 0.5)});
+    model.updateSoftContactPlanes(positions);
+    for (unsigned int i = 0; i < 3; ++i) {
+      EXPECT_NEAR(
+          model.softContact(0).contactPlaneOrigin()(i),
+          origin(i),
+          requiredPrecision);
+      EXPECT_NEAR(
+          model.softContact(0).contactPlaneNormal()(i),
+          normal(i),
+          requiredPrecision);
+      EXPECT_NEAR(
+          model.softContact(1).contactPlaneOrigin()(i), 0, requiredPrecision);
+      EXPECT_NEAR(
+          model.softContact(1).contactPlaneNormal()(i),
+          i == 2 ? 1 : 0,
+          requiredPrecision);
+    }
+  };
+
+  // Above a face, the plane is the face
+  utils::Vector3d faceNormal(1 / sqrt(2), 0, 1 / sqrt(2));
+  utils::Vector3d onFace(0.6, 0.2, 0.4);
+  expectPlane(onFace + 0.1 * faceNormal, onFace, faceNormal);
+
+  // Above the ridge between the faces z = 1 - x and z = 1 - y, the plane is
+  // tangent to the sphere
+  utils::Vector3d edgeNormal(1 / sqrt(6), 1 / sqrt(6), 2 / sqrt(6));
+  utils::Vector3d onEdge(0.5, 0.5, 0.5);
+  expectPlane(onEdge + 0.1 * edgeNormal, onEdge, edgeNormal);
+
+  // Above the top, the plane is tangent to the sphere at the vertex
+  utils::Vector3d top(0, 0, 1);
+  utils::Vector3d fromTop(0.05, 0.02, 0.5);
+  expectPlane(top + fromTop, top, fromTop / fromTop.norm());
+
+  // Out of reach of the pyramid, the declared plane is back
+  expectPlane(
+      utils::Vector3d(100, 100, 100),
+      utils::Vector3d(0, 0, 0),
+      utils::Vector3d(0, 0, 1));
+}
+
+TEST(SoftContacts, contactSurfaceMesh) {
+  rigidbody::ContactSurface surface(Reader::readMeshFileStl(
+      utils::Path("models/meshFiles/stl/pendulum.STL")));
+  EXPECT_GT(surface.nbTriangles(), 0);
+
+  utils::Vector3d x(1e3, 1e3, 1e3);
+  utils::Vector3d point(0, 0, 0);
+  size_t triangle(surface.nbTriangles());
+  EXPECT_FALSE(surface.closestPoint(x, 1e-3, point, triangle));
+  EXPECT_EQ(triangle, surface.nbTriangles());
+  EXPECT_TRUE(surface.closestPoint(x, 1e6, point, triangle));
+  EXPECT_LT(triangle, surface.nbTriangles());
+
+  // Starting from the last closest triangle gives the same point
+  size_t warmTriangle(triangle);
+  utils::Vector3d warmPoint(0, 0, 0);
+  EXPECT_TRUE(surface.closestPoint(x, 1e6, warmPoint, warmTriangle));
+  EXPECT_EQ(warmTriangle, triangle);
+  for (unsigned int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(warmPoint(i), point(i), requiredPrecision);
+  }
+}
+
+TEST(SegmentCollisions, distanceAndPenetration) {
+  Model model(modelForCollision);
+  rigidbody::SegmentCollisions collisions(model);
+  EXPECT_EQ(collisions.nbPairs(), 1);
+  EXPECT_EQ(collisions.firstSegment(0), 0);
+  EXPECT_EQ(collisions.secondSegment(0), 1);
+
+  rigidbody::GeneralizedCoordinates Q(model);
+  Q.setZero();
+
+  // Side by side
+  Q[3] = 1.5;
+  collisions.update(model, Q, 1.0);
+  EXPECT_NEAR(collisions.distance(0), 0.5, requiredPrecision);
+  EXPECT_FALSE(collisions.isColliding(0));
+  EXPECT_NEAR(collisions.penetration(0), 0, requiredPrecision);
+  EXPECT_NEAR(collisions.firstPoint(0)(0), 1, requiredPrecision);
+  EXPECT_NEAR(collisions.secondPoint(0)(0), 1.5, requiredPrecision);
+
+  // Further than the maximal distance
+  collisions.update(model, Q, 0.1);
+  EXPECT_TRUE(std::isinf(collisions.distance(0)));
+  EXPECT_FALSE(collisions.isColliding(0));
+
+  // An edge of the rotated cube is the closest
+  Q[3] = 2;
+  Q[6] = M_PI / 4;
+  collisions.update(model, Q, 1.0);
+  EXPECT_NEAR(collisions.distance(0), 1 - sqrt(0.5), requiredPrecision);
+  EXPECT_NEAR(collisions.secondPoint(0)(0), 2 - sqrt(0.5), requiredPrecision);
+  EXPECT_NEAR(collisions.secondPoint(0)(1), sqrt(0.5), requiredPrecision);
+  EXPECT_FALSE(collisions.isColliding(0));
+
+  // Intersecting
+  Q[3] = 0.8;
+  Q[4] = 0.5;
+  Q[5] = 0.5;
+  Q[6] = 0;
+  collisions.update(model, Q, 1.0);
+  EXPECT_NEAR(collisions.distance(0), 0, requiredPrecision);
+  EXPECT_TRUE(collisions.isColliding(0));
+  EXPECT_NEAR(collisions.penetration(0), 0.2, requiredPrecision);
+}
+#endif
+
 static std::vector<double> Qtest =
     {0.1, 0.1, 0.1, 0.3, 0.3, 0.3, 0.3, 0.3, 0.3, 0.3, 0.3, 0.4, 0.3};
 
@@ -2588,6 +2761,209 @@ TEST(Dynamics, ForwardLoopConstraint) {
   }
 }
 
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(Dynamics, LoopConstraintSolver) {
+  {
+    // Same values as ForwardAccelerationConstraint
+    Model model(modelPathForGeneralTesting);
+    model.segment(0).setJointDampings({});
+    rigidbody::GeneralizedCoordinates Q(model);
+    rigidbody::GeneralizedVelocity Qdot(model);
+    rigidbody::GeneralizedTorque Tau(model);
+    Q.setOnes();
+    Qdot.setOnes();
+    Tau.setOnes();
+
+    rigidbody::Contacts cs(model.getConstraints());
+    rigidbody::GeneralizedAcceleration Qddot_expected(
+        model.ForwardDynamicsConstraintsDirect(Q, Qdot, Tau, cs));
+    utils::Vector forces_expected(cs.getForce());
+
+    rigidbody::LoopConstraintSolver solver(model);
+    for (unsigned int k = 0; k < 2; ++k) {
+      solver.setNullSpace(k == 1);
+      for (unsigned int call = 0; call < 2; ++call) {
+        rigidbody::GeneralizedAcceleration Qddot(
+            solver.forwardDynamics(Q, Qdot, Tau));
+        EXPECT_EQ(solver.nbIndependentConstraints(), cs.nbContacts());
+        for (unsigned int i = 0; i < model.nbQddot(); ++i) {
+          EXPECT_NEAR(Qddot(i), Qddot_expected(i), 1e-8);
+        }
+        for (unsigned int i = 0; i < cs.nbContacts(); ++i) {
+          EXPECT_NEAR(solver.forces()(i), forces_expected(i), 1e-8);
+        }
+      }
+    }
+  }
+  {
+    Model model(modelPathForLoopConstraintTesting);
+    rigidbody::GeneralizedCoordinates Q(model);
+    rigidbody::GeneralizedVelocity Qdot(model);
+    rigidbody::GeneralizedTorque Tau(model);
+    for (unsigned int i = 0; i < model.nbQ(); ++i) {
+      Q(i) = 0.1 * i;
+      Qdot(i) = 0.2 - 0.05 * i;
+      Tau(i) = 0.1 * i;
+    }
+
+    // Project the state on the constraints
+    rigidbody::LoopConstraintSolver solver(model);
+    EXPECT_TRUE(solver.projectPositions(Q, 1e-12));
+    EXPECT_TRUE(solver.projectPositions(Q, 1e-12, 0));
+    solver.projectVelocities(Q, Qdot);
+    EXPECT_EQ(
+        solver.dependentCoordinates().size() +
+            solver.independentCoordinates().size(),
+        model.nbQ());
+
+    utils::Matrix G(
+        utils::Matrix::Zero(solver.nbConstraints(), model.nbQdot()));
+    RigidBodyDynamics::CalcConstraintsJacobian(
+        model, Q, model.getConstraints(), G, true);
+    utils::Vector velocityError(G * Qdot);
+    for (unsigned int i = 0; i < solver.nbConstraints(); ++i) {
+      EXPECT_NEAR(velocityError(i), 0, requiredPrecision);
+    }
+
+    // Both formulations match the direct solution of the constraints
+    rigidbody::GeneralizedAcceleration Qddot_expected(
+        model.ForwardDynamicsConstraintsDirect(Q, Qdot, Tau));
+    for (unsigned int k = 0; k < 2; ++k) {
+      solver.setNullSpace(k == 1);
+      rigidbody::GeneralizedAcceleration Qddot(
+          solver.forwardDynamics(Q, Qdot, Tau));
+      for (unsigned int i = 0; i < model.nbQddot(); ++i) {
+        EXPECT_NEAR(
+            Qddot(i),
+            Qddot_expected(i),
+            1e-6 * (1 + std::abs(Qddot_expected(i))));
+      }
+    }
+
+    // The Baumgarte terms vanish on the constraint manifold
+    solver.setStabilization(5, 5);
+    rigidbody::GeneralizedAcceleration Qddot(
+        solver.forwardDynamics(Q, Qdot, Tau));
+    for (unsigned int i = 0; i < model.nbQddot(); ++i) {
+      EXPECT_NEAR(
+          Qddot(i),
+          Qddot_expected(i),
+          1e-6 * (1 + std::abs(Qddot_expected(i))));
+    }
+  }
+}
+#endif
+
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(Dynamics, RigidContactSolver) {
+  Model model(modelWithUnilateralContact);
+  rigidbody::RigidContactSolver solver(model, 0.5);
+  EXPECT_EQ(solver.nbUnilateralContacts(), 1);
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  rigidbody::GeneralizedTorque Tau(model);
+  Q.setZero();
+  Tau.setZero();
+
+  // Plastic impact, the sliding is slowed down by the friction
+  Qdot << 2, 0, -1;
+  rigidbody::GeneralizedVelocity QdotPost(solver.impact(Q, Qdot));
+  std::vector<double> QdotPost_expected = {1.5, 0, 0};
+  std::vector<double> impulses_expected = {-1, 0, 2};
+  for (unsigned int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(QdotPost(i), QdotPost_expected[i], requiredPrecision);
+    EXPECT_NEAR(solver.impulses()(i), impulses_expected[i], requiredPrecision);
+  }
+  EXPECT_EQ(solver.nbIterations(), 2);
+
+  // Warm started from the previous impulses
+  QdotPost = solver.impact(Q, Qdot);
+  EXPECT_NEAR(QdotPost(0), 1.5, requiredPrecision);
+  EXPECT_EQ(solver.nbIterations(), 1);
+
+  // Bouncing
+  solver.setRestitution(0.5);
+  QdotPost = solver.impact(Q, Qdot);
+  EXPECT_NEAR(QdotPost(0), 1.25, requiredPrecision);
+  EXPECT_NEAR(QdotPost(2), 0.5, requiredPrecision);
+
+  // Leaving the ground, the contact does not pull
+  Qdot << 0, 0, 1;
+  QdotPost = solver.impact(Q, Qdot);
+  for (unsigned int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(QdotPost(i), Qdot(i), requiredPrecision);
+    EXPECT_NEAR(solver.impulses()(i), 0, requiredPrecision);
+  }
+
+  // Stance, sticking then sliding when the push leaves the friction cone
+  double dt(0.01);
+  double normalImpulse(2 * 9.81 * dt);
+  solver.setFriction(0.8);
+  solver.setRestitution(0);
+  Qdot.setZero();
+  Tau << 10, 0, 0;
+  QdotPost = solver.timeStep(Q, Qdot, Tau, dt);
+  for (unsigned int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(QdotPost(i), 0, requiredPrecision);
+  }
+  EXPECT_NEAR(solver.impulses()(2), normalImpulse, requiredPrecision);
+
+  Tau << 20, 0, 0;
+  QdotPost = solver.timeStep(Q, Qdot, Tau, dt);
+  EXPECT_NEAR(
+      QdotPost(0), (20 * dt - 0.8 * normalImpulse) / 2, requiredPrecision);
+  EXPECT_NEAR(QdotPost(2), 0, requiredPrecision);
+  EXPECT_NEAR(solver.impulses()(0), -0.8 * normalImpulse, requiredPrecision);
+}
+
+TEST(Dynamics, RigidContactSolverLanding) {
+  Model model(modelWithUnilateralContact);
+  rigidbody::RigidContactSolver solver(model, 0.5);
+  rigidbody::GeneralizedCoordinates Q(model);
+  rigidbody::GeneralizedVelocity Qdot(model);
+  rigidbody::GeneralizedTorque Tau(model);
+  Q << 0, 0, 0.1;
+  Qdot << 0.5, 0, 0;
+  Tau.setZero();
+  double dt(0.01);
+
+  // Falling freely, the contact is away from the ground
+  rigidbody::GeneralizedVelocity QdotPost(solver.timeStep(Q, Qdot, Tau, dt));
+  EXPECT_NEAR(solver.gaps()(0), 0.1, requiredPrecision);
+  EXPECT_NEAR(QdotPost(0), 0.5, requiredPrecision);
+  EXPECT_NEAR(QdotPost(2), -9.81 * dt, requiredPrecision);
+  for (unsigned int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(solver.impulses()(i), 0, requiredPrecision);
+  }
+
+  // Landing on the ground without going through it, then standing on it
+  for (unsigned int step = 0; step < 50; ++step) {
+    QdotPost = solver.timeStep(Q, Qdot, Tau, dt);
+    Qdot = QdotPost;
+    Q += dt * Qdot;
+    EXPECT_GT(Q(2), -requiredPrecision);
+  }
+  EXPECT_NEAR(Q(2), 0, requiredPrecision);
+  EXPECT_NEAR(Qdot(0), 0, requiredPrecision);
+  EXPECT_NEAR(Qdot(2), 0, requiredPrecision);
+  EXPECT_NEAR(solver.impulses()(2), 2 * 9.81 * dt, requiredPrecision);
+
+  // A contact in the ground is pushed out by a part of the penetration
+  Q << 0, 0, -0.01;
+  Qdot.setZero();
+  QdotPost = solver.timeStep(Q, Qdot, Tau, dt);
+  EXPECT_NEAR(solver.gaps()(0), -0.01, requiredPrecision);
+  EXPECT_NEAR(
+      QdotPost(2), solver.stabilization() * 0.01 / dt, requiredPrecision);
+
+  // An impact only involves the contacts touching the ground
+  Q << 0, 0, 0.1;
+  Qdot << 0, 0, -1;
+  QdotPost = solver.impact(Q, Qdot);
+  EXPECT_NEAR(QdotPost(2), -1, requiredPrecision);
+}
+#endif
+
 TEST(Dynamics, ForwardAccelerationConstraint) {
   Model model(modelPathForGeneralTesting);
   model.segment(0).setJointDampings({});  // Remove the dampings for this test
@@ -2865,6 +3241,105 @@ TEST(ExternalForces, toRbdl_softContactOnly) {
   }
 }
 
+#ifndef BIORBD_USE_CASADI_MATH
+TEST(ExternalForces, toRbdl_compiledSoftContacts) {
+  Model model(modelWithSoftContact);
+  DECLARE_GENERALIZED_COORDINATES(Q, model);
+  DECLARE_GENERALIZED_VELOCITY(Qdot, model);
+  FILL_VECTOR(Q, std::vector<double>({-2.01, -3.01, -3.01, 0.1}));
+  FILL_VECTOR(Qdot, std::vector<double>({-2.01, -3.01, -3.01, 0.1}));
+
+  EXPECT_FALSE(model.isSoftContactsCompiled());
+  std::vector<RigidBodyDynamics::Math::SpatialVector> forceExpected =
+      model.externalForceSet(false, true)
+          .computeRbdlSpatialVectors(
+              model.UpdateKinematicsCustom(&Q, &Qdot), Q, Qdot);
+
+  model.compileSoftContacts();
+  EXPECT_TRUE(model.isSoftContactsCompiled());
+  auto &updatedModel = model.UpdateKinematicsCustom(&Q, &Qdot);
+  std::vector<RigidBodyDynamics::Math::SpatialVector> forceInRbdl =
+      model.externalForceSet(false, true)
+          .computeRbdlSpatialVectors(updatedModel, Q, Qdot);
+
+  EXPECT_EQ(forceInRbdl.size(), forceExpected.size());
+  for (size_t i = 0; i < forceExpected.size(); ++i) {
+    for (size_t j = 0; j < 6; ++j) {
+      SCALAR_TO_DOUBLE(f_expected, forceExpected[i](j));
+      SCALAR_TO_DOUBLE(f, forceInRbdl[i](j));
+      EXPECT_NEAR(f, f_expected, 1e-6);
+    }
+  }
+
+  // The contact positions are the same as the ones of the model
+  const rigidbody::SoftContactSet &softContacts(model.softContactSet());
+  EXPECT_EQ(softContacts.nbSoftContacts(), model.nbSoftContacts());
+  std::vector<rigidbody::NodeSegment> positions(model.softContacts(Q));
+  for (size_t i = 0; i < model.nbSoftContacts(); ++i) {
+    for (unsigned int j = 0; j < 3; ++j) {
+      SCALAR_TO_DOUBLE(x_expected, positions[i](j));
+      SCALAR_TO_DOUBLE(x, softContacts.positions()[i](j));
+      EXPECT_NEAR(x, x_expected, requiredPrecision);
+    }
+  }
+}
+
+static utils::Vector softContactGeneralizedForces(
+    Model& model,
+    const rigidbody::GeneralizedCoordinates& Q,
+    const rigidbody::GeneralizedVelocity& Qdot) {
+  rigidbody::GeneralizedAcceleration Qddot(model);
+  Qddot.setZero();
+  rigidbody::ExternalForceSet noContacts(model.externalForceSet(false, false));
+  rigidbody::ExternalForceSet contacts(model.externalForceSet(false, true));
+  return model.InverseDynamics(Q, Qdot, Qddot, noContacts) -
+         model.InverseDynamics(Q, Qdot, Qddot, contacts);
+}
+
+TEST(ExternalForces, softContactJacobians) {
+  Model model(modelWithSoftContact);
+  DECLARE_GENERALIZED_COORDINATES(Q, model);
+  DECLARE_GENERALIZED_VELOCITY(Qdot, model);
+  FILL_VECTOR(Q, std::vector<double>({0.1, 0.2, -0.3, 0.4}));
+  FILL_VECTOR(Qdot, std::vector<double>({0.5, -0.3, 0.2, 0.7}));
+
+  utils::Matrix dTauDq;
+  utils::Matrix dTauDqdot;
+  rigidbody::ExternalForceSet externalForces(model.externalForceSet(false));
+  externalForces.computeSoftContactJacobians(
+      model.UpdateKinematicsCustom(&Q, &Qdot), Q, Qdot, dTauDq, dTauDqdot);
+  EXPECT_EQ(static_cast<size_t>(dTauDq.rows()), model.nbQdot());
+  EXPECT_EQ(static_cast<size_t>(dTauDq.cols()), model.nbQdot());
+  EXPECT_FALSE(model.isSoftContactsCompiled());
+
+  // Compare with the central finite differences of the whole pipeline
+  double h(1e-6);
+  for (unsigned int k = 0; k < model.nbQ(); ++k) {
+    rigidbody::GeneralizedCoordinates Qplus(Q);
+    rigidbody::GeneralizedCoordinates Qminus(Q);
+    Qplus[k] += h;
+    Qminus[k] -= h;
+    rigidbody::GeneralizedVelocity QdotPlus(Qdot);
+    rigidbody::GeneralizedVelocity QdotMinus(Qdot);
+    QdotPlus[k] += h;
+    QdotMinus[k] -= h;
+    utils::Vector dq(
+        (softContactGeneralizedForces(model, Qplus, Qdot) -
+         softContactGeneralizedForces(model, Qminus, Qdot)) /
+        (2 * h));
+    utils::Vector dqdot(
+        (softContactGeneralizedForces(model, Q, QdotPlus) -
+         softContactGeneralizedForces(model, Q, QdotMinus)) /
+        (2 * h));
+    for (unsigned int j = 0; j < model.nbQdot(); ++j) {
+      EXPECT_NEAR(dTauDq(j, k), dq(j), 1e-5 * (1 + std::fabs(dq(j))));
+      EXPECT_NEAR(
+          dTauDqdot(j, k), dqdot(j), 1e-5 * (1 + std::fabs(dqdot(j))));
+    }
+  }
+}
+#endif
+
 TEST(ExternalForces, toRbdl_externalForcesAndLinearForces) {
   Model model(modelWithRigidContactsExternalForces);
   DECLARE_GENERALIZED_COORDINATES(Q, model);